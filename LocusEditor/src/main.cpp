@@ -1,14 +1,485 @@
 #include "Locus.hpp"
 #include "Platform/Platform.hpp"
 
+#include <cmath>
+#include <vector>
 
 using namespace Locus;
 
 f64 s_DeltaTime = 0.0;
+bool s_bShowRenderGraph = false;
+bool s_bGradientBackground = true;
+ComputePipelineHandle s_GradientPipeline = HANDLE_INVALID;
+
+MeshHandle s_CubeMesh = HANDLE_INVALID;
+std::vector<SceneObjectHandle> s_SceneObjects;
+i32 s_SceneObjectCount = 4096;
+bool s_bOrbitCamera = true;
+f64 s_OrbitAngle = 0.0;
+
+constexpr u32 QUEUE_MATERIAL_COUNT = 8;
+constexpr u32 QUEUE_TRANSLUCENT_MATERIALS = 2; // The last few materials blend
+GraphicsBufferHandle s_CubeVertexBuffer = HANDLE_INVALID;
+GraphicsBufferHandle s_CubeIndexBuffer = HANDLE_INVALID;
+GraphicsPipelineHandle s_QueuePipelines[2] = { HANDLE_INVALID, HANDLE_INVALID }; // Opaque, translucent
+GraphicsBufferHandle s_QueueMaterialBuffers[QUEUE_MATERIAL_COUNT];
+MaterialHandle s_QueueMaterials[QUEUE_MATERIAL_COUNT];
+i32 s_QueueDrawCount = 256;
+bool s_bSortRenderQueue = true;
+
+constexpr u32 CHURN_MESH_COUNT = 256;
+bool s_bChurnMeshes = false;
+std::vector<MeshHandle> s_ChurnMeshes;
+u32 s_ChurnSeed = 1;
+
+StaticMeshHandle s_StaticMesh = HANDLE_INVALID;
+std::vector<StaticMeshInstance> s_StaticMeshInstances;
+i32 s_StaticMeshInstanceCount = 1024;
+
+i32 s_TextureBudgetMB = 256;
+TextureHandle s_StreamedTexture = HANDLE_INVALID;
+GraphicsPipelineHandle s_TexturedQuadPipeline = HANDLE_INVALID;
+MaterialHandle s_TexturedQuadMaterial = HANDLE_INVALID;
+
+struct QueueDrawConstants
+{
+	f32 ViewProjection[16];
+	f32 PositionScale[4];
+};
+
+struct TexturedQuadConstants
+{
+	f32 ViewProjection[16];
+	f32 PositionScale[4];
+	u32 ImageIndex; // Bindless, see GetTextureBinding
+	u32 SamplerIndex;
+};
+
+static void BuildCube(MeshVertex (&Vertices)[24], u32 (&Indices)[36])
+{
+	// Four vertices per face so each face keeps its own normal, wound counter-clockwise from outside.
+	for (u32 Face = 0; Face < 6; Face++)
+	{
+		u32 Axis = Face / 2;
+		f32 Sign = (Face % 2) ? -1.0f : 1.0f;
+		
+		f32 Normal[3] = {};
+		f32 U[3] = {};
+		f32 V[3] = {};
+		Normal[Axis] = Sign;
+		U[(Axis + 1) % 3] = Sign;
+		V[(Axis + 2) % 3] = 1.0f;
+		
+		const f32 Corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+		for (u32 Corner = 0; Corner < 4; Corner++)
+		{
+			MeshVertex& Vertex = Vertices[Face * 4 + Corner];
+			for (u32 i = 0; i < 3; i++)
+			{
+				Vertex.Position[i] = 0.5f * (Normal[i] + Corners[Corner][0] * U[i] + Corners[Corner][1] * V[i]);
+				Vertex.Normal[i] = Normal[i];
+			}
+		}
+		
+		const u32 FaceIndices[6] = { 0, 1, 2, 0, 2, 3 };
+		for (u32 i = 0; i < 6; i++)
+		{
+			Indices[Face * 6 + i] = Face * 4 + FaceIndices[i];
+		}
+	}
+}
+
+static void CreateCube()
+{
+	MeshVertex Vertices[24];
+	u32 Indices[36];
+	BuildCube(Vertices, Indices);
+	
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	s_CubeMesh = GraphicsManager.CreateMesh(Vertices, 24, Indices, 36);
+	s_CubeVertexBuffer = GraphicsManager.CreateBuffer(sizeof(Vertices), Vertices);
+	s_CubeIndexBuffer = GraphicsManager.CreateBuffer(sizeof(Indices), Indices);
+}
+
+static u32 NextChurnRandom()
+{
+	// Xorshift, only needs to scatter mesh sizes.
+	s_ChurnSeed ^= s_ChurnSeed << 13;
+	s_ChurnSeed ^= s_ChurnSeed >> 17;
+	s_ChurnSeed ^= s_ChurnSeed << 5;
+	return s_ChurnSeed;
+}
+
+static MeshHandle CreateChurnMesh()
+{
+	// Between 1 and 256 stacked cubes, so ranges of very different sizes come and go.
+	MeshVertex CubeVertices[24];
+	u32 CubeIndices[36];
+	BuildCube(CubeVertices, CubeIndices);
+	
+	u32 Cubes = 1u << (NextChurnRandom() % 9);
+	std::vector<MeshVertex> Vertices(24 * Cubes);
+	std::vector<u32> Indices(36 * Cubes);
+	for (u32 Cube = 0; Cube < Cubes; Cube++)
+	{
+		for (u32 i = 0; i < 24; i++)
+		{
+			Vertices[Cube * 24 + i] = CubeVertices[i];
+			Vertices[Cube * 24 + i].Position[1] += static_cast<f32>(Cube);
+		}
+		for (u32 i = 0; i < 36; i++)
+		{
+			Indices[Cube * 36 + i] = Cube * 24 + CubeIndices[i];
+		}
+	}
+	
+	return GraphicsManager::Get().CreateMesh(Vertices.data(), static_cast<u32>(Vertices.size()), Indices.data(), static_cast<u32>(Indices.size()));
+}
+
+static void UpdateMeshChurn()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	if (!s_bChurnMeshes)
+	{
+		for (MeshHandle Mesh : s_ChurnMeshes)
+		{
+			GraphicsManager.DestroyMesh(Mesh);
+		}
+		s_ChurnMeshes.clear();
+		return;
+	}
+	
+	// Replace a few random meshes a frame to exercise the geometry allocator.
+	while (s_ChurnMeshes.size() < CHURN_MESH_COUNT)
+	{
+		MeshHandle Mesh = CreateChurnMesh();
+		if (!HandleIsValid(Mesh))
+		{
+			break;
+		}
+		s_ChurnMeshes.push_back(Mesh);
+	}
+	
+	for (u32 i = 0; i < 4 && !s_ChurnMeshes.empty(); i++)
+	{
+		arch Victim = NextChurnRandom() % s_ChurnMeshes.size();
+		GraphicsManager.DestroyMesh(s_ChurnMeshes[Victim]);
+		s_ChurnMeshes[Victim] = s_ChurnMeshes.back();
+		s_ChurnMeshes.pop_back();
+	}
+}
+
+static void CreateQueueMaterials()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	GraphicsPipelineDesc PipelineDesc = {
+		.VertexShaderPath = "shaders/queue_mesh.vert.spv",
+		.FragmentShaderPath = "shaders/queue_mesh.frag.spv",
+	};
+	s_QueuePipelines[0] = GraphicsManager.CreateGraphicsPipeline(PipelineDesc);
+	PipelineDesc.bAlphaBlend = true;
+	s_QueuePipelines[1] = GraphicsManager.CreateGraphicsPipeline(PipelineDesc);
+	
+	for (u32 i = 0; i < QUEUE_MATERIAL_COUNT; i++)
+	{
+		bool bTranslucent = i >= QUEUE_MATERIAL_COUNT - QUEUE_TRANSLUCENT_MATERIALS;
+		f32 Color[4] = {
+			0.5f + 0.5f * cosf(0.8f * i),
+			0.5f + 0.5f * cosf(0.8f * i + 2.0f),
+			0.5f + 0.5f * cosf(0.8f * i + 4.0f),
+			bTranslucent ? 0.4f : 1.0f,
+		};
+		s_QueueMaterialBuffers[i] = GraphicsManager.CreateBuffer(sizeof(Color), Color);
+		
+		GraphicsPipelineHandle Pipeline = s_QueuePipelines[bTranslucent ? 1 : 0];
+		s_QueueMaterials[i] = HANDLE_INVALID;
+		if (HandleIsValid(Pipeline) && HandleIsValid(s_QueueMaterialBuffers[i]))
+		{
+			s_QueueMaterials[i] = GraphicsManager.CreateMaterial({ .Pipeline = Pipeline, .Buffers = &s_QueueMaterialBuffers[i], .BufferCount = 1 });
+		}
+	}
+}
+
+static void CreateTexturedQuad()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	s_StreamedTexture = GraphicsManager.LoadTexture("textures/checker.ktx2");
+	s_TexturedQuadPipeline = GraphicsManager.CreateGraphicsPipeline({
+		.VertexShaderPath = "shaders/textured_quad.vert.spv",
+		.FragmentShaderPath = "shaders/textured_quad.frag.spv",
+	});
+	
+	// Nothing in set 0, the texture is reached through the bindless heap.
+	if (HandleIsValid(s_TexturedQuadPipeline))
+	{
+		s_TexturedQuadMaterial = GraphicsManager.CreateMaterial({ .Pipeline = s_TexturedQuadPipeline });
+	}
+}
+
+static void DestroyTexturedQuad()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	if (HandleIsValid(s_TexturedQuadMaterial))
+	{
+		GraphicsManager.DestroyMaterial(s_TexturedQuadMaterial);
+	}
+	if (HandleIsValid(s_TexturedQuadPipeline))
+	{
+		GraphicsManager.DestroyGraphicsPipeline(s_TexturedQuadPipeline);
+	}
+	if (HandleIsValid(s_StreamedTexture))
+	{
+		GraphicsManager.DestroyTexture(s_StreamedTexture);
+	}
+}
+
+static void DestroyQueueMaterials()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	for (u32 i = 0; i < QUEUE_MATERIAL_COUNT; i++)
+	{
+		if (HandleIsValid(s_QueueMaterials[i]))
+		{
+			GraphicsManager.DestroyMaterial(s_QueueMaterials[i]);
+		}
+		if (HandleIsValid(s_QueueMaterialBuffers[i]))
+		{
+			GraphicsManager.DestroyBuffer(s_QueueMaterialBuffers[i]);
+		}
+	}
+	
+	for (GraphicsPipelineHandle Pipeline : s_QueuePipelines)
+	{
+		if (HandleIsValid(Pipeline))
+		{
+			GraphicsManager.DestroyGraphicsPipeline(Pipeline);
+		}
+	}
+}
+
+static u32 GetSceneGridSide()
+{
+	return static_cast<u32>(ceil(sqrt(static_cast<f64>(s_SceneObjectCount))));
+}
+
+static void RebuildScene()
+{
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	for (SceneObjectHandle Object : s_SceneObjects)
+	{
+		GraphicsManager.DestroySceneObject(Object);
+	}
+	s_SceneObjects.clear();
+	
+	if (!HandleIsValid(s_CubeMesh))
+	{
+		return;
+	}
+	
+	// A flat grid of cubes, each turned and tinted a little differently.
+	u32 Side = GetSceneGridSide();
+	for (i32 i = 0; i < s_SceneObjectCount; i++)
+	{
+		f32 X = static_cast<f32>(i % Side) - 0.5f * (Side - 1);
+		f32 Z = static_cast<f32>(i / Side) - 0.5f * (Side - 1);
+		f32 Angle = 0.37f * i;
+		
+		SceneObjectDesc Desc;
+		Desc.Mesh = s_CubeMesh;
+		Desc.Transform.Position[0] = 2.0f * X;
+		Desc.Transform.Position[2] = 2.0f * Z;
+		Desc.Transform.Rotation[1] = sinf(0.5f * Angle);
+		Desc.Transform.Rotation[3] = cosf(0.5f * Angle);
+		Desc.Color[0] = 0.5f + 0.5f * sinf(0.11f * i);
+		Desc.Color[1] = 0.5f + 0.5f * sinf(0.07f * i + 2.0f);
+		Desc.Color[2] = 0.5f + 0.5f * sinf(0.05f * i + 4.0f);
+		s_SceneObjects.push_back(GraphicsManager.CreateSceneObject(Desc));
+	}
+}
+
+static void UpdateSceneCamera()
+{
+	if (s_bOrbitCamera)
+	{
+		s_OrbitAngle += 0.2 * s_DeltaTime;
+	}
+	
+	// Circles the grid from above, looking at its centre.
+	f32 Radius = 1.2f * GetSceneGridSide() + 4.0f;
+	f32 Height = 0.5f * Radius;
+	f32 Angle = static_cast<f32>(s_OrbitAngle);
+	
+	Camera& SceneCamera = GraphicsManager::Get().GetSceneCamera();
+	SceneCamera.Position[0] = Radius * sinf(Angle);
+	SceneCamera.Position[1] = Height;
+	SceneCamera.Position[2] = Radius * cosf(Angle);
+	SceneCamera.Yaw = Angle;
+	SceneCamera.Pitch = -atanf(Height / Radius);
+}
+
+static void SubmitQueueDraws()
+{
+	if (!HandleIsValid(s_CubeVertexBuffer) || !HandleIsValid(s_CubeIndexBuffer))
+	{
+		return;
+	}
+	
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	u32 Width, Height;
+	GraphicsManager.GetSceneExtent(Width, Height);
+	
+	const Camera& SceneCamera = GraphicsManager.GetSceneCamera();
+	QueueDrawConstants Constants;
+	SceneCamera.GetViewProjection(static_cast<f32>(Width) / static_cast<f32>(Height), Constants.ViewProjection);
+	
+	// A ring of cubes spinning above the grid, materials interleaved so submission order is the worst case for binds.
+	f32 Radius = 0.6f * GetSceneGridSide() + 2.0f;
+	f32 Spin = static_cast<f32>(s_OrbitAngle) * 3.0f;
+	for (i32 i = 0; i < s_QueueDrawCount; i++)
+	{
+		f32 Angle = Spin + 6.2831853f * i / s_QueueDrawCount;
+		Constants.PositionScale[0] = Radius * cosf(Angle);
+		Constants.PositionScale[1] = 3.0f + sinf(4.0f * Angle);
+		Constants.PositionScale[2] = Radius * sinf(Angle);
+		Constants.PositionScale[3] = 0.8f;
+		
+		u32 Material = i % QUEUE_MATERIAL_COUNT;
+		if (!HandleIsValid(s_QueueMaterials[Material]))
+		{
+			continue;
+		}
+		
+		f32 Offset[3];
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Offset[Axis] = Constants.PositionScale[Axis] - SceneCamera.Position[Axis];
+		}
+		
+		DrawDesc Draw = {
+			.Layer = Material >= QUEUE_MATERIAL_COUNT - QUEUE_TRANSLUCENT_MATERIALS ? RenderLayer::Translucent : RenderLayer::Opaque,
+			.Material = s_QueueMaterials[Material],
+			.VertexBuffer = s_CubeVertexBuffer,
+			.IndexBuffer = s_CubeIndexBuffer,
+			.Count = 36,
+			.SortDepth = sqrtf(Offset[0] * Offset[0] + Offset[1] * Offset[1] + Offset[2] * Offset[2]),
+			.PushConstants = &Constants,
+			.PushConstantSize = sizeof(Constants),
+		};
+		GraphicsManager.SubmitDraw(Draw);
+	}
+}
+
+static void SubmitTexturedQuad()
+{
+	if (!HandleIsValid(s_TexturedQuadMaterial) || !HandleIsValid(s_StreamedTexture))
+	{
+		return;
+	}
+	
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	u32 Width, Height;
+	GraphicsManager.GetSceneExtent(Width, Height);
+	const Camera& SceneCamera = GraphicsManager.GetSceneCamera();
+	
+	// A square hanging over the middle of the grid, under the knots.
+	TexturedQuadConstants Constants;
+	SceneCamera.GetViewProjection(static_cast<f32>(Width) / static_cast<f32>(Height), Constants.ViewProjection);
+	Constants.PositionScale[0] = 0.0f;
+	Constants.PositionScale[1] = 4.0f;
+	Constants.PositionScale[2] = 0.0f;
+	Constants.PositionScale[3] = 0.5f * GetSceneGridSide() + 4.0f;
+	
+	f32 Distance = 0.0f;
+	for (u32 Axis = 0; Axis < 3; Axis++)
+	{
+		f32 Offset = Constants.PositionScale[Axis] - SceneCamera.Position[Axis];
+		Distance += Offset * Offset;
+	}
+	Distance = sqrtf(Distance);
+	
+	// Requested every frame it is drawn, or it falls back to its tail. Its indices move as levels stream in and out.
+	GraphicsManager.RequestTextureAtDistance(s_StreamedTexture, Constants.PositionScale[3], Distance);
+	if (!GraphicsManager.GetTextureBinding(s_StreamedTexture, Constants.ImageIndex, Constants.SamplerIndex))
+	{
+		return;
+	}
+	
+	DrawDesc Draw = {
+		.Layer = RenderLayer::Opaque,
+		.Material = s_TexturedQuadMaterial,
+		.Count = 6,
+		.SortDepth = Distance,
+		.PushConstants = &Constants,
+		.PushConstantSize = sizeof(Constants),
+	};
+	GraphicsManager.SubmitDraw(Draw);
+}
+
+static void DrawStaticMeshes()
+{
+	if (!HandleIsValid(s_StaticMesh) || s_StaticMeshInstanceCount == 0)
+	{
+		return;
+	}
+	
+	// A slowly turning disc of knots floating over the grid, all one instanced draw.
+	f32 Radius = 0.5f * GetSceneGridSide();
+	f32 Spin = static_cast<f32>(s_OrbitAngle);
+	s_StaticMeshInstances.resize(s_StaticMeshInstanceCount);
+	for (i32 i = 0; i < s_StaticMeshInstanceCount; i++)
+	{
+		// Spread evenly over the disc along a golden angle spiral.
+		f32 Distance = Radius * sqrtf((i + 0.5f) / s_StaticMeshInstanceCount);
+		f32 Angle = Spin + 2.3999632f * i;
+		
+		StaticMeshInstance& Instance = s_StaticMeshInstances[i];
+		Instance.Transform.Position[0] = Distance * cosf(Angle);
+		Instance.Transform.Position[1] = 6.0f;
+		Instance.Transform.Position[2] = Distance * sinf(Angle);
+		Instance.Transform.Scale = 0.6f;
+		Instance.Transform.Rotation[0] = sinf(Angle);
+		Instance.Transform.Rotation[3] = cosf(Angle);
+		Instance.Color[0] = 0.9f;
+		Instance.Color[1] = 0.6f + 0.3f * sinf(0.13f * i);
+		Instance.Color[2] = 0.3f;
+	}
+	GraphicsManager::Get().DrawStaticMesh(s_StaticMesh, s_StaticMeshInstances.data(), static_cast<u32>(s_StaticMeshInstanceCount));
+}
 
 static void Draw(RenderContextHandle RenderContext)
 {
-	GraphicsManager::Get().TestDraw(RenderContext);
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	
+	if (s_bGradientBackground && HandleIsValid(s_GradientPipeline))
+	{
+		u32 Width, Height;
+		GraphicsManager.GetSceneExtent(Width, Height);
+		i32 Extent[2] = { static_cast<i32>(Width), static_cast<i32>(Height) };
+		
+		ComputeBinding Target = {
+			.Binding = 0,
+			.Resource = ComputeResource::SceneColor,
+			.Access = ComputeAccess::Write,
+		};
+		ComputePass Pass = {
+			.Name = "Gradient",
+			.Pipeline = s_GradientPipeline,
+			.Bindings = &Target,
+			.BindingCount = 1,
+			.PushConstants = Extent,
+			.PushConstantSize = sizeof(Extent),
+		};
+		GraphicsManager.Dispatch(Pass, (Width + 15) / 16, (Height + 15) / 16, 1);
+	}
+	
+	UpdateSceneCamera();
+	UpdateMeshChurn();
+	GraphicsManager.DrawScene();
+	SubmitQueueDraws();
+	SubmitTexturedQuad();
+	DrawStaticMeshes();
+	
+	GraphicsManager.TestDraw(RenderContext);
 }
 
 static void DrawGUI()
@@ -16,12 +487,83 @@ static void DrawGUI()
 	if(ImGui::Begin("Debug"))
 	{
 		ImGui::Text("Frame Time: %.2lfms", s_DeltaTime * 1000.0);
+		
+		const GraphicsStats& Stats = GraphicsManager::Get().GetStats();
+		ImGui::Text("Pipelines: %u in %.2lfms (%s cache), %u shared", Stats.PipelinesCreated, Stats.PipelineCreateMilliseconds, Stats.bPipelineCacheWarm ? "warm" : "cold", Stats.PipelineRegistryHits);
+		ImGui::Text("Pipeline compiles in flight: %u", Stats.PipelineCompilesPending);
+		ImGui::Text("Descriptors: %s, %u images, %u buffers, %u samplers", Stats.bBindlessDescriptors ? "bindless" : "fallback", Stats.BindlessImages, Stats.BindlessBuffers, Stats.BindlessSamplers);
+		ImGui::Text("Descriptor cache: %u sets, %llu hits, %llu misses", Stats.DescriptorCacheEntries, (unsigned long long)Stats.DescriptorCacheHits, (unsigned long long)Stats.DescriptorCacheMisses);
+		ImGui::Text("Uploads: %u pending, %.1lfKB last frame", Stats.UploadsPending, Stats.UploadBytesLastFrame / 1024.0);
+		ImGui::Text("Render graph: %u passes (%u culled), %u barriers, %.1lfKB transient in %.1lfKB", Stats.RenderGraphPasses, Stats.RenderGraphCulledPasses, Stats.RenderGraphBarriers, Stats.RenderGraphTransientBytes / 1024.0, Stats.RenderGraphAllocatedBytes / 1024.0);
+		ImGui::Checkbox("Show Render Graph", &s_bShowRenderGraph);
+		
+		ImGui::Text("Swapchain: %ux%u, %u recreations, %u frames skipped", Stats.SwapchainWidth, Stats.SwapchainHeight, Stats.SwapchainRecreations, Stats.SkippedFrames);
+		
+		static const char* PresentPolicyNames[] = { "FIFO", "Mailbox", "Immediate" };
+		PresentSettings& Present = GraphicsManager::Get().GetPresentSettings();
+		i32 Policy = static_cast<i32>(Present.Policy);
+		if (ImGui::Combo("Present Mode", &Policy, PresentPolicyNames, IM_ARRAYSIZE(PresentPolicyNames)))
+		{
+			Present.Policy = static_cast<PresentPolicy>(Policy);
+		}
+		u32 FramesInFlightMin = 1;
+		u32 FramesInFlightMax = FRAMES_IN_FLIGHT_MAX;
+		ImGui::SliderScalar("Frames In Flight", ImGuiDataType_U32, &Present.FramesInFlight, &FramesInFlightMin, &FramesInFlightMax);
+		ImGui::BeginDisabled(!Stats.bPresentWait);
+		ImGui::Checkbox("Wait For Present", &Present.bWaitForPresent);
+		ImGui::EndDisabled();
+		ImGui::Text("Presenting with %s, input latency %.2lfms (to %s), waited %.2lfms", PresentPolicyNames[static_cast<u32>(Stats.Policy)], Stats.InputLatencyMilliseconds, Stats.bPresentWait && Present.bWaitForPresent ? "screen" : "frame end", Stats.LatencyWaitMilliseconds);
+		
+		RenderScaleSettings& RenderScale = GraphicsManager::Get().GetRenderScaleSettings();
+		ImGui::Text("Render scale: %.0f%%, GPU %.2lfms", Stats.RenderScale * 100.0f, Stats.GpuFrameMilliseconds);
+		ImGui::Checkbox("Dynamic Resolution", &RenderScale.bEnabled);
+		ImGui::SliderFloat("GPU Budget (ms)", &RenderScale.TargetMilliseconds, 1.0f, 33.3f, "%.1f");
+		
+		ImGui::Text("Compute: %u dispatches, %.3lfms", Stats.ComputeDispatches, Stats.ComputeMilliseconds);
+		ImGui::Checkbox("Gradient Background", &s_bGradientBackground);
+		
+		ImGui::Text("Scene: %u objects, %u visible, %u meshes, %u draws (%s)", Stats.SceneObjects, Stats.SceneVisibleObjects, Stats.SceneMeshes, Stats.SceneDrawCalls, Stats.bDrawIndirectCount ? "indirect count" : "indirect");
+		ImGui::SliderInt("Scene Objects", &s_SceneObjectCount, 1, 262144, "%d", ImGuiSliderFlags_Logarithmic);
+		if (ImGui::IsItemDeactivatedAfterEdit())
+		{
+			RebuildScene();
+		}
+		ImGui::Checkbox("Orbit Camera", &s_bOrbitCamera);
+		ImGui::Text("Occlusion: %u retested, %u occluded, %u recovered", Stats.SceneRetestedObjects, Stats.SceneOccludedObjects, Stats.SceneRetestedObjects - Stats.SceneOccludedObjects);
+		ImGui::Text("Scene GPU: cull %.3lfms, draw %.3lfms, occlusion %.3lfms, saved ~%.3lfms", Stats.SceneCullMilliseconds, Stats.SceneDrawMilliseconds, Stats.SceneOcclusionMilliseconds, Stats.SceneOcclusionSavedMilliseconds);
+		
+		ImGui::Text("Geometry: %.1lfMB used, %.1lfMB free in %u ranges, %.0f%% fragmented", Stats.SceneGeometryBytes / (1024.0 * 1024.0), Stats.SceneGeometryFreeBytes / (1024.0 * 1024.0), Stats.SceneGeometryFreeRegions, Stats.SceneGeometryFragmentation * 100.0f);
+		ImGui::Checkbox("Churn Meshes", &s_bChurnMeshes);
+		
+		ImGui::Text("Render queue: %u draws, %u sort passes in %.3lfms", Stats.QueuedDraws, Stats.QueueSortPasses, Stats.QueueSortMilliseconds);
+		ImGui::Text("Binds: %u pipelines, %u sets, %u vertex, %u index", Stats.PipelineBinds, Stats.DescriptorSetBinds, Stats.VertexBufferBinds, Stats.IndexBufferBinds);
+		ImGui::SliderInt("Queued Draws", &s_QueueDrawCount, 0, 16384, "%d", ImGuiSliderFlags_Logarithmic);
+		if (ImGui::Checkbox("Sort Render Queue", &s_bSortRenderQueue))
+		{
+			GraphicsManager::Get().SetRenderQueueSorting(s_bSortRenderQueue);
+		}
+		
+		ImGui::Text("Static meshes: %u meshes, %u instances in %u draws, %.1lfKB geometry", Stats.StaticMeshes, Stats.StaticMeshInstances, Stats.StaticMeshDrawCalls, Stats.StaticMeshGeometryBytes / 1024.0);
+		ImGui::Text("Clusters: %u of %u visible, %.1lfk of %.1lfk triangles", Stats.StaticMeshVisibleClusters, Stats.StaticMeshTestedClusters, Stats.StaticMeshTriangles / 1000.0, Stats.StaticMeshFullDetailTriangles / 1000.0);
+		ImGui::SliderInt("Static Mesh Instances", &s_StaticMeshInstanceCount, 0, 65536, "%d", ImGuiSliderFlags_Logarithmic);
+		
+		ImGui::Text("Textures: %u, %u streaming, %.1lfMB resident of %.1lfMB wanted", Stats.Textures, Stats.TexturesStreaming, Stats.TextureResidentBytes / (1024.0 * 1024.0), Stats.TextureWantedBytes / (1024.0 * 1024.0));
+		ImGui::Text("Texture levels: %u streamed in, %u evicted", Stats.TextureLevelsStreamedIn, Stats.TextureLevelsEvicted);
+		if (ImGui::SliderInt("Texture Budget (MB)", &s_TextureBudgetMB, 16, 2048, "%d", ImGuiSliderFlags_Logarithmic))
+		{
+			GraphicsManager::Get().SetTextureBudget(static_cast<u64>(s_TextureBudgetMB) * 1024 * 1024);
+		}
 		if (ImGui::Button("Make Window!"))
 		{
 			WindowHandle Handle = DisplayManager::Get().CreateWindow("Aghh", 800, 600);
 		}
 	}
 	ImGui::End();
+	
+	if (s_bShowRenderGraph)
+	{
+		GraphicsManager::Get().DrawDebugRenderGraph(&s_bShowRenderGraph);
+	}
 }
 
 i32 main(i32 argc, char* argv[])
@@ -35,6 +577,12 @@ i32 main(i32 argc, char* argv[])
 	Clock.Start();
 	
 	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	s_GradientPipeline = GraphicsManager.CreateComputePipeline("shaders/gradient.comp.spv");
+	CreateCube();
+	CreateQueueMaterials();
+	CreateTexturedQuad();
+	RebuildScene();
+	s_StaticMesh = GraphicsManager.LoadStaticMesh("meshes/torus_knot.lmesh");
 	
 	bool bShouldQuit = false;
 	while (!bShouldQuit)
@@ -42,9 +590,16 @@ i32 main(i32 argc, char* argv[])
 		s_DeltaTime = Clock.GetElapsedSeconds();
 		Clock.Reset(true);
 		
+		// Blocking here rather than in BeginFrame, the input polled next is as fresh as the frame allows.
+		GraphicsManager.WaitForFrameLatency(RenderContext);
 		DisplayManager::Get().PollEvents(bShouldQuit);
 		
-		GraphicsManager.BeginFrame(RenderContext);
+		// Minimised, there is nothing to draw to, so don't spin until there is.
+		if (!GraphicsManager.BeginFrame(RenderContext))
+		{
+			Platform::SleepThisThread(10);
+			continue;
+		}
 		{
 			Draw(RenderContext);
 			{
@@ -56,6 +611,34 @@ i32 main(i32 argc, char* argv[])
 		GraphicsManager.EndFrame(RenderContext);
 	}
 	
+	if (HandleIsValid(s_GradientPipeline))
+	{
+		GraphicsManager.DestroyComputePipeline(s_GradientPipeline);
+	}
+	
+	s_SceneObjectCount = 0;
+	RebuildScene();
+	s_bChurnMeshes = false;
+	UpdateMeshChurn();
+	if (HandleIsValid(s_CubeMesh))
+	{
+		GraphicsManager.DestroyMesh(s_CubeMesh);
+	}
+	
+	DestroyQueueMaterials();
+	DestroyTexturedQuad();
+	if (HandleIsValid(s_StaticMesh))
+	{
+		GraphicsManager.DestroyStaticMesh(s_StaticMesh);
+	}
+	for (GraphicsBufferHandle Buffer : { s_CubeVertexBuffer, s_CubeIndexBuffer })
+	{
+		if (HandleIsValid(Buffer))
+		{
+			GraphicsManager.DestroyBuffer(Buffer);
+		}
+	}
+	
 	Engine::Get().Shutdown();
 	return 0;
 }
\ No newline at end of file
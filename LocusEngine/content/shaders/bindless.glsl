@@ -0,0 +1,39 @@
+// Global bindless descriptor heap, see LVKBindlessHeap.hpp.
+// Include from a stage with #extension GL_GOOGLE_include_directive : require.
+//
+// Resources are indexed by the handle index the engine hands out, passed in through push constants.
+// Stages including this are also built with LOCUS_BINDLESS_FALLBACK into <stage>.fallback.spv, which the engine
+// loads on devices without descriptor indexing. The fallback array sizes match the engine's.
+
+#ifndef LOCUS_BINDLESS_GLSL
+#define LOCUS_BINDLESS_GLSL
+
+#ifdef LOCUS_BINDLESS_FALLBACK
+	#define BINDLESS_IMAGE_COUNT 16
+	#define BINDLESS_BUFFER_COUNT 4
+	#define BINDLESS_SAMPLER_COUNT 16
+	#define BindlessIndex(Index) (Index)
+#else
+	#extension GL_EXT_nonuniform_qualifier : require
+	#define BINDLESS_IMAGE_COUNT
+	#define BINDLESS_BUFFER_COUNT
+	#define BINDLESS_SAMPLER_COUNT
+	#define BindlessIndex(Index) nonuniformEXT(Index)
+#endif
+
+// Set 0 belongs to the material, the render queue binds the heap here for pipelines that declare it.
+#define BINDLESS_SET 1
+
+layout (set = BINDLESS_SET, binding = 0) uniform texture2D BindlessImages[BINDLESS_IMAGE_COUNT];
+layout (set = BINDLESS_SET, binding = 2) uniform sampler BindlessSamplers[BINDLESS_SAMPLER_COUNT];
+
+// Storage buffers are declared per use, since the block layout differs:
+// BINDLESS_BUFFER(Vertices, { vec4 Positions[]; });
+#define BINDLESS_BUFFER(Name, Block) layout (std430, set = BINDLESS_SET, binding = 1) readonly buffer Name##Block Block Name[BINDLESS_BUFFER_COUNT]
+
+vec4 SampleBindless(uint ImageIndex, uint SamplerIndex, vec2 UV)
+{
+	return texture(sampler2D(BindlessImages[BindlessIndex(ImageIndex)], BindlessSamplers[BindlessIndex(SamplerIndex)]), UV);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,183 @@
+// Single pass downsampler, see LVKDownsampler.hpp. Included by one compute shader per destination
+// format, each defining DOWNSAMPLE_FORMAT as its image format qualifier first.
+//
+// Each group of 256 threads reduces a 64x64 block of the base level into the six levels below it,
+// the first two in registers and the rest through shared memory, a quarter of the threads at a
+// time. With more levels than that, every group leaves its last texel in the scratch buffer and
+// counts itself finished, and the last group to finish reduces those texels into the rest. A level
+// is half the one above rounded down, at least one, each texel reading texels 2x and 2x + 1 above.
+// Nothing folds in the last row and column of an odd level, they are never read, so the base has to
+// be a power of two wide and high. Reads past an edge are clamped, which only comes into play once
+// one side is down to a single texel.
+
+#ifndef LOCUS_DOWNSAMPLE_GLSL
+#define LOCUS_DOWNSAMPLE_GLSL
+
+#define DOWNSAMPLE_LEVELS_MAX 12
+#define DOWNSAMPLE_BLOCK_LEVELS 6u
+
+#define REDUCTION_AVERAGE 0
+#define REDUCTION_MIN 1
+#define REDUCTION_MAX 2
+
+layout (local_size_x = 256) in;
+
+layout (set = 0, binding = 0) uniform sampler2D source; // The base level
+layout (set = 0, binding = 1, DOWNSAMPLE_FORMAT) uniform writeonly image2D destination[DOWNSAMPLE_LEVELS_MAX]; // Levels one and on
+layout (std430, set = 0, binding = 2) coherent buffer Scratch
+{
+	uint finishedGroups; // Back to zero once the last group is done
+	uint pad[3];
+	vec4 lastTexels[]; // A group's texel of level six, by group
+} scratch;
+
+layout (push_constant) uniform Constants
+{
+	uvec2 baseSize;
+	uint levelCount; // Written below the base
+	uint reduction;
+} constants;
+
+shared vec4 texels[16][16];
+shared uint isLastGroup;
+
+vec4 Reduce(vec4 a, vec4 b, vec4 c, vec4 d)
+{
+	if (constants.reduction == REDUCTION_MIN)
+	{
+		return min(min(a, b), min(c, d));
+	}
+	if (constants.reduction == REDUCTION_MAX)
+	{
+		return max(max(a, b), max(c, d));
+	}
+	return (a + b + c + d) * 0.25;
+}
+
+ivec2 LevelSize(uint level)
+{
+	return max(ivec2(constants.baseSize) >> int(level), ivec2(1));
+}
+
+// Where a child texel is within its block, after clamping it to the edge of its level.
+ivec2 ClampChild(ivec2 blockOrigin, ivec2 child, ivec2 size)
+{
+	return max(min(blockOrigin + child, size - 1) - blockOrigin, ivec2(0));
+}
+
+vec4 LoadBase(ivec2 texel, ivec2 size, bool fromScratch)
+{
+	texel = min(texel, size - 1);
+	return fromScratch ? scratch.lastTexels[texel.y * gl_NumWorkGroups.x + texel.x] : texelFetch(source, texel, 0);
+}
+
+// Image arrays are only indexed with constants, dynamic indexing of storage images is an optional feature.
+#define STORE_LEVEL(Level) case Level: imageStore(destination[Level - 1], texel, value); break;
+
+void Store(uint level, ivec2 texel, vec4 value)
+{
+	if (level > constants.levelCount || any(greaterThanEqual(texel, LevelSize(level))))
+	{
+		return;
+	}
+	
+	switch (int(level))
+	{
+		STORE_LEVEL(1) STORE_LEVEL(2) STORE_LEVEL(3) STORE_LEVEL(4) STORE_LEVEL(5) STORE_LEVEL(6)
+		STORE_LEVEL(7) STORE_LEVEL(8) STORE_LEVEL(9) STORE_LEVEL(10) STORE_LEVEL(11) STORE_LEVEL(12)
+	}
+}
+
+// Reduces the 64x64 block of level first - 1 at block into levels first to first + count - 1, count
+// at most six. Returns the texel of the last level in thread zero.
+vec4 DownsampleBlock(uint first, uint count, ivec2 block, bool fromScratch)
+{
+	ivec2 thread = ivec2(gl_LocalInvocationIndex % 16, gl_LocalInvocationIndex / 16);
+	ivec2 sourceSize = LevelSize(first - 1);
+	ivec2 size = LevelSize(first);
+	
+	// Every thread reduces a 4x4 footprint of the source into 2x2 texels of the first level, and those into one of the next.
+	ivec2 quadOrigin = block * 32 + thread * 2;
+	vec4 quad[4];
+	for (int i = 0; i < 4; i++)
+	{
+		ivec2 texel = quadOrigin + ivec2(i & 1, i >> 1);
+		ivec2 even = texel * 2;
+		quad[i] = Reduce(LoadBase(even, sourceSize, fromScratch), LoadBase(even + ivec2(1, 0), sourceSize, fromScratch), LoadBase(even + ivec2(0, 1), sourceSize, fromScratch), LoadBase(even + ivec2(1, 1), sourceSize, fromScratch));
+		Store(first, texel, quad[i]);
+	}
+	if (count == 1)
+	{
+		return quad[0];
+	}
+	
+	ivec2 c0 = ClampChild(quadOrigin, ivec2(0, 0), size);
+	ivec2 c1 = ClampChild(quadOrigin, ivec2(1, 0), size);
+	ivec2 c2 = ClampChild(quadOrigin, ivec2(0, 1), size);
+	ivec2 c3 = ClampChild(quadOrigin, ivec2(1, 1), size);
+	vec4 value = Reduce(quad[c0.x + 2 * c0.y], quad[c1.x + 2 * c1.y], quad[c2.x + 2 * c2.y], quad[c3.x + 2 * c3.y]);
+	Store(first + 1, block * 16 + thread, value);
+	texels[thread.y][thread.x] = value;
+	
+	for (uint level = first + 2, width = 8; level < first + count; level++, width /= 2)
+	{
+		barrier();
+		
+		bool bActive = gl_LocalInvocationIndex < width * width;
+		ivec2 local = ivec2(gl_LocalInvocationIndex % width, gl_LocalInvocationIndex / width);
+		if (bActive)
+		{
+			ivec2 childOrigin = block * int(width * 2);
+			ivec2 childSize = LevelSize(level - 1);
+			c0 = ClampChild(childOrigin, local * 2, childSize);
+			c1 = ClampChild(childOrigin, local * 2 + ivec2(1, 0), childSize);
+			c2 = ClampChild(childOrigin, local * 2 + ivec2(0, 1), childSize);
+			c3 = ClampChild(childOrigin, local * 2 + ivec2(1, 1), childSize);
+			value = Reduce(texels[c0.y][c0.x], texels[c1.y][c1.x], texels[c2.y][c2.x], texels[c3.y][c3.x]);
+		}
+		
+		// Every thread has read the previous level before it is overwritten.
+		barrier();
+		
+		if (bActive)
+		{
+			texels[local.y][local.x] = value;
+			Store(level, block * int(width) + local, value);
+		}
+	}
+	return value;
+}
+
+void main()
+{
+	ivec2 block = ivec2(gl_WorkGroupID.xy);
+	vec4 last = DownsampleBlock(1, min(constants.levelCount, DOWNSAMPLE_BLOCK_LEVELS), block, false);
+	if (constants.levelCount <= DOWNSAMPLE_BLOCK_LEVELS)
+	{
+		return;
+	}
+	
+	if (gl_LocalInvocationIndex == 0)
+	{
+		scratch.lastTexels[block.y * gl_NumWorkGroups.x + block.x] = last;
+		memoryBarrierBuffer();
+		uint finished = atomicAdd(scratch.finishedGroups, 1u);
+		isLastGroup = finished == gl_NumWorkGroups.x * gl_NumWorkGroups.y - 1u ? 1u : 0u;
+	}
+	barrier();
+	
+	if (isLastGroup == 0)
+	{
+		return;
+	}
+	
+	// Level six fits in one block, every group's texel of it is visible now that all of them have counted in.
+	memoryBarrierBuffer();
+	DownsampleBlock(DOWNSAMPLE_BLOCK_LEVELS + 1, constants.levelCount - DOWNSAMPLE_BLOCK_LEVELS, ivec2(0), true);
+	if (gl_LocalInvocationIndex == 0)
+	{
+		scratch.finishedGroups = 0u;
+	}
+}
+
+#endif
\ No newline at end of file
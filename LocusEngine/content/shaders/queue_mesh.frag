@@ -0,0 +1,14 @@
+#version 460
+
+layout (location = 0) in vec3 inNormal;
+
+layout (std430, set = 0, binding = 0) readonly buffer Material { vec4 color; } material;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+	vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.3));
+	float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+	outColor = vec4(material.color.rgb * (0.15 + 0.85 * diffuse), material.color.a);
+}
\ No newline at end of file
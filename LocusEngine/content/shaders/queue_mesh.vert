@@ -0,0 +1,21 @@
+#version 460
+
+// Drawn through the render queue, one draw per object with its transform pushed.
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inNormal;
+
+layout (push_constant) uniform Constants
+{
+	mat4 viewProjection;
+	vec4 positionScale;
+} constants;
+
+layout (location = 0) out vec3 outNormal;
+
+void main()
+{
+	vec3 worldPosition = constants.positionScale.xyz + inPosition * constants.positionScale.w;
+	gl_Position = constants.viewProjection * vec4(worldPosition, 1.0);
+	outNormal = inNormal;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 460
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec3 inColor;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+	// Fixed key light plus a little ambient, enough to read the shapes.
+	vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.3));
+	float diffuse = max(dot(normalize(inNormal), lightDirection), 0.0);
+	outColor = vec4(inColor * (0.15 + 0.85 * diffuse), 1.0);
+}
\ No newline at end of file
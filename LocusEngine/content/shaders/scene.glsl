@@ -0,0 +1,48 @@
+// GPU scene layout, see LVKGpuScene.hpp. The std430 structs match the engine's byte for byte.
+// Include from a stage with #extension GL_GOOGLE_include_directive : require.
+
+#ifndef LOCUS_SCENE_GLSL
+#define LOCUS_SCENE_GLSL
+
+struct SceneMesh
+{
+	uint FirstIndex;
+	uint IndexCount; // Zero until the mesh's geometry has been uploaded
+	int VertexOffset;
+	uint Pad;
+	vec4 Bounds; // Object space sphere, centre and radius
+};
+
+struct SceneObject
+{
+	vec4 PositionScale;
+	vec4 Rotation;
+	vec4 Color;
+	uint Mesh;
+	uint Batch;
+	uint Pad0;
+	uint Pad1;
+};
+
+// Float arrays rather than vec3, which std430 would pad to 16 bytes.
+struct SceneVertex
+{
+	float Position[3];
+	float Normal[3];
+};
+
+struct SceneDrawCommand
+{
+	uint IndexCount;
+	uint InstanceCount;
+	uint FirstIndex;
+	int VertexOffset;
+	uint FirstInstance; // The object, instance data is fetched with gl_InstanceIndex
+};
+
+vec3 RotateByQuat(vec4 Q, vec3 V)
+{
+	return V + 2.0 * cross(Q.xyz, cross(Q.xyz, V) + Q.w * V);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "scene.glsl"
+
+// Vertices are pulled from a storage buffer, gl_VertexIndex already includes the mesh's offset.
+
+layout (std430, set = 0, binding = 0) readonly buffer Vertices { SceneVertex vertices[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Objects { SceneObject objects[]; };
+
+layout (push_constant) uniform Constants
+{
+	mat4 viewProjection;
+} constants;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+
+void main()
+{
+	SceneVertex vertex = vertices[gl_VertexIndex];
+	SceneObject object = objects[gl_InstanceIndex];
+	
+	vec3 position = vec3(vertex.Position[0], vertex.Position[1], vertex.Position[2]);
+	vec3 normal = vec3(vertex.Normal[0], vertex.Normal[1], vertex.Normal[2]);
+	
+	vec3 worldPosition = object.PositionScale.xyz + RotateByQuat(object.Rotation, position * object.PositionScale.w);
+	gl_Position = constants.viewProjection * vec4(worldPosition, 1.0);
+	
+	outNormal = RotateByQuat(object.Rotation, normal);
+	outColor = object.Color.rgb;
+}
\ No newline at end of file
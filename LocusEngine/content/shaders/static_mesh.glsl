@@ -0,0 +1,39 @@
+// Static mesh layout, see LVKStaticMeshRenderer.hpp and Graphics/MeshAsset.hpp. The std430 structs
+// match the engine's byte for byte. Include after scene.glsl.
+
+#ifndef LOCUS_STATIC_MESH_GLSL
+#define LOCUS_STATIC_MESH_GLSL
+
+struct StaticMeshInstance
+{
+	vec4 PositionScale;
+	vec4 Rotation;
+	float BoundsMin[3]; // Quantisation box of the instance's mesh
+	uint Color; // RGBA8 unorm
+	float BoundsExtent[3];
+	uint Pad;
+};
+
+struct StaticMeshBatch
+{
+	uint FirstWork;
+	uint FirstInstance;
+	uint FirstMeshlet;
+	uint MeshletCount;
+	uint IndexBase; // In the batch's own index size
+	int VertexOffset;
+	uint Stream;
+	uint Pad;
+};
+
+struct Meshlet
+{
+	vec4 Sphere; // Object space, centre and radius
+	vec4 Cone; // Axis and cutoff, a cutoff of one never culls
+	uint FirstIndex; // From the mesh's first index
+	uint TriangleCount;
+	uint Pad0;
+	uint Pad1;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "scene.glsl"
+#include "static_mesh.glsl"
+
+// Cooked mesh vertices, see Graphics/MeshAsset.hpp. Three words each: position x and y, position z
+// and the normal's x, then the normal's y. gl_VertexIndex already includes the mesh's offset, and
+// each instance carries its mesh's quantisation box since one indirect draw covers every mesh.
+
+layout (std430, set = 0, binding = 0) readonly buffer Vertices { uint words[]; };
+layout (std430, set = 0, binding = 1) readonly buffer Instances { StaticMeshInstance instances[]; };
+
+layout (push_constant) uniform Constants
+{
+	mat4 viewProjection;
+} constants;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+
+vec3 DecodeOctahedral(vec2 E)
+{
+	vec3 N = vec3(E, 1.0 - abs(E.x) - abs(E.y));
+	if (N.z < 0.0)
+	{
+		N.xy = (1.0 - abs(N.yx)) * vec2(N.x >= 0.0 ? 1.0 : -1.0, N.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(N);
+}
+
+void main()
+{
+	uint base = uint(gl_VertexIndex) * 3u;
+	vec2 positionXY = unpackUnorm2x16(words[base]);
+	vec2 positionZNormalX = vec2(unpackUnorm2x16(words[base + 1u]).x, unpackSnorm2x16(words[base + 1u]).y);
+	vec2 normalY = unpackSnorm2x16(words[base + 2u]);
+	
+	StaticMeshInstance instance = instances[gl_InstanceIndex];
+	vec3 boundsMin = vec3(instance.BoundsMin[0], instance.BoundsMin[1], instance.BoundsMin[2]);
+	vec3 boundsExtent = vec3(instance.BoundsExtent[0], instance.BoundsExtent[1], instance.BoundsExtent[2]);
+	vec3 position = boundsMin + vec3(positionXY, positionZNormalX.x) * boundsExtent;
+	vec3 normal = DecodeOctahedral(vec2(positionZNormalX.y, normalY.x));
+	
+	vec3 worldPosition = instance.PositionScale.xyz + RotateByQuat(instance.Rotation, position * instance.PositionScale.w);
+	gl_Position = constants.viewProjection * vec4(worldPosition, 1.0);
+	
+	outNormal = RotateByQuat(instance.Rotation, normal);
+	outColor = unpackUnorm4x8(instance.Color).rgb;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "bindless.glsl"
+
+layout (location = 0) in vec2 inUV;
+
+// Indices into the bindless heap, fetched for the texture every frame since streaming moves its image.
+layout (push_constant) uniform Constants
+{
+	mat4 viewProjection;
+	vec4 positionScale;
+	uint imageIndex;
+	uint samplerIndex;
+} constants;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+	outColor = SampleBindless(constants.imageIndex, constants.samplerIndex, inUV);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 460
+
+// A flat quad facing up, generated from the vertex index so it needs no vertex buffer. Drawn through the render queue.
+
+layout (push_constant) uniform Constants
+{
+	mat4 viewProjection;
+	vec4 positionScale;
+	uint imageIndex;
+	uint samplerIndex;
+} constants;
+
+layout (location = 0) out vec2 outUV;
+
+const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main()
+{
+	vec2 corner = corners[gl_VertexIndex];
+	vec3 worldPosition = constants.positionScale.xyz + vec3(corner.x - 0.5, 0.0, 0.5 - corner.y) * constants.positionScale.w;
+	gl_Position = constants.viewProjection * vec4(worldPosition, 1.0);
+	outUV = corner;
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "../src/Core/Engine.hpp"
 #include "../src/Core/DisplayManager.hpp"
+#include "../src/Core/JobSystem.hpp"
 #include "../src/Core/Time.hpp"
 
 #include "../src/Graphics/GraphicsManager.hpp"
@@ -11,5 +12,6 @@
 #include "../src/Math/Numerics.hpp"
 
 #include "../src/Platform/Platform.hpp"
+#include "../src/Platform/VirtualFileSystem.hpp"
 
 #include "imgui.h"
\ No newline at end of file
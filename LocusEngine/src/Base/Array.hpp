@@ -3,6 +3,7 @@
 #include "Asserts.hpp"
 #include "Defines.hpp"
 
+#include <cstdlib>
 #include <cstring>
 
 namespace Locus
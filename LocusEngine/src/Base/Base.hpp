@@ -2,8 +2,10 @@
 
 #include "Array.hpp"
 #include "Asserts.hpp"
+#include "Compression.hpp"
 #include "Defines.hpp"
 #include "Handles.hpp"
+#include "Hash.hpp"
 #include "Logging.hpp"
 #include "Object.hpp"
 #include "Singleton.hpp"
@@ -0,0 +1,204 @@
+#include "Compression.hpp"
+
+#include <cstring>
+
+namespace Locus::Compression
+{
+	static constexpr arch LZ4_MIN_MATCH = 4;
+	static constexpr arch LZ4_LAST_LITERALS = 5;	// The last 5 bytes are always literals
+	static constexpr arch LZ4_MF_LIMIT = 12;		// A match cannot start within the last 12 bytes
+	static constexpr arch LZ4_MAX_OFFSET = 65535;
+	static constexpr u32 LZ4_HASH_BITS = 12;
+	
+	static inline u32 ReadU32(const u8* Ptr)
+	{
+		u32 Value;
+		memcpy(&Value, Ptr, sizeof(u32));
+		return Value;
+	}
+	
+	static inline u32 HashSequence(u32 Sequence)
+	{
+		return (Sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+	}
+	
+	static inline u8* WriteLength(u8* Op, arch Length)
+	{
+		while (Length >= 255)
+		{
+			*Op++ = 255;
+			Length -= 255;
+		}
+		*Op++ = static_cast<u8>(Length);
+		return Op;
+	}
+	
+	arch LZ4CompressBound(arch SrcSize)
+	{
+		return SrcSize + (SrcSize / 255) + 16;
+	}
+	
+	arch LZ4Compress(const u8* Src, arch SrcSize, u8* Dst, arch DstCapacity)
+	{
+		if (DstCapacity < LZ4CompressBound(SrcSize))
+		{
+			return 0;
+		}
+		
+		u32 HashTable[1 << LZ4_HASH_BITS];
+		memset(HashTable, 0, sizeof(HashTable));
+		
+		const u8* Ip = Src;
+		const u8* Anchor = Src;
+		const u8* const End = Src + SrcSize;
+		const u8* const MatchLimit = End - LZ4_LAST_LITERALS;
+		u8* Op = Dst;
+		
+		if (SrcSize >= LZ4_MF_LIMIT + 1)
+		{
+			const u8* const SearchLimit = End - LZ4_MF_LIMIT;
+			
+			// Position 0 is stored in the table as 0, so skip it to keep 0 meaning "empty".
+			Ip++;
+			while (Ip < SearchLimit)
+			{
+				u32 Sequence = ReadU32(Ip);
+				u32 Slot = HashSequence(Sequence);
+				const u8* Candidate = Src + HashTable[Slot];
+				HashTable[Slot] = static_cast<u32>(Ip - Src);
+				
+				if (Candidate == Src || static_cast<arch>(Ip - Candidate) > LZ4_MAX_OFFSET || ReadU32(Candidate) != Sequence)
+				{
+					Ip++;
+					continue;
+				}
+				
+				// Extend the match backwards over pending literals
+				while (Ip > Anchor && Candidate > Src && Ip[-1] == Candidate[-1])
+				{
+					Ip--;
+					Candidate--;
+				}
+				
+				// Extend the match forwards
+				const u8* MatchEnd = Ip + LZ4_MIN_MATCH;
+				const u8* CandidateEnd = Candidate + LZ4_MIN_MATCH;
+				while (MatchEnd < MatchLimit && *MatchEnd == *CandidateEnd)
+				{
+					MatchEnd++;
+					CandidateEnd++;
+				}
+				
+				arch LiteralLength = Ip - Anchor;
+				arch MatchLength = (MatchEnd - Ip) - LZ4_MIN_MATCH;
+				u16 Offset = static_cast<u16>(Ip - Candidate);
+				
+				u8* Token = Op++;
+				*Token = static_cast<u8>(((LiteralLength >= 15 ? 15 : LiteralLength) << 4) | (MatchLength >= 15 ? 15 : MatchLength));
+				if (LiteralLength >= 15)
+				{
+					Op = WriteLength(Op, LiteralLength - 15);
+				}
+				memcpy(Op, Anchor, LiteralLength);
+				Op += LiteralLength;
+				
+				*Op++ = static_cast<u8>(Offset & 0xFF);
+				*Op++ = static_cast<u8>(Offset >> 8);
+				if (MatchLength >= 15)
+				{
+					Op = WriteLength(Op, MatchLength - 15);
+				}
+				
+				Ip = MatchEnd;
+				Anchor = Ip;
+			}
+		}
+		
+		// Final literal run
+		arch LiteralLength = End - Anchor;
+		*Op++ = static_cast<u8>((LiteralLength >= 15 ? 15 : LiteralLength) << 4);
+		if (LiteralLength >= 15)
+		{
+			Op = WriteLength(Op, LiteralLength - 15);
+		}
+		memcpy(Op, Anchor, LiteralLength);
+		Op += LiteralLength;
+		
+		return Op - Dst;
+	}
+	
+	bool LZ4Decompress(const u8* Src, arch SrcSize, u8* Dst, arch DstSize)
+	{
+		const u8* Ip = Src;
+		const u8* const IpEnd = Src + SrcSize;
+		u8* Op = Dst;
+		u8* const OpEnd = Dst + DstSize;
+		
+		while (Ip < IpEnd)
+		{
+			u8 Token = *Ip++;
+			
+			arch LiteralLength = Token >> 4;
+			if (LiteralLength == 15)
+			{
+				u8 Byte;
+				do
+				{
+					if (Ip >= IpEnd) return false;
+					Byte = *Ip++;
+					LiteralLength += Byte;
+				} while (Byte == 255);
+			}
+			
+			if (LiteralLength > static_cast<arch>(IpEnd - Ip) || LiteralLength > static_cast<arch>(OpEnd - Op))
+			{
+				return false;
+			}
+			memcpy(Op, Ip, LiteralLength);
+			Ip += LiteralLength;
+			Op += LiteralLength;
+			
+			// The last sequence has no match part
+			if (Ip == IpEnd)
+			{
+				break;
+			}
+			
+			if (IpEnd - Ip < 2) return false;
+			arch Offset = Ip[0] | (Ip[1] << 8);
+			Ip += 2;
+			if (Offset == 0 || Offset > static_cast<arch>(Op - Dst))
+			{
+				return false;
+			}
+			
+			arch MatchLength = Token & 15;
+			if (MatchLength == 15)
+			{
+				u8 Byte;
+				do
+				{
+					if (Ip >= IpEnd) return false;
+					Byte = *Ip++;
+					MatchLength += Byte;
+				} while (Byte == 255);
+			}
+			MatchLength += LZ4_MIN_MATCH;
+			
+			if (MatchLength > static_cast<arch>(OpEnd - Op))
+			{
+				return false;
+			}
+			
+			// Matches may overlap their own output, so copy bytewise
+			const u8* Match = Op - Offset;
+			for (arch i = 0; i < MatchLength; i++)
+			{
+				Op[i] = Match[i];
+			}
+			Op += MatchLength;
+		}
+		
+		return Op == OpEnd;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Defines.hpp"
+
+/*
+	Minimal LZ4 block format codec (no frame format, no dictionaries).
+	Output is compatible with LZ4_decompress_safe from the reference library.
+*/
+
+namespace Locus::Compression
+{
+	arch LZ4CompressBound(arch SrcSize);
+	
+	// Returns the number of bytes written to Dst, or 0 if Dst was too small.
+	arch LZ4Compress(const u8* Src, arch SrcSize, u8* Dst, arch DstCapacity);
+	
+	// Returns false if the stream is malformed or does not decode to exactly DstSize bytes.
+	bool LZ4Decompress(const u8* Src, arch SrcSize, u8* Dst, arch DstSize);
+}
\ No newline at end of file
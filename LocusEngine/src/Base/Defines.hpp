@@ -67,4 +67,9 @@ namespace Locus
 };
 
 
-#define LAPI // for DLL symbol exports, currently nothing because we are developing on MacOS
\ No newline at end of file
+#define LAPI // for DLL symbol exports, currently nothing because we are developing on MacOS
+
+// Development builds favour iteration (loose content files, hot reload) over shipping behaviour.
+#if !defined(LOCUS_DEVELOPMENT)
+	#define LOCUS_DEVELOPMENT 1
+#endif
\ No newline at end of file
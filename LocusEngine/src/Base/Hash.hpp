@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Defines.hpp"
+
+namespace Locus::Hash
+{
+	constexpr u64 FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+	constexpr u64 FNV1A_PRIME = 0x100000001b3ull;
+	
+	// FNV-1a, pass a previous result as the seed to hash discontiguous data.
+	
+	inline u64 FNV1a64(const void* Data, arch Size, u64 Seed = FNV1A_OFFSET_BASIS)
+	{
+		const u8* Bytes = static_cast<const u8*>(Data);
+		u64 Hash = Seed;
+		for (arch i = 0; i < Size; i++)
+		{
+			Hash ^= Bytes[i];
+			Hash *= FNV1A_PRIME;
+		}
+		return Hash;
+	}
+	
+	inline u64 FNV1a64String(const char* String, u64 Seed = FNV1A_OFFSET_BASIS)
+	{
+		u64 Hash = Seed;
+		while (*String)
+		{
+			Hash ^= static_cast<u8>(*String++);
+			Hash *= FNV1A_PRIME;
+		}
+		return Hash;
+	}
+	
+	template<typename T>
+	inline u64 FNV1a64Value(const T& Value, u64 Seed = FNV1A_OFFSET_BASIS)
+	{
+		return FNV1a64(&Value, sizeof(T), Seed);
+	}
+	
+	inline u64 Combine(u64 Hash, u64 Value)
+	{
+		return Hash ^ (Value + 0x9e3779b97f4a7c15ull + (Hash << 6) + (Hash >> 2));
+	}
+}
\ No newline at end of file
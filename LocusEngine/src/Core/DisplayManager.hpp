@@ -13,7 +13,8 @@ namespace Locus
 	class DisplayManager : public Object, public Singleton<DisplayManager>
 	{
 	public:
-		virtual WindowHandle CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext = true) = 0;
+		// Hidden windows still get a swapchain, for running the renderer without showing anything.
+		virtual WindowHandle CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext = true, bool bHidden = false) = 0;
 		virtual void DestroyWindow(WindowHandle Window) = 0;
 		
 		virtual void* GetNativeWindowHandle(WindowHandle Window) = 0;
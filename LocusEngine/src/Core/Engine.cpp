@@ -3,13 +3,23 @@
 #include "Core/DisplayManager.hpp"
 #include "Platform/LSDL/LSDLDisplayManager.hpp"
 #include "Platform/LVK/LVKGraphicsManager.hpp"
+#include "Platform/VirtualFileSystem.hpp"
 
 namespace Locus
 {
 	static Engine gEngine;
 	
+	static const char* CONTENT_DIRECTORY = LOCUS_CONTENT_DIR;
+	static const char* CONTENT_PACK = LOCUS_CONTENT_PACK;
+	
 	void Engine::Init()
 	{
+		m_FileSystem = new VirtualFileSystem();
+		m_FileSystem->MountPack(CONTENT_PACK);
+		m_FileSystem->MountDirectory(CONTENT_DIRECTORY);
+		
+		m_JobSystem = new JobSystem();
+		
 		m_DisplayManager = new LSDLDisplayManager();
 		m_GraphicsManager = new LVKGraphicsManager();
 	}
@@ -18,5 +28,7 @@ namespace Locus
 	{
 		delete m_GraphicsManager;
 		delete m_DisplayManager;
+		delete m_JobSystem;
+		delete m_FileSystem;
 	}
 }
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include "Base/Base.hpp"
 
 #include "Core/DisplayManager.hpp"
+#include "Core/JobSystem.hpp"
 #include "Graphics/GraphicsManager.hpp"
+#include "Platform/VirtualFileSystem.hpp"
 
 namespace Locus
 {
@@ -14,6 +16,8 @@ namespace Locus
 		void Shutdown();
 	
 	private:
+		VirtualFileSystem* m_FileSystem;
+		JobSystem* m_JobSystem;
 		DisplayManager* m_DisplayManager;
 		GraphicsManager* m_GraphicsManager;
 		
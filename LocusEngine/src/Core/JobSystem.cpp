@@ -0,0 +1,139 @@
+#include "JobSystem.hpp"
+
+#include "Math/Numerics.hpp"
+
+namespace Locus
+{
+	JobSystem::JobSystem(u32 WorkerCount)
+	{
+		if (WorkerCount == 0)
+		{
+			// Leave a core for the main thread.
+			u32 HardwareThreads = std::thread::hardware_concurrency();
+			WorkerCount = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+		}
+		
+		for (u32 i = 0; i < WorkerCount; i++)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerMain, this);
+		}
+	}
+	
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_bShuttingDown = true;
+		}
+		m_JobAvailable.notify_all();
+		
+		for (std::thread& Worker : m_Workers)
+		{
+			Worker.join();
+		}
+	}
+	
+	void JobSystem::Submit(JobFunction&& Job)
+	{
+		m_JobsInFlight++;
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_Jobs.push_back(std::move(Job));
+		}
+		m_JobAvailable.notify_one();
+	}
+	
+	void JobSystem::ParallelFor(u32 Count, u32 BatchSize, const std::function<void(u32, u32)>& Function)
+	{
+		if (Count == 0)
+		{
+			return;
+		}
+		
+		BatchSize = Math::Max(BatchSize, 1u);
+		u32 BatchCount = (Count + BatchSize - 1) / BatchSize;
+		if (BatchCount == 1)
+		{
+			Function(0, Count);
+			return;
+		}
+		
+		std::atomic<u32> Remaining {BatchCount};
+		for (u32 Batch = 1; Batch < BatchCount; Batch++)
+		{
+			u32 Begin = Batch * BatchSize;
+			u32 End = Math::Min(Begin + BatchSize, Count);
+			Submit([&Function, &Remaining, Begin, End]() {
+				Function(Begin, End);
+				Remaining--;
+			});
+		}
+		
+		Function(0, Math::Min(BatchSize, Count));
+		Remaining--;
+		
+		// Help out instead of sleeping while our batches are pending.
+		while (Remaining.load() > 0)
+		{
+			if (!RunOneJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+	
+	void JobSystem::WaitIdle()
+	{
+		std::unique_lock<std::mutex> Lock(m_Mutex);
+		m_JobFinished.wait(Lock, [this]() { return m_JobsInFlight.load() == 0; });
+	}
+	
+	bool JobSystem::RunOneJob()
+	{
+		JobFunction Job;
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			if (m_Jobs.empty())
+			{
+				return false;
+			}
+			Job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+		
+		Job();
+		
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_JobsInFlight--;
+		}
+		m_JobFinished.notify_all();
+		return true;
+	}
+	
+	void JobSystem::WorkerMain()
+	{
+		while (true)
+		{
+			JobFunction Job;
+			{
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				m_JobAvailable.wait(Lock, [this]() { return m_bShuttingDown || !m_Jobs.empty(); });
+				if (m_bShuttingDown && m_Jobs.empty())
+				{
+					return;
+				}
+				Job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+			
+			Job();
+			
+			{
+				std::lock_guard<std::mutex> Lock(m_Mutex);
+				m_JobsInFlight--;
+			}
+			m_JobFinished.notify_all();
+		}
+	}
+}
\ No newline at end of file
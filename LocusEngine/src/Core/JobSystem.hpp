@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	A small pool of worker threads for fire-and-forget background work.
+	Jobs must not touch the graphics queue or any per-frame state directly,
+	results should be handed back to the main thread and applied at a frame boundary.
+*/
+
+namespace Locus
+{
+	using JobFunction = std::function<void()>;
+	
+	class JobSystem : public Singleton<JobSystem>
+	{
+	public:
+		JobSystem(u32 WorkerCount = 0);
+		~JobSystem();
+		
+		void Submit(JobFunction&& Job);
+		
+		// Runs Function(Begin, End) over [0, Count) in batches, blocking until all batches finish.
+		// The calling thread participates so this is safe to use from a worker.
+		void ParallelFor(u32 Count, u32 BatchSize, const std::function<void(u32, u32)>& Function);
+		
+		void WaitIdle();
+		u32 GetWorkerCount() const { return static_cast<u32>(m_Workers.size()); }
+	
+	private:
+		void WorkerMain();
+		bool RunOneJob();
+		
+		std::vector<std::thread> m_Workers;
+		std::deque<JobFunction> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_JobAvailable;
+		std::condition_variable m_JobFinished;
+		std::atomic<u32> m_JobsInFlight {0};
+		bool m_bShuttingDown = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "OffsetAllocator.hpp"
+#include "Base/Asserts.hpp"
+#include "Math/Numerics.hpp"
+
+#include <algorithm>
+
+namespace Locus
+{
+	static constexpr u32 MANTISSA_BITS = 3;
+	static constexpr u32 MANTISSA_VALUE = 1 << MANTISSA_BITS;
+	static constexpr u32 MANTISSA_MASK = MANTISSA_VALUE - 1;
+	
+	// Sizes as 5.3 floats, exact below 8 and rounded above. Bin indices are these values.
+	
+	static u32 SizeToBinRoundUp(u32 Size)
+	{
+		if (Size < MANTISSA_VALUE)
+		{
+			return Size;
+		}
+		
+		u32 MantissaShift = (31 - Math::CountLeadingZeros(Size)) - MANTISSA_BITS;
+		u32 Exponent = MantissaShift + 1;
+		u32 Mantissa = (Size >> MantissaShift) & MANTISSA_MASK;
+		
+		// Anything below the mantissa rounds up, overflowing into the exponent is still correct.
+		u32 LowBits = (1u << MantissaShift) - 1;
+		if ((Size & LowBits) != 0)
+		{
+			Mantissa++;
+		}
+		return (Exponent << MANTISSA_BITS) + Mantissa;
+	}
+	
+	static u32 SizeToBinRoundDown(u32 Size)
+	{
+		if (Size < MANTISSA_VALUE)
+		{
+			return Size;
+		}
+		
+		u32 MantissaShift = (31 - Math::CountLeadingZeros(Size)) - MANTISSA_BITS;
+		u32 Exponent = MantissaShift + 1;
+		u32 Mantissa = (Size >> MantissaShift) & MANTISSA_MASK;
+		return (Exponent << MANTISSA_BITS) | Mantissa;
+	}
+	
+	static u32 LowestBitFrom(u32 Mask, u32 StartBit)
+	{
+		u32 Masked = StartBit >= 32 ? 0 : Mask & ~((1u << StartBit) - 1);
+		return Masked == 0 ? OFFSET_ALLOCATION_NONE : Math::CountTrailingZeros(Masked);
+	}
+	
+	OffsetAllocator::OffsetAllocator(u32 Size, u32 MaxAllocations) : m_Size(Size), m_MaxAllocations(MaxAllocations)
+	{
+		LAssert(Size > 0 && MaxAllocations > 0);
+		Reset();
+	}
+	
+	void OffsetAllocator::Reset()
+	{
+		m_FreeStorage = 0;
+		m_FreeRegions = 0;
+		m_UsedTopBins = 0;
+		for (u8& Leaves : m_UsedLeafBins)
+		{
+			Leaves = 0;
+		}
+		for (u32& Head : m_BinHeads)
+		{
+			Head = OFFSET_ALLOCATION_NONE;
+		}
+		
+		// One node more than allocations, n allocations can leave n + 1 free regions between them.
+		m_Nodes.assign(m_MaxAllocations + 1, {});
+		m_FreeNodes.resize(m_MaxAllocations + 1);
+		for (u32 i = 0; i < m_FreeNodes.size(); i++)
+		{
+			m_FreeNodes[i] = static_cast<u32>(m_FreeNodes.size()) - 1 - i;
+		}
+		
+		InsertFreeRegion(m_Size, 0);
+	}
+	
+	OffsetAllocation OffsetAllocator::Allocate(u32 Size)
+	{
+		LAssert(Size > 0);
+		if (m_FreeNodes.empty())
+		{
+			return {};
+		}
+		
+		// Every region in the rounded up bin fits, smaller bins may not.
+		u32 MinBin = SizeToBinRoundUp(Size);
+		u32 MinTop = MinBin >> MANTISSA_BITS;
+		u32 MinLeaf = MinBin & MANTISSA_MASK;
+		
+		u32 Top = MinTop;
+		u32 Leaf = OFFSET_ALLOCATION_NONE;
+		if (Top < TOP_BINS && (m_UsedTopBins & (1u << Top)) != 0)
+		{
+			Leaf = LowestBitFrom(m_UsedLeafBins[Top], MinLeaf);
+		}
+		
+		if (Leaf == OFFSET_ALLOCATION_NONE)
+		{
+			Top = LowestBitFrom(m_UsedTopBins, MinTop + 1);
+			if (Top == OFFSET_ALLOCATION_NONE)
+			{
+				return {};
+			}
+			Leaf = Math::CountTrailingZeros(m_UsedLeafBins[Top]);
+		}
+		
+		u32 NodeIndex = m_BinHeads[(Top << MANTISSA_BITS) | Leaf];
+		Node& Taken = m_Nodes[NodeIndex];
+		u32 RegionSize = Taken.Size;
+		u32 RegionOffset = Taken.Offset;
+		
+		RemoveFreeRegion(NodeIndex);
+		m_FreeNodes.pop_back(); // RemoveFreeRegion returned it, but it stays as the allocation
+		
+		Node& Allocated = m_Nodes[NodeIndex];
+		Allocated.Size = Size;
+		Allocated.bUsed = true;
+		
+		// The tail goes back as a free region between this and the next neighbour.
+		if (RegionSize > Size)
+		{
+			u32 Tail = InsertFreeRegion(RegionSize - Size, RegionOffset + Size);
+			Node& Head = m_Nodes[NodeIndex];
+			if (Head.NeighbourNext != OFFSET_ALLOCATION_NONE)
+			{
+				m_Nodes[Head.NeighbourNext].NeighbourPrev = Tail;
+			}
+			m_Nodes[Tail].NeighbourPrev = NodeIndex;
+			m_Nodes[Tail].NeighbourNext = Head.NeighbourNext;
+			Head.NeighbourNext = Tail;
+		}
+		
+		return { RegionOffset, NodeIndex };
+	}
+	
+	void OffsetAllocator::Free(OffsetAllocation Allocation)
+	{
+		LAssert(Allocation.Node < m_Nodes.size() && m_Nodes[Allocation.Node].bUsed);
+		
+		Node& Freed = m_Nodes[Allocation.Node];
+		u32 Offset = Freed.Offset;
+		u32 Size = Freed.Size;
+		u32 NeighbourPrev = Freed.NeighbourPrev;
+		u32 NeighbourNext = Freed.NeighbourNext;
+		
+		// Merge with free neighbours, so free regions are never adjacent.
+		if (NeighbourPrev != OFFSET_ALLOCATION_NONE && !m_Nodes[NeighbourPrev].bUsed)
+		{
+			const Node& Prev = m_Nodes[NeighbourPrev];
+			Offset = Prev.Offset;
+			Size += Prev.Size;
+			u32 Merged = NeighbourPrev;
+			NeighbourPrev = Prev.NeighbourPrev;
+			RemoveFreeRegion(Merged);
+		}
+		
+		if (NeighbourNext != OFFSET_ALLOCATION_NONE && !m_Nodes[NeighbourNext].bUsed)
+		{
+			const Node& Next = m_Nodes[NeighbourNext];
+			Size += Next.Size;
+			u32 Merged = NeighbourNext;
+			NeighbourNext = Next.NeighbourNext;
+			RemoveFreeRegion(Merged);
+		}
+		
+		Freed.bUsed = false;
+		m_FreeNodes.push_back(Allocation.Node);
+		
+		u32 Combined = InsertFreeRegion(Size, Offset);
+		m_Nodes[Combined].NeighbourPrev = NeighbourPrev;
+		m_Nodes[Combined].NeighbourNext = NeighbourNext;
+		if (NeighbourPrev != OFFSET_ALLOCATION_NONE)
+		{
+			m_Nodes[NeighbourPrev].NeighbourNext = Combined;
+		}
+		if (NeighbourNext != OFFSET_ALLOCATION_NONE)
+		{
+			m_Nodes[NeighbourNext].NeighbourPrev = Combined;
+		}
+	}
+	
+	u32 OffsetAllocator::GetAllocationSize(OffsetAllocation Allocation) const
+	{
+		LAssert(Allocation.Node < m_Nodes.size() && m_Nodes[Allocation.Node].bUsed);
+		return m_Nodes[Allocation.Node].Size;
+	}
+	
+	OffsetAllocatorReport OffsetAllocator::GetReport() const
+	{
+		OffsetAllocatorReport Report = {
+			.TotalFree = m_FreeStorage,
+			.LargestFree = 0,
+			.FreeRegions = m_FreeRegions,
+		};
+		
+		// The highest used bin holds the largest region, its list is short in practice.
+		if (m_UsedTopBins != 0)
+		{
+			u32 Top = 31 - Math::CountLeadingZeros(m_UsedTopBins);
+			u32 Leaf = 31 - Math::CountLeadingZeros(m_UsedLeafBins[Top]);
+			for (u32 NodeIndex = m_BinHeads[(Top << MANTISSA_BITS) | Leaf]; NodeIndex != OFFSET_ALLOCATION_NONE; NodeIndex = m_Nodes[NodeIndex].BinNext)
+			{
+				Report.LargestFree = std::max(Report.LargestFree, m_Nodes[NodeIndex].Size);
+			}
+		}
+		return Report;
+	}
+	
+	u32 OffsetAllocator::InsertFreeRegion(u32 Size, u32 Offset)
+	{
+		LAssert(!m_FreeNodes.empty());
+		
+		u32 Bin = SizeToBinRoundDown(Size);
+		u32 Top = Bin >> MANTISSA_BITS;
+		u32 Leaf = Bin & MANTISSA_MASK;
+		m_UsedTopBins |= 1u << Top;
+		m_UsedLeafBins[Top] |= static_cast<u8>(1u << Leaf);
+		
+		u32 NodeIndex = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+		
+		u32 Head = m_BinHeads[Bin];
+		m_Nodes[NodeIndex] = {
+			.Offset = Offset,
+			.Size = Size,
+			.BinPrev = OFFSET_ALLOCATION_NONE,
+			.BinNext = Head,
+			.NeighbourPrev = OFFSET_ALLOCATION_NONE,
+			.NeighbourNext = OFFSET_ALLOCATION_NONE,
+			.bUsed = false,
+		};
+		if (Head != OFFSET_ALLOCATION_NONE)
+		{
+			m_Nodes[Head].BinPrev = NodeIndex;
+		}
+		m_BinHeads[Bin] = NodeIndex;
+		
+		m_FreeStorage += Size;
+		m_FreeRegions++;
+		return NodeIndex;
+	}
+	
+	void OffsetAllocator::RemoveFreeRegion(u32 NodeIndex)
+	{
+		const Node& Region = m_Nodes[NodeIndex];
+		if (Region.BinPrev != OFFSET_ALLOCATION_NONE)
+		{
+			m_Nodes[Region.BinPrev].BinNext = Region.BinNext;
+			if (Region.BinNext != OFFSET_ALLOCATION_NONE)
+			{
+				m_Nodes[Region.BinNext].BinPrev = Region.BinPrev;
+			}
+		}
+		else
+		{
+			// Head of its bin, the bin's bits clear once it empties.
+			u32 Bin = SizeToBinRoundDown(Region.Size);
+			u32 Top = Bin >> MANTISSA_BITS;
+			u32 Leaf = Bin & MANTISSA_MASK;
+			
+			m_BinHeads[Bin] = Region.BinNext;
+			if (Region.BinNext != OFFSET_ALLOCATION_NONE)
+			{
+				m_Nodes[Region.BinNext].BinPrev = OFFSET_ALLOCATION_NONE;
+			}
+			else
+			{
+				m_UsedLeafBins[Top] &= static_cast<u8>(~(1u << Leaf));
+				if (m_UsedLeafBins[Top] == 0)
+				{
+					m_UsedTopBins &= ~(1u << Top);
+				}
+			}
+		}
+		
+		m_FreeNodes.push_back(NodeIndex);
+		m_FreeStorage -= Region.Size;
+		m_FreeRegions--;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <vector>
+
+/*
+	Two-level segregated fit allocator over an abstract range, for carving suballocations out of a
+	larger resource such as a GPU buffer. It only hands out offsets and never touches the memory.
+	
+	Free regions are kept in 256 bins whose sizes step like a float with a 3-bit mantissa, so a bin
+	is at most 12.5% wider than its smallest region. Two levels of bitmasks find the first bin that
+	can hold a request in a couple of bit scans. Allocating takes a region from that bin and returns
+	the tail to a smaller one, freeing merges with free neighbours, both in constant time.
+	
+	Regions in a bin may be smaller than the request rounded up, so requests are matched against
+	the next bin up. That wastes at most the bin's width and never needs a search.
+*/
+
+namespace Locus
+{
+	constexpr u32 OFFSET_ALLOCATION_NONE = 0xFFFFFFFF;
+	
+	struct OffsetAllocation
+	{
+		u32 Offset = OFFSET_ALLOCATION_NONE;
+		u32 Node = OFFSET_ALLOCATION_NONE; // Internal, identifies the allocation when freed
+		
+		bool IsValid() const { return Offset != OFFSET_ALLOCATION_NONE; }
+	};
+	
+	struct OffsetAllocatorReport
+	{
+		u32 TotalFree = 0;
+		u32 LargestFree = 0;
+		u32 FreeRegions = 0;
+		
+		// Zero when all free space is one region, tending to one as it splinters.
+		f32 GetFragmentation() const { return TotalFree == 0 ? 0.0f : 1.0f - static_cast<f32>(LargestFree) / static_cast<f32>(TotalFree); }
+	};
+	
+	class OffsetAllocator
+	{
+	public:
+		// Every allocation and every free region between them takes a node, so MaxAllocations bounds both.
+		OffsetAllocator(u32 Size, u32 MaxAllocations = 64 * 1024);
+		
+		void Reset(); // Frees everything
+		
+		OffsetAllocation Allocate(u32 Size); // Invalid if no free region is large enough or out of nodes
+		void Free(OffsetAllocation Allocation);
+		
+		u32 GetSize() const { return m_Size; }
+		u32 GetAllocationSize(OffsetAllocation Allocation) const;
+		OffsetAllocatorReport GetReport() const;
+	
+	private:
+		static constexpr u32 TOP_BINS = 32;
+		static constexpr u32 LEAF_BINS = 8;
+		
+		struct Node
+		{
+			u32 Offset;
+			u32 Size;
+			u32 BinPrev; // Free list of the bin
+			u32 BinNext;
+			u32 NeighbourPrev; // Adjacent regions, in address order
+			u32 NeighbourNext;
+			bool bUsed;
+		};
+		
+		u32 InsertFreeRegion(u32 Size, u32 Offset);
+		void RemoveFreeRegion(u32 NodeIndex);
+		
+		u32 m_Size;
+		u32 m_MaxAllocations;
+		u32 m_FreeStorage = 0;
+		u32 m_FreeRegions = 0;
+		
+		u32 m_UsedTopBins = 0;
+		u8 m_UsedLeafBins[TOP_BINS] = {};
+		u32 m_BinHeads[TOP_BINS * LEAF_BINS];
+		
+		std::vector<Node> m_Nodes;
+		std::vector<u32> m_FreeNodes; // Stack of unused node indices
+	};
+}
\ No newline at end of file
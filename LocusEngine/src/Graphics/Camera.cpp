@@ -0,0 +1,75 @@
+#include "Camera.hpp"
+
+#include <cmath>
+
+namespace Locus
+{
+	void Camera::GetViewProjection(f32 AspectRatio, f32 OutMatrix[16]) const
+	{
+		f32 CosYaw = cosf(Yaw);
+		f32 SinYaw = sinf(Yaw);
+		f32 CosPitch = cosf(Pitch);
+		f32 SinPitch = sinf(Pitch);
+		
+		f32 Forward[3] = { -SinYaw * CosPitch, SinPitch, -CosYaw * CosPitch };
+		f32 Right[3] = { CosYaw, 0.0f, -SinYaw };
+		f32 Up[3] = {
+			Right[1] * Forward[2] - Right[2] * Forward[1],
+			Right[2] * Forward[0] - Right[0] * Forward[2],
+			Right[0] * Forward[1] - Right[1] * Forward[0],
+		};
+		
+		auto Dot = [this](const f32 Axis[3]) { return Axis[0] * Position[0] + Axis[1] * Position[1] + Axis[2] * Position[2]; };
+		
+		// Rows of the view matrix, the camera looks down its own -Z.
+		f32 View[3][4] = {
+			{ Right[0], Right[1], Right[2], -Dot(Right) },
+			{ Up[0], Up[1], Up[2], -Dot(Up) },
+			{ -Forward[0], -Forward[1], -Forward[2], Dot(Forward) },
+		};
+		
+		// The projection only scales x and y, puts the near plane in z and -z_view in w, so the
+		// product is written out row by row rather than multiplied.
+		f32 FocalLength = 1.0f / tanf(VerticalFov * 0.5f);
+		f32 Rows[4][4] = {};
+		for (u32 Column = 0; Column < 4; Column++)
+		{
+			Rows[0][Column] = View[0][Column] * FocalLength / AspectRatio;
+			Rows[1][Column] = View[1][Column] * -FocalLength;
+			Rows[3][Column] = -View[2][Column];
+		}
+		Rows[2][3] = Near;
+		
+		for (u32 Row = 0; Row < 4; Row++)
+		{
+			for (u32 Column = 0; Column < 4; Column++)
+			{
+				OutMatrix[Column * 4 + Row] = Rows[Row][Column];
+			}
+		}
+	}
+	
+	void ExtractFrustumPlanes(const f32 ViewProjection[16], f32 OutPlanes[FRUSTUM_PLANE_COUNT][4])
+	{
+		auto Row = [ViewProjection](u32 Index, u32 Column) { return ViewProjection[Column * 4 + Index]; };
+		
+		// -w <= x, y <= w and z <= w in clip space. With an infinite far plane z >= 0 always holds.
+		for (u32 Column = 0; Column < 4; Column++)
+		{
+			OutPlanes[0][Column] = Row(3, Column) + Row(0, Column);
+			OutPlanes[1][Column] = Row(3, Column) - Row(0, Column);
+			OutPlanes[2][Column] = Row(3, Column) + Row(1, Column);
+			OutPlanes[3][Column] = Row(3, Column) - Row(1, Column);
+			OutPlanes[4][Column] = Row(3, Column) - Row(2, Column);
+		}
+		
+		for (u32 Plane = 0; Plane < FRUSTUM_PLANE_COUNT; Plane++)
+		{
+			f32 Length = sqrtf(OutPlanes[Plane][0] * OutPlanes[Plane][0] + OutPlanes[Plane][1] * OutPlanes[Plane][1] + OutPlanes[Plane][2] * OutPlanes[Plane][2]);
+			for (u32 Column = 0; Column < 4; Column++)
+			{
+				OutPlanes[Plane][Column] /= Length;
+			}
+		}
+	}
+}
\ No newline at end of file
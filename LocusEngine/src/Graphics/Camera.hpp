@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+/*
+	Perspective camera for the GPU scene.
+	
+	Y is up and the camera looks down -Z at zero yaw and pitch. The projection uses reverse Z with
+	an infinite far plane, so depth is 1 at the near plane and tends to 0 at infinity, which keeps
+	precision even far away. Matrices are column-major, ready for GLSL, and map to Vulkan clip
+	space (Y down, depth 0 to 1).
+*/
+
+namespace Locus
+{
+	struct Camera
+	{
+		f32 Position[3] = { 0.0f, 0.0f, 0.0f };
+		f32 Yaw = 0.0f; // Radians about +Y
+		f32 Pitch = 0.0f; // Radians, positive looks up
+		f32 VerticalFov = 1.0f; // Radians
+		f32 Near = 0.1f;
+		
+		void GetViewProjection(f32 AspectRatio, f32 OutMatrix[16]) const;
+	};
+	
+	// Left, right, bottom, top and near, normalised and facing inwards. The far plane is at infinity.
+	constexpr u32 FRUSTUM_PLANE_COUNT = 5;
+	void ExtractFrustumPlanes(const f32 ViewProjection[16], f32 OutPlanes[FRUSTUM_PLANE_COUNT][4]);
+}
\ No newline at end of file
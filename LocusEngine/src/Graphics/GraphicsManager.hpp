@@ -3,17 +3,241 @@
 #include "Base/Base.hpp"
 #include "Base/Handles.hpp"
 #include "Core/DisplayManager.hpp"
+#include "Graphics/Camera.hpp"
+#include "Graphics/RenderQueue.hpp"
+#include "Graphics/RenderScaleController.hpp"
 #include "imgui.h"
 
 namespace Locus
 {
+	using ComputePipelineHandle = HandleType;
+	using GraphicsBufferHandle = HandleType;
+	using MeshHandle = HandleType;
+	using SceneObjectHandle = HandleType;
+	using GraphicsPipelineHandle = HandleType;
+	using MaterialHandle = HandleType;
+	using StaticMeshHandle = HandleType;
+	using TextureHandle = HandleType;
+	
+	struct MeshVertex
+	{
+		f32 Position[3];
+		f32 Normal[3];
+	};
+	
+	struct SceneTransform
+	{
+		f32 Position[3] = { 0.0f, 0.0f, 0.0f };
+		f32 Scale = 1.0f; // Uniform, so bounding spheres stay spheres
+		f32 Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // Quaternion, xyzw
+	};
+	
+	struct SceneObjectDesc
+	{
+		MeshHandle Mesh = HANDLE_INVALID;
+		SceneTransform Transform;
+		f32 Color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	};
+	
+	struct StaticMeshInstance
+	{
+		SceneTransform Transform;
+		f32 Color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	};
+	
+	// What a compute pass binds, resolved against the frame being recorded.
+	enum class ComputeResource : u32
+	{
+		SceneColor, // Storage image, the HDR target the scene renders into, see GetSceneExtent
+		Buffer, // Storage buffer
+	};
+	
+	enum class ComputeAccess : u32
+	{
+		Read,
+		Write, // Overwrites everything the pass covers, earlier contents are discarded
+		ReadWrite,
+	};
+	
+	struct ComputeBinding
+	{
+		u32 Binding = 0; // In set 0
+		ComputeResource Resource = ComputeResource::SceneColor;
+		GraphicsBufferHandle Buffer = HANDLE_INVALID;
+		ComputeAccess Access = ComputeAccess::Read;
+	};
+	
+	struct ComputePass
+	{
+		const char* Name = "Compute";
+		ComputePipelineHandle Pipeline = HANDLE_INVALID;
+		const ComputeBinding* Bindings = nullptr;
+		u32 BindingCount = 0;
+		const void* PushConstants = nullptr; // Copied when the pass is recorded
+		u32 PushConstantSize = 0;
+	};
+	
+	struct GraphicsPipelineDesc
+	{
+		const char* VertexShaderPath = nullptr;
+		const char* FragmentShaderPath = nullptr;
+		bool bDepthTest = true; // Against the scene's depth, reverse Z so nearer is greater
+		bool bAlphaBlend = false;
+	};
+	
+	// Storage buffers for set 0 of the pipeline, Buffers[i] goes to binding i.
+	constexpr u32 MATERIAL_BUFFERS_MAX = 8;
+	struct MaterialDesc
+	{
+		GraphicsPipelineHandle Pipeline = HANDLE_INVALID;
+		const GraphicsBufferHandle* Buffers = nullptr;
+		u32 BufferCount = 0;
+	};
+	
+	struct DrawDesc
+	{
+		RenderLayer Layer = RenderLayer::Opaque;
+		MaterialHandle Material = HANDLE_INVALID;
+		GraphicsBufferHandle VertexBuffer = HANDLE_INVALID; // Optional, binding 0 of the pipeline's vertex input
+		GraphicsBufferHandle IndexBuffer = HANDLE_INVALID; // Optional, 32-bit indices
+		u32 Count = 0; // Indices, or vertices without an index buffer
+		u32 First = 0;
+		i32 VertexOffset = 0;
+		f32 SortDepth = 0.0f; // Distance from the camera
+		const void* PushConstants = nullptr; // Copied when the draw is submitted
+		u32 PushConstantSize = 0;
+	};
+	
+	// How finished frames reach the screen, a trade between tearing, throughput and latency.
+	enum class PresentPolicy : u32
+	{
+		Fifo = 0, // Vsync, a full queue blocks the CPU, always available
+		Mailbox = 1, // Vsync, newer frames replace queued ones, falls back to Fifo
+		Immediate = 2, // No vsync, may tear, falls back to Mailbox then Fifo
+	};
+	
+	constexpr u32 FRAMES_IN_FLIGHT_MAX = 3;
+	
+	// Read every frame, changes apply at the start of the next one.
+	struct PresentSettings
+	{
+		PresentPolicy Policy = PresentPolicy::Mailbox;
+		u32 FramesInFlight = 2; // 1 to FRAMES_IN_FLIGHT_MAX, fewer is lower latency, more keeps the GPU busier
+		bool bWaitForPresent = false; // Hold WaitForFrameLatency until earlier frames are on screen, with present wait only
+	};
+	
+	struct GraphicsStats
+	{
+		// Pipelines
+		bool bPipelineCacheWarm = false;
+		u32 PipelinesCreated = 0;
+		u32 PipelineRegistryHits = 0;
+		u32 PipelineCompilesPending = 0;
+		f64 PipelineCreateMilliseconds = 0.0;
+		
+		// Bindless descriptors
+		bool bBindlessDescriptors = false; // False when running on the per-frame fallback
+		u32 BindlessImages = 0;
+		u32 BindlessBuffers = 0;
+		u32 BindlessSamplers = 0;
+		
+		// Descriptor set cache
+		u64 DescriptorCacheHits = 0;
+		u64 DescriptorCacheMisses = 0;
+		u32 DescriptorCacheEntries = 0;
+		
+		// Uploads
+		u64 UploadBytesLastFrame = 0;
+		u32 UploadsPending = 0;
+		
+		// Render graph
+		u32 RenderGraphPasses = 0;
+		u32 RenderGraphCulledPasses = 0;
+		u32 RenderGraphBarriers = 0;
+		u64 RenderGraphTransientBytes = 0;
+		u64 RenderGraphAllocatedBytes = 0; // Less than the transient bytes once aliasing kicks in
+		
+		// Swapchain
+		u32 SwapchainWidth = 0;
+		u32 SwapchainHeight = 0;
+		u32 SwapchainRecreations = 0; // Since start, on resize or when presentation reports it out of date
+		u32 SkippedFrames = 0; // Since start, while a window has no area to present to
+		PresentPolicy Policy = PresentPolicy::Fifo; // In use, after falling back from the requested one
+		u32 FramesInFlight = 0;
+		bool bPresentWait = false; // Supported, without it PresentSettings::bWaitForPresent does nothing
+		f64 InputLatencyMilliseconds = 0.0; // Smoothed, from input being sampled to the frame on screen when waiting for present, else to it finishing
+		f64 LatencyWaitMilliseconds = 0.0; // Last time spent in WaitForFrameLatency
+		
+		// Dynamic resolution
+		f32 RenderScale = 1.0f;
+		f64 GpuFrameMilliseconds = 0.0; // Zero when the device can't time the graphics queue
+		
+		// Compute
+		u32 ComputeDispatches = 0;
+		f64 ComputeMilliseconds = 0.0; // GPU time of the timed dispatches, zero without timestamps
+		
+		// GPU scene
+		u32 SceneMeshes = 0;
+		u32 SceneObjects = 0;
+		u32 SceneVisibleObjects = 0; // Read back from the GPU, a few frames old
+		u32 SceneDrawCalls = 0; // Indirect draws issued, one per pipeline with objects
+		bool bDrawIndirectCount = false; // False when culled draws are zeroed instead of compacted away
+		u64 SceneGeometryBytes = 0; // Vertex and index ranges in use
+		u64 SceneGeometryFreeBytes = 0;
+		u32 SceneGeometryFreeRegions = 0;
+		f32 SceneGeometryFragmentation = 0.0f; // 0 when free space is one range, towards 1 as it splinters
+		
+		// GPU scene occlusion, counts are read back a few frames old and times are zero without timestamps
+		u32 SceneRetestedObjects = 0; // Hidden by the previous frame's depth and tested again
+		u32 SceneOccludedObjects = 0; // Still hidden by this frame's, so never drawn
+		f64 SceneCullMilliseconds = 0.0;
+		f64 SceneDrawMilliseconds = 0.0;
+		f64 SceneOcclusionMilliseconds = 0.0; // Building the depth pyramid and the late cull
+		f64 SceneOcclusionSavedMilliseconds = 0.0; // Estimate, negative when occlusion costs more than it culls
+		
+		// Render queue, binds are only counted when the state actually changes
+		u32 QueuedDraws = 0;
+		u32 QueueSortPasses = 0; // Radix passes, bytes every key shares are skipped
+		f64 QueueSortMilliseconds = 0.0;
+		u32 PipelineBinds = 0;
+		u32 DescriptorSetBinds = 0;
+		u32 VertexBufferBinds = 0;
+		u32 IndexBufferBinds = 0;
+		
+		// Static meshes
+		u32 StaticMeshes = 0;
+		u32 StaticMeshInstances = 0;
+		u32 StaticMeshDrawCalls = 0; // Indirect, one per index size in use however many meshes there are
+		u64 StaticMeshGeometryBytes = 0;
+		u32 StaticMeshTestedClusters = 0; // Meshlets of the LODs picked, before culling
+		u32 StaticMeshVisibleClusters = 0; // Read back, a few frames late
+		u64 StaticMeshTriangles = 0; // Read back, a few frames late
+		u64 StaticMeshFullDetailTriangles = 0; // Without LODs or cluster culling
+		
+		// Streamed textures
+		u32 Textures = 0;
+		u32 TexturesStreaming = 0; // Changing their resident levels
+		u64 TextureResidentBytes = 0;
+		u64 TextureWantedBytes = 0; // Resident if the budget were unlimited
+		u64 TextureBudgetBytes = 0;
+		u32 TextureLevelsStreamedIn = 0; // Since start
+		u32 TextureLevelsEvicted = 0;
+	};
+	
 	class GraphicsManager : public Object, public Singleton<GraphicsManager>
 	{
 	public:
 		virtual	RenderContextHandle CreateRenderContext(const WindowHandle Window) = 0;
 		virtual void DestroyRenderContext(RenderContextHandle RenderContext) = 0;
 		
-		virtual void BeginFrame(RenderContextHandle RenderContext) = 0;
+		// Blocks until the next frame can start without queueing behind too many others, see PresentSettings.
+		// Called before input is sampled, so the frame is built from input as fresh as it can be. Optional,
+		// BeginFrame does the part of the wait it needs without it, but after the input was read.
+		virtual void WaitForFrameLatency(RenderContextHandle RenderContext) = 0;
+		
+		// False when there is nothing to present to, a minimised window, and the frame is skipped. The rest
+		// of the frame, EndFrame included, is only called after a successful BeginFrame.
+		virtual bool BeginFrame(RenderContextHandle RenderContext) = 0;
 		virtual void EndFrame(RenderContextHandle RenderContext) = 0;
 		
 		virtual void BeginFrameImGui() = 0;
@@ -21,10 +245,79 @@ namespace Locus
 		
 		virtual void TestDraw(RenderContextHandle RenderContext) = 0;
 		
+		// Built from a compiled shader in the virtual file system, the layout is reflected from it.
+		// Compiles in the background, dispatches are skipped until the pipeline is ready.
+		virtual ComputePipelineHandle CreateComputePipeline(const char* ShaderPath) = 0;
+		virtual void DestroyComputePipeline(ComputePipelineHandle Pipeline) = 0;
+		
+		// Device local, usable as a storage, vertex or index buffer and for indirect arguments. Initial data is streamed in,
+		// and passes that use the buffer are skipped until it has arrived.
+		virtual GraphicsBufferHandle CreateBuffer(u64 Size, const void* InitialData = nullptr) = 0;
+		virtual void DestroyBuffer(GraphicsBufferHandle Buffer) = 0;
+		
+		// Recorded into the active frame and synchronised against everything else in it.
+		// Indirect arguments are three u32 group counts at Offset, which may be written by an earlier pass.
+		virtual void Dispatch(const ComputePass& Pass, u32 GroupCountX, u32 GroupCountY, u32 GroupCountZ) = 0;
+		virtual void DispatchIndirect(const ComputePass& Pass, GraphicsBufferHandle Arguments, u64 Offset = 0) = 0;
+		virtual void GetSceneExtent(u32& OutWidth, u32& OutHeight) const = 0; // The part of SceneColor drawn this frame
+		
+		// The GPU scene. Objects live on the GPU and are culled and drawn there, a frame only
+		// uploads what changed, so CPU cost does not grow with the number of objects.
+		virtual MeshHandle CreateMesh(const MeshVertex* Vertices, u32 VertexCount, const u32* Indices, u32 IndexCount) = 0;
+		virtual void DestroyMesh(MeshHandle Mesh) = 0; // Once no object uses it
+		virtual SceneObjectHandle CreateSceneObject(const SceneObjectDesc& Desc) = 0;
+		virtual void SetSceneObjectTransform(SceneObjectHandle Object, const SceneTransform& Transform) = 0;
+		virtual void DestroySceneObject(SceneObjectHandle Object) = 0;
+		
+		// Culls and draws every scene object into SceneColor from the scene camera.
+		virtual void DrawScene() = 0;
+		
+		// Draws are queued with a sort key built from their layer, pipeline, material and depth, and
+		// are sorted and recorded into SceneColor once the frame's scene is done. Pipelines compile in
+		// the background, draws are skipped until theirs is ready.
+		virtual GraphicsPipelineHandle CreateGraphicsPipeline(const GraphicsPipelineDesc& Desc) = 0;
+		virtual void DestroyGraphicsPipeline(GraphicsPipelineHandle Pipeline) = 0;
+		virtual MaterialHandle CreateMaterial(const MaterialDesc& Desc) = 0;
+		virtual void DestroyMaterial(MaterialHandle Material) = 0;
+		virtual void SubmitDraw(const DrawDesc& Draw) = 0;
+		
+		// Static meshes cooked by LocusMeshCook, loaded from the virtual file system. Instances are
+		// submitted every frame they are drawn, and all of a mesh's instances in a frame are a single
+		// instanced draw. Meshes are skipped until their geometry has been uploaded.
+		virtual StaticMeshHandle LoadStaticMesh(const char* LogicalPath) = 0;
+		virtual void DestroyStaticMesh(StaticMeshHandle Mesh) = 0;
+		virtual void DrawStaticMesh(StaticMeshHandle Mesh, const StaticMeshInstance* Instances, u32 Count) = 0;
+		
+		// KTX2 textures streamed from the virtual file system. Only the small levels are loaded up
+		// front, finer ones stream in for textures requested at a size that needs them, within a
+		// budget. Request every frame a texture is drawn, either with its width on screen in pixels or
+		// its world size at a distance from the scene camera, and fetch its binding every frame since
+		// it moves whenever the resident levels change. No binding until the small levels have arrived.
+		virtual TextureHandle LoadTexture(const char* LogicalPath) = 0;
+		virtual void DestroyTexture(TextureHandle Texture) = 0;
+		virtual void RequestTextureResolution(TextureHandle Texture, f32 ScreenPixels) = 0;
+		virtual void RequestTextureAtDistance(TextureHandle Texture, f32 WorldSize, f32 Distance) = 0;
+		virtual bool GetTextureBinding(TextureHandle Texture, u32& OutImageIndex, u32& OutSamplerIndex) const = 0; // Bindless indices
+		virtual void SetTextureBudget(u64 Bytes) = 0;
+		
+		// Inside an ImGui frame, shows the active render context's last compiled render graph.
+		virtual void DrawDebugRenderGraph(bool* bOpen) = 0;
+		
 		inline RenderContextHandle GetActiveRenderContext() { return m_ActiveRenderContext; }
 		virtual ImGuiContext* GetImGuiContext(RenderContextHandle RenderContext) = 0;
 		
+		inline const GraphicsStats& GetStats() const { return m_Stats; }
+		inline RenderScaleSettings& GetRenderScaleSettings() { return m_RenderScaleSettings; }
+		inline PresentSettings& GetPresentSettings() { return m_PresentSettings; }
+		inline Camera& GetSceneCamera() { return m_SceneCamera; }
+		inline void SetRenderQueueSorting(bool bSort) { m_bSortRenderQueue = bSort; } // Off to measure what sorting saves
+	
 	protected:
 		RenderContextHandle m_ActiveRenderContext = HANDLE_INVALID;
+		GraphicsStats m_Stats;
+		RenderScaleSettings m_RenderScaleSettings;
+		PresentSettings m_PresentSettings;
+		Camera m_SceneCamera;
+		bool m_bSortRenderQueue = true;
 	};
 };
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "MeshAsset.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Locus
+{
+	u32 MeshAssetView::GetIndex(u32 i) const
+	{
+		if (Header->Flags & MESH_ASSET_INDICES_16)
+		{
+			return static_cast<const u16*>(Indices)[i];
+		}
+		return static_cast<const u32*>(Indices)[i];
+	}
+	
+	bool ParseMeshAsset(const u8* Data, arch Size, MeshAssetView& OutView)
+	{
+		OutView = {};
+		if (Data == nullptr || Size < sizeof(MeshAssetHeader))
+		{
+			return false;
+		}
+		
+		const MeshAssetHeader* Header = reinterpret_cast<const MeshAssetHeader*>(Data);
+		if (Header->Magic != MESH_ASSET_MAGIC || Header->Version != MESH_ASSET_VERSION)
+		{
+			LLOG(Assets, Error, "Not a version %u mesh asset.", MESH_ASSET_VERSION);
+			return false;
+		}
+		
+		u64 IndexSize = (Header->Flags & MESH_ASSET_INDICES_16) ? 2 : 4;
+		u64 VertexBytes = static_cast<u64>(Header->VertexCount) * sizeof(MeshAssetVertex);
+		u64 IndexBytes = static_cast<u64>(Header->IndexCount) * IndexSize;
+		u64 LodBytes = static_cast<u64>(Header->LodCount) * sizeof(MeshAssetLod);
+		u64 MeshletBytes = static_cast<u64>(Header->MeshletCount) * sizeof(MeshAssetMeshlet);
+		auto IsValidRange = [Size](u64 Offset, u64 Bytes){
+			return Offset % MESH_ASSET_ALIGNMENT == 0 && Offset >= sizeof(MeshAssetHeader) && Offset <= Size && Bytes <= Size - Offset;
+		};
+		
+		if (Header->VertexCount == 0 || Header->IndexCount == 0 || Header->IndexCount % 3 != 0
+			|| Header->LodCount == 0 || Header->LodCount > MESH_ASSET_LODS_MAX || Header->MeshletCount == 0
+			|| !IsValidRange(Header->VertexOffset, VertexBytes) || !IsValidRange(Header->IndexOffset, IndexBytes)
+			|| !IsValidRange(Header->LodOffset, LodBytes) || !IsValidRange(Header->MeshletOffset, MeshletBytes))
+		{
+			LLOG(Assets, Error, "Mesh asset is truncated or its ranges are malformed.");
+			return false;
+		}
+		
+		// The runtime trusts these ranges when it draws, so they are checked once here.
+		const MeshAssetLod* Lods = reinterpret_cast<const MeshAssetLod*>(Data + Header->LodOffset);
+		const MeshAssetMeshlet* Meshlets = reinterpret_cast<const MeshAssetMeshlet*>(Data + Header->MeshletOffset);
+		for (u32 i = 0; i < Header->LodCount; i++)
+		{
+			const MeshAssetLod& Lod = Lods[i];
+			bool bValid = static_cast<u64>(Lod.FirstIndex) + Lod.IndexCount <= Header->IndexCount && Lod.MeshletCount > 0
+				&& static_cast<u64>(Lod.FirstMeshlet) + Lod.MeshletCount <= Header->MeshletCount;
+			for (u32 m = 0; bValid && m < Lod.MeshletCount; m++)
+			{
+				const MeshAssetMeshlet& Meshlet = Meshlets[Lod.FirstMeshlet + m];
+				bValid = Meshlet.FirstIndex >= Lod.FirstIndex && static_cast<u64>(Meshlet.FirstIndex) + 3ull * Meshlet.TriangleCount <= static_cast<u64>(Lod.FirstIndex) + Lod.IndexCount;
+			}
+			if (!bValid)
+			{
+				LLOG(Assets, Error, "Mesh asset LOD %u has ranges outside the mesh.", i);
+				return false;
+			}
+		}
+		
+		OutView.Header = Header;
+		OutView.Vertices = reinterpret_cast<const MeshAssetVertex*>(Data + Header->VertexOffset);
+		OutView.Indices = Data + Header->IndexOffset;
+		OutView.Lods = Lods;
+		OutView.Meshlets = Meshlets;
+		return true;
+	}
+	
+	static i16 ToSnorm16(f32 Value)
+	{
+		return static_cast<i16>(std::lround(std::clamp(Value, -1.0f, 1.0f) * 32767.0f));
+	}
+	
+	void EncodeOctahedralNormal(const f32 Normal[3], i16 OutEncoded[2])
+	{
+		// Project onto the octahedron, then fold the lower half over the diagonals.
+		f32 L1 = std::fabs(Normal[0]) + std::fabs(Normal[1]) + std::fabs(Normal[2]);
+		if (L1 <= 0.0f)
+		{
+			OutEncoded[0] = 0;
+			OutEncoded[1] = 0;
+			return;
+		}
+		
+		f32 X = Normal[0] / L1;
+		f32 Y = Normal[1] / L1;
+		if (Normal[2] < 0.0f)
+		{
+			f32 FoldedX = (1.0f - std::fabs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+			f32 FoldedY = (1.0f - std::fabs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+			X = FoldedX;
+			Y = FoldedY;
+		}
+		
+		OutEncoded[0] = ToSnorm16(X);
+		OutEncoded[1] = ToSnorm16(Y);
+	}
+	
+	void DecodeOctahedralNormal(const i16 Encoded[2], f32 OutNormal[3])
+	{
+		f32 X = std::max(Encoded[0] / 32767.0f, -1.0f);
+		f32 Y = std::max(Encoded[1] / 32767.0f, -1.0f);
+		f32 Z = 1.0f - std::fabs(X) - std::fabs(Y);
+		if (Z < 0.0f)
+		{
+			f32 UnfoldedX = (1.0f - std::fabs(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+			f32 UnfoldedY = (1.0f - std::fabs(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+			X = UnfoldedX;
+			Y = UnfoldedY;
+		}
+		
+		f32 Length = std::sqrt(X * X + Y * Y + Z * Z);
+		OutNormal[0] = X / Length;
+		OutNormal[1] = Y / Length;
+		OutNormal[2] = Z / Length;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+/*
+	Locus mesh asset (.lmesh) layout, written by LocusMeshCook:
+	
+	[MeshAssetHeader]
+	[MeshAssetVertex x VertexCount]		- at VertexOffset, MESH_ASSET_ALIGNMENT aligned
+	[u16 or u32 x IndexCount]			- at IndexOffset, triangle lists, u16 with MESH_ASSET_INDICES_16
+	[MeshAssetLod x LodCount]			- at LodOffset, finest first
+	[MeshAssetMeshlet x MeshletCount]	- at MeshletOffset, grouped by LOD
+	
+	Positions are 16-bit unorm across the mesh's bounding box and normals are octahedral 16-bit
+	snorm, 12 bytes a vertex against 24 for MeshVertex. Indices are ordered for the post-transform
+	vertex cache and vertices for first use. Everything is little endian and laid out the way the
+	GPU reads it, so a mapped file uploads without any conversion.
+	
+	Every LOD indexes the same vertices, coarser ones just use fewer of them. Each LOD's triangles
+	are split into meshlets, contiguous runs of at most MESH_ASSET_MESHLET_TRIANGLES_MAX triangles
+	over at most MESH_ASSET_MESHLET_VERTICES_MAX vertices, each with a bounding sphere and a cone
+	bounding its triangles' normals, so they can be culled on their own.
+*/
+
+namespace Locus
+{
+	constexpr u32 MESH_ASSET_MAGIC = 0x48534D4C; // "LMSH"
+	constexpr u32 MESH_ASSET_VERSION = 2;
+	constexpr u64 MESH_ASSET_ALIGNMENT = 16;
+	constexpr u32 MESH_ASSET_LODS_MAX = 8;
+	constexpr u32 MESH_ASSET_MESHLET_VERTICES_MAX = 64;
+	constexpr u32 MESH_ASSET_MESHLET_TRIANGLES_MAX = 124;
+	
+	enum MeshAssetFlags : u32
+	{
+		MESH_ASSET_INDICES_16 = 1 << 0,
+	};
+	
+	struct MeshAssetHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 VertexCount;
+		u32 IndexCount;			// Of every LOD together
+		u32 Flags;
+		u32 LodCount;
+		u32 MeshletCount;
+		u32 Reserved;
+		f32 BoundsMin[3];		// Quantisation box, positions decode to BoundsMin + Unorm * BoundsExtent
+		f32 BoundsExtent[3];
+		f32 Sphere[4];			// Bounding sphere, centre and radius
+		u64 VertexOffset;		// From the start of the file
+		u64 IndexOffset;
+		u64 LodOffset;
+		u64 MeshletOffset;
+	};
+	CHECK_SIZE_COMPTIME(MeshAssetHeader, 104)
+	
+	// Mirrors the vertex words static_mesh.vert unpacks.
+	struct MeshAssetVertex
+	{
+		u16 Position[3];
+		i16 Normal[2];
+		u16 Pad;
+	};
+	CHECK_SIZE_COMPTIME(MeshAssetVertex, 12)
+	
+	struct MeshAssetLod
+	{
+		u32 FirstIndex;
+		u32 IndexCount;
+		u32 FirstMeshlet;
+		u32 MeshletCount;
+		f32 Error;				// Object space distance the simplification may have moved the surface, zero for the first
+		u32 Pad[3];
+	};
+	CHECK_SIZE_COMPTIME(MeshAssetLod, 32)
+	
+	// Mirrors Meshlet in static_mesh_cull.comp.
+	struct MeshAssetMeshlet
+	{
+		f32 Sphere[4];			// Object space, centre and radius
+		f32 Cone[4];			// Axis and cutoff, back facing from everywhere dot(Centre - Eye, Axis) >= Cutoff * |Centre - Eye| + Radius
+		u32 FirstIndex;			// From the first index of the mesh
+		u32 TriangleCount;
+		u32 Pad[2];
+	};
+	CHECK_SIZE_COMPTIME(MeshAssetMeshlet, 48)
+	
+	// Pointers into the asset's memory, valid while it stays mapped.
+	struct MeshAssetView
+	{
+		const MeshAssetHeader* Header = nullptr;
+		const MeshAssetVertex* Vertices = nullptr;
+		const void* Indices = nullptr;
+		const MeshAssetLod* Lods = nullptr;
+		const MeshAssetMeshlet* Meshlets = nullptr;
+		
+		u32 GetIndexSize() const { return (Header->Flags & MESH_ASSET_INDICES_16) ? 2 : 4; }
+		u32 GetIndex(u32 i) const;
+	};
+	
+	// Validates the header and that every range lies inside Size bytes.
+	bool ParseMeshAsset(const u8* Data, arch Size, MeshAssetView& OutView);
+	
+	void EncodeOctahedralNormal(const f32 Normal[3], i16 OutEncoded[2]);
+	void DecodeOctahedralNormal(const i16 Encoded[2], f32 OutNormal[3]);
+}
\ No newline at end of file
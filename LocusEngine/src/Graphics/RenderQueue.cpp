@@ -0,0 +1,130 @@
+#include "RenderQueue.hpp"
+
+#include "Core/JobSystem.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Locus
+{
+	static constexpr u32 RADIX_BITS = 8;
+	static constexpr u32 RADIX_BUCKETS = 1 << RADIX_BITS;
+	static constexpr u32 PARALLEL_SORT_MIN = 8192; // Below this the jobs cost more than they save
+	static constexpr u32 SORT_CHUNKS_MAX = 16;
+	
+	static u32 DepthBits(f32 Depth)
+	{
+		// Non-negative floats order the same as their bit patterns.
+		f32 Clamped = std::max(Depth, 0.0f);
+		u32 Bits;
+		memcpy(&Bits, &Clamped, sizeof(Bits));
+		return Bits;
+	}
+	
+	u64 MakeRenderKey(RenderLayer Layer, u32 Pipeline, u32 Material, f32 Depth)
+	{
+		LAssert(Pipeline < (1u << RENDER_KEY_PIPELINE_BITS) && Material < (1u << RENDER_KEY_MATERIAL_BITS));
+		
+		u64 State = (static_cast<u64>(Pipeline) << RENDER_KEY_MATERIAL_BITS) | Material;
+		u64 Key = static_cast<u64>(Layer) << 60;
+		if (Layer == RenderLayer::Translucent)
+		{
+			return Key | (static_cast<u64>(~DepthBits(Depth)) << 28) | State;
+		}
+		return Key | (State << 32) | DepthBits(Depth);
+	}
+	
+	RenderLayer GetRenderKeyLayer(u64 Key)
+	{
+		return static_cast<RenderLayer>(Key >> 60);
+	}
+	
+	void RenderQueue::Sort()
+	{
+		m_LastSortPasses = 0;
+		u32 Count = static_cast<u32>(m_Entries.size());
+		if (Count < 2)
+		{
+			return;
+		}
+		
+		// Bits that differ between any two keys, the bytes without any are already in order.
+		u64 Varying = 0;
+		for (const RenderQueueEntry& Entry : m_Entries)
+		{
+			Varying |= Entry.Key ^ m_Entries[0].Key;
+		}
+		if (Varying == 0)
+		{
+			return;
+		}
+		
+		u32 ChunkCount = 1;
+		if (Count >= PARALLEL_SORT_MIN)
+		{
+			ChunkCount = std::min(JobSystem::Get().GetWorkerCount() + 1, SORT_CHUNKS_MAX);
+		}
+		u32 ChunkSize = (Count + ChunkCount - 1) / ChunkCount;
+		ChunkCount = (Count + ChunkSize - 1) / ChunkSize;
+		
+		m_Scratch.resize(Count);
+		m_Histograms.resize(ChunkCount * RADIX_BUCKETS);
+		
+		RenderQueueEntry* Src = m_Entries.data();
+		RenderQueueEntry* Dst = m_Scratch.data();
+		u32* Histograms = m_Histograms.data();
+		
+		for (u32 Shift = 0; Shift < 64; Shift += RADIX_BITS)
+		{
+			if (((Varying >> Shift) & (RADIX_BUCKETS - 1)) == 0)
+			{
+				continue;
+			}
+			
+			memset(Histograms, 0, sizeof(u32) * ChunkCount * RADIX_BUCKETS);
+			JobSystem::Get().ParallelFor(ChunkCount, 1, [=](u32 Begin, u32 End){
+				for (u32 Chunk = Begin; Chunk < End; Chunk++)
+				{
+					u32* Histogram = Histograms + Chunk * RADIX_BUCKETS;
+					u32 Last = std::min((Chunk + 1) * ChunkSize, Count);
+					for (u32 i = Chunk * ChunkSize; i < Last; i++)
+					{
+						Histogram[(Src[i].Key >> Shift) & (RADIX_BUCKETS - 1)]++;
+					}
+				}
+			});
+			
+			// Offsets run bucket by bucket and chunk by chunk within a bucket, which keeps the sort stable.
+			u32 Offset = 0;
+			for (u32 Bucket = 0; Bucket < RADIX_BUCKETS; Bucket++)
+			{
+				for (u32 Chunk = 0; Chunk < ChunkCount; Chunk++)
+				{
+					u32 BucketCount = Histograms[Chunk * RADIX_BUCKETS + Bucket];
+					Histograms[Chunk * RADIX_BUCKETS + Bucket] = Offset;
+					Offset += BucketCount;
+				}
+			}
+			
+			JobSystem::Get().ParallelFor(ChunkCount, 1, [=](u32 Begin, u32 End){
+				for (u32 Chunk = Begin; Chunk < End; Chunk++)
+				{
+					u32* Offsets = Histograms + Chunk * RADIX_BUCKETS;
+					u32 Last = std::min((Chunk + 1) * ChunkSize, Count);
+					for (u32 i = Chunk * ChunkSize; i < Last; i++)
+					{
+						Dst[Offsets[(Src[i].Key >> Shift) & (RADIX_BUCKETS - 1)]++] = Src[i];
+					}
+				}
+			});
+			
+			std::swap(Src, Dst);
+			m_LastSortPasses++;
+		}
+		
+		if (Src != m_Entries.data())
+		{
+			m_Entries.swap(m_Scratch);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <vector>
+
+/*
+	Draws as 64-bit sort keys.
+	
+	A draw is pushed as a key and a payload, an index into whatever the submitter keeps its draw
+	data in. Sorting the keys puts draws that share state next to each other, so emitting them in
+	order only binds what actually changes. Keys are sorted with an LSD radix sort, one byte per
+	pass, split over the job system's workers. Bytes every key agrees on are skipped, so a queue
+	that only differs in depth and material sorts in a few passes.
+	
+	Opaque keys, from the top: layer (4 bits), pipeline (12), material (16), depth (32), so state
+	changes are minimised first and draws sharing a material then go front to back.
+	
+	Translucent keys, from the top: layer (4 bits), inverted depth (32), pipeline (12), material
+	(16), so blending is back to front and state only breaks ties.
+*/
+
+namespace Locus
+{
+	enum class RenderLayer : u32
+	{
+		Opaque = 0,
+		Translucent = 1,
+		Overlay = 2,
+		
+		Count
+	};
+	
+	constexpr u32 RENDER_KEY_PIPELINE_BITS = 12;
+	constexpr u32 RENDER_KEY_MATERIAL_BITS = 16;
+	
+	// Depth is view distance, negative values are clamped to zero.
+	u64 MakeRenderKey(RenderLayer Layer, u32 Pipeline, u32 Material, f32 Depth);
+	RenderLayer GetRenderKeyLayer(u64 Key);
+	
+	struct RenderQueueEntry
+	{
+		u64 Key;
+		u32 Payload;
+		u32 Pad;
+	};
+	
+	class RenderQueue
+	{
+	public:
+		void Reset() { m_Entries.clear(); }
+		void Push(u64 Key, u32 Payload) { m_Entries.push_back({ Key, Payload, 0 }); }
+		
+		// Stable, draws with equal keys keep the order they were pushed in.
+		void Sort();
+		
+		const std::vector<RenderQueueEntry>& GetEntries() const { return m_Entries; }
+		u32 GetCount() const { return static_cast<u32>(m_Entries.size()); }
+		u32 GetLastSortPasses() const { return m_LastSortPasses; }
+	
+	private:
+		std::vector<RenderQueueEntry> m_Entries;
+		std::vector<RenderQueueEntry> m_Scratch;
+		std::vector<u32> m_Histograms; // 256 counters per chunk
+		u32 m_LastSortPasses = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "RenderScaleController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Locus
+{
+	static constexpr f64 SMOOTHING = 0.1; // Weight of the newest sample
+	static constexpr u32 SETTLE_FRAMES = 8;
+	static constexpr f64 SCALE_DOWN_THRESHOLD = 1.05; // Over budget by more than this
+	static constexpr f64 SCALE_UP_THRESHOLD = 0.85; // Under budget by more than this
+	static constexpr f32 MAX_STEP = 0.1f;
+	static constexpr f32 MIN_STEP = 0.01f;
+	
+	void RenderScaleController::Update(f64 GpuMilliseconds, const RenderScaleSettings& Settings)
+	{
+		m_SmoothedMilliseconds = (m_SmoothedMilliseconds == 0.0) ? GpuMilliseconds : m_SmoothedMilliseconds + (GpuMilliseconds - m_SmoothedMilliseconds) * SMOOTHING;
+		m_FramesSinceChange++;
+		
+		if (!Settings.bEnabled)
+		{
+			m_Scale = Settings.MaxScale;
+			return;
+		}
+		
+		m_Scale = std::clamp(m_Scale, Settings.MinScale, Settings.MaxScale);
+		if (m_FramesSinceChange < SETTLE_FRAMES || m_SmoothedMilliseconds <= 0.0)
+		{
+			return;
+		}
+		
+		f64 Load = m_SmoothedMilliseconds / Settings.TargetMilliseconds;
+		if (Load < SCALE_DOWN_THRESHOLD && Load > SCALE_UP_THRESHOLD)
+		{
+			return;
+		}
+		
+		f32 Desired = m_Scale * static_cast<f32>(std::sqrt(1.0 / Load));
+		Desired = std::clamp(Desired, m_Scale - MAX_STEP, m_Scale + MAX_STEP);
+		Desired = std::clamp(Desired, Settings.MinScale, Settings.MaxScale);
+		
+		if (std::abs(Desired - m_Scale) >= MIN_STEP)
+		{
+			m_Scale = Desired;
+			m_FramesSinceChange = 0;
+		}
+	}
+}
\ No newline at end of file
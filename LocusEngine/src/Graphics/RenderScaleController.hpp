@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+/*
+	Picks the fraction of the output resolution the scene is rendered at from measured GPU time.
+	
+	GPU cost is taken to scale with pixel count, so the scale moves by the square root of the
+	ratio between the budget and the smoothed frame time. Timings arrive a few frames late, so
+	after each change the controller waits for the new measurements to settle, and it ignores
+	small errors around the budget, more so upwards than downwards, to avoid oscillating.
+*/
+
+namespace Locus
+{
+	struct RenderScaleSettings
+	{
+		bool bEnabled = true;
+		f32 TargetMilliseconds = 16.0f; // GPU budget per frame
+		f32 MinScale = 0.5f;
+		f32 MaxScale = 1.0f;
+	};
+	
+	class RenderScaleController
+	{
+	public:
+		void Update(f64 GpuMilliseconds, const RenderScaleSettings& Settings);
+		
+		f32 GetScale() const { return m_Scale; }
+		f64 GetSmoothedMilliseconds() const { return m_SmoothedMilliseconds; }
+	
+	private:
+		f32 m_Scale = 1.0f;
+		f64 m_SmoothedMilliseconds = 0.0;
+		u32 m_FramesSinceChange = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "ShaderHotReloader.hpp"
+
+#include "Core/JobSystem.hpp"
+#include "Core/Time.hpp"
+#include "Platform/Platform.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace Locus
+{
+	ShaderHotReloader::ShaderHotReloader(const char* SourceDirectory, const char* BinaryDirectory, const char* CompilerPath) :
+	m_SourceDirectory(SourceDirectory),
+	m_BinaryDirectory(BinaryDirectory),
+	m_CompilerPath(CompilerPath)
+	{
+		if (!m_BinaryDirectory.empty() && m_BinaryDirectory.back() != '/')
+		{
+			m_BinaryDirectory.push_back('/');
+		}
+		
+		m_Watcher.Watch(SourceDirectory);
+	}
+	
+	ShaderHotReloader::~ShaderHotReloader()
+	{
+		// Compile jobs reference this object, let them drain.
+		while (m_CompilesInFlight.load() > 0)
+		{
+			Platform::SleepThisThread(1);
+		}
+	}
+	
+	bool ShaderHotReloader::IsShaderSource(const std::string& Path)
+	{
+		static const char* Extensions[] = { ".vert", ".frag", ".comp" };
+		for (const char* Extension : Extensions)
+		{
+			arch Length = strlen(Extension);
+			if (Path.size() > Length && Path.compare(Path.size() - Length, Length, Extension) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	bool ShaderHotReloader::IsShaderInclude(const std::string& Path)
+	{
+		return Path.size() > 5 && Path.compare(Path.size() - 5, 5, ".glsl") == 0;
+	}
+	
+	bool ShaderHotReloader::IncludesAny(const std::string& SourcePath, const std::set<std::string>& IncludeNames, std::set<std::string>& Visited)
+	{
+		if (!Visited.insert(SourcePath).second)
+		{
+			return false;
+		}
+		
+		// Includes are resolved next to the including file, as glslangValidator does.
+		std::string Directory = SourcePath.substr(0, SourcePath.find_last_of('/') + 1);
+		std::ifstream File(SourcePath);
+		std::string Line;
+		while (std::getline(File, Line))
+		{
+			arch Directive = Line.find("#include");
+			arch Open = Directive == std::string::npos ? std::string::npos : Line.find('"', Directive);
+			arch Close = Open == std::string::npos ? std::string::npos : Line.find('"', Open + 1);
+			if (Close == std::string::npos)
+			{
+				continue;
+			}
+			
+			std::string Included = Line.substr(Open + 1, Close - Open - 1);
+			if (IncludeNames.count(Included) > 0 || IncludesAny(Directory + Included, IncludeNames, Visited))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	void ShaderHotReloader::Update()
+	{
+		std::vector<std::string> ChangedFiles;
+		m_Watcher.Poll(ChangedFiles);
+		
+		std::set<std::string> ChangedIncludes;
+		for (const std::string& SourcePath : ChangedFiles)
+		{
+			if (IsShaderSource(SourcePath))
+			{
+				QueueCompile(SourcePath);
+			}
+			else if (IsShaderInclude(SourcePath))
+			{
+				ChangedIncludes.insert(SourcePath.substr(SourcePath.find_last_of('/') + 1));
+			}
+		}
+		
+		if (ChangedIncludes.empty())
+		{
+			return;
+		}
+		
+		// Nothing records who includes what, the sources are few and small enough to scan on each change.
+		std::vector<std::string> Sources;
+		Platform::ListDirectory(m_SourceDirectory.c_str(), Sources);
+		for (const std::string& SourcePath : Sources)
+		{
+			std::set<std::string> Visited;
+			if (IsShaderSource(SourcePath) && IncludesAny(SourcePath, ChangedIncludes, Visited))
+			{
+				QueueCompile(SourcePath);
+			}
+		}
+	}
+	
+	void ShaderHotReloader::QueueCompile(const std::string& SourcePath)
+	{
+		std::string FileName = SourcePath.substr(SourcePath.find_last_of('/') + 1);
+		
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			if (!m_Compiling.insert(FileName).second)
+			{
+				// Already compiling, and maybe from the old source, so it goes round once more when done.
+				m_Dirty.insert(FileName);
+				return;
+			}
+		}
+		
+		m_CompilesInFlight++;
+		JobSystem::Get().Submit([this, SourcePath, FileName]() {
+			// One compile per file at a time, they share the temporary output.
+			bool bCompileAgain = true;
+			while (bCompileAgain)
+			{
+				Compile(SourcePath, FileName);
+				
+				std::lock_guard<std::mutex> Lock(m_Mutex);
+				bCompileAgain = m_Dirty.erase(FileName) > 0;
+				if (!bCompileAgain)
+				{
+					m_Compiling.erase(FileName);
+				}
+			}
+			m_CompilesInFlight--;
+		});
+	}
+	
+	void ShaderHotReloader::Compile(const std::string& SourcePath, const std::string& FileName)
+	{
+		if (!CompileVariant(SourcePath, FileName + ".spv", ""))
+		{
+			return;
+		}
+		
+		// Same as the build, stages using the heap also get the variant for devices without descriptor indexing.
+		std::set<std::string> Visited;
+		if (IncludesAny(SourcePath, { "bindless.glsl" }, Visited))
+		{
+			CompileVariant(SourcePath, FileName + ".fallback.spv", "-DLOCUS_BINDLESS_FALLBACK ");
+		}
+	}
+	
+	bool ShaderHotReloader::CompileVariant(const std::string& SourcePath, const std::string& BinaryName, const char* Defines)
+	{
+		std::string BinaryPath = m_BinaryDirectory + BinaryName;
+		std::string TempPath = BinaryPath + ".tmp";
+		std::string CommandLine = "\"" + m_CompilerPath + "\" -V " + Defines + "\"" + SourcePath + "\" -o \"" + TempPath + "\"";
+		
+		Clock CompileClock;
+		CompileClock.Start();
+		
+		std::string Output;
+		i32 ExitCode = Platform::RunProcess(CommandLine.c_str(), &Output);
+		
+		if (ExitCode != 0)
+		{
+			LLOG(Shaders, Error, "Failed to compile %s, keeping the previous version:\n%s", BinaryName.c_str(), Output.c_str());
+			std::remove(TempPath.c_str());
+			return false;
+		}
+		
+		// Swap the new binary in atomically so readers never see a partial file.
+		if (std::rename(TempPath.c_str(), BinaryPath.c_str()) != 0)
+		{
+			LLOG(Shaders, Error, "Failed to replace %s", BinaryPath.c_str());
+			return false;
+		}
+		
+		LLOG(Shaders, Info, "Recompiled %s in %.2lfms", BinaryName.c_str(), CompileClock.GetElapsedMilliseconds());
+		
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Reloaded.push_back("shaders/" + BinaryName);
+		return true;
+	}
+	
+	void ShaderHotReloader::ConsumeReloadedShaders(std::vector<std::string>& OutLogicalPaths)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		OutLogicalPaths.insert(OutLogicalPaths.end(), m_Reloaded.begin(), m_Reloaded.end());
+		m_Reloaded.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Base/Base.hpp"
+#include "Platform/FileWatcher.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+	Watches the shader source directory and recompiles changed stages on the job system.
+	Freshly compiled SPIR-V is written next to the built content, where the VFS picks it
+	up as a loose file, and the graphics backend is told which logical paths changed so it
+	can rebuild dependent pipelines at its next frame boundary.
+	
+	A changed .glsl include recompiles every stage that includes it, directly or through
+	other includes. A file saved again mid-compile is compiled once more when it finishes.
+*/
+
+namespace Locus
+{
+	class ShaderHotReloader
+	{
+	public:
+		ShaderHotReloader(const char* SourceDirectory, const char* BinaryDirectory, const char* CompilerPath);
+		~ShaderHotReloader();
+		
+		// Main thread, once per frame. Cheap when nothing changed.
+		void Update();
+		
+		// Logical paths (e.g. "shaders/triangle.vert.spv") compiled successfully since the last call.
+		void ConsumeReloadedShaders(std::vector<std::string>& OutLogicalPaths);
+	
+	private:
+		static bool IsShaderSource(const std::string& Path);
+		static bool IsShaderInclude(const std::string& Path);
+		static bool IncludesAny(const std::string& SourcePath, const std::set<std::string>& IncludeNames, std::set<std::string>& Visited);
+		void QueueCompile(const std::string& SourcePath);
+		void Compile(const std::string& SourcePath, const std::string& FileName);
+		bool CompileVariant(const std::string& SourcePath, const std::string& BinaryName, const char* Defines);
+		
+		FileWatcher m_Watcher;
+		std::string m_SourceDirectory;
+		std::string m_BinaryDirectory;
+		std::string m_CompilerPath;
+		
+		std::mutex m_Mutex;
+		std::set<std::string> m_Compiling;
+		std::set<std::string> m_Dirty; // Changed again while compiling
+		std::vector<std::string> m_Reloaded;
+		std::atomic<u32> m_CompilesInFlight {0};
+	};
+}
\ No newline at end of file
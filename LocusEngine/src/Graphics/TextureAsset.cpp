@@ -0,0 +1,64 @@
+#include "TextureAsset.hpp"
+#include "Math/Numerics.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Locus
+{
+	static constexpr u8 KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	
+	bool ParseTextureAsset(const u8* Data, arch Size, TextureAssetInfo& OutInfo)
+	{
+		OutInfo = {};
+		if (Data == nullptr || Size < sizeof(TextureAssetHeader))
+		{
+			return false;
+		}
+		
+		const TextureAssetHeader* Header = reinterpret_cast<const TextureAssetHeader*>(Data);
+		if (memcmp(Header->Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			LLOG(Assets, Error, "Not a KTX2 texture.");
+			return false;
+		}
+		
+		if (Header->PixelDepth > 1 || Header->LayerCount > 1 || Header->FaceCount != 1 || Header->PixelWidth == 0 || Header->PixelHeight == 0)
+		{
+			LLOG(Assets, Error, "KTX2 texture is not a single 2D image.");
+			return false;
+		}
+		
+		if (Header->SupercompressionScheme != 0)
+		{
+			LLOG(Assets, Error, "KTX2 texture uses supercompression scheme %u, only plain levels can be streamed.", Header->SupercompressionScheme);
+			return false;
+		}
+		
+		u32 LevelCount = std::max(Header->LevelCount, 1u);
+		u32 FullChain = 32 - Math::CountLeadingZeros(std::max(Header->PixelWidth, Header->PixelHeight));
+		if (LevelCount > TEXTURE_ASSET_LEVELS_MAX || LevelCount > FullChain || Size < sizeof(TextureAssetHeader) + LevelCount * sizeof(TextureAssetLevel))
+		{
+			LLOG(Assets, Error, "KTX2 texture has a malformed level index.");
+			return false;
+		}
+		
+		const TextureAssetLevel* Levels = reinterpret_cast<const TextureAssetLevel*>(Data + sizeof(TextureAssetHeader));
+		for (u32 i = 0; i < LevelCount; i++)
+		{
+			const TextureAssetLevel& Level = Levels[i];
+			if (Level.ByteLength == 0 || Level.ByteOffset > Size || Level.ByteLength > Size - Level.ByteOffset)
+			{
+				LLOG(Assets, Error, "KTX2 texture level %u lies outside the file.", i);
+				return false;
+			}
+			OutInfo.Levels[i] = Level;
+		}
+		
+		OutInfo.Format = Header->VkFormat;
+		OutInfo.Width = Header->PixelWidth;
+		OutInfo.Height = Header->PixelHeight;
+		OutInfo.LevelCount = LevelCount;
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+/*
+	KTX2 textures (.ktx2), as written by toktx or any other KTX 2.0 tool:
+	
+	[TextureAssetHeader]
+	[TextureAssetLevel x LevelCount]	- straight after the header, finest first
+	[Data format descriptor, key/value data, supercompression data]
+	[Level data]						- usually coarsest first in the file, wherever the index says
+	
+	Only single 2D images without supercompression are read, so every level's bytes are what the
+	GPU samples and upload unchanged. The format is a VkFormat number, which formats the renderer
+	accepts is up to it. A level index is all a streamer needs to read any one level on its own.
+*/
+
+namespace Locus
+{
+	constexpr u32 TEXTURE_ASSET_LEVELS_MAX = 16;
+	
+	struct TextureAssetHeader
+	{
+		u8 Identifier[12];			// "«KTX 20»\r\n\x1A\n"
+		u32 VkFormat;
+		u32 TypeSize;
+		u32 PixelWidth;
+		u32 PixelHeight;
+		u32 PixelDepth;				// Zero for 2D
+		u32 LayerCount;				// Zero when not an array
+		u32 FaceCount;				// Six for cube maps
+		u32 LevelCount;				// Zero asks the loader to generate mips, read as one
+		u32 SupercompressionScheme;
+		u32 DfdByteOffset;
+		u32 DfdByteLength;
+		u32 KvdByteOffset;
+		u32 KvdByteLength;
+		u64 SgdByteOffset;
+		u64 SgdByteLength;
+	};
+	CHECK_SIZE_COMPTIME(TextureAssetHeader, 80)
+	
+	struct TextureAssetLevel
+	{
+		u64 ByteOffset;				// From the start of the file
+		u64 ByteLength;
+		u64 UncompressedByteLength;
+	};
+	CHECK_SIZE_COMPTIME(TextureAssetLevel, 24)
+	
+	// Copied out of the file's header, so it stays valid once the file is closed.
+	struct TextureAssetInfo
+	{
+		u32 Format = 0;				// VkFormat
+		u32 Width = 0;
+		u32 Height = 0;
+		u32 LevelCount = 0;
+		TextureAssetLevel Levels[TEXTURE_ASSET_LEVELS_MAX] = {};
+		
+		u32 GetLevelWidth(u32 Level) const { return (Width >> Level) > 0 ? (Width >> Level) : 1; }
+		u32 GetLevelHeight(u32 Level) const { return (Height >> Level) > 0 ? (Height >> Level) : 1; }
+	};
+	
+	// Validates the header and that every level lies inside Size bytes.
+	bool ParseTextureAsset(const u8* Data, arch Size, TextureAssetInfo& OutInfo);
+}
\ No newline at end of file
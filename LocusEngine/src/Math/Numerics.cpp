@@ -2,6 +2,10 @@
 
 #include <math.h>
 
+#if LOCUS_PLATFORM_WINDOWS
+	#include <intrin.h>
+#endif
+
 f32 Locus::Math::Sin(f32 Angle)
 {
 	return sinf(Angle);
@@ -71,4 +75,41 @@ u32 Locus::Math::Max(u32 X, u32 Y)
 u32 Locus::Math::Clamp(u32 X, u32 Min, u32 Max)
 {
 	return X < Min ? Min : (X > Max ? Max : X);
+}
+
+u32 Locus::Math::CountLeadingZeros(u32 X)
+{
+#if LOCUS_PLATFORM_WINDOWS
+	unsigned long Index;
+	_BitScanReverse(&Index, X);
+	return 31 - static_cast<u32>(Index);
+#else
+	return static_cast<u32>(__builtin_clz(X));
+#endif
+}
+
+u32 Locus::Math::CountTrailingZeros(u32 X)
+{
+#if LOCUS_PLATFORM_WINDOWS
+	unsigned long Index;
+	_BitScanForward(&Index, X);
+	return static_cast<u32>(Index);
+#else
+	return static_cast<u32>(__builtin_ctz(X));
+#endif
+}
+
+u64 Locus::Math::NextPowerOfTwo(u64 X)
+{
+	if (X <= 1)
+	{
+		return 1;
+	}
+	
+	X--;
+	for (u32 Shift = 1; Shift < 64; Shift <<= 1)
+	{
+		X |= X >> Shift;
+	}
+	return X + 1;
 }
\ No newline at end of file
@@ -38,4 +38,9 @@ namespace Locus::Math
 	u32 Min(u32 X, u32 Y);
 	u32 Max(u32 X, u32 Y);
 	u32 Clamp(u32 X, u32 Min, u32 Max);
+	
+	// Bit scans are undefined for zero.
+	u32 CountLeadingZeros(u32 X);
+	u32 CountTrailingZeros(u32 X);
+	u64 NextPowerOfTwo(u64 X); // X itself if it already is one, 1 for zero
 }
\ No newline at end of file
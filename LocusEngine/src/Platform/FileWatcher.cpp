@@ -0,0 +1,110 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+
+#if LOCUS_PLATFORM_LINUX
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+namespace Locus
+{
+#if LOCUS_PLATFORM_LINUX
+	FileWatcher::~FileWatcher()
+	{
+		if (m_Descriptor >= 0)
+		{
+			close(m_Descriptor);
+		}
+	}
+	
+	bool FileWatcher::Watch(const char* Directory)
+	{
+		if (m_Descriptor < 0)
+		{
+			m_Descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (m_Descriptor < 0)
+			{
+				LLOG(FileWatcher, Error, "inotify_init1 failed, file watching is disabled.");
+				return false;
+			}
+		}
+		
+		// Editors commonly save by writing a temporary file and renaming it over the original.
+		i32 WatchDescriptor = inotify_add_watch(m_Descriptor, Directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (WatchDescriptor < 0)
+		{
+			LLOG(FileWatcher, Warning, "Could not watch %s", Directory);
+			return false;
+		}
+		
+		std::string Path = Directory;
+		if (!Path.empty() && Path.back() != '/')
+		{
+			Path.push_back('/');
+		}
+		
+		m_Directories.push_back({WatchDescriptor, Path});
+		LLOG(FileWatcher, Info, "Watching %s", Directory);
+		return true;
+	}
+	
+	void FileWatcher::Poll(std::vector<std::string>& OutChangedFiles)
+	{
+		if (m_Descriptor < 0)
+		{
+			return;
+		}
+		
+		alignas(inotify_event) char Buffer[4096];
+		arch FirstNew = OutChangedFiles.size();
+		
+		while (true)
+		{
+			ssize_t Length = read(m_Descriptor, Buffer, sizeof(Buffer));
+			if (Length <= 0)
+			{
+				break;
+			}
+			
+			for (char* Ptr = Buffer; Ptr < Buffer + Length; )
+			{
+				const inotify_event* Event = reinterpret_cast<const inotify_event*>(Ptr);
+				Ptr += sizeof(inotify_event) + Event->len;
+				
+				if (Event->len == 0 || (Event->mask & IN_ISDIR))
+				{
+					continue;
+				}
+				
+				for (const WatchedDirectory& Directory : m_Directories)
+				{
+					if (Directory.WatchDescriptor == Event->wd)
+					{
+						std::string FullPath = Directory.Path + Event->name;
+						if (std::find(OutChangedFiles.begin() + FirstNew, OutChangedFiles.end(), FullPath) == OutChangedFiles.end())
+						{
+							OutChangedFiles.push_back(FullPath);
+						}
+						break;
+					}
+				}
+			}
+		}
+	}
+#else
+	FileWatcher::~FileWatcher()
+	{
+	}
+	
+	bool FileWatcher::Watch(const char* Directory)
+	{
+		LLOG(FileWatcher, Warning, "File watching is not implemented on this platform, ignoring %s", Directory);
+		return false;
+	}
+	
+	void FileWatcher::Poll(std::vector<std::string>& OutChangedFiles)
+	{
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+	Non-blocking directory watcher, backed by inotify on Linux.
+	Other platforms currently report no changes.
+*/
+
+namespace Locus
+{
+	class FileWatcher
+	{
+	public:
+		FileWatcher() = default;
+		~FileWatcher();
+		
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+		
+		bool Watch(const char* Directory);
+		
+		// Appends full paths of files written or moved into a watched directory since the last poll.
+		// Each path is reported once per poll even if it was written several times.
+		void Poll(std::vector<std::string>& OutChangedFiles);
+	
+	private:
+		struct WatchedDirectory
+		{
+			i32 WatchDescriptor;
+			std::string Path;
+		};
+		
+		i32 m_Descriptor = -1;
+		std::vector<WatchedDirectory> m_Directories;
+	};
+}
\ No newline at end of file
@@ -25,10 +25,10 @@ namespace Locus
 		SDL_QuitSubSystem(SDL_INIT_VIDEO);
 	}
 	
-	WindowHandle LSDLDisplayManager::CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext)
+	WindowHandle LSDLDisplayManager::CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext, bool bHidden)
 	{
 		LSDLWindow Window = {
-			.Flags = SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN,
+			.Flags = (bHidden ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN) | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI,
 			.Title = Title
 		};
 				
@@ -86,7 +86,15 @@ namespace Locus
 			return;
 		}
 		
-		SDL_GetWindowSize(m_WindowPool.Get(Window).NativeHandle, (i32*)&Width, (i32*)&Height);
+		// In pixels, which is what the swapchain is sized in, and zero while minimised.
+		SDL_Window* NativeHandle = m_WindowPool.Get(Window).NativeHandle;
+		if (SDL_GetWindowFlags(NativeHandle) & SDL_WINDOW_MINIMIZED)
+		{
+			Width = 0;
+			Height = 0;
+			return;
+		}
+		SDL_Vulkan_GetDrawableSize(NativeHandle, (i32*)&Width, (i32*)&Height);
 	}
 	
 	RenderContextHandle LSDLDisplayManager::GetWindowRenderContext(WindowHandle Window)
@@ -34,7 +34,7 @@ namespace Locus
 		LSDLDisplayManager();
 		~LSDLDisplayManager();
 	
-		virtual WindowHandle CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext = true) override;
+		virtual WindowHandle CreateWindow(const char* Title, u32 Width, u32 Height, bool bMakeRenderContext = true, bool bHidden = false) override;
 		virtual void DestroyWindow(WindowHandle Window) override;
 		
 		virtual void* GetNativeWindowHandle(WindowHandle Window) override;
@@ -0,0 +1,344 @@
+#include "LVKBindlessHeap.hpp"
+
+#include <algorithm>
+
+namespace Locus
+{
+	static constexpr u32 BINDLESS_IMAGES = 16384;
+	static constexpr u32 BINDLESS_BUFFERS = 16384;
+	static constexpr u32 BINDLESS_SAMPLERS = 256;
+	
+	static constexpr VkDescriptorType BINDLESS_DESCRIPTOR_TYPES[] = {
+		VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		VK_DESCRIPTOR_TYPE_SAMPLER,
+	};
+	
+	void LVKBindlessHeap::Init(VkDevice Device, VkPhysicalDevice PhysicalDevice, bool bDescriptorIndexing, const LVKBindlessDefaults& Defaults, u32 MaxFrameSets)
+	{
+		m_bBindless = bDescriptorIndexing;
+		m_Defaults = Defaults;
+		
+		VkPhysicalDeviceVulkan12Properties Properties12 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+		VkPhysicalDeviceProperties2 Properties = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &Properties12 };
+		vkGetPhysicalDeviceProperties2(PhysicalDevice, &Properties);
+		
+		if (m_bBindless)
+		{
+			m_Capacity[0] = std::min(BINDLESS_IMAGES, Properties12.maxPerStageDescriptorUpdateAfterBindSampledImages);
+			m_Capacity[1] = std::min(BINDLESS_BUFFERS, Properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+			m_Capacity[2] = std::min(BINDLESS_SAMPLERS, Properties12.maxPerStageDescriptorUpdateAfterBindSamplers);
+		}
+		else
+		{
+			m_Capacity[0] = BINDLESS_FALLBACK_IMAGES;
+			m_Capacity[1] = BINDLESS_FALLBACK_BUFFERS;
+			m_Capacity[2] = BINDLESS_FALLBACK_SAMPLERS;
+		}
+		
+		for (u32 i = 0; i < static_cast<u32>(LVKBindlessType::Count); i++)
+		{
+			m_Allocators[i] = std::make_unique<Pool<u8>>(m_Capacity[i]);
+		}
+		
+		m_Images.assign(m_Capacity[0], { VK_NULL_HANDLE, Defaults.ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+		m_Buffers.assign(m_Capacity[1], { Defaults.Buffer, 0, VK_WHOLE_SIZE });
+		m_Samplers.assign(m_Capacity[2], { Defaults.Sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED });
+		
+		// Layout
+		
+		VkDescriptorSetLayoutBinding Bindings[3];
+		VkDescriptorBindingFlags BindingFlags[3];
+		for (u32 i = 0; i < 3; i++)
+		{
+			Bindings[i] = {
+				.binding = i,
+				.descriptorType = BINDLESS_DESCRIPTOR_TYPES[i],
+				.descriptorCount = m_Capacity[i],
+				.stageFlags = VK_SHADER_STAGE_ALL,
+				.pImmutableSamplers = nullptr,
+			};
+			BindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		}
+		
+		VkDescriptorSetLayoutBindingFlagsCreateInfo BindingFlagsInfo = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+			.pNext = nullptr,
+			.bindingCount = 3,
+			.pBindingFlags = BindingFlags,
+		};
+		
+		VkDescriptorSetLayoutCreateInfo LayoutInfo = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			.pNext = m_bBindless ? &BindingFlagsInfo : nullptr,
+			.flags = m_bBindless ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0u,
+			.bindingCount = 3,
+			.pBindings = Bindings,
+		};
+		
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(Device, &LayoutInfo, nullptr, &m_Layout));
+		
+		// Pool, one set in bindless mode, otherwise one per frame set
+		
+		u32 SetCount = m_bBindless ? 1 : MaxFrameSets;
+		VkDescriptorPoolSize PoolSizes[3];
+		for (u32 i = 0; i < 3; i++)
+		{
+			PoolSizes[i] = { BINDLESS_DESCRIPTOR_TYPES[i], m_Capacity[i] * SetCount };
+		}
+		
+		VkDescriptorPoolCreateInfo PoolInfo = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = m_bBindless ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+			.maxSets = SetCount,
+			.poolSizeCount = 3,
+			.pPoolSizes = PoolSizes,
+		};
+		
+		VK_CHECK_RESULT(vkCreateDescriptorPool(Device, &PoolInfo, nullptr, &m_Pool));
+		
+		if (m_bBindless)
+		{
+			VkDescriptorSetAllocateInfo AllocInfo = {
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.descriptorPool = m_Pool,
+				.descriptorSetCount = 1,
+				.pSetLayouts = &m_Layout,
+			};
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(Device, &AllocInfo, &m_SharedSet));
+		}
+		
+		LLOG(Vulkan, Info, "Bindless heap: %s, %u images, %u buffers, %u samplers.", m_bBindless ? "descriptor indexing" : "per-frame fallback", m_Capacity[0], m_Capacity[1], m_Capacity[2]);
+	}
+	
+	void LVKBindlessHeap::Destroy(VkDevice Device)
+	{
+		vkDestroyDescriptorPool(Device, m_Pool, nullptr);
+		vkDestroyDescriptorSetLayout(Device, m_Layout, nullptr);
+		m_Pool = VK_NULL_HANDLE;
+		m_Layout = VK_NULL_HANDLE;
+		m_SharedSet = VK_NULL_HANDLE;
+		m_FrameSets.clear();
+		m_WriteLog.clear();
+	}
+	
+	LVKBindlessHandle LVKBindlessHeap::Allocate(LVKBindlessType Type)
+	{
+		u32 TypeIndex = static_cast<u32>(Type);
+		Pool<u8>& Allocator = *m_Allocators[TypeIndex];
+		
+		// Pool::Create does not check its size, a full heap is a hard error.
+		LAssertMsg(m_Counts[TypeIndex] < m_Capacity[TypeIndex], "Bindless heap is full.");
+		m_Counts[TypeIndex]++;
+		return Allocator.Create(0);
+	}
+	
+	LVKBindlessHandle LVKBindlessHeap::AddImage(VkDevice Device, VkImageView View, VkImageLayout Layout)
+	{
+		LVKBindlessHandle Handle = Allocate(LVKBindlessType::SampledImage);
+		m_Images[HandleIndex(Handle)] = { VK_NULL_HANDLE, View, Layout };
+		Publish(Device, LVKBindlessType::SampledImage, HandleIndex(Handle));
+		return Handle;
+	}
+	
+	LVKBindlessHandle LVKBindlessHeap::AddBuffer(VkDevice Device, VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Range)
+	{
+		LVKBindlessHandle Handle = Allocate(LVKBindlessType::StorageBuffer);
+		m_Buffers[HandleIndex(Handle)] = { Buffer, Offset, Range };
+		Publish(Device, LVKBindlessType::StorageBuffer, HandleIndex(Handle));
+		return Handle;
+	}
+	
+	LVKBindlessHandle LVKBindlessHeap::AddSampler(VkDevice Device, VkSampler Sampler)
+	{
+		LVKBindlessHandle Handle = Allocate(LVKBindlessType::Sampler);
+		m_Samplers[HandleIndex(Handle)] = { Sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+		Publish(Device, LVKBindlessType::Sampler, HandleIndex(Handle));
+		return Handle;
+	}
+	
+	void LVKBindlessHeap::Remove(VkDevice Device, LVKBindlessType Type, LVKBindlessHandle Handle)
+	{
+		u32 TypeIndex = static_cast<u32>(Type);
+		if (!m_Allocators[TypeIndex]->Destroy(Handle))
+		{
+			LLOG(Vulkan, Warning, "Removing a stale bindless handle.");
+			return;
+		}
+		m_Counts[TypeIndex]--;
+		
+		// Point the slot back at the default so a stray index reads something valid.
+		u32 Index = HandleIndex(Handle);
+		switch (Type)
+		{
+			case LVKBindlessType::SampledImage: m_Images[Index] = { VK_NULL_HANDLE, m_Defaults.ImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }; break;
+			case LVKBindlessType::StorageBuffer: m_Buffers[Index] = { m_Defaults.Buffer, 0, VK_WHOLE_SIZE }; break;
+			case LVKBindlessType::Sampler: m_Samplers[Index] = { m_Defaults.Sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED }; break;
+			default: break;
+		}
+		Publish(Device, Type, Index);
+	}
+	
+	void LVKBindlessHeap::Publish(VkDevice Device, LVKBindlessType Type, u32 Index)
+	{
+		Slot Changed = { Type, Index };
+		if (m_bBindless)
+		{
+			// Update-after-bind and update-unused-while-pending make this safe with frames in flight.
+			Write(Device, m_SharedSet, &Changed, 1);
+			return;
+		}
+		
+		m_WriteLog.push_back(Changed);
+	}
+	
+	void LVKBindlessHeap::Write(VkDevice Device, VkDescriptorSet Set, const Slot* Slots, u32 SlotCount) const
+	{
+		std::vector<VkWriteDescriptorSet> Writes;
+		Writes.reserve(SlotCount);
+		
+		for (u32 i = 0; i < SlotCount; i++)
+		{
+			const Slot& Changed = Slots[i];
+			VkWriteDescriptorSet Write = {
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = Set,
+				.dstBinding = static_cast<u32>(Changed.Type),
+				.dstArrayElement = Changed.Index,
+				.descriptorCount = 1,
+				.descriptorType = BINDLESS_DESCRIPTOR_TYPES[static_cast<u32>(Changed.Type)],
+			};
+			
+			switch (Changed.Type)
+			{
+				case LVKBindlessType::SampledImage: Write.pImageInfo = &m_Images[Changed.Index]; break;
+				case LVKBindlessType::StorageBuffer: Write.pBufferInfo = &m_Buffers[Changed.Index]; break;
+				case LVKBindlessType::Sampler: Write.pImageInfo = &m_Samplers[Changed.Index]; break;
+				default: continue;
+			}
+			
+			Writes.push_back(Write);
+		}
+		
+		vkUpdateDescriptorSets(Device, static_cast<u32>(Writes.size()), Writes.data(), 0, nullptr);
+	}
+	
+	u32 LVKBindlessHeap::CreateFrameSet(VkDevice Device)
+	{
+		u32 Index = 0;
+		while (Index < m_FrameSets.size() && m_FrameSets[Index].bAlive)
+		{
+			Index++;
+		}
+		if (Index == m_FrameSets.size())
+		{
+			m_FrameSets.emplace_back();
+		}
+		
+		FrameSetState& FrameSet = m_FrameSets[Index];
+		FrameSet.bAlive = true;
+		FrameSet.AppliedWrites = m_WriteLogBase + m_WriteLog.size();
+		
+		if (m_bBindless)
+		{
+			FrameSet.Set = m_SharedSet;
+			return Index;
+		}
+		
+		VkDescriptorSetAllocateInfo AllocInfo = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.descriptorPool = m_Pool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &m_Layout,
+		};
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(Device, &AllocInfo, &FrameSet.Set));
+		
+		// Without partially bound descriptors every slot must be valid, so fill the whole copy.
+		std::vector<Slot> AllSlots;
+		for (u32 Type = 0; Type < static_cast<u32>(LVKBindlessType::Count); Type++)
+		{
+			for (u32 i = 0; i < m_Capacity[Type]; i++)
+			{
+				AllSlots.push_back({ static_cast<LVKBindlessType>(Type), i });
+			}
+		}
+		Write(Device, FrameSet.Set, AllSlots.data(), static_cast<u32>(AllSlots.size()));
+		
+		return Index;
+	}
+	
+	void LVKBindlessHeap::DestroyFrameSet(VkDevice Device, u32 FrameSet)
+	{
+		FrameSetState& State = m_FrameSets[FrameSet];
+		if (!m_bBindless)
+		{
+			VK_CHECK_RESULT(vkFreeDescriptorSets(Device, m_Pool, 1, &State.Set));
+		}
+		State = {};
+	}
+	
+	VkDescriptorSet LVKBindlessHeap::Sync(VkDevice Device, u32 FrameSet)
+	{
+		FrameSetState& State = m_FrameSets[FrameSet];
+		if (m_bBindless)
+		{
+			return State.Set;
+		}
+		
+		u64 LogEnd = m_WriteLogBase + m_WriteLog.size();
+		if (State.AppliedWrites < LogEnd)
+		{
+			// The log holds slots, not values, so replaying a slot twice is harmless and always writes its latest contents.
+			arch First = static_cast<arch>(State.AppliedWrites - m_WriteLogBase);
+			Write(Device, State.Set, m_WriteLog.data() + First, static_cast<u32>(m_WriteLog.size() - First));
+			State.AppliedWrites = LogEnd;
+		}
+		
+		// Drop whatever every live frame set has consumed.
+		u64 Oldest = LogEnd;
+		for (const FrameSetState& Other : m_FrameSets)
+		{
+			if (Other.bAlive)
+			{
+				Oldest = std::min(Oldest, Other.AppliedWrites);
+			}
+		}
+		
+		if (Oldest > m_WriteLogBase)
+		{
+			m_WriteLog.erase(m_WriteLog.begin(), m_WriteLog.begin() + static_cast<arch>(Oldest - m_WriteLogBase));
+			m_WriteLogBase = Oldest;
+		}
+		
+		return State.Set;
+	}
+	
+	bool LVKBindlessHeap::MatchesLayout(const std::vector<VkDescriptorSetLayoutBinding>& Bindings) const
+	{
+		if (Bindings.empty())
+		{
+			return false;
+		}
+		
+		for (const VkDescriptorSetLayoutBinding& Binding : Bindings)
+		{
+			if (Binding.binding >= static_cast<u32>(LVKBindlessType::Count) || Binding.descriptorType != BINDLESS_DESCRIPTOR_TYPES[Binding.binding])
+			{
+				return false;
+			}
+			
+			// Runtime sized arrays need descriptor indexing, fixed ones must fit the heap.
+			bool bRuntimeSized = Binding.descriptorCount == 0;
+			if ((bRuntimeSized && !m_bBindless) || Binding.descriptorCount > m_Capacity[Binding.binding])
+			{
+				return false;
+			}
+		}
+		
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "Base/Handles.hpp"
+
+#include <vector>
+
+/*
+	Global bindless descriptor heap.
+	
+	One descriptor set holds every sampled image, storage buffer and sampler the renderer knows
+	about. Resources are registered once, receive a stable handle, and shaders index the arrays with
+	HandleIndex(Handle), normally passed in through push constants. See shaders/bindless.glsl.
+	Shaders declare it at BINDLESS_SET, set 0 is left to the material's own bindings.
+	
+	With descriptor indexing the set is update-after-bind and partially bound, so there is a single
+	set that is written in place. Without it, each frame slot of each render context gets its own
+	copy of the set. Writes are logged, and a copy catches up in Sync once its frame's timeline value has
+	been reached. Slots without a resource hold the default descriptors.
+*/
+
+namespace Locus
+{
+	using LVKBindlessHandle = HandleType;
+	
+	enum class LVKBindlessType : u32
+	{
+		SampledImage = 0,
+		StorageBuffer = 1,
+		Sampler = 2,
+		Count
+	};
+	
+	constexpr u32 BINDLESS_SET = 1; // Matches BINDLESS_SET in bindless.glsl
+	
+	// Guaranteed minimum per-stage limits, the fallback arrays in bindless.glsl use the same sizes.
+	constexpr u32 BINDLESS_FALLBACK_IMAGES = 16;
+	constexpr u32 BINDLESS_FALLBACK_BUFFERS = 4;
+	constexpr u32 BINDLESS_FALLBACK_SAMPLERS = 16;
+	
+	struct LVKBindlessDefaults
+	{
+		VkImageView ImageView;
+		VkBuffer Buffer;
+		VkSampler Sampler;
+	};
+	
+	class LVKBindlessHeap
+	{
+	public:
+		LVKBindlessHeap() = default;
+		LVKBindlessHeap(const LVKBindlessHeap&) = delete;
+		LVKBindlessHeap& operator=(const LVKBindlessHeap&) = delete;
+		
+		void Init(VkDevice Device, VkPhysicalDevice PhysicalDevice, bool bDescriptorIndexing, const LVKBindlessDefaults& Defaults, u32 MaxFrameSets);
+		void Destroy(VkDevice Device);
+		
+		LVKBindlessHandle AddImage(VkDevice Device, VkImageView View, VkImageLayout Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		LVKBindlessHandle AddBuffer(VkDevice Device, VkBuffer Buffer, VkDeviceSize Offset = 0, VkDeviceSize Range = VK_WHOLE_SIZE);
+		LVKBindlessHandle AddSampler(VkDevice Device, VkSampler Sampler);
+		
+		// The slot is reused immediately, only call this once no frame in flight can reference the resource.
+		void Remove(VkDevice Device, LVKBindlessType Type, LVKBindlessHandle Handle);
+		
+		// A frame set is the descriptor set one frame slot binds. In bindless mode every frame set is the shared set.
+		u32 CreateFrameSet(VkDevice Device);
+		void DestroyFrameSet(VkDevice Device, u32 FrameSet);
+		VkDescriptorSet Sync(VkDevice Device, u32 FrameSet); // Only once the frame slot's timeline value has been reached
+		
+		// True if these reflected bindings describe this heap, so a pipeline can use its layout.
+		bool MatchesLayout(const std::vector<VkDescriptorSetLayoutBinding>& Bindings) const;
+		
+		VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+		bool IsBindless() const { return m_bBindless; }
+		u32 GetCapacity(LVKBindlessType Type) const { return m_Capacity[static_cast<u32>(Type)]; }
+		u32 GetCount(LVKBindlessType Type) const { return m_Counts[static_cast<u32>(Type)]; }
+	
+	private:
+		struct Slot
+		{
+			LVKBindlessType Type;
+			u32 Index;
+		};
+		
+		struct FrameSetState
+		{
+			VkDescriptorSet Set = VK_NULL_HANDLE;
+			u64 AppliedWrites = 0;
+			bool bAlive = false;
+		};
+		
+		LVKBindlessHandle Allocate(LVKBindlessType Type);
+		void Write(VkDevice Device, VkDescriptorSet Set, const Slot* Slots, u32 SlotCount) const;
+		void Publish(VkDevice Device, LVKBindlessType Type, u32 Index);
+		
+		bool m_bBindless = false;
+		VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
+		VkDescriptorSet m_SharedSet = VK_NULL_HANDLE;
+		LVKBindlessDefaults m_Defaults = {};
+		
+		u32 m_Capacity[static_cast<u32>(LVKBindlessType::Count)] = {};
+		u32 m_Counts[static_cast<u32>(LVKBindlessType::Count)] = {};
+		Unique<Pool<u8>> m_Allocators[static_cast<u32>(LVKBindlessType::Count)];
+		
+		// Current contents of every slot, the source for writes into any copy of the set.
+		std::vector<VkDescriptorImageInfo> m_Images;
+		std::vector<VkDescriptorBufferInfo> m_Buffers;
+		std::vector<VkDescriptorImageInfo> m_Samplers;
+		
+		// Fallback only, slots changed since the oldest frame set last synced.
+		std::vector<Slot> m_WriteLog;
+		u64 m_WriteLogBase = 0;
+		std::vector<FrameSetState> m_FrameSets;
+	};
+}
\ No newline at end of file
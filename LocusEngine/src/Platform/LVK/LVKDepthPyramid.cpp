@@ -0,0 +1,254 @@
+#include "LVKDepthPyramid.hpp"
+#include "LVKResources.hpp"
+#include "Math/Numerics.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Locus
+{
+	static constexpr VkFormat DEPTH_PYRAMID_FORMAT = VK_FORMAT_R32_SFLOAT;
+	static constexpr u32 DEPTH_PYRAMID_GROUP_SIZE = 8;
+	
+	// Largest power of two no greater than X, X is at least one.
+	static u32 FloorPowerOfTwo(u32 X)
+	{
+		return 1u << (31 - Math::CountLeadingZeros(X));
+	}
+	
+	void LVKDepthPyramid::Init(VkDevice Device, VmaAllocator Allocator, std::function<void(std::function<void()>&&)>&& Retire)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		m_Retire = std::move(Retire);
+		
+		VkSamplerCreateInfo SamplerInfo = {
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.pNext = nullptr,
+			.magFilter = VK_FILTER_NEAREST,
+			.minFilter = VK_FILTER_NEAREST,
+			.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+			.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.maxLod = VK_LOD_CLAMP_NONE,
+		};
+		VK_CHECK_RESULT(vkCreateSampler(Device, &SamplerInfo, nullptr, &m_Sampler));
+	}
+	
+	void LVKDepthPyramid::Destroy()
+	{
+		DestroyImage();
+		if (m_Sampler != VK_NULL_HANDLE)
+		{
+			vkDestroySampler(m_Device, m_Sampler, nullptr);
+			m_Sampler = VK_NULL_HANDLE;
+		}
+	}
+	
+	void LVKDepthPyramid::Resize(VkExtent2D DepthExtent)
+	{
+		if (m_Image != VK_NULL_HANDLE && DepthExtent.width == m_DepthExtent.width && DepthExtent.height == m_DepthExtent.height)
+		{
+			return;
+		}
+		
+		// Frames still in flight may read the old image, it goes once they have finished.
+		if (m_Image != VK_NULL_HANDLE)
+		{
+			VkDevice Device = m_Device;
+			VmaAllocator Allocator = m_Allocator;
+			VkImage Image = m_Image;
+			VmaAllocation Allocation = m_Allocation;
+			std::vector<VkImageView> Views = m_LevelViews;
+			Views.push_back(m_View);
+			m_Retire([=](){
+				for (VkImageView View : Views)
+				{
+					vkDestroyImageView(Device, View, nullptr);
+				}
+				vmaDestroyImage(Allocator, Image, Allocation);
+			});
+			m_Image = VK_NULL_HANDLE;
+			m_View = VK_NULL_HANDLE;
+			m_LevelViews.clear();
+		}
+		
+		m_DepthExtent = DepthExtent;
+		m_Extent = { FloorPowerOfTwo(std::max(DepthExtent.width, 1u)), FloorPowerOfTwo(std::max(DepthExtent.height, 1u)) };
+		m_LevelCount = 32 - Math::CountLeadingZeros(std::max(m_Extent.width, m_Extent.height));
+		m_Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		m_bBuilt = false;
+		
+		VkImageCreateInfo ImageInfo = LVKImage::CreateInfo(DEPTH_PYRAMID_FORMAT, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, { m_Extent.width, m_Extent.height, 1 });
+		ImageInfo.mipLevels = m_LevelCount;
+		VmaAllocationCreateInfo AllocInfo = {
+			.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+			.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		};
+		VK_CHECK_RESULT(vmaCreateImage(m_Allocator, &ImageInfo, &AllocInfo, &m_Image, &m_Allocation, nullptr));
+		
+		VkImageViewCreateInfo ViewInfo = LVKImage::ViewCreateInfo(DEPTH_PYRAMID_FORMAT, m_Image, VK_IMAGE_ASPECT_COLOR_BIT);
+		ViewInfo.subresourceRange.levelCount = m_LevelCount;
+		VK_CHECK_RESULT(vkCreateImageView(m_Device, &ViewInfo, nullptr, &m_View));
+		
+		m_LevelViews.resize(m_LevelCount);
+		for (u32 Level = 0; Level < m_LevelCount; Level++)
+		{
+			ViewInfo.subresourceRange.baseMipLevel = Level;
+			ViewInfo.subresourceRange.levelCount = 1;
+			VK_CHECK_RESULT(vkCreateImageView(m_Device, &ViewInfo, nullptr, &m_LevelViews[Level]));
+		}
+	}
+	
+	LVKGraphResource LVKDepthPyramid::Import(LVKRenderGraph& Graph)
+	{
+		LAssertMsg(m_Image != VK_NULL_HANDLE, "The depth pyramid is sized before it is used.");
+		
+		// Last touched by the previous frame's compute passes, earlier on the same queue.
+		LVKGraphResourceState Initial = {
+			.Stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.Access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			.Layout = m_Layout,
+		};
+		m_Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		return Graph.ImportImage("Depth Pyramid", m_Image, m_View, DEPTH_PYRAMID_FORMAT, { m_Extent.width, m_Extent.height, 1 }, Initial, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+	
+	void LVKDepthPyramid::Build(LVKRenderGraph& Graph, LVKGraphResource Pyramid, LVKGraphResource Depth, VkExtent2D DrawExtent, const f32 ViewProjection[16], const LVKGpuScenePipeline& Pipeline, LVKDownsampler* Downsampler, const LVKGpuScenePipeline& DownsamplePipeline, LVKDescriptorAllocator* Descriptors, VkQueryPool TimestampPool, u32 TimestampQuery)
+	{
+		if (Pipeline.Pipeline == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		// Levels reduced one dispatch at a time, only level 0 once the downsampler can do the rest.
+		bool bDownsample = Downsampler != nullptr && DownsamplePipeline.Pipeline != VK_NULL_HANDLE;
+		u32 DispatchedLevels = bDownsample ? 1 : m_LevelCount;
+		
+		std::vector<VkDescriptorSet> Sets(DispatchedLevels);
+		for (VkDescriptorSet& Set : Sets)
+		{
+			Set = Descriptors->Allocate(m_Device, Pipeline.SetLayout);
+		}
+		
+		VkDevice Device = m_Device;
+		VkSampler Sampler = m_Sampler;
+		std::vector<VkImageView> LevelViews = m_LevelViews;
+		VkExtent2D Extent = m_Extent;
+		VkExtent2D SourceExtent = { std::min(DrawExtent.width, m_DepthExtent.width), std::min(DrawExtent.height, m_DepthExtent.height) };
+		
+		Graph.AddPass("Depth Pyramid", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			if (TimestampPool != VK_NULL_HANDLE)
+			{
+				vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, TimestampPool, TimestampQuery);
+			}
+			
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline.Pipeline);
+			
+			struct
+			{
+				u32 SourceSize[2];
+				u32 DestinationSize[2];
+			} Constants;
+			Constants.SourceSize[0] = SourceExtent.width;
+			Constants.SourceSize[1] = SourceExtent.height;
+			
+			for (u32 Level = 0; Level < DispatchedLevels; Level++)
+			{
+				Constants.DestinationSize[0] = std::max(Extent.width >> Level, 1u);
+				Constants.DestinationSize[1] = std::max(Extent.height >> Level, 1u);
+				
+				// Level 0 reads the depth buffer, every other level the one before, still in general layout.
+				VkDescriptorImageInfo ImageInfos[2] = {
+					Level == 0 ? VkDescriptorImageInfo{ Sampler, Graph.GetImageView(Depth), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } : VkDescriptorImageInfo{ Sampler, LevelViews[Level - 1], VK_IMAGE_LAYOUT_GENERAL },
+					{ VK_NULL_HANDLE, LevelViews[Level], VK_IMAGE_LAYOUT_GENERAL },
+				};
+				VkWriteDescriptorSet Writes[2];
+				for (u32 i = 0; i < 2; i++)
+				{
+					Writes[i] = {
+						.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						.pNext = nullptr,
+						.dstSet = Sets[Level],
+						.dstBinding = i,
+						.dstArrayElement = 0,
+						.descriptorCount = 1,
+						.descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+						.pImageInfo = &ImageInfos[i],
+						.pBufferInfo = nullptr,
+					};
+				}
+				vkUpdateDescriptorSets(Device, 2, Writes, 0, nullptr);
+				
+				if (Level > 0)
+				{
+					VkMemoryBarrier2 LevelBarrier = {
+						.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+						.pNext = nullptr,
+						.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+						.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+						.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+						.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+					};
+					VkDependencyInfo Dependency = {
+						.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+						.pNext = nullptr,
+						.memoryBarrierCount = 1,
+						.pMemoryBarriers = &LevelBarrier,
+					};
+					vkCmdPipelineBarrier2(Cmd, &Dependency);
+				}
+				
+				vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline.Layout, 0, 1, &Sets[Level], 0, nullptr);
+				vkCmdPushConstants(Cmd, Pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), &Constants);
+				vkCmdDispatch(Cmd, (Constants.DestinationSize[0] + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, (Constants.DestinationSize[1] + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, 1);
+				
+				Constants.SourceSize[0] = Constants.DestinationSize[0];
+				Constants.SourceSize[1] = Constants.DestinationSize[1];
+			}
+			
+			// The downsampler's own barrier makes level 0 visible to it.
+			if (bDownsample && LevelViews.size() > 1)
+			{
+				LVKDownsampleDesc Downsample = {
+					.Source = LevelViews[0],
+					.SourceLayout = VK_IMAGE_LAYOUT_GENERAL,
+					.BaseExtent = Extent,
+					.LevelViews = LevelViews.data() + 1,
+					.LevelCount = static_cast<u32>(LevelViews.size()) - 1,
+					.Reduction = LVKDownsampleReduction::Min,
+				};
+				Downsampler->Record(Cmd, Downsample, DownsamplePipeline, Descriptors);
+			}
+			
+			if (TimestampPool != VK_NULL_HANDLE)
+			{
+				vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, TimestampPool, TimestampQuery + 1);
+			}
+		}).Read(Depth, LVKGraphAccess::SampledRead).Write(Pyramid, LVKGraphAccess::StorageWrite).SideEffects();
+		
+		// Read by the next frame, which runs after this one on the same queue.
+		memcpy(m_ViewProjection, ViewProjection, sizeof(m_ViewProjection));
+		m_bBuilt = true;
+	}
+	
+	void LVKDepthPyramid::DestroyImage()
+	{
+		for (VkImageView View : m_LevelViews)
+		{
+			vkDestroyImageView(m_Device, View, nullptr);
+		}
+		m_LevelViews.clear();
+		if (m_View != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(m_Device, m_View, nullptr);
+			m_View = VK_NULL_HANDLE;
+		}
+		if (m_Image != VK_NULL_HANDLE)
+		{
+			vmaDestroyImage(m_Allocator, m_Image, m_Allocation);
+			m_Image = VK_NULL_HANDLE;
+		}
+	}
+}
\ No newline at end of file
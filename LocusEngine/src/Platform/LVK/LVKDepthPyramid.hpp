@@ -0,0 +1,76 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKDownsampler.hpp"
+#include "LVKGpuScene.hpp"
+#include "LVKRenderGraph.hpp"
+
+#include <functional>
+#include <vector>
+
+/*
+	Hierarchical depth.
+	
+	A full mip chain of the scene depth, each texel holding the farthest depth of everything under
+	it. Depth is reverse Z, so farthest is the minimum. Level 0 is the largest power of two that
+	fits in the depth image on each axis, and its texels cover the drawn part of the depth buffer
+	whatever the render scale, so the pyramid only changes size with the swapchain.
+	
+	The image lives across frames: it is built from one frame's depth and tested against in the
+	next, along with the view projection it was built with. Level 0 gets a dispatch of its own, as
+	its texels can cover up to three depth texels on an axis. Every level below it halves the one
+	before, so the downsampler builds all of them in a single dispatch, and while its pipeline
+	compiles they fall back to one dispatch per level with a barrier between each.
+*/
+
+namespace Locus
+{
+	class LVKDepthPyramid
+	{
+	public:
+		LVKDepthPyramid() = default;
+		LVKDepthPyramid(const LVKDepthPyramid&) = delete;
+		LVKDepthPyramid& operator=(const LVKDepthPyramid&) = delete;
+		
+		void Init(VkDevice Device, VmaAllocator Allocator, std::function<void(std::function<void()>&&)>&& Retire);
+		void Destroy(); // The GPU must be idle
+		
+		// Sized for a depth image of DepthExtent, a new size retires the old image and forgets what was built.
+		void Resize(VkExtent2D DepthExtent);
+		
+		// Imported once per frame, sampled as a whole chain and left ready to be sampled.
+		LVKGraphResource Import(LVKRenderGraph& Graph);
+		
+		// Adds the pass building every level from the top left DrawExtent of Depth, the levels below 0
+		// with Downsampler when DownsamplePipeline is ready. Timed with the pair of queries at
+		// TimestampQuery when TimestampPool is set.
+		void Build(LVKRenderGraph& Graph, LVKGraphResource Pyramid, LVKGraphResource Depth, VkExtent2D DrawExtent, const f32 ViewProjection[16], const LVKGpuScenePipeline& Pipeline, LVKDownsampler* Downsampler, const LVKGpuScenePipeline& DownsamplePipeline, LVKDescriptorAllocator* Descriptors, VkQueryPool TimestampPool, u32 TimestampQuery);
+		
+		bool IsBuilt() const { return m_bBuilt; }
+		const f32* GetViewProjection() const { return m_ViewProjection; } // Of the depth last built from
+		VkExtent2D GetExtent() const { return m_Extent; }
+		u32 GetLevelCount() const { return m_LevelCount; }
+		VkSampler GetSampler() const { return m_Sampler; }
+	
+	private:
+		void DestroyImage();
+		
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		std::function<void(std::function<void()>&&)> m_Retire;
+		VkSampler m_Sampler = VK_NULL_HANDLE; // Nearest, levels are read with texelFetch
+		
+		VkImage m_Image = VK_NULL_HANDLE;
+		VmaAllocation m_Allocation = VK_NULL_HANDLE;
+		VkImageView m_View = VK_NULL_HANDLE; // Every level
+		std::vector<VkImageView> m_LevelViews;
+		VkExtent2D m_DepthExtent = { 0, 0 };
+		VkExtent2D m_Extent = { 0, 0 }; // Of level 0
+		u32 m_LevelCount = 0;
+		VkImageLayout m_Layout = VK_IMAGE_LAYOUT_UNDEFINED; // At the start of the next frame
+		
+		bool m_bBuilt = false;
+		f32 m_ViewProjection[16] = {};
+	};
+}
\ No newline at end of file
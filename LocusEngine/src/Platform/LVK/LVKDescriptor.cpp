@@ -2,15 +2,17 @@
 #include "Platform/LVK/LVKTypes.hpp"
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
+
 namespace Locus
 {
-	void LVKDescriptorLayoutFactory::Push(u32 Binding, VkDescriptorType Type)
+	void LVKDescriptorLayoutFactory::Push(u32 Binding, VkDescriptorType Type, u32 Count, VkShaderStageFlags Stages)
 	{
 		Bindings.Push({
 			.binding = Binding,
 			.descriptorType = Type,
-			.descriptorCount = 1,
-			.stageFlags = 0,
+			.descriptorCount = Count,
+			.stageFlags = Stages,
 			.pImmutableSamplers = nullptr
 		});
 	}
@@ -45,48 +47,129 @@ namespace Locus
 		return SetLayout;
 	}
 	
-	void LVKDescriptorAllocator::InitPool(VkDevice Device, VkDescriptorPoolSize* Regions, u32 RegionCount)
+	// Growth stops here, past this a single pool gains little over several.
+	static constexpr u32 DESCRIPTOR_POOL_SETS_MAX = 4096;
+	
+	void LVKDescriptorAllocator::Init(VkDevice Device, u32 InitialSets, const LVKDescriptorPoolRatio* Ratios, u32 RatioCount, VkDescriptorPoolCreateFlags Flags)
+	{
+		m_Flags = Flags;
+		m_Ratios.assign(Ratios, Ratios + RatioCount);
+		m_ReadyPools.push_back(CreatePool(Device, InitialSets));
+		m_SetsPerPool = std::min(InitialSets + InitialSets / 2, DESCRIPTOR_POOL_SETS_MAX);
+	}
+	
+	void LVKDescriptorAllocator::Destroy(VkDevice Device)
+	{
+		for (VkDescriptorPool Pool : m_ReadyPools)
+		{
+			vkDestroyDescriptorPool(Device, Pool, nullptr);
+		}
+		for (VkDescriptorPool Pool : m_FullPools)
+		{
+			vkDestroyDescriptorPool(Device, Pool, nullptr);
+		}
+		m_ReadyPools.clear();
+		m_FullPools.clear();
+	}
+	
+	VkDescriptorPool LVKDescriptorAllocator::CreatePool(VkDevice Device, u32 SetCount)
 	{
-		u32 MaxSets = 0;
-		for (arch i = 0; i < RegionCount; i++)
+		std::vector<VkDescriptorPoolSize> PoolSizes;
+		for (const LVKDescriptorPoolRatio& Ratio : m_Ratios)
 		{
-			MaxSets += Regions[i].descriptorCount;
+			PoolSizes.push_back({
+				.type = Ratio.Type,
+				.descriptorCount = std::max(1u, static_cast<u32>(Ratio.Ratio * SetCount)),
+			});
 		}
 		
 		VkDescriptorPoolCreateInfo PoolCreateInfo = {
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-			.flags = 0,
-			.maxSets = MaxSets,
-			.poolSizeCount = RegionCount,
-			.pPoolSizes = Regions
+			.pNext = nullptr,
+			.flags = m_Flags,
+			.maxSets = SetCount,
+			.poolSizeCount = static_cast<u32>(PoolSizes.size()),
+			.pPoolSizes = PoolSizes.data()
 		};
 		
+		VkDescriptorPool Pool;
 		VK_CHECK_RESULT(vkCreateDescriptorPool(Device, &PoolCreateInfo, nullptr, &Pool));
+		return Pool;
 	}
 	
-	void LVKDescriptorAllocator::DestroyPool(VkDevice Device)
+	VkDescriptorPool LVKDescriptorAllocator::AcquirePool(VkDevice Device)
 	{
-		vkDestroyDescriptorPool(Device, Pool, nullptr);
+		if (!m_ReadyPools.empty())
+		{
+			VkDescriptorPool Pool = m_ReadyPools.back();
+			m_ReadyPools.pop_back();
+			return Pool;
+		}
+		
+		VkDescriptorPool Pool = CreatePool(Device, m_SetsPerPool);
+		m_SetsPerPool = std::min(m_SetsPerPool + m_SetsPerPool / 2, DESCRIPTOR_POOL_SETS_MAX);
+		return Pool;
 	}
 	
-	VkDescriptorSet LVKDescriptorAllocator::AllocateDescriptor(VkDevice Device, VkDescriptorSetLayout Layout)
+	VkDescriptorSet LVKDescriptorAllocator::Allocate(VkDevice Device, VkDescriptorSetLayout Layout, const void* pNext, VkDescriptorPool* OutPool)
 	{
+		VkDescriptorPool Pool = AcquirePool(Device);
+		
 		VkDescriptorSetAllocateInfo AllocInfo = {
 			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-			.pNext = nullptr,
+			.pNext = pNext,
 			.descriptorPool = Pool,
 			.descriptorSetCount = 1,
 			.pSetLayouts = &Layout
 		};
 		
 		VkDescriptorSet DescriptorSet;
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(Device, &AllocInfo, &DescriptorSet));
+		VkResult Result = vkAllocateDescriptorSets(Device, &AllocInfo, &DescriptorSet);
+		
+		if (Result == VK_ERROR_OUT_OF_POOL_MEMORY || Result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			// Retire the exhausted pool until the next reset and retry once with a fresh one.
+			m_FullPools.push_back(Pool);
+			Pool = AcquirePool(Device);
+			AllocInfo.descriptorPool = Pool;
+			Result = vkAllocateDescriptorSets(Device, &AllocInfo, &DescriptorSet);
+		}
+		
+		VK_CHECK_RESULT(Result);
+		m_ReadyPools.push_back(Pool);
 		
+		if (OutPool)
+		{
+			*OutPool = Pool;
+		}
 		return DescriptorSet;
 	}
 	
-	void LVKDescriptorAllocator::ClearDescriptors(VkDevice Device)
+	void LVKDescriptorAllocator::Free(VkDevice Device, VkDescriptorPool Pool, VkDescriptorSet Set)
 	{
-		vkResetDescriptorPool(Device, Pool, 0);
+		LAssertMsg(m_Flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT, "Descriptor allocator was not created with the free flag.");
+		VK_CHECK_RESULT(vkFreeDescriptorSets(Device, Pool, 1, &Set));
+		
+		// The pool has room again, let it take allocations before any new pool is made.
+		auto It = std::find(m_FullPools.begin(), m_FullPools.end(), Pool);
+		if (It != m_FullPools.end())
+		{
+			m_FullPools.erase(It);
+			m_ReadyPools.insert(m_ReadyPools.begin(), Pool);
+		}
+	}
+	
+	void LVKDescriptorAllocator::Reset(VkDevice Device)
+	{
+		for (VkDescriptorPool Pool : m_ReadyPools)
+		{
+			VK_CHECK_RESULT(vkResetDescriptorPool(Device, Pool, 0));
+		}
+		for (VkDescriptorPool Pool : m_FullPools)
+		{
+			VK_CHECK_RESULT(vkResetDescriptorPool(Device, Pool, 0));
+			m_ReadyPools.push_back(Pool);
+		}
+		m_FullPools.clear();
 	}
 }
\ No newline at end of file
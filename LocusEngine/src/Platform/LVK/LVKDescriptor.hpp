@@ -2,13 +2,15 @@
 
 #include "LVKCommon.hpp"
 
+#include <vector>
+
 namespace Locus
 {
 	struct LVKDescriptorLayoutFactory
 	{
 		TArray<VkDescriptorSetLayoutBinding> Bindings;
 		
-		void Push(u32 Binding, VkDescriptorType Type);
+		void Push(u32 Binding, VkDescriptorType Type, u32 Count = 1, VkShaderStageFlags Stages = 0);
 		void Clear();
 		
 		VkDescriptorSetLayout Create(
@@ -19,14 +21,39 @@ namespace Locus
 		);
 	};
 	
+	// Descriptors of each type to reserve per set a pool is sized for.
+	struct LVKDescriptorPoolRatio
+	{
+		VkDescriptorType Type;
+		f32 Ratio;
+	};
+	
+	/*
+		Pool of descriptor pools. When the current pool runs dry it is retired and a fresh one is
+		taken, each new pool sized larger than the last. Reset returns every pool in one call, so
+		sets are normally meant to live for a single frame. Allocators created with
+		VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT can also free sets one at a time.
+	*/
+	
 	struct LVKDescriptorAllocator
 	{
-		VkDescriptorPool Pool;
+		void Init(VkDevice Device, u32 InitialSets, const LVKDescriptorPoolRatio* Ratios, u32 RatioCount, VkDescriptorPoolCreateFlags Flags = 0);
+		void Destroy(VkDevice Device);
+		
+		VkDescriptorSet Allocate(VkDevice Device, VkDescriptorSetLayout Layout, const void* pNext = nullptr, VkDescriptorPool* OutPool = nullptr);
+		void Free(VkDevice Device, VkDescriptorPool Pool, VkDescriptorSet Set); // Needs the free descriptor set flag
+		void Reset(VkDevice Device); // Only once nothing in flight uses the sets
 		
-		void InitPool(VkDevice Device, VkDescriptorPoolSize* Regions, u32 RegionCount);
-		void DestroyPool(VkDevice Device);
+		u32 GetPoolCount() const { return static_cast<u32>(m_ReadyPools.size() + m_FullPools.size()); }
+	
+	private:
+		VkDescriptorPool AcquirePool(VkDevice Device);
+		VkDescriptorPool CreatePool(VkDevice Device, u32 SetCount);
 		
-		VkDescriptorSet AllocateDescriptor(VkDevice Device, VkDescriptorSetLayout Layout);
-		void ClearDescriptors(VkDevice Device);
+		std::vector<LVKDescriptorPoolRatio> m_Ratios;
+		std::vector<VkDescriptorPool> m_ReadyPools;
+		std::vector<VkDescriptorPool> m_FullPools;
+		u32 m_SetsPerPool = 0;
+		VkDescriptorPoolCreateFlags m_Flags = 0;
 	};
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "LVKDescriptorCache.hpp"
+
+#include "Base/Hash.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Locus
+{
+	static constexpr LVKDescriptorPoolRatio DESCRIPTOR_CACHE_RATIOS[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	};
+	
+	void LVKDescriptorCache::Init(VkDevice Device, u32 Capacity)
+	{
+		m_Capacity = Capacity;
+		m_Allocator.Init(Device, std::min(Capacity, 256u), DESCRIPTOR_CACHE_RATIOS, static_cast<u32>(std::size(DESCRIPTOR_CACHE_RATIOS)), VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+	}
+	
+	void LVKDescriptorCache::Destroy(VkDevice Device)
+	{
+		// Destroying the pools frees every set.
+		m_Allocator.Destroy(Device);
+		m_Entries.clear();
+		m_LRU.clear();
+		m_Retired.clear();
+	}
+	
+	u64 LVKDescriptorCache::HashBindings(VkDescriptorSetLayout Layout, const LVKDescriptorBinding* Bindings, u32 BindingCount)
+	{
+		u64 Key = Hash::FNV1a64Value(Layout);
+		for (u32 i = 0; i < BindingCount; i++)
+		{
+			const LVKDescriptorBinding& Binding = Bindings[i];
+			Key = Hash::FNV1a64Value(Binding.Binding, Key);
+			Key = Hash::FNV1a64Value(Binding.Type, Key);
+			Key = Hash::FNV1a64Value(Binding.Resource, Key);
+			Key = Hash::FNV1a64Value(Binding.ResourceType, Key);
+			Key = Hash::FNV1a64Value(Binding.Image.sampler, Key);
+			Key = Hash::FNV1a64Value(Binding.Image.imageView, Key);
+			Key = Hash::FNV1a64Value(Binding.Image.imageLayout, Key);
+			Key = Hash::FNV1a64Value(Binding.Buffer.buffer, Key);
+			Key = Hash::FNV1a64Value(Binding.Buffer.offset, Key);
+			Key = Hash::FNV1a64Value(Binding.Buffer.range, Key);
+		}
+		return Key;
+	}
+	
+	VkDescriptorSet LVKDescriptorCache::Get(VkDevice Device, VkDescriptorSetLayout Layout, const LVKDescriptorBinding* Bindings, u32 BindingCount)
+	{
+		u64 Key = HashBindings(Layout, Bindings, BindingCount);
+		
+		auto It = m_Entries.find(Key);
+		if (It != m_Entries.end())
+		{
+			m_Hits++;
+			It->second.LastUsedFrame = m_Frame;
+			m_LRU.splice(m_LRU.begin(), m_LRU, It->second.LRU);
+			return It->second.Set;
+		}
+		
+		m_Misses++;
+		
+		Entry NewEntry;
+		NewEntry.Set = m_Allocator.Allocate(Device, Layout, nullptr, &NewEntry.Pool);
+		NewEntry.LastUsedFrame = m_Frame;
+		
+		std::vector<VkWriteDescriptorSet> Writes;
+		Writes.reserve(BindingCount);
+		for (u32 i = 0; i < BindingCount; i++)
+		{
+			const LVKDescriptorBinding& Binding = Bindings[i];
+			
+			bool bBuffer = Binding.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+				Binding.Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+				Binding.Type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+				Binding.Type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+			
+			Writes.push_back({
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = NewEntry.Set,
+				.dstBinding = Binding.Binding,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = Binding.Type,
+				.pImageInfo = bBuffer ? nullptr : &Binding.Image,
+				.pBufferInfo = bBuffer ? &Binding.Buffer : nullptr,
+			});
+			
+			if (HandleIsValid(Binding.Resource))
+			{
+				LAssertMsg(Binding.ResourceType != LVKDescriptorResource::None, "Descriptor binding names a resource without saying which pool it is from.");
+				NewEntry.Resources.push_back({ Binding.ResourceType, Binding.Resource });
+			}
+		}
+		vkUpdateDescriptorSets(Device, static_cast<u32>(Writes.size()), Writes.data(), 0, nullptr);
+		
+		m_LRU.push_front(Key);
+		NewEntry.LRU = m_LRU.begin();
+		VkDescriptorSet Set = NewEntry.Set;
+		m_Entries.emplace(Key, std::move(NewEntry));
+		return Set;
+	}
+	
+	void LVKDescriptorCache::Retire(std::unordered_map<u64, Entry>::iterator It)
+	{
+		m_Retired.push_back({ It->second.Set, It->second.Pool, It->second.LastUsedFrame });
+		m_LRU.erase(It->second.LRU);
+		m_Entries.erase(It);
+	}
+	
+	void LVKDescriptorCache::InvalidateResource(LVKDescriptorResource Type, HandleType Resource)
+	{
+		// Any generation of the same slot in the same pool, the old generation is the one still referenced.
+		for (auto It = m_Entries.begin(); It != m_Entries.end(); )
+		{
+			const std::vector<ResourceRef>& Resources = It->second.Resources;
+			bool bReferenced = std::any_of(Resources.begin(), Resources.end(), [Type, Resource](const ResourceRef& Other) {
+				return Other.Type == Type && HandleIndex(Other.Handle) == HandleIndex(Resource);
+			});
+			
+			auto Next = std::next(It);
+			if (bReferenced)
+			{
+				Retire(It);
+			}
+			It = Next;
+		}
+	}
+	
+	void LVKDescriptorCache::BeginFrame(VkDevice Device, u64 Frame, u64 SafeFrame)
+	{
+		m_Frame = Frame;
+		
+		// Evict from the cold end, stopping at the first set that may still be in flight.
+		while (m_Entries.size() > m_Capacity)
+		{
+			auto It = m_Entries.find(m_LRU.back());
+			if (It->second.LastUsedFrame > SafeFrame)
+			{
+				break;
+			}
+			Retire(It);
+		}
+		
+		auto FirstKept = std::partition(m_Retired.begin(), m_Retired.end(), [SafeFrame](const RetiredSet& Retired) {
+			return Retired.LastUsedFrame > SafeFrame;
+		});
+		for (auto It = FirstKept; It != m_Retired.end(); It++)
+		{
+			m_Allocator.Free(Device, It->Pool, It->Set);
+		}
+		m_Retired.erase(FirstKept, m_Retired.end());
+	}
+}
\ No newline at end of file
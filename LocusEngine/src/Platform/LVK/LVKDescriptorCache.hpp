@@ -0,0 +1,97 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "Base/Handles.hpp"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Long-lived descriptor sets, looked up by what they contain.
+	
+	The key is a hash of the layout and every binding: type, engine resource handle, and the
+	Vulkan objects, offsets and ranges written. A resource that is recreated gets a new handle
+	generation and so a new key, and InvalidateResource drops the sets that still point at the
+	old one. Resources are told apart by their pool as well as their handle, since handles from
+	different pools share indices. Sets unused for a while are evicted least recently used first, but never while a
+	frame in flight may still bind them.
+*/
+
+namespace Locus
+{
+	// Which engine pool a binding's resource handle comes from.
+	enum class LVKDescriptorResource : u32
+	{
+		None,
+		GraphicsBuffer,
+		Texture,
+	};
+	
+	struct LVKDescriptorBinding
+	{
+		u32 Binding = 0;
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		VkDescriptorImageInfo Image = {}; // Image and sampler types
+		VkDescriptorBufferInfo Buffer = {}; // Buffer types
+		HandleType Resource = HANDLE_INVALID; // Engine handle the descriptor was made from, if any
+		LVKDescriptorResource ResourceType = LVKDescriptorResource::None;
+	};
+	
+	class LVKDescriptorCache
+	{
+	public:
+		void Init(VkDevice Device, u32 Capacity);
+		void Destroy(VkDevice Device);
+		
+		// Frame is the graphics timeline value the coming submission signals, entries last used
+		// at or before SafeFrame (the completed value) are no longer referenced by the GPU.
+		void BeginFrame(VkDevice Device, u64 Frame, u64 SafeFrame);
+		
+		VkDescriptorSet Get(VkDevice Device, VkDescriptorSetLayout Layout, const LVKDescriptorBinding* Bindings, u32 BindingCount);
+		
+		// Call when a resource is destroyed or its handle regenerated.
+		void InvalidateResource(LVKDescriptorResource Type, HandleType Resource);
+		
+		u64 GetHits() const { return m_Hits; }
+		u64 GetMisses() const { return m_Misses; }
+		u32 GetEntryCount() const { return static_cast<u32>(m_Entries.size()); }
+	
+	private:
+		struct ResourceRef
+		{
+			LVKDescriptorResource Type;
+			HandleType Handle;
+		};
+		
+		struct Entry
+		{
+			VkDescriptorSet Set;
+			VkDescriptorPool Pool;
+			u64 LastUsedFrame;
+			std::vector<ResourceRef> Resources;
+			std::list<u64>::iterator LRU;
+		};
+		
+		struct RetiredSet
+		{
+			VkDescriptorSet Set;
+			VkDescriptorPool Pool;
+			u64 LastUsedFrame;
+		};
+		
+		static u64 HashBindings(VkDescriptorSetLayout Layout, const LVKDescriptorBinding* Bindings, u32 BindingCount);
+		void Retire(std::unordered_map<u64, Entry>::iterator It);
+		
+		LVKDescriptorAllocator m_Allocator;
+		std::unordered_map<u64, Entry> m_Entries;
+		std::list<u64> m_LRU; // Most recently used at the front
+		std::vector<RetiredSet> m_Retired; // Freed once the GPU is done with them
+		
+		u32 m_Capacity = 0;
+		u64 m_Frame = 0;
+		u64 m_Hits = 0;
+		u64 m_Misses = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "LVKDownsampler.hpp"
+#include "LVKResources.hpp"
+
+#include <algorithm>
+
+namespace Locus
+{
+	static constexpr u32 DOWNSAMPLE_BLOCK_LEVELS = 6; // Per group, before the last one carries on
+	static constexpr u32 DOWNSAMPLE_BLOCK_SIZE = 64; // Texels of the base a group reduces on each axis
+	static constexpr u32 DOWNSAMPLE_BASE_MAX = DOWNSAMPLE_BLOCK_SIZE * DOWNSAMPLE_BLOCK_SIZE; // Widest base whose sixth level one group can finish
+	static constexpr VkDeviceSize DOWNSAMPLE_SCRATCH_HEADER = 16;
+	
+	struct DownsampleConstants
+	{
+		u32 BaseSize[2];
+		u32 LevelCount;
+		u32 Reduction;
+	};
+	
+	void LVKDownsampler::Init(VkDevice Device, VmaAllocator Allocator)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		
+		VkSamplerCreateInfo SamplerInfo = {
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.pNext = nullptr,
+			.magFilter = VK_FILTER_NEAREST,
+			.minFilter = VK_FILTER_NEAREST,
+			.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+			.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+			.maxLod = VK_LOD_CLAMP_NONE,
+		};
+		VK_CHECK_RESULT(vkCreateSampler(Device, &SamplerInfo, nullptr, &m_Sampler));
+		
+		// A texel for every group of the widest base that gets a tail.
+		VkDeviceSize ScratchSize = DOWNSAMPLE_SCRATCH_HEADER + 4 * sizeof(f32) * (DOWNSAMPLE_BASE_MAX / DOWNSAMPLE_BLOCK_SIZE) * (DOWNSAMPLE_BASE_MAX / DOWNSAMPLE_BLOCK_SIZE);
+		m_Scratch = LVKBuffer::Allocate(ScratchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_bScratchCleared = false;
+	}
+	
+	void LVKDownsampler::Destroy()
+	{
+		if (m_Scratch.Buffer != VK_NULL_HANDLE)
+		{
+			vmaDestroyBuffer(m_Allocator, m_Scratch.Buffer, m_Scratch.Allocation);
+			m_Scratch = {};
+		}
+		if (m_Sampler != VK_NULL_HANDLE)
+		{
+			vkDestroySampler(m_Device, m_Sampler, nullptr);
+			m_Sampler = VK_NULL_HANDLE;
+		}
+	}
+	
+	bool LVKDownsampler::GetFormat(VkFormat Format, LVKDownsampleFormat& OutFormat)
+	{
+		switch (Format)
+		{
+			case VK_FORMAT_R8G8B8A8_UNORM: OutFormat = LVKDownsampleFormat::RGBA8; return true;
+			case VK_FORMAT_R16G16B16A16_SFLOAT: OutFormat = LVKDownsampleFormat::RGBA16F; return true;
+			case VK_FORMAT_R32_SFLOAT: OutFormat = LVKDownsampleFormat::R32F; return true;
+			default: return false;
+		}
+	}
+	
+	const char* LVKDownsampler::GetShaderPath(LVKDownsampleFormat Format)
+	{
+		switch (Format)
+		{
+			case LVKDownsampleFormat::RGBA8: return "shaders/downsample_rgba8.comp.spv";
+			case LVKDownsampleFormat::RGBA16F: return "shaders/downsample_rgba16f.comp.spv";
+			case LVKDownsampleFormat::R32F: return "shaders/downsample_r32f.comp.spv";
+			default: return nullptr;
+		}
+	}
+	
+	void LVKDownsampler::Record(VkCommandBuffer Cmd, const LVKDownsampleDesc& Desc, const LVKGpuScenePipeline& Pipeline, LVKDescriptorAllocator* Descriptors)
+	{
+		if (Pipeline.Pipeline == VK_NULL_HANDLE || Desc.LevelCount == 0)
+		{
+			return;
+		}
+		
+		// An odd level's last row and column would never be read, see downsample.glsl.
+		LAssertMsg((Desc.BaseExtent.width & (Desc.BaseExtent.width - 1)) == 0 && (Desc.BaseExtent.height & (Desc.BaseExtent.height - 1)) == 0, "Downsampled bases have to be a power of two wide and high.");
+		
+		// The count is only zeroed once, every dispatch hands it back at zero.
+		if (!m_bScratchCleared)
+		{
+			vkCmdFillBuffer(Cmd, m_Scratch.Buffer, 0, DOWNSAMPLE_SCRATCH_HEADER, 0);
+			m_bScratchCleared = true;
+		}
+		
+		VkImageView Source = Desc.Source;
+		VkImageLayout SourceLayout = Desc.SourceLayout;
+		VkExtent2D Base = Desc.BaseExtent;
+		for (u32 Done = 0; Done < Desc.LevelCount; )
+		{
+			// A base too wide for one group to finish its sixth level stops there, the next dispatch starts from it.
+			u32 Count = std::min(Desc.LevelCount - Done, DOWNSAMPLE_LEVELS_MAX);
+			if (Base.width > DOWNSAMPLE_BASE_MAX || Base.height > DOWNSAMPLE_BASE_MAX)
+			{
+				Count = std::min(Count, DOWNSAMPLE_BLOCK_LEVELS);
+			}
+			
+			// Every slot of the array is written, the ones past Count repeat the last level and are never stored to.
+			VkDescriptorImageInfo SourceInfo = { m_Sampler, Source, SourceLayout };
+			VkDescriptorImageInfo LevelInfos[DOWNSAMPLE_LEVELS_MAX];
+			for (u32 i = 0; i < DOWNSAMPLE_LEVELS_MAX; i++)
+			{
+				LevelInfos[i] = { VK_NULL_HANDLE, Desc.LevelViews[Done + std::min(i, Count - 1)], VK_IMAGE_LAYOUT_GENERAL };
+			}
+			VkDescriptorBufferInfo ScratchInfo = { m_Scratch.Buffer, 0, VK_WHOLE_SIZE };
+			
+			VkDescriptorSet Set = Descriptors->Allocate(m_Device, Pipeline.SetLayout);
+			VkWriteDescriptorSet Writes[3] = {
+				{
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.dstSet = Set,
+					.dstBinding = 0,
+					.descriptorCount = 1,
+					.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+					.pImageInfo = &SourceInfo,
+				},
+				{
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.dstSet = Set,
+					.dstBinding = 1,
+					.descriptorCount = DOWNSAMPLE_LEVELS_MAX,
+					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+					.pImageInfo = LevelInfos,
+				},
+				{
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.dstSet = Set,
+					.dstBinding = 2,
+					.descriptorCount = 1,
+					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					.pBufferInfo = &ScratchInfo,
+				},
+			};
+			vkUpdateDescriptorSets(m_Device, 3, Writes, 0, nullptr);
+			
+			// Earlier downsamples on the queue share the scratch buffer, and the base may be a level the last dispatch wrote.
+			VkMemoryBarrier2 ScratchBarrier = {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+				.pNext = nullptr,
+				.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT,
+				.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			};
+			VkDependencyInfo Dependency = {
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.pNext = nullptr,
+				.memoryBarrierCount = 1,
+				.pMemoryBarriers = &ScratchBarrier,
+			};
+			vkCmdPipelineBarrier2(Cmd, &Dependency);
+			
+			DownsampleConstants Constants = {
+				.BaseSize = { Base.width, Base.height },
+				.LevelCount = Count,
+				.Reduction = static_cast<u32>(Desc.Reduction),
+			};
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline.Pipeline);
+			vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline.Layout, 0, 1, &Set, 0, nullptr);
+			vkCmdPushConstants(Cmd, Pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), &Constants);
+			vkCmdDispatch(Cmd, (Base.width + DOWNSAMPLE_BLOCK_SIZE - 1) / DOWNSAMPLE_BLOCK_SIZE, (Base.height + DOWNSAMPLE_BLOCK_SIZE - 1) / DOWNSAMPLE_BLOCK_SIZE, 1);
+			
+			Done += Count;
+			Source = Desc.LevelViews[Done - 1];
+			SourceLayout = VK_IMAGE_LAYOUT_GENERAL;
+			Base = { std::max(Desc.BaseExtent.width >> Done, 1u), std::max(Desc.BaseExtent.height >> Done, 1u) };
+		}
+	}
+}
\ No newline at end of file
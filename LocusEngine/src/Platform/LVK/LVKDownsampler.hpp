@@ -0,0 +1,82 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKGpuScene.hpp"
+
+/*
+	Single pass downsampler.
+	
+	Builds up to twelve levels below a base level in one dispatch, see downsample.glsl. A level is
+	half the one above rounded down, at least one, each texel the average, minimum or maximum of the
+	2x2 texels above it. The base has to be a power of two wide and high, since nothing folds in the
+	last row and column of an odd level. The depth pyramid's base always is, textures and bloom
+	chains have to be padded or resized to one first. Longer chains are split into dispatches of twelve, and so are bases wider or
+	taller than 4096, six levels at a time, until they fit.
+	
+	The shader writes every level as a storage image, so there is a pipeline per destination format,
+	see LVKDownsampleFormat. Levels are written in general layout through single level views, the
+	base is sampled through its own view and can be any image, or a level of the one being written.
+	
+	Groups that finish early leave their last texel and a count in a scratch buffer the downsampler
+	owns, so dispatches are serialised against every earlier one on the queue with a barrier.
+*/
+
+namespace Locus
+{
+	constexpr u32 DOWNSAMPLE_LEVELS_MAX = 12; // Per dispatch, as in downsample.glsl
+	
+	// One shader per storage image format.
+	enum class LVKDownsampleFormat : u32
+	{
+		RGBA8 = 0, // Textures
+		RGBA16F = 1, // The HDR scene target, bloom chains
+		R32F = 2, // The depth pyramid
+		Count
+	};
+	
+	enum class LVKDownsampleReduction : u32
+	{
+		Average = 0,
+		Min = 1, // Farthest depth with reverse Z
+		Max = 2,
+	};
+	
+	struct LVKDownsampleDesc
+	{
+		VkImageView Source; // The base level, sampled
+		VkImageLayout SourceLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		VkExtent2D BaseExtent; // Of the base, powers of two, only its top left part of the source is read
+		const VkImageView* LevelViews; // One level each, the first is half the base, in general layout
+		u32 LevelCount;
+		LVKDownsampleReduction Reduction = LVKDownsampleReduction::Average;
+	};
+	
+	class LVKDownsampler
+	{
+	public:
+		LVKDownsampler() = default;
+		LVKDownsampler(const LVKDownsampler&) = delete;
+		LVKDownsampler& operator=(const LVKDownsampler&) = delete;
+		
+		void Init(VkDevice Device, VmaAllocator Allocator);
+		void Destroy(); // The GPU must be idle
+		
+		// False for formats with no shader.
+		static bool GetFormat(VkFormat Format, LVKDownsampleFormat& OutFormat);
+		static const char* GetShaderPath(LVKDownsampleFormat Format);
+		
+		// Records the dispatches building every level, with Pipeline the one for the levels' format.
+		// Descriptor sets come from Descriptors and are written as they are recorded. The levels are
+		// left written by the compute stage, the caller makes them visible to whatever reads them.
+		void Record(VkCommandBuffer Cmd, const LVKDownsampleDesc& Desc, const LVKGpuScenePipeline& Pipeline, LVKDescriptorAllocator* Descriptors);
+	
+	private:
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		VkSampler m_Sampler = VK_NULL_HANDLE; // Nearest, the base is read with texelFetch
+		
+		LVKBuffer m_Scratch = {}; // Finished group count and every group's last texel
+		bool m_bScratchCleared = false; // The count starts at zero, and every dispatch leaves it there
+	};
+}
\ No newline at end of file
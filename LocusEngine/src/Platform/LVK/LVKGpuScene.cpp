@@ -0,0 +1,854 @@
+#include "LVKGpuScene.hpp"
+#include "LVKDepthPyramid.hpp"
+#include "LVKHelpers.hpp"
+#include "Math/Numerics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Locus
+{
+	static_assert(sizeof(MeshVertex) == 24, "MeshVertex must match SceneVertex in scene.glsl.");
+	
+	static constexpr u32 DRAW_COMMAND_SIZE = sizeof(VkDrawIndexedIndirectCommand);
+	static constexpr u32 FRAME_SLOTS_INITIAL = 4;
+	static constexpr VkDeviceSize STAGING_SIZE_MIN = 64 * 1024;
+	static constexpr u32 READBACK_RETESTED = 2 * GPU_SCENE_BATCHES_MAX; // After the early then the late counts
+	
+	void LVKGpuScene::Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, bool bDrawIndirectCount, const LVKGpuSceneConfig& Config)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		m_Uploads = Uploads;
+		m_bDrawIndirectCount = bDrawIndirectCount;
+		m_Config = Config;
+		
+		const VkBufferUsageFlags StorageUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		m_Vertices = LVKBuffer::Allocate(sizeof(MeshVertex) * Config.MaxVertices, StorageUsage, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_Indices = LVKBuffer::Allocate(sizeof(u32) * Config.MaxIndices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_MeshTable = LVKBuffer::Allocate(sizeof(LVKGpuSceneMesh) * Config.MaxMeshes, StorageUsage, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_Objects = LVKBuffer::Allocate(sizeof(LVKGpuSceneObject) * Config.MaxObjects, StorageUsage, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_BatchTable = LVKBuffer::Allocate(sizeof(u32) * GPU_SCENE_BATCHES_MAX, StorageUsage, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		
+		m_Meshes = std::make_unique<Pool<Mesh>>(Config.MaxMeshes);
+		m_VertexRanges = std::make_unique<OffsetAllocator>(Config.MaxVertices, Config.MaxMeshes);
+		m_IndexRanges = std::make_unique<OffsetAllocator>(Config.MaxIndices, Config.MaxMeshes);
+		UpdateGeometryStats();
+		m_ObjectHandles = std::make_unique<Pool<u32>>(Config.MaxObjects);
+		
+		m_DenseObjects.reserve(Config.MaxObjects);
+		m_DenseHandles.reserve(Config.MaxObjects);
+		m_FrameSlots.resize(FRAME_SLOTS_INITIAL);
+		
+		LLOG(Vulkan, Info, "GPU scene created, %u vertices, %u indices, %u meshes, %u objects, draw indirect count %s.", Config.MaxVertices, Config.MaxIndices, Config.MaxMeshes, Config.MaxObjects, bDrawIndirectCount ? "on" : "off");
+	}
+	
+	void LVKGpuScene::Destroy()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		for (FrameSlot& Slot : m_FrameSlots)
+		{
+			if (Slot.Staging.Buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(m_Allocator, Slot.Staging.Buffer, Slot.Staging.Allocation);
+			}
+			if (Slot.Constants.Buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(m_Allocator, Slot.Constants.Buffer, Slot.Constants.Allocation);
+			}
+			if (Slot.Readback.Buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(m_Allocator, Slot.Readback.Buffer, Slot.Readback.Allocation);
+			}
+		}
+		m_FrameSlots.clear();
+		
+		for (LVKBuffer* Buffer : { &m_Vertices, &m_Indices, &m_MeshTable, &m_Objects, &m_BatchTable })
+		{
+			vmaDestroyBuffer(m_Allocator, Buffer->Buffer, Buffer->Allocation);
+			*Buffer = {};
+		}
+		
+		m_Meshes.reset();
+		m_ObjectHandles.reset();
+		m_VertexRanges.reset();
+		m_IndexRanges.reset();
+		m_RetiredGeometry.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+	
+	MeshHandle LVKGpuScene::CreateMesh(const MeshVertex* Vertices, u32 VertexCount, const u32* Indices, u32 IndexCount)
+	{
+		LAssert(Vertices != nullptr && Indices != nullptr && VertexCount > 0 && IndexCount > 0);
+		
+		if (m_Stats.Meshes >= m_Config.MaxMeshes)
+		{
+			LLOG(Vulkan, Error, "GPU scene already holds %u meshes, mesh not created.", m_Stats.Meshes);
+			return HANDLE_INVALID;
+		}
+		
+		OffsetAllocation VertexRange = m_VertexRanges->Allocate(VertexCount);
+		OffsetAllocation IndexRange = VertexRange.IsValid() ? m_IndexRanges->Allocate(IndexCount) : OffsetAllocation{};
+		if (!IndexRange.IsValid())
+		{
+			if (VertexRange.IsValid())
+			{
+				m_VertexRanges->Free(VertexRange);
+			}
+			LLOG(Vulkan, Error, "GPU scene geometry has no free range for a mesh of %u vertices and %u indices, mesh not created.", VertexCount, IndexCount);
+			return HANDLE_INVALID;
+		}
+		
+		// Bounding sphere around the centre of the box, looser than the minimal sphere but cheap.
+		f32 Min[3] = { Vertices[0].Position[0], Vertices[0].Position[1], Vertices[0].Position[2] };
+		f32 Max[3] = { Min[0], Min[1], Min[2] };
+		for (u32 i = 1; i < VertexCount; i++)
+		{
+			for (u32 Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(Min[Axis], Vertices[i].Position[Axis]);
+				Max[Axis] = std::max(Max[Axis], Vertices[i].Position[Axis]);
+			}
+		}
+		
+		f32 Centre[3] = { 0.5f * (Min[0] + Max[0]), 0.5f * (Min[1] + Max[1]), 0.5f * (Min[2] + Max[2]) };
+		f32 RadiusSquared = 0.0f;
+		for (u32 i = 0; i < VertexCount; i++)
+		{
+			f32 X = Vertices[i].Position[0] - Centre[0];
+			f32 Y = Vertices[i].Position[1] - Centre[1];
+			f32 Z = Vertices[i].Position[2] - Centre[2];
+			RadiusSquared = std::max(RadiusSquared, X * X + Y * Y + Z * Z);
+		}
+		
+		m_Uploads->UploadBuffer(m_Vertices.Buffer, sizeof(MeshVertex) * VertexRange.Offset, Vertices, sizeof(MeshVertex) * VertexCount);
+		LVKUploadTicket Upload = m_Uploads->UploadBuffer(m_Indices.Buffer, sizeof(u32) * IndexRange.Offset, Indices, sizeof(u32) * IndexCount);
+		
+		Mesh NewMesh = {
+			.Gpu = {
+				.FirstIndex = IndexRange.Offset,
+				.IndexCount = IndexCount,
+				.VertexOffset = static_cast<i32>(VertexRange.Offset),
+				.Pad = 0,
+				.Bounds = { Centre[0], Centre[1], Centre[2], std::sqrt(RadiusSquared) },
+			},
+			.Vertices = VertexRange,
+			.Indices = IndexRange,
+			.Upload = Upload,
+			.Objects = 0,
+			.bResident = false,
+		};
+		
+		MeshHandle Handle = m_Meshes->Create(NewMesh);
+		m_PendingMeshes.push_back(Handle);
+		m_Stats.Meshes++;
+		
+		// The slot may hold a destroyed mesh's entry, objects can see it before the upload lands.
+		m_DirtyMeshes.push_back({ HandleIndex(Handle), {} });
+		return Handle;
+	}
+	
+	void LVKGpuScene::DestroyMesh(MeshHandle Handle)
+	{
+		LAssert(m_Meshes->IsValid(Handle));
+		LAssertMsg(m_Meshes->Get(Handle).Objects == 0, "Mesh destroyed while scene objects still use it.");
+		
+		// Frames already recorded may still draw it, and its upload may still be in flight.
+		const Mesh& Destroyed = m_Meshes->Get(Handle);
+		m_RetiredGeometry.push_back({ Destroyed.Vertices, Destroyed.Indices, Destroyed.Upload, m_LastRecordedValue });
+		
+		m_DirtyMeshes.push_back({ HandleIndex(Handle), {} });
+		m_Meshes->Destroy(Handle);
+		m_Stats.Meshes--;
+	}
+	
+	SceneObjectHandle LVKGpuScene::CreateObject(const SceneObjectDesc& Desc, u32 Batch)
+	{
+		LAssert(m_Meshes->IsValid(Desc.Mesh));
+		LAssert(Batch < GPU_SCENE_BATCHES_MAX);
+		
+		if (m_DenseObjects.size() >= m_Config.MaxObjects)
+		{
+			LLOG(Vulkan, Error, "GPU scene already holds %u objects, object not created.", m_Config.MaxObjects);
+			return HANDLE_INVALID;
+		}
+		
+		LVKGpuSceneObject Object = {
+			.PositionScale = { 0.0f, 0.0f, 0.0f, 1.0f },
+			.Rotation = { 0.0f, 0.0f, 0.0f, 1.0f },
+			.Color = { Desc.Color[0], Desc.Color[1], Desc.Color[2], Desc.Color[3] },
+			.Mesh = HandleIndex(Desc.Mesh),
+			.Batch = Batch,
+			.Pad = { 0, 0 },
+		};
+		FillObject(Object, Desc.Transform);
+		
+		u32 DenseIndex = static_cast<u32>(m_DenseObjects.size());
+		SceneObjectHandle Handle = m_ObjectHandles->Create(DenseIndex);
+		m_DenseObjects.push_back(Object);
+		m_DenseHandles.push_back(Handle);
+		MarkDirty(DenseIndex);
+		
+		m_Meshes->GetMut(Desc.Mesh).Objects++;
+		m_BatchObjects[Batch]++;
+		m_bBatchTableDirty = true;
+		m_Stats.Objects++;
+		return Handle;
+	}
+	
+	void LVKGpuScene::SetObjectTransform(SceneObjectHandle Handle, const SceneTransform& Transform)
+	{
+		LAssert(m_ObjectHandles->IsValid(Handle));
+		u32 DenseIndex = m_ObjectHandles->Get(Handle);
+		FillObject(m_DenseObjects[DenseIndex], Transform);
+		MarkDirty(DenseIndex);
+	}
+	
+	void LVKGpuScene::DestroyObject(SceneObjectHandle Handle)
+	{
+		LAssert(m_ObjectHandles->IsValid(Handle));
+		
+		u32 DenseIndex = m_ObjectHandles->Get(Handle);
+		const LVKGpuSceneObject& Object = m_DenseObjects[DenseIndex];
+		m_Meshes->GetMut(m_Meshes->GetHandleAt(Object.Mesh)).Objects--;
+		m_BatchObjects[Object.Batch]--;
+		m_bBatchTableDirty = true;
+		
+		// Swap the last object into the hole to keep the array dense.
+		u32 LastIndex = static_cast<u32>(m_DenseObjects.size()) - 1;
+		if (DenseIndex != LastIndex)
+		{
+			m_DenseObjects[DenseIndex] = m_DenseObjects[LastIndex];
+			m_DenseHandles[DenseIndex] = m_DenseHandles[LastIndex];
+			m_ObjectHandles->GetMut(m_DenseHandles[DenseIndex]) = DenseIndex;
+			MarkDirty(DenseIndex);
+		}
+		m_DenseObjects.pop_back();
+		m_DenseHandles.pop_back();
+		
+		m_ObjectHandles->Destroy(Handle);
+		m_Stats.Objects--;
+	}
+	
+	void LVKGpuScene::Update(u64 CompletedValue)
+	{
+		// Meshes whose geometry has landed get their real table entry.
+		for (arch i = 0; i < m_PendingMeshes.size();)
+		{
+			MeshHandle Handle = m_PendingMeshes[i];
+			if (m_Meshes->IsValid(Handle) && !m_Uploads->IsComplete(m_Meshes->Get(Handle).Upload))
+			{
+				i++;
+				continue;
+			}
+			
+			if (m_Meshes->IsValid(Handle))
+			{
+				Mesh& Resident = m_Meshes->GetMut(Handle);
+				Resident.bResident = true;
+				m_DirtyMeshes.push_back({ HandleIndex(Handle), Resident.Gpu });
+			}
+			m_PendingMeshes[i] = m_PendingMeshes.back();
+			m_PendingMeshes.pop_back();
+		}
+		
+		// Ranges of destroyed meshes no frame can read any more.
+		for (arch i = 0; i < m_RetiredGeometry.size();)
+		{
+			const RetiredGeometry& Retired = m_RetiredGeometry[i];
+			if (Retired.TimelineValue > CompletedValue || !m_Uploads->IsComplete(Retired.Upload))
+			{
+				i++;
+				continue;
+			}
+			
+			m_VertexRanges->Free(Retired.Vertices);
+			m_IndexRanges->Free(Retired.Indices);
+			m_RetiredGeometry[i] = m_RetiredGeometry.back();
+			m_RetiredGeometry.pop_back();
+		}
+		UpdateGeometryStats();
+		
+		// Visible and retested counts of the newest finished frame.
+		for (FrameSlot& Slot : m_FrameSlots)
+		{
+			if (Slot.TimelineValue == 0 || Slot.TimelineValue > CompletedValue)
+			{
+				continue;
+			}
+			
+			if (Slot.bReadback && Slot.TimelineValue > m_LatestReadback)
+			{
+				VK_CHECK_RESULT(vmaInvalidateAllocation(m_Allocator, Slot.Readback.Allocation, 0, VK_WHOLE_SIZE));
+				const u32* Counts = static_cast<const u32*>(Slot.Readback.Info.pMappedData);
+				
+				u32 Visible = 0;
+				u32 LateVisible = 0;
+				for (u32 Batch = 0; Batch < GPU_SCENE_BATCHES_MAX; Batch++)
+				{
+					Visible += Counts[Batch];
+					LateVisible += Slot.bLatePhase ? Counts[GPU_SCENE_BATCHES_MAX + Batch] : 0;
+				}
+				u32 Retested = Slot.bLatePhase ? Counts[READBACK_RETESTED] : 0;
+				m_Stats.VisibleObjects = Visible + LateVisible;
+				m_Stats.RetestedObjects = Retested;
+				m_Stats.OccludedObjects = Retested - std::min(LateVisible, Retested);
+				m_LatestReadback = Slot.TimelineValue;
+			}
+			
+			Slot.TimelineValue = 0;
+			Slot.bReadback = false;
+			Slot.bLatePhase = false;
+		}
+	}
+	
+	bool LVKGpuScene::Record(LVKRenderGraph& Graph, const LVKGpuSceneView& View)
+	{
+		m_Stats.DrawCalls = 0;
+		m_LastRecordedValue = View.TimelineValue;
+		
+		// Gather this frame's writes into staging, each one a copy into its buffer.
+		
+		struct Copy
+		{
+			VkBuffer Dst;
+			VkBufferCopy Region;
+		};
+		std::vector<Copy> Copies;
+		
+		std::stable_sort(m_DirtyMeshes.begin(), m_DirtyMeshes.end(), [](const auto& A, const auto& B){ return A.first < B.first; });
+		std::sort(m_DirtyObjects.begin(), m_DirtyObjects.end());
+		
+		// Only the last write to a mesh entry counts, regions of a single copy must not overlap.
+		std::vector<std::pair<u32, LVKGpuSceneMesh>> MeshWrites;
+		for (arch i = 0; i < m_DirtyMeshes.size(); i++)
+		{
+			if (i + 1 < m_DirtyMeshes.size() && m_DirtyMeshes[i + 1].first == m_DirtyMeshes[i].first)
+			{
+				continue;
+			}
+			MeshWrites.push_back(m_DirtyMeshes[i]);
+		}
+		
+		// Dirty objects in runs of consecutive indices, the ones past the end were removed.
+		std::vector<std::pair<u32, u32>> ObjectRuns;
+		u32 ObjectCount = static_cast<u32>(m_DenseObjects.size());
+		for (u32 DenseIndex : m_DirtyObjects)
+		{
+			if (DenseIndex < m_bObjectDirty.size())
+			{
+				m_bObjectDirty[DenseIndex] = false;
+			}
+			if (DenseIndex >= ObjectCount)
+			{
+				continue;
+			}
+			if (!ObjectRuns.empty() && ObjectRuns.back().first + ObjectRuns.back().second == DenseIndex)
+			{
+				ObjectRuns.back().second++;
+			}
+			else
+			{
+				ObjectRuns.push_back({ DenseIndex, 1 });
+			}
+		}
+		m_DirtyObjects.clear();
+		m_DirtyMeshes.clear();
+		
+		// Each batch's commands follow the previous batch's, sized for all of its objects.
+		u32 FirstCommand[GPU_SCENE_BATCHES_MAX];
+		u32 CommandCount = 0;
+		for (u32 Batch = 0; Batch < GPU_SCENE_BATCHES_MAX; Batch++)
+		{
+			FirstCommand[Batch] = CommandCount;
+			CommandCount += m_BatchObjects[Batch];
+		}
+		
+		VkDeviceSize StagingSize = MeshWrites.size() * sizeof(LVKGpuSceneMesh) + (m_bBatchTableDirty ? sizeof(FirstCommand) : 0);
+		for (const auto& Run : ObjectRuns)
+		{
+			StagingSize += Run.second * sizeof(LVKGpuSceneObject);
+		}
+		
+		FrameSlot& Slot = AcquireFrameSlot(StagingSize, View.TimelineValue);
+		u8* Staging = static_cast<u8*>(Slot.Staging.Info.pMappedData);
+		VkDeviceSize StagingOffset = 0;
+		
+		for (const auto& Write : MeshWrites)
+		{
+			memcpy(Staging + StagingOffset, &Write.second, sizeof(LVKGpuSceneMesh));
+			Copies.push_back({ m_MeshTable.Buffer, { StagingOffset, Write.first * sizeof(LVKGpuSceneMesh), sizeof(LVKGpuSceneMesh) } });
+			StagingOffset += sizeof(LVKGpuSceneMesh);
+		}
+		for (const auto& Run : ObjectRuns)
+		{
+			VkDeviceSize Size = Run.second * sizeof(LVKGpuSceneObject);
+			memcpy(Staging + StagingOffset, &m_DenseObjects[Run.first], Size);
+			Copies.push_back({ m_Objects.Buffer, { StagingOffset, Run.first * sizeof(LVKGpuSceneObject), Size } });
+			StagingOffset += Size;
+		}
+		if (m_bBatchTableDirty)
+		{
+			memcpy(Staging + StagingOffset, FirstCommand, sizeof(FirstCommand));
+			Copies.push_back({ m_BatchTable.Buffer, { StagingOffset, 0, sizeof(FirstCommand) } });
+			StagingOffset += sizeof(FirstCommand);
+			m_bBatchTableDirty = false;
+		}
+		if (StagingOffset > 0)
+		{
+			VK_CHECK_RESULT(vmaFlushAllocation(m_Allocator, Slot.Staging.Allocation, 0, StagingOffset));
+		}
+		
+		// Resources
+		
+		LVKGraphResource Vertices = Graph.ImportBuffer("Scene Vertices", m_Vertices.Buffer, m_Vertices.Info.size);
+		LVKGraphResource Indices = Graph.ImportBuffer("Scene Indices", m_Indices.Buffer, m_Indices.Info.size);
+		LVKGraphResource MeshTable = Graph.ImportBuffer("Scene Meshes", m_MeshTable.Buffer, m_MeshTable.Info.size);
+		LVKGraphResource Objects = Graph.ImportBuffer("Scene Objects", m_Objects.Buffer, m_Objects.Info.size);
+		LVKGraphResource BatchTable = Graph.ImportBuffer("Scene Batches", m_BatchTable.Buffer, m_BatchTable.Info.size);
+		
+		// Rounded up so the transient keeps its shape while the object count moves.
+		VkDeviceSize CommandsSize = DRAW_COMMAND_SIZE * Math::NextPowerOfTwo(std::max(CommandCount, 64u));
+		LVKGraphResource Commands = Graph.CreateBuffer("Scene Commands", { .Size = CommandsSize });
+		LVKGraphResource Counts = Graph.CreateBuffer("Scene Counts", { .Size = sizeof(u32) * GPU_SCENE_BATCHES_MAX });
+		
+		if (!Copies.empty())
+		{
+			VkBuffer StagingBuffer = Slot.Staging.Buffer;
+			LVKGraphPassBuilder Builder = Graph.AddPass("Scene Update", [StagingBuffer, Copies](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+				// Grouped by destination, one copy call each.
+				std::vector<VkBufferCopy> Regions;
+				for (arch i = 0; i < Copies.size(); i++)
+				{
+					Regions.push_back(Copies[i].Region);
+					if (i + 1 == Copies.size() || Copies[i + 1].Dst != Copies[i].Dst)
+					{
+						vkCmdCopyBuffer(Cmd, StagingBuffer, Copies[i].Dst, static_cast<u32>(Regions.size()), Regions.data());
+						Regions.clear();
+					}
+				}
+			});
+			
+			bool bWritten[3] = {};
+			for (const Copy& Write : Copies)
+			{
+				bWritten[0] |= Write.Dst == m_MeshTable.Buffer;
+				bWritten[1] |= Write.Dst == m_Objects.Buffer;
+				bWritten[2] |= Write.Dst == m_BatchTable.Buffer;
+			}
+			if (bWritten[0]) Builder.Write(MeshTable, LVKGraphAccess::TransferDst);
+			if (bWritten[1]) Builder.Write(Objects, LVKGraphAccess::TransferDst);
+			if (bWritten[2]) Builder.Write(BatchTable, LVKGraphAccess::TransferDst);
+		}
+		
+		if (ObjectCount == 0 || View.Cull.Pipeline == VK_NULL_HANDLE)
+		{
+			m_Stats.VisibleObjects = ObjectCount == 0 ? 0 : m_Stats.VisibleObjects;
+			return false;
+		}
+		
+		// Occlusion needs the pyramid's pipeline, until then everything the frustum keeps is drawn early.
+		LAssert(View.DepthPyramid != nullptr);
+		LVKDepthPyramid* Pyramid = View.DepthPyramid;
+		bool bOcclusion = View.DepthPyramidBuild.Pipeline != VK_NULL_HANDLE;
+		
+		LVKGpuSceneCullConstants* Constants = static_cast<LVKGpuSceneCullConstants*>(Slot.Constants.Info.pMappedData);
+		memcpy(Constants->ViewProjection, View.ViewProjection, sizeof(Constants->ViewProjection));
+		memcpy(Constants->PyramidViewProjection, Pyramid->GetViewProjection(), sizeof(Constants->PyramidViewProjection));
+		memcpy(Constants->Planes, View.FrustumPlanes, sizeof(Constants->Planes));
+		Constants->PyramidSize[0] = Pyramid->GetExtent().width;
+		Constants->PyramidSize[1] = Pyramid->GetExtent().height;
+		Constants->PyramidLevels = Pyramid->GetLevelCount();
+		Constants->ObjectCount = ObjectCount;
+		Constants->bPyramid = bOcclusion && Pyramid->IsBuilt() ? 1 : 0;
+		VK_CHECK_RESULT(vmaFlushAllocation(m_Allocator, Slot.Constants.Allocation, 0, sizeof(LVKGpuSceneCullConstants)));
+		
+		LVKGraphResource PyramidImage = Pyramid->Import(Graph);
+		LVKGraphResource Retest = Graph.CreateBuffer("Scene Retest", { .Size = sizeof(u32) * (1 + Math::NextPowerOfTwo(std::max(ObjectCount, 64u))) });
+		LVKGraphResource RetestDispatch = Graph.CreateBuffer("Scene Retest Dispatch", { .Size = sizeof(VkDispatchIndirectCommand) });
+		LVKGraphResource LateCommands = LVK_GRAPH_RESOURCE_INVALID;
+		LVKGraphResource LateCounts = LVK_GRAPH_RESOURCE_INVALID;
+		if (bOcclusion)
+		{
+			LateCommands = Graph.CreateBuffer("Scene Late Commands", { .Size = CommandsSize });
+			LateCounts = Graph.CreateBuffer("Scene Late Counts", { .Size = sizeof(u32) * GPU_SCENE_BATCHES_MAX });
+		}
+		
+		VkQueryPool TimestampPool = View.TimestampPool;
+		auto TimestampQuery = [&View](LVKGpuSceneTiming Timing) { return View.FirstTimestamp + 2 * static_cast<u32>(Timing); };
+		
+		// Clear
+		
+		bool bDrawIndirectCount = m_bDrawIndirectCount;
+		LVKGraphPassBuilder Clear = Graph.AddPass("Scene Clear", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkDispatchIndirectCommand NoGroups = { 0, 1, 1 };
+			vkCmdUpdateBuffer(Cmd, Graph.GetBuffer(RetestDispatch), 0, sizeof(NoGroups), &NoGroups);
+			vkCmdFillBuffer(Cmd, Graph.GetBuffer(Retest), 0, sizeof(u32), 0);
+			
+			for (LVKGraphResource PhaseCounts : { Counts, LateCounts })
+			{
+				if (PhaseCounts != LVK_GRAPH_RESOURCE_INVALID)
+				{
+					vkCmdFillBuffer(Cmd, Graph.GetBuffer(PhaseCounts), 0, VK_WHOLE_SIZE, 0);
+				}
+			}
+			if (!bDrawIndirectCount)
+			{
+				// Drawn in full, the slots culling leaves untouched must be empty draws.
+				for (LVKGraphResource PhaseCommands : { Commands, LateCommands })
+				{
+					if (PhaseCommands != LVK_GRAPH_RESOURCE_INVALID)
+					{
+						vkCmdFillBuffer(Cmd, Graph.GetBuffer(PhaseCommands), 0, VK_WHOLE_SIZE, 0);
+					}
+				}
+			}
+		});
+		Clear.Write(Counts, LVKGraphAccess::TransferDst).Write(Retest, LVKGraphAccess::TransferDst).Write(RetestDispatch, LVKGraphAccess::TransferDst);
+		if (!bDrawIndirectCount)
+		{
+			Clear.Write(Commands, LVKGraphAccess::TransferDst);
+		}
+		if (bOcclusion)
+		{
+			Clear.Write(LateCounts, LVKGraphAccess::TransferDst);
+			if (!bDrawIndirectCount)
+			{
+				Clear.Write(LateCommands, LVKGraphAccess::TransferDst);
+			}
+		}
+		
+		// Cull, the early phase over every object and the late one over those it set aside
+		
+		VkDevice Device = m_Device;
+		LVKGpuScenePipeline CullPipeline = View.Cull;
+		VkBuffer MeshTableBuffer = m_MeshTable.Buffer;
+		VkBuffer ObjectsBuffer = m_Objects.Buffer;
+		VkBuffer BatchTableBuffer = m_BatchTable.Buffer;
+		VkBuffer ConstantsBuffer = Slot.Constants.Buffer;
+		VkSampler PyramidSampler = Pyramid->GetSampler();
+		
+		auto AddCullPass = [&](const char* Name, u32 Phase, LVKGraphResource PhaseCommands, LVKGraphResource PhaseCounts, LVKGpuSceneTiming Timing) {
+			VkDescriptorSet CullSet = View.Descriptors->Allocate(Device, CullPipeline.SetLayout);
+			u32 Query = TimestampQuery(Timing);
+			
+			LVKGraphPassBuilder Cull = Graph.AddPass(Name, [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+				VkDescriptorBufferInfo BufferInfos[8] = {
+					{ MeshTableBuffer, 0, VK_WHOLE_SIZE },
+					{ ObjectsBuffer, 0, VK_WHOLE_SIZE },
+					{ BatchTableBuffer, 0, VK_WHOLE_SIZE },
+					{ Graph.GetBuffer(PhaseCommands), 0, VK_WHOLE_SIZE },
+					{ Graph.GetBuffer(PhaseCounts), 0, VK_WHOLE_SIZE },
+					{ Graph.GetBuffer(Retest), 0, VK_WHOLE_SIZE },
+					{ Graph.GetBuffer(RetestDispatch), 0, VK_WHOLE_SIZE },
+					{ ConstantsBuffer, 0, sizeof(LVKGpuSceneCullConstants) },
+				};
+				VkDescriptorImageInfo PyramidInfo = { PyramidSampler, Graph.GetImageView(PyramidImage), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+				VkWriteDescriptorSet Writes[9];
+				for (u32 i = 0; i < 9; i++)
+				{
+					Writes[i] = {
+						.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						.pNext = nullptr,
+						.dstSet = CullSet,
+						.dstBinding = i,
+						.dstArrayElement = 0,
+						.descriptorCount = 1,
+						.descriptorType = i == 8 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : i == 7 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+						.pImageInfo = i == 8 ? &PyramidInfo : nullptr,
+						.pBufferInfo = i == 8 ? nullptr : &BufferInfos[i],
+					};
+				}
+				vkUpdateDescriptorSets(Device, 9, Writes, 0, nullptr);
+				
+				if (TimestampPool != VK_NULL_HANDLE)
+				{
+					vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, TimestampPool, Query);
+				}
+				
+				vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, CullPipeline.Pipeline);
+				vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, CullPipeline.Layout, 0, 1, &CullSet, 0, nullptr);
+				vkCmdPushConstants(Cmd, CullPipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Phase), &Phase);
+				if (Phase == 0)
+				{
+					vkCmdDispatch(Cmd, (ObjectCount + 63) / 64, 1, 1);
+				}
+				else
+				{
+					vkCmdDispatchIndirect(Cmd, Graph.GetBuffer(RetestDispatch), 0);
+				}
+				
+				if (TimestampPool != VK_NULL_HANDLE)
+				{
+					vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, TimestampPool, Query + 1);
+				}
+			});
+			Cull.Read(MeshTable, LVKGraphAccess::StorageRead).Read(Objects, LVKGraphAccess::StorageRead).Read(BatchTable, LVKGraphAccess::StorageRead);
+			Cull.Read(PyramidImage, LVKGraphAccess::SampledRead);
+			Cull.Read(PhaseCounts, LVKGraphAccess::StorageWrite).Write(PhaseCounts, LVKGraphAccess::StorageWrite);
+			if (!bDrawIndirectCount)
+			{
+				Cull.Read(PhaseCommands, LVKGraphAccess::StorageWrite);
+			}
+			Cull.Write(PhaseCommands, LVKGraphAccess::StorageWrite);
+			if (Phase == 0)
+			{
+				Cull.Read(Retest, LVKGraphAccess::StorageWrite).Write(Retest, LVKGraphAccess::StorageWrite);
+				Cull.Read(RetestDispatch, LVKGraphAccess::StorageWrite).Write(RetestDispatch, LVKGraphAccess::StorageWrite);
+			}
+			else
+			{
+				Cull.Read(Retest, LVKGraphAccess::StorageRead).Read(RetestDispatch, LVKGraphAccess::IndirectRead);
+			}
+		};
+		
+		// Draw, one indirect draw per batch with objects and a ready pipeline
+		
+		struct BatchDraw
+		{
+			LVKGpuScenePipeline Pipeline;
+			VkDescriptorSet Set;
+			u32 Batch;
+			u32 FirstCommand;
+			u32 MaxCount;
+		};
+		std::vector<BatchDraw> Batches;
+		for (u32 Batch = 0; Batch < GPU_SCENE_BATCHES_MAX; Batch++)
+		{
+			const LVKGpuScenePipeline& Pipeline = View.Batches[Batch];
+			if (m_BatchObjects[Batch] == 0 || Pipeline.Pipeline == VK_NULL_HANDLE)
+			{
+				continue;
+			}
+			Batches.push_back({ Pipeline, VK_NULL_HANDLE, Batch, FirstCommand[Batch], m_BatchObjects[Batch] });
+		}
+		m_Stats.DrawCalls = static_cast<u32>(Batches.size()) * (bOcclusion ? 2 : 1);
+		
+		VkBuffer VerticesBuffer = m_Vertices.Buffer;
+		VkBuffer IndicesBuffer = m_Indices.Buffer;
+		LVKGraphResource Color = View.Color;
+		LVKGraphResource Depth = View.Depth;
+		VkExtent2D Extent = View.Extent;
+		std::array<f32, 16> ViewProjection;
+		memcpy(ViewProjection.data(), View.ViewProjection, sizeof(View.ViewProjection));
+		
+		auto AddDrawPass = [&](const char* Name, LVKGraphResource PhaseCommands, LVKGraphResource PhaseCounts, bool bClearDepth, LVKGpuSceneTiming Timing) {
+			std::vector<BatchDraw> Draws = Batches;
+			for (BatchDraw& Draw : Draws)
+			{
+				Draw.Set = View.Descriptors->Allocate(Device, Draw.Pipeline.SetLayout);
+			}
+			u32 Query = TimestampQuery(Timing);
+			
+			LVKGraphPassBuilder Draw = Graph.AddPass(Name, [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+				if (TimestampPool != VK_NULL_HANDLE)
+				{
+					vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, TimestampPool, Query);
+				}
+				
+				VkClearValue DepthClear = { .depthStencil = { 0.0f, 0 } }; // Reverse Z, far is zero
+				VkRenderingAttachmentInfo ColorAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(Color), nullptr, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+				VkRenderingAttachmentInfo DepthAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(Depth), bClearDepth ? &DepthClear : nullptr, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+				VkRenderingInfo RenderingInfo = {
+					.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+					.pNext = nullptr,
+					.flags = 0,
+					.renderArea = { { 0, 0 }, Extent },
+					.layerCount = 1,
+					.viewMask = 0,
+					.colorAttachmentCount = 1,
+					.pColorAttachments = &ColorAttachment,
+					.pDepthAttachment = &DepthAttachment,
+					.pStencilAttachment = nullptr,
+				};
+				vkCmdBeginRendering(Cmd, &RenderingInfo);
+				
+				VkViewport Viewport = { 0.0f, 0.0f, static_cast<f32>(Extent.width), static_cast<f32>(Extent.height), 0.0f, 1.0f };
+				VkRect2D Scissor = { { 0, 0 }, Extent };
+				vkCmdSetViewport(Cmd, 0, 1, &Viewport);
+				vkCmdSetScissor(Cmd, 0, 1, &Scissor);
+				vkCmdBindIndexBuffer(Cmd, IndicesBuffer, 0, VK_INDEX_TYPE_UINT32);
+				
+				VkBuffer CommandsBuffer = Graph.GetBuffer(PhaseCommands);
+				VkBuffer CountsBuffer = Graph.GetBuffer(PhaseCounts);
+				for (const BatchDraw& Batch : Draws)
+				{
+					VkDescriptorBufferInfo BufferInfos[2] = {
+						{ VerticesBuffer, 0, VK_WHOLE_SIZE },
+						{ ObjectsBuffer, 0, VK_WHOLE_SIZE },
+					};
+					VkWriteDescriptorSet Writes[2];
+					for (u32 i = 0; i < 2; i++)
+					{
+						Writes[i] = {
+							.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+							.pNext = nullptr,
+							.dstSet = Batch.Set,
+							.dstBinding = i,
+							.dstArrayElement = 0,
+							.descriptorCount = 1,
+							.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+							.pImageInfo = nullptr,
+							.pBufferInfo = &BufferInfos[i],
+						};
+					}
+					vkUpdateDescriptorSets(Device, 2, Writes, 0, nullptr);
+					
+					vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Batch.Pipeline.Pipeline);
+					vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Batch.Pipeline.Layout, 0, 1, &Batch.Set, 0, nullptr);
+					vkCmdPushConstants(Cmd, Batch.Pipeline.Layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(f32) * 16, ViewProjection.data());
+					
+					VkDeviceSize CommandsOffset = static_cast<VkDeviceSize>(Batch.FirstCommand) * DRAW_COMMAND_SIZE;
+					if (bDrawIndirectCount)
+					{
+						vkCmdDrawIndexedIndirectCount(Cmd, CommandsBuffer, CommandsOffset, CountsBuffer, sizeof(u32) * Batch.Batch, Batch.MaxCount, DRAW_COMMAND_SIZE);
+					}
+					else
+					{
+						vkCmdDrawIndexedIndirect(Cmd, CommandsBuffer, CommandsOffset, Batch.MaxCount, DRAW_COMMAND_SIZE);
+					}
+				}
+				
+				vkCmdEndRendering(Cmd);
+				
+				if (TimestampPool != VK_NULL_HANDLE)
+				{
+					vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, TimestampPool, Query + 1);
+				}
+			});
+			Draw.Read(Color, LVKGraphAccess::ColorAttachment).Write(Color, LVKGraphAccess::ColorAttachment).Write(Depth, LVKGraphAccess::DepthAttachment);
+			if (!bClearDepth)
+			{
+				Draw.Read(Depth, LVKGraphAccess::DepthAttachment);
+			}
+			Draw.Read(PhaseCommands, LVKGraphAccess::IndirectRead).Read(Indices, LVKGraphAccess::VertexRead);
+			Draw.Read(Vertices, LVKGraphAccess::StorageRead).Read(Objects, LVKGraphAccess::StorageRead);
+			if (bDrawIndirectCount)
+			{
+				Draw.Read(PhaseCounts, LVKGraphAccess::IndirectRead);
+			}
+		};
+		
+		AddCullPass("Scene Cull", 0, Commands, Counts, LVKGpuSceneTiming::EarlyCull);
+		AddDrawPass("Scene", Commands, Counts, View.bClearDepth, LVKGpuSceneTiming::EarlyDraw);
+		if (bOcclusion)
+		{
+			Pyramid->Build(Graph, PyramidImage, Depth, Extent, View.ViewProjection, View.DepthPyramidBuild, View.Downsampler, View.DepthPyramidDownsample, View.Descriptors, TimestampPool, TimestampQuery(LVKGpuSceneTiming::DepthPyramid));
+			AddCullPass("Scene Late Cull", 1, LateCommands, LateCounts, LVKGpuSceneTiming::LateCull);
+			AddDrawPass("Scene Late", LateCommands, LateCounts, false, LVKGpuSceneTiming::LateDraw);
+		}
+		
+		// Readback of the visible and retested counts, picked up by Update once the frame has finished.
+		
+		VkBuffer ReadbackBuffer = Slot.Readback.Buffer;
+		Slot.bReadback = true;
+		Slot.bLatePhase = bOcclusion;
+		LVKGraphPassBuilder Readback = Graph.AddPass("Scene Readback", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkBufferCopy CountsRegion = { 0, 0, sizeof(u32) * GPU_SCENE_BATCHES_MAX };
+			vkCmdCopyBuffer(Cmd, Graph.GetBuffer(Counts), ReadbackBuffer, 1, &CountsRegion);
+			if (LateCounts != LVK_GRAPH_RESOURCE_INVALID)
+			{
+				VkBufferCopy LateRegion = { 0, sizeof(u32) * GPU_SCENE_BATCHES_MAX, sizeof(u32) * GPU_SCENE_BATCHES_MAX };
+				VkBufferCopy RetestRegion = { 0, sizeof(u32) * READBACK_RETESTED, sizeof(u32) };
+				vkCmdCopyBuffer(Cmd, Graph.GetBuffer(LateCounts), ReadbackBuffer, 1, &LateRegion);
+				vkCmdCopyBuffer(Cmd, Graph.GetBuffer(Retest), ReadbackBuffer, 1, &RetestRegion);
+			}
+			
+			VkMemoryBarrier2 HostBarrier = {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+				.pNext = nullptr,
+				.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+				.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+				.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+			};
+			VkDependencyInfo Dependency = {
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.pNext = nullptr,
+				.memoryBarrierCount = 1,
+				.pMemoryBarriers = &HostBarrier,
+			};
+			vkCmdPipelineBarrier2(Cmd, &Dependency);
+		});
+		Readback.Read(Counts, LVKGraphAccess::TransferSrc).SideEffects();
+		if (bOcclusion)
+		{
+			Readback.Read(LateCounts, LVKGraphAccess::TransferSrc).Read(Retest, LVKGraphAccess::TransferSrc);
+		}
+		
+		return true;
+	}
+	
+	LVKGpuScene::FrameSlot& LVKGpuScene::AcquireFrameSlot(VkDeviceSize StagingSize, u64 TimelineValue)
+	{
+		auto Free = std::find_if(m_FrameSlots.begin(), m_FrameSlots.end(), [](const FrameSlot& Slot){ return Slot.TimelineValue == 0; });
+		if (Free == m_FrameSlots.end())
+		{
+			// More frames in flight than slots, grow rather than wait.
+			m_FrameSlots.emplace_back();
+			Free = m_FrameSlots.end() - 1;
+		}
+		
+		FrameSlot& Slot = *Free;
+		Slot.TimelineValue = TimelineValue;
+		Slot.bReadback = false;
+		Slot.bLatePhase = false;
+		
+		if (Slot.Readback.Buffer == VK_NULL_HANDLE)
+		{
+			Slot.Readback = LVKBuffer::Allocate(sizeof(u32) * (READBACK_RETESTED + 1), VK_BUFFER_USAGE_TRANSFER_DST_BIT, m_Allocator, VMA_MEMORY_USAGE_GPU_TO_CPU);
+			Slot.Constants = LVKBuffer::Allocate(sizeof(LVKGpuSceneCullConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, m_Allocator, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		}
+		if (Slot.Staging.Buffer == VK_NULL_HANDLE || Slot.Staging.Info.size < StagingSize)
+		{
+			// The slot is free, so the GPU is done with its old staging buffer.
+			if (Slot.Staging.Buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(m_Allocator, Slot.Staging.Buffer, Slot.Staging.Allocation);
+			}
+			Slot.Staging = LVKBuffer::Allocate(Math::NextPowerOfTwo(std::max(StagingSize, STAGING_SIZE_MIN)), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, m_Allocator, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		}
+		return Slot;
+	}
+	
+	void LVKGpuScene::MarkDirty(u32 DenseIndex)
+	{
+		if (DenseIndex >= m_bObjectDirty.size())
+		{
+			m_bObjectDirty.resize(DenseIndex + 1, false);
+		}
+		if (!m_bObjectDirty[DenseIndex])
+		{
+			m_bObjectDirty[DenseIndex] = true;
+			m_DirtyObjects.push_back(DenseIndex);
+		}
+	}
+	
+	void LVKGpuScene::UpdateGeometryStats()
+	{
+		OffsetAllocatorReport Vertices = m_VertexRanges->GetReport();
+		OffsetAllocatorReport Indices = m_IndexRanges->GetReport();
+		
+		u64 VertexBytes = sizeof(MeshVertex) * static_cast<u64>(m_VertexRanges->GetSize() - Vertices.TotalFree);
+		u64 IndexBytes = sizeof(u32) * static_cast<u64>(m_IndexRanges->GetSize() - Indices.TotalFree);
+		m_Stats.GeometryBytes = VertexBytes + IndexBytes;
+		m_Stats.GeometryFreeBytes = sizeof(MeshVertex) * static_cast<u64>(Vertices.TotalFree) + sizeof(u32) * static_cast<u64>(Indices.TotalFree);
+		m_Stats.GeometryFreeRegions = Vertices.FreeRegions + Indices.FreeRegions;
+		m_Stats.GeometryFragmentation = std::max(Vertices.GetFragmentation(), Indices.GetFragmentation());
+	}
+	
+	void LVKGpuScene::FillObject(LVKGpuSceneObject& Object, const SceneTransform& Transform)
+	{
+		Object.PositionScale[0] = Transform.Position[0];
+		Object.PositionScale[1] = Transform.Position[1];
+		Object.PositionScale[2] = Transform.Position[2];
+		Object.PositionScale[3] = Transform.Scale;
+		memcpy(Object.Rotation, Transform.Rotation, sizeof(Object.Rotation));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKRenderGraph.hpp"
+#include "LVKResources.hpp"
+#include "LVKUploadManager.hpp"
+#include "Base/Handles.hpp"
+#include "Core/OffsetAllocator.hpp"
+#include "Graphics/Camera.hpp"
+#include "Graphics/GraphicsManager.hpp"
+
+#include <utility>
+#include <vector>
+
+/*
+	GPU-driven scene.
+	
+	Meshes, objects and their bounds live in storage buffers, and a frame only sends the objects
+	that changed. A compute pass tests every object's bounding sphere against the frustum and
+	appends the survivors to the indirect command range of their batch, one batch per pipeline,
+	counting them as it goes. Each batch is then a single vkCmdDrawIndexedIndirectCount, so the CPU
+	does the same work whether there are ten objects or hundreds of thousands.
+	
+	Given a depth pyramid, culling also tests against depth, in two phases. The early phase tests
+	against the pyramid of the frame before, reprojected with the view it was built from, and draws
+	what it does not hide. Those are then reduced into a new pyramid, and the late phase retests
+	only the objects the old one hid, now against this frame's own depth, drawing the ones that
+	came out from behind something. Nothing that moved into view is ever missing for a frame, and
+	the new pyramid, built from the early phase alone, is what the next frame starts from.
+	
+	Geometry of every mesh shares one vertex and one index buffer, vertices are pulled in the
+	vertex shader, and objects are fetched by firstInstance. Ranges of both are handed out by an
+	offset allocator, and a destroyed mesh's ranges are only reused once the frames that could
+	still draw it have finished. Without draw indirect count the batch
+	ranges are zeroed first and drawn in full, culled slots are then empty draws.
+	
+	Objects are kept densely packed so the cull dispatch covers exactly the live objects. Geometry
+	is streamed through the upload manager, and a mesh's table entry is only written once its
+	upload has completed, so the GPU never sees a mesh without its data.
+*/
+
+namespace Locus
+{
+	class LVKDepthPyramid;
+	class LVKDownsampler;
+	
+	constexpr u32 GPU_SCENE_BATCHES_MAX = 16;
+	
+	// Timestamp pairs the scene writes from the view's first query, each a begin and an end.
+	enum class LVKGpuSceneTiming : u32
+	{
+		EarlyCull,
+		EarlyDraw,
+		DepthPyramid,
+		LateCull,
+		LateDraw,
+		Count,
+	};
+	
+	// Mirrors SceneObject in scene.glsl.
+	struct LVKGpuSceneObject
+	{
+		f32 PositionScale[4];
+		f32 Rotation[4];
+		f32 Color[4];
+		u32 Mesh;
+		u32 Batch;
+		u32 Pad[2];
+	};
+	static_assert(sizeof(LVKGpuSceneObject) == 64);
+	
+	// Mirrors SceneMesh in scene.glsl.
+	struct LVKGpuSceneMesh
+	{
+		u32 FirstIndex;
+		u32 IndexCount;
+		i32 VertexOffset;
+		u32 Pad;
+		f32 Bounds[4];
+	};
+	static_assert(sizeof(LVKGpuSceneMesh) == 32);
+	
+	// Mirrors CullConstants in scene_cull.comp, std140.
+	struct LVKGpuSceneCullConstants
+	{
+		f32 ViewProjection[16];
+		f32 PyramidViewProjection[16];
+		f32 Planes[FRUSTUM_PLANE_COUNT][4];
+		u32 PyramidSize[2];
+		u32 PyramidLevels;
+		u32 ObjectCount;
+		u32 bPyramid;
+		u32 Pad[3];
+	};
+	static_assert(sizeof(LVKGpuSceneCullConstants) == 240);
+	
+	struct LVKGpuSceneConfig
+	{
+		u32 MaxVertices = 1 << 20;
+		u32 MaxIndices = 1 << 22;
+		u32 MaxMeshes = 4096;
+		u32 MaxObjects = 1 << 18;
+	};
+	
+	struct LVKGpuScenePipeline
+	{
+		VkPipeline Pipeline = VK_NULL_HANDLE; // Null while compiling, the pass or batch is skipped
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		VkDescriptorSetLayout SetLayout = VK_NULL_HANDLE;
+	};
+	
+	// Everything a frame's passes need from the caller.
+	struct LVKGpuSceneView
+	{
+		LVKGraphResource Color;
+		LVKGraphResource Depth;
+		bool bClearDepth; // Otherwise drawn over what is there
+		VkExtent2D Extent;
+		f32 ViewProjection[16];
+		f32 FrustumPlanes[FRUSTUM_PLANE_COUNT][4];
+		
+		LVKGpuScenePipeline Cull;
+		LVKGpuScenePipeline Batches[GPU_SCENE_BATCHES_MAX];
+		
+		// Tested against and rebuilt every frame, culling is by frustum alone while its pipeline compiles.
+		LVKDepthPyramid* DepthPyramid;
+		LVKGpuScenePipeline DepthPyramidBuild;
+		LVKDownsampler* Downsampler; // Reduces the pyramid below level 0 in one dispatch once its pipeline is ready
+		LVKGpuScenePipeline DepthPyramidDownsample;
+		
+		LVKDescriptorAllocator* Descriptors; // The frame's, sets are written when the passes execute
+		u64 TimelineValue; // Graphics timeline value the frame signals
+		
+		VkQueryPool TimestampPool; // Optional, see LVKGpuSceneTiming
+		u32 FirstTimestamp;
+	};
+	
+	struct LVKGpuSceneStats
+	{
+		u32 Meshes = 0;
+		u32 Objects = 0;
+		u32 VisibleObjects = 0;
+		u32 DrawCalls = 0;
+		
+		u32 RetestedObjects = 0; // Hidden by the previous frame's pyramid, read back
+		u32 OccludedObjects = 0; // Of those, still hidden by this frame's, read back
+		
+		u64 GeometryBytes = 0; // Vertices and indices in use
+		u64 GeometryFreeBytes = 0;
+		u32 GeometryFreeRegions = 0;
+		f32 GeometryFragmentation = 0.0f; // The worse of the two buffers, see OffsetAllocatorReport
+	};
+	
+	class LVKGpuScene
+	{
+	public:
+		LVKGpuScene() = default;
+		LVKGpuScene(const LVKGpuScene&) = delete;
+		LVKGpuScene& operator=(const LVKGpuScene&) = delete;
+		
+		void Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, bool bDrawIndirectCount, const LVKGpuSceneConfig& Config);
+		void Destroy(); // The GPU must be idle
+		
+		MeshHandle CreateMesh(const MeshVertex* Vertices, u32 VertexCount, const u32* Indices, u32 IndexCount);
+		void DestroyMesh(MeshHandle Mesh);
+		
+		SceneObjectHandle CreateObject(const SceneObjectDesc& Desc, u32 Batch);
+		void SetObjectTransform(SceneObjectHandle Object, const SceneTransform& Transform);
+		void DestroyObject(SceneObjectHandle Object);
+		
+		// Picks up readbacks of frames that have finished, CompletedValue is the graphics timeline's.
+		void Update(u64 CompletedValue);
+		
+		// Adds the update, cull, draw, depth pyramid and readback passes to the frame's graph. False if nothing was drawn.
+		bool Record(LVKRenderGraph& Graph, const LVKGpuSceneView& View);
+		
+		const LVKGpuSceneStats& GetStats() const { return m_Stats; }
+	
+	private:
+		struct Mesh
+		{
+			LVKGpuSceneMesh Gpu;
+			OffsetAllocation Vertices;
+			OffsetAllocation Indices;
+			LVKUploadTicket Upload;
+			u32 Objects; // Users, a mesh can only be destroyed at zero
+			bool bResident; // Table entry written
+		};
+		
+		// Host visible buffers of one recorded frame, reused once its timeline value is reached.
+		struct FrameSlot
+		{
+			LVKBuffer Staging = {};
+			LVKBuffer Constants = {}; // Cull constants, uniform
+			LVKBuffer Readback = {}; // Visible count per batch of each phase, then the retested count
+			u64 TimelineValue = 0; // Zero when free
+			bool bReadback = false;
+			bool bLatePhase = false; // The readback has late counts
+		};
+		
+		// Geometry of a destroyed mesh, freed once the graphics timeline reaches TimelineValue.
+		struct RetiredGeometry
+		{
+			OffsetAllocation Vertices;
+			OffsetAllocation Indices;
+			LVKUploadTicket Upload;
+			u64 TimelineValue;
+		};
+		
+		FrameSlot& AcquireFrameSlot(VkDeviceSize StagingSize, u64 TimelineValue);
+		void MarkDirty(u32 DenseIndex);
+		void UpdateGeometryStats();
+		static void FillObject(LVKGpuSceneObject& Object, const SceneTransform& Transform);
+		
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		LVKUploadManager* m_Uploads = nullptr;
+		bool m_bDrawIndirectCount = false;
+		LVKGpuSceneConfig m_Config;
+		
+		LVKBuffer m_Vertices;
+		LVKBuffer m_Indices;
+		LVKBuffer m_MeshTable;
+		LVKBuffer m_Objects;
+		LVKBuffer m_BatchTable;
+		Unique<OffsetAllocator> m_VertexRanges; // In vertices
+		Unique<OffsetAllocator> m_IndexRanges; // In indices
+		std::vector<RetiredGeometry> m_RetiredGeometry;
+		u64 m_LastRecordedValue = 0;
+		
+		Unique<Pool<Mesh>> m_Meshes;
+		std::vector<MeshHandle> m_PendingMeshes; // Waiting for their upload
+		std::vector<std::pair<u32, LVKGpuSceneMesh>> m_DirtyMeshes; // Table entries to write next frame
+		
+		Unique<Pool<u32>> m_ObjectHandles; // To dense index
+		std::vector<LVKGpuSceneObject> m_DenseObjects;
+		std::vector<SceneObjectHandle> m_DenseHandles;
+		std::vector<u32> m_DirtyObjects;
+		std::vector<bool> m_bObjectDirty;
+		
+		u32 m_BatchObjects[GPU_SCENE_BATCHES_MAX] = {};
+		bool m_bBatchTableDirty = true;
+		
+		std::vector<FrameSlot> m_FrameSlots;
+		u64 m_LatestReadback = 0;
+		
+		LVKGpuSceneStats m_Stats;
+	};
+}
\ No newline at end of file
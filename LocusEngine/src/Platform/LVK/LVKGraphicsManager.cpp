@@ -7,7 +7,9 @@
 #include "LVKResources.hpp"
 
 #include "Core/DisplayManager.hpp"
+#include "Core/Time.hpp"
 #include "Platform/Platform.hpp"
+#include "Platform/VirtualFileSystem.hpp"
 
 #define VMA_IMPLEMENTATION
 #include "vma/vk_mem_alloc.h"
@@ -17,8 +19,77 @@
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_vulkan.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Locus
 {
+	static constexpr const char* PIPELINE_CACHE_PATH = LOCUS_PIPELINE_CACHE_PATH;
+	
+	static constexpr u32 FRAME_DESCRIPTOR_SETS_INITIAL = 64;
+	static constexpr u32 DESCRIPTOR_CACHE_CAPACITY = 1024;
+	static constexpr VkDeviceSize UPLOAD_RING_SIZE = 32 * 1024 * 1024;
+	static constexpr VkDeviceSize UPLOAD_FRAME_BUDGET = 8 * 1024 * 1024;
+	static constexpr VkFormat DRAW_IMAGE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+	static constexpr VkFormat SCENE_DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+	static constexpr arch COMPUTE_PIPELINES_MAX = 256;
+	static constexpr arch BUFFERS_MAX = 4096;
+	static constexpr arch GRAPHICS_PIPELINES_MAX = 1 << RENDER_KEY_PIPELINE_BITS; // Handle indices have to fit the sort key
+	static constexpr arch MATERIALS_MAX = 1 << RENDER_KEY_MATERIAL_BITS;
+	
+	// Timestamp queries per frame slot, the frame and scene bounds, the GPU scene's passes, then a begin and end for each timed dispatch.
+	static constexpr u32 TIMESTAMP_FRAME_BEGIN = 0;
+	static constexpr u32 TIMESTAMP_SCENE_END = 1;
+	static constexpr u32 TIMESTAMP_SCENE_PASSES = 2;
+	static constexpr u32 TIMESTAMP_DISPATCHES = TIMESTAMP_SCENE_PASSES + 2 * static_cast<u32>(LVKGpuSceneTiming::Count);
+	static constexpr u32 TIMED_DISPATCHES_MAX = 16;
+	static constexpr u32 TIMESTAMP_QUERY_COUNT = TIMESTAMP_DISPATCHES + 2 * TIMED_DISPATCHES_MAX;
+	static constexpr u64 PRESENT_WAIT_TIMEOUT = 100 * 1000 * 1000; // Nanoseconds, an occluded window may not present at all
+	static constexpr f64 INPUT_LATENCY_SMOOTHING = 0.1; // Weight of each new measurement
+	static constexpr LVKDescriptorPoolRatio FRAME_DESCRIPTOR_RATIOS[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	};
+	
+	static void BeginSwapchainRenderPass(VkCommandBuffer Cmd, VkRenderPass RenderPass, VkFramebuffer Framebuffer, VkExtent2D Extent)
+	{
+		VkRenderPassBeginInfo RenderPassBeginInfo = {
+			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+			.renderPass = RenderPass,
+			.framebuffer = Framebuffer,
+			.renderArea = {
+				.offset = {0, 0},
+				.extent = Extent,
+			},
+			.clearValueCount = 0,
+			.pClearValues = nullptr
+		};
+		
+		vkCmdBeginRenderPass(Cmd, &RenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+	
+	static VkPresentModeKHR ToVkPresentMode(PresentPolicy Policy)
+	{
+		switch (Policy)
+		{
+			case PresentPolicy::Mailbox: return VK_PRESENT_MODE_MAILBOX_KHR;
+			case PresentPolicy::Immediate: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+			default: return VK_PRESENT_MODE_FIFO_KHR;
+		}
+	}
+	
+	static PresentPolicy ToPresentPolicy(VkPresentModeKHR PresentMode)
+	{
+		switch (PresentMode)
+		{
+			case VK_PRESENT_MODE_MAILBOX_KHR: return PresentPolicy::Mailbox;
+			case VK_PRESENT_MODE_IMMEDIATE_KHR: return PresentPolicy::Immediate;
+			default: return PresentPolicy::Fifo;
+		}
+	}
+	
 	void LVKDeletionQueue::Push(std::function<void()>&& DeletionFunction)
 	{
 		Deletors.push_back(DeletionFunction);
@@ -33,7 +104,27 @@ namespace Locus
 		Deletors.clear();
 	}
 	
-	LVKGraphicsManager::LVKGraphicsManager() : m_RenderContextPool(WINDOW_COUNT_MAX)
+	void LVKTimelineDeletionQueue::Push(u64 TimelineValue, std::function<void()>&& DeletionFunction)
+	{
+		LAssert(Deletors.empty() || Deletors.back().TimelineValue <= TimelineValue);
+		Deletors.push_back({ TimelineValue, std::move(DeletionFunction) });
+	}
+	
+	void LVKTimelineDeletionQueue::Flush(u64 CompletedValue)
+	{
+		while (!Deletors.empty() && Deletors.front().TimelineValue <= CompletedValue)
+		{
+			Deletors.front().Function();
+			Deletors.pop_front();
+		}
+	}
+	
+	void LVKTimelineDeletionQueue::FlushAll()
+	{
+		Flush(UINT64_MAX);
+	}
+	
+	LVKGraphicsManager::LVKGraphicsManager() : m_RenderContextPool(WINDOW_COUNT_MAX), m_ComputePipelines(COMPUTE_PIPELINES_MAX), m_Buffers(BUFFERS_MAX), m_GraphicsPipelines(GRAPHICS_PIPELINES_MAX), m_Materials(MATERIALS_MAX)
 	{
 		LAssertMsg(DisplayManager::GetPtr() != nullptr, "DisplayManager must be initialized before GraphicsManager!");
 		
@@ -57,7 +148,11 @@ namespace Locus
 		DisplayManager::Get().GetVulkanInstanceExtensions(DummyWindow, m_GraphicsDevice.Config.RequiredExtensions);
 		
         m_GraphicsDevice.Config.ValidationLayers.Push("VK_LAYER_KHRONOS_validation");
-        m_GraphicsDevice.Config.RequiredDeviceFeatures = {/* Anything goes for now! */};
+        m_GraphicsDevice.Config.RequiredDeviceFeatures = {
+			// The GPU scene issues all of its draws from one indirect buffer, instance data indexed by firstInstance.
+			.multiDrawIndirect = VK_TRUE,
+			.drawIndirectFirstInstance = VK_TRUE,
+		};
         m_GraphicsDevice.Config.RequiredDeviceExtensions.Push("VK_KHR_portability_subset");
         m_GraphicsDevice.Config.RequiredDeviceExtensions.Push(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
         m_GraphicsDevice.Config.AllowedDeviceTypes.Push(VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU);
@@ -76,11 +171,45 @@ namespace Locus
 		LVK::ChoosePhysicalDevice(m_GraphicsDevice.Instance, DummySurface, m_GraphicsDevice.PhysicalDevice, m_GraphicsDevice.Config.RequiredDeviceFeatures, m_GraphicsDevice.Config.AllowedDeviceTypes, m_GraphicsDevice.Config.RequiredDeviceExtensions);
 		VK_CHECK_HANDLE(m_GraphicsDevice.PhysicalDevice);
 		
-		LVK::CreateLogicalDevice(m_GraphicsDevice.PhysicalDevice, DummySurface, m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices, m_GraphicsDevice.Config.RequiredDeviceFeatures, m_GraphicsDevice.Config.RequiredDeviceExtensions, m_GraphicsDevice.Config.ValidationLayers);
+		VkPhysicalDeviceVulkan12Features EnabledFeatures12;
+		VkPhysicalDeviceVulkan13Features EnabledFeatures13;
+		VkPhysicalDevicePresentIdFeaturesKHR EnabledPresentId;
+		VkPhysicalDevicePresentWaitFeaturesKHR EnabledPresentWait;
+		LVK::QueryDeviceCapabilities(m_GraphicsDevice.PhysicalDevice, m_GraphicsDevice.Capabilities, EnabledFeatures12, EnabledFeatures13, EnabledPresentId, EnabledPresentWait);
+		m_GraphicsDevice.Config.RequiredDeviceFeatures.textureCompressionBC = m_GraphicsDevice.Capabilities.bTextureCompressionBC;
+		if (m_GraphicsDevice.Capabilities.bPresentWait)
+		{
+			m_GraphicsDevice.Config.RequiredDeviceExtensions.Push(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			m_GraphicsDevice.Config.RequiredDeviceExtensions.Push(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		}
+		
+		LVK::CreateLogicalDevice(m_GraphicsDevice.PhysicalDevice, DummySurface, m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices, m_GraphicsDevice.Config.RequiredDeviceFeatures, m_GraphicsDevice.Config.RequiredDeviceExtensions, m_GraphicsDevice.Config.ValidationLayers, &EnabledFeatures12);
 		VK_CHECK_HANDLE(m_GraphicsDevice.Device);	
 		
+		if (m_GraphicsDevice.Capabilities.bPresentWait)
+		{
+			m_GraphicsDevice.WaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_GraphicsDevice.Device, "vkWaitForPresentKHR"));
+			m_GraphicsDevice.Capabilities.bPresentWait = m_GraphicsDevice.WaitForPresent != nullptr;
+		}
+		m_Stats.bPresentWait = m_GraphicsDevice.Capabilities.bPresentWait;
+		m_LatencyClock.Start();
+		
 		vkGetDeviceQueue(m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex, 0, &m_GraphicsDevice.GraphicsQueue);
 		vkGetDeviceQueue(m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices.PresentFamilyIndex, 0, &m_GraphicsDevice.PresentQueue);
+		vkGetDeviceQueue(m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices.GetTransferFamily(), 0, &m_GraphicsDevice.TransferQueue);
+		vkGetDeviceQueue(m_GraphicsDevice.Device, m_GraphicsDevice.QueueFamilyIndices.GetComputeFamily(), 0, &m_GraphicsDevice.ComputeQueue);
+		
+		LLOG(Vulkan, Info, "Queue families: graphics %u, present %u, transfer %u%s, compute %u%s.",
+			m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex,
+			m_GraphicsDevice.QueueFamilyIndices.PresentFamilyIndex,
+			m_GraphicsDevice.QueueFamilyIndices.GetTransferFamily(), m_GraphicsDevice.QueueFamilyIndices.TransferFamilyPresent ? " (dedicated)" : "",
+			m_GraphicsDevice.QueueFamilyIndices.GetComputeFamily(), m_GraphicsDevice.QueueFamilyIndices.ComputeFamilyPresent ? " (dedicated)" : "");
+		
+		m_GraphicsDevice.Capabilities.TimestampPeriod = LVK::QueryTimestampPeriod(m_GraphicsDevice.PhysicalDevice, m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex);
+		if (m_GraphicsDevice.Capabilities.TimestampPeriod == 0.0f)
+		{
+			LLOG(Vulkan, Warning, "Graphics queue has no timestamps, dynamic resolution is disabled.");
+		}
 		
 		LVK::DestroySurface(m_GraphicsDevice.Instance, DummySurface);
 		DisplayManager::Get().DestroyWindow(DummyWindow);
@@ -90,6 +219,22 @@ namespace Locus
 			LVK::DestroyInstance(m_GraphicsDevice.Instance);	
 		});
 		
+		// One timeline per queue that is submitted to, frames and uploads wait on values instead of fences
+		
+		m_GraphicsDevice.GraphicsTimeline.Init(m_GraphicsDevice.Device);
+		if (m_GraphicsDevice.QueueFamilyIndices.TransferFamilyPresent)
+		{
+			m_GraphicsDevice.TransferTimeline.Init(m_GraphicsDevice.Device);
+		}
+		
+		m_GraphicsDevice.GlobalDeletionQueue.Push([&](){
+			m_GraphicsDevice.GraphicsTimeline.Destroy(m_GraphicsDevice.Device);
+			if (m_GraphicsDevice.QueueFamilyIndices.TransferFamilyPresent)
+			{
+				m_GraphicsDevice.TransferTimeline.Destroy(m_GraphicsDevice.Device);
+			}
+		});
+		
 		// Allocator
 		
 		VmaAllocatorCreateInfo AllocatorInfo = {
@@ -126,10 +271,95 @@ namespace Locus
 		m_GraphicsDevice.GlobalDeletionQueue.Push([=](){
 			vkDestroyDescriptorPool(m_GraphicsDevice.Device, m_GraphicsDevice.ImGuiDescriptorPool, nullptr);
 		});
+		
+		// Pipeline cache, saved back to disk on shutdown
+		
+		m_GraphicsDevice.PipelineCache.Load(m_GraphicsDevice.Device, m_GraphicsDevice.PhysicalDevice, PIPELINE_CACHE_PATH);
+		m_Stats.bPipelineCacheWarm = m_GraphicsDevice.PipelineCache.bWarm;
+		
+		m_GraphicsDevice.GlobalDeletionQueue.Push([&](){
+			m_GraphicsDevice.PipelineCache.Destroy(m_GraphicsDevice.Device);
+		});
+		
+		// Immediate submission, for one-off uploads outside of a frame
+		
+		VkCommandPoolCreateInfo ImmediatePoolInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex
+		};
+		VK_CHECK_RESULT(vkCreateCommandPool(m_GraphicsDevice.Device, &ImmediatePoolInfo, nullptr, &m_GraphicsDevice.ImmediateCommandPool));
+		
+		VkCommandBufferAllocateInfo ImmediateBufferInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.commandPool = m_GraphicsDevice.ImmediateCommandPool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = 1,
+		};
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(m_GraphicsDevice.Device, &ImmediateBufferInfo, &m_GraphicsDevice.ImmediateCommandBuffer));
+		
+		m_GraphicsDevice.GlobalDeletionQueue.Push([&](){
+			vkDestroyCommandPool(m_GraphicsDevice.Device, m_GraphicsDevice.ImmediateCommandPool, nullptr);
+		});
+		
+		// Bindless heap, every slot starts out pointing at the default resources
+		
+		CreateDefaultResources();
+		
+		LVKBindlessDefaults BindlessDefaults = {
+			.ImageView = m_DefaultImage.View,
+			.Buffer = m_DefaultBuffer.Buffer,
+			.Sampler = m_DefaultSampler,
+		};
+		m_BindlessHeap.Init(m_GraphicsDevice.Device, m_GraphicsDevice.PhysicalDevice, m_GraphicsDevice.Capabilities.bDescriptorIndexing, BindlessDefaults, WINDOW_COUNT_MAX * FRAMES_IN_FLIGHT_MAX);
+		m_PipelineRegistry.SetBindlessHeap(&m_BindlessHeap);
+		m_Stats.bBindlessDescriptors = m_BindlessHeap.IsBindless();
+		
+		m_DescriptorCache.Init(m_GraphicsDevice.Device, DESCRIPTOR_CACHE_CAPACITY);
+		
+		// Staging uploads, submitted ahead of each frame on the transfer queue
+		
+		LVKUploadManagerConfig UploadConfig = {
+			.RingSize = UPLOAD_RING_SIZE,
+			.FrameBudget = UPLOAD_FRAME_BUDGET,
+			.QueueFamily = m_GraphicsDevice.QueueFamilyIndices.GetTransferFamily(),
+			.DstQueueFamily = m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex,
+		};
+		m_UploadManager.Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, &m_GraphicsDevice.GetTransferTimeline(), UploadConfig);
+		
+		// Single pass mip chains, for the depth pyramid and anything else with a shader for its format
+		
+		m_Downsampler.Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator);
+		CreateDownsamplePipelines();
+		
+		// GPU-driven scene, its geometry is streamed through the upload manager
+		
+		m_GpuScene.Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, &m_UploadManager, m_GraphicsDevice.Capabilities.bDrawIndirectCount, {});
+		m_Stats.bDrawIndirectCount = m_GraphicsDevice.Capabilities.bDrawIndirectCount;
+		CreateScenePipelines();
+		
+		// Instanced static meshes, uploaded the same way
+		
+		m_StaticMeshes.Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, &m_UploadManager, m_GraphicsDevice.Capabilities.bDrawIndirectCount, {});
+		CreateStaticMeshPipeline();
+		
+		// Streamed textures, levels come in through the upload manager and are sampled from the bindless heap
+		
+		m_TextureStreamer.Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, &m_UploadManager, &m_BindlessHeap, m_DefaultSampler, m_GraphicsDevice.Capabilities.bTextureCompressionBC, [this](std::function<void()>&& DeletionFunction){
+			RetireResource(std::move(DeletionFunction));
+		}, {});
+
+#if LOCUS_DEVELOPMENT && defined(LOCUS_SHADER_SOURCE_DIR)
+		m_ShaderHotReloader = std::make_unique<ShaderHotReloader>(LOCUS_SHADER_SOURCE_DIR, LOCUS_SHADER_BINARY_DIR, LOCUS_GLSLANG_VALIDATOR);
+#endif
 	}
 	
 	LVKGraphicsManager::~LVKGraphicsManager()
 	{
+		m_ShaderHotReloader.reset();
+		
 		vkDeviceWaitIdle(m_GraphicsDevice.Device);
 		
 		for (arch i = 0; i < m_RenderContextPool.Count(); i++)
@@ -141,113 +371,87 @@ namespace Locus
 			}
 		}
 		
+		for (arch i = 0; i < m_ComputePipelines.Count(); i++)
+		{
+			if (m_ComputePipelines.IsValidAt(i))
+			{
+				ReleasePipelineInstance(m_ComputePipelines.GetValueAt(i).Instance);
+			}
+		}
+		
+		for (arch i = 0; i < m_GraphicsPipelines.Count(); i++)
+		{
+			if (m_GraphicsPipelines.IsValidAt(i))
+			{
+				ReleasePipelineInstance(m_GraphicsPipelines.GetValueAt(i).Instance);
+			}
+		}
+		
+		for (arch i = 0; i < m_Buffers.Count(); i++)
+		{
+			if (m_Buffers.IsValidAt(i))
+			{
+				const LVKBuffer& Buffer = m_Buffers.GetValueAt(i).Buffer;
+				vmaDestroyBuffer(m_GraphicsDevice.Allocator, Buffer.Buffer, Buffer.Allocation);
+			}
+		}
+		
+		for (const LVKGraphicsBuffer& Buffer : m_BuffersAwaitingUpload)
+		{
+			vmaDestroyBuffer(m_GraphicsDevice.Allocator, Buffer.Buffer.Buffer, Buffer.Buffer.Allocation);
+		}
+		
+		for (const LVKComputePipeline& Pipeline : m_DownsamplePipelines)
+		{
+			ReleasePipelineInstance(Pipeline.Instance);
+		}
+		m_Downsampler.Destroy();
+		ReleasePipelineInstance(m_SceneCullPipeline.Instance);
+		ReleasePipelineInstance(m_DepthPyramidPipeline.Instance);
+		ReleasePipelineInstance(m_SceneDrawPipeline);
+		m_GpuScene.Destroy();
+		ReleasePipelineInstance(m_StaticMeshCullPipeline.Instance);
+		ReleasePipelineInstance(m_StaticMeshPipeline);
+		m_StaticMeshes.Destroy();
+		m_TextureStreamer.Destroy();
+		
+		m_GraphicsDevice.RetiredResources.FlushAll();
+		m_PipelineRegistry.Destroy(m_GraphicsDevice.Device);
+		m_BindlessHeap.Destroy(m_GraphicsDevice.Device);
+		m_DescriptorCache.Destroy(m_GraphicsDevice.Device);
+		m_UploadManager.Destroy(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator);
+		
+		LLOG(Vulkan, Info, "Created %u pipelines in %.2lfms with a %s pipeline cache.", m_PipelineRegistry.GetPipelinesCreated(), m_PipelineRegistry.GetPipelineCreateMilliseconds(), m_Stats.bPipelineCacheWarm ? "warm" : "cold");
+		m_GraphicsDevice.PipelineCache.Save(m_GraphicsDevice.Device, m_GraphicsDevice.PhysicalDevice, PIPELINE_CACHE_PATH);
+		
 		m_GraphicsDevice.GlobalDeletionQueue.Flush();
 	}
 	
 	RenderContextHandle LVKGraphicsManager::CreateRenderContext(const WindowHandle Window)
 	{
 		LVKRenderContext Ctx;
+		Ctx.Window = Window;
 		
 		VK_CHECK_HANDLE(m_GraphicsDevice.Instance);
 		
-		// Make the surface
+		// Make the surface, destroyed with the context
 		LVK::CreateSurface(Window, m_GraphicsDevice.Instance, Ctx.Surface);
 		
-		m_GraphicsDevice.GlobalDeletionQueue.Push([&](){
-			LVK::DestroySurface(m_GraphicsDevice.Instance, Ctx.Surface);
-		});
-		
-		// Query for swapchain details
+		// The format is chosen once, the render pass below and every pipeline built against it depend on it.
 		LVKSwapchainSupportDetails SwapchainSupportDetails = LVK::QuerySwapchainSupport(Ctx.Surface, m_GraphicsDevice.PhysicalDevice);
+		Ctx.Swapchain.Details.ImageFormat = LVK::ChooseSwapchainSurfaceFormat(SwapchainSupportDetails.Formats).format;
 		
-		VkSurfaceFormatKHR SurfaceFormat = LVK::ChooseSwapchainSurfaceFormat(SwapchainSupportDetails.Formats);
-		VkPresentModeKHR PresentMode = LVK::ChooseSwapchainPresentMode(SwapchainSupportDetails.PresentModes);
-		VkExtent2D Extent = LVK::ChooseSwapchainExtent(Window, SwapchainSupportDetails.Capabilities);
-		
-		u32 ImageCount = SwapchainSupportDetails.Capabilities.minImageCount + 1;
-		if (SwapchainSupportDetails.Capabilities.maxImageCount > 0 && ImageCount > SwapchainSupportDetails.Capabilities.maxImageCount) {
-			ImageCount = SwapchainSupportDetails.Capabilities.maxImageCount;
-		}
-		
-		VkSwapchainCreateInfoKHR SwapchainCreateInfo = {
-			.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-			.surface = Ctx.Surface,
-			.minImageCount = ImageCount,
-			.imageFormat = SurfaceFormat.format,
-			.imageColorSpace = SurfaceFormat.colorSpace,
-			.imageExtent = Extent,
-			.imageArrayLayers = 1,
-			.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-			.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
-			.queueFamilyIndexCount = 0,
-			.pQueueFamilyIndices = nullptr,
-			.preTransform = SwapchainSupportDetails.Capabilities.currentTransform,
-			.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-			.presentMode = PresentMode,
-			.clipped = VK_TRUE,
-			.oldSwapchain = VK_NULL_HANDLE
-		};
-		
-		LVKQueueFamilyIndices QueueFamilyIndices = LVK::FindPhysicalDeviceQueueFamilies(m_GraphicsDevice.PhysicalDevice, Ctx.Surface);
-		u32 Indices[] = {QueueFamilyIndices.GraphicsFamilyIndex, QueueFamilyIndices.PresentFamilyIndex};
-		if (Indices[0] != Indices[1])
-		{
-			SwapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-			SwapchainCreateInfo.queueFamilyIndexCount = 2;
-			SwapchainCreateInfo.pQueueFamilyIndices = Indices;
-		}
-		
-		VK_CHECK_RESULT(vkCreateSwapchainKHR(m_GraphicsDevice.Device, &SwapchainCreateInfo, nullptr, &Ctx.Swapchain.Swapchain));
-		
-		// Store the details and grab the images
-		
-		Ctx.Swapchain.Details.Extent = Extent;
-		Ctx.Swapchain.Details.ImageFormat = SurfaceFormat.format;
-		Ctx.Swapchain.Details.ImageCount = ImageCount;
-		
-		vkGetSwapchainImagesKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, &Ctx.Swapchain.Details.ImageCount, nullptr);
-		Ctx.Swapchain.Images.Reserve(Ctx.Swapchain.Details.ImageCount);
-		vkGetSwapchainImagesKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, &Ctx.Swapchain.Details.ImageCount, Ctx.Swapchain.Images.Data());
-		
-		// Create the image views
-		
-		Ctx.Swapchain.ImageViews.Reserve(Ctx.Swapchain.Details.ImageCount);
-		for (arch i = 0; i < Ctx.Swapchain.Images.Length(); i++)
-		{
-			VkImageViewCreateInfo ViewCreateInfo = {
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.image = Ctx.Swapchain.Images[i],
-				.viewType = VK_IMAGE_VIEW_TYPE_2D,
-				.format = Ctx.Swapchain.Details.ImageFormat,
-				.components = {
-					.r = VK_COMPONENT_SWIZZLE_IDENTITY,
-					.g = VK_COMPONENT_SWIZZLE_IDENTITY,
-					.b = VK_COMPONENT_SWIZZLE_IDENTITY,
-					.a = VK_COMPONENT_SWIZZLE_IDENTITY,
-				},
-				.subresourceRange = {
-					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-					.baseMipLevel = 0,
-					.levelCount = 1,
-					.baseArrayLayer = 0,
-					.layerCount = 1,
-				},
-			};
-		
-			VK_CHECK_RESULT(vkCreateImageView(m_GraphicsDevice.Device, &ViewCreateInfo, nullptr, &Ctx.Swapchain.ImageViews[i]));
-		}
-		
-		// Renderpass
+		// Renderpass, layout transitions and the clear are left to the render graph
 			
 		VkAttachmentDescription ColorAttachment = {
 			.format = Ctx.Swapchain.Details.ImageFormat,
 			.samples = VK_SAMPLE_COUNT_1_BIT,
-			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
 			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
 			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-			.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+			.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 		};
 	
 		VkAttachmentReference ColorAttachmentRef = {
@@ -270,25 +474,12 @@ namespace Locus
 		};
 		
 		VK_CHECK_RESULT(vkCreateRenderPass(m_GraphicsDevice.Device, &RenderPassInfo, nullptr, &Ctx.Swapchain.RenderPass));
+		Ctx.Swapchain.RenderPassKey = LVK::RenderPassCompatibilityHash(RenderPassInfo);
 		
-		// Create framebuffers
+		// Swapchain, images, views and framebuffers, which are remade on resize
 		
-		Ctx.Swapchain.Framebuffers.Reserve(Ctx.Swapchain.Details.ImageCount);
-		for (arch i = 0; i < Ctx.Swapchain.Framebuffers.Length(); i++)
-		{
-			VkImageView Attachments[] = {Ctx.Swapchain.ImageViews[i]};
-			VkFramebufferCreateInfo FramebufferInfo = {
-				.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-				.renderPass = Ctx.Swapchain.RenderPass,
-				.attachmentCount = 1,
-				.pAttachments = Attachments,
-				.width = Ctx.Swapchain.Details.Extent.width,
-				.height = Ctx.Swapchain.Details.Extent.height,
-				.layers = 1
-			};
-			
-			VK_CHECK_RESULT(vkCreateFramebuffer(m_GraphicsDevice.Device, &FramebufferInfo, nullptr, &Ctx.Swapchain.Framebuffers[i]));
-		}
+		bool bSwapchainCreated = CreateSwapchain(Ctx, VK_NULL_HANDLE);
+		LAssertMsg(bSwapchainCreated, "A render context needs a window with some area to present to.");
 		
 		// Frame resources
 		
@@ -299,7 +490,7 @@ namespace Locus
 			.queueFamilyIndex = m_GraphicsDevice.QueueFamilyIndices.GraphicsFamilyIndex
 		};
 		
-		for (i32 i = 0; i < FRAMES_IN_FLIGHT; i++)
+		for (i32 i = 0; i < FRAMES_IN_FLIGHT_MAX; i++)
 		{
 			VK_CHECK_RESULT(vkCreateCommandPool(m_GraphicsDevice.Device, &PoolCreateInfo, nullptr, &Ctx.FrameResources[i].CommandPool));
 			
@@ -312,23 +503,28 @@ namespace Locus
 			};
 			
 			VK_CHECK_RESULT(vkAllocateCommandBuffers(m_GraphicsDevice.Device, &AllocInfo, &Ctx.FrameResources[i].CommandBuffer));
+			
+			if (m_GraphicsDevice.Capabilities.TimestampPeriod > 0.0f)
+			{
+				VkQueryPoolCreateInfo QueryPoolInfo = {
+					.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+					.pNext = nullptr,
+					.queryType = VK_QUERY_TYPE_TIMESTAMP,
+					.queryCount = TIMESTAMP_QUERY_COUNT,
+				};
+				VK_CHECK_RESULT(vkCreateQueryPool(m_GraphicsDevice.Device, &QueryPoolInfo, nullptr, &Ctx.FrameResources[i].TimestampPool));
+			}
 		}
 		
-		VkFenceCreateInfo FenceCreateInfo = {
-			.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = VK_FENCE_CREATE_SIGNALED_BIT
-		};
-		
 		VkSemaphoreCreateInfo SemaphoreCreateInfo = {
 			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
 			.pNext = nullptr,
 			.flags = 0
 		};
 		
-		for (i32 i = 0; i < FRAMES_IN_FLIGHT; i++)
+		for (i32 i = 0; i < FRAMES_IN_FLIGHT_MAX; i++)
 		{
-			VK_CHECK_RESULT(vkCreateFence(m_GraphicsDevice.Device, &FenceCreateInfo, nullptr, &Ctx.FrameResources[i].InFlightFence));
+			Ctx.FrameResources[i].BindlessFrameSet = m_BindlessHeap.CreateFrameSet(m_GraphicsDevice.Device);
 			VK_CHECK_RESULT(vkCreateSemaphore(m_GraphicsDevice.Device, &SemaphoreCreateInfo, nullptr, &Ctx.FrameResources[i].ImageAvailableSemaphore));
 			VK_CHECK_RESULT(vkCreateSemaphore(m_GraphicsDevice.Device, &SemaphoreCreateInfo, nullptr, &Ctx.FrameResources[i].RenderFinishedSemaphore));
 		}
@@ -364,6 +560,24 @@ namespace Locus
 		ImGui_ImplVulkan_Init(&InitInfo);
 		
 		RenderContextHandle Handle = m_RenderContextPool.Create(Ctx);
+		
+		// Initialized in place, the pool copies contexts bytewise.
+		for (LVKFrameResources& Frame : m_RenderContextPool.GetMut(Handle).FrameResources)
+		{
+			Frame.DescriptorAllocator.Init(m_GraphicsDevice.Device, FRAME_DESCRIPTOR_SETS_INITIAL, FRAME_DESCRIPTOR_RATIOS, static_cast<u32>(std::size(FRAME_DESCRIPTOR_RATIOS)));
+		}
+		
+		Unique<LVKRenderGraph> RenderGraph = std::make_unique<LVKRenderGraph>();
+		RenderGraph->Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, [this](std::function<void()>&& DeletionFunction){
+			RetireResource(std::move(DeletionFunction));
+		});
+		m_RenderGraphs[Handle] = std::move(RenderGraph);
+		
+		Unique<LVKDepthPyramid> DepthPyramid = std::make_unique<LVKDepthPyramid>();
+		DepthPyramid->Init(m_GraphicsDevice.Device, m_GraphicsDevice.Allocator, [this](std::function<void()>&& DeletionFunction){
+			RetireResource(std::move(DeletionFunction));
+		});
+		m_DepthPyramids[Handle] = std::move(DepthPyramid);
 
 		// TEMP
 		MakePipelines(Handle);
@@ -386,12 +600,21 @@ namespace Locus
 		ImGui_ImplSDL2_Shutdown();
 		ImGui::DestroyContext(Ctx.ImGuiContext);
 		
-		for (i32 i = 0; i < FRAMES_IN_FLIGHT; i++)
+		DestroyPipelines(RenderContext);
+		
+		m_RenderGraphs[RenderContext]->Destroy();
+		m_RenderGraphs.erase(RenderContext);
+		m_DepthPyramids[RenderContext]->Destroy();
+		m_DepthPyramids.erase(RenderContext);
+		
+		for (i32 i = 0; i < FRAMES_IN_FLIGHT_MAX; i++)
 		{
-			vkDestroyFence(m_GraphicsDevice.Device, Ctx.FrameResources[i].InFlightFence, nullptr);
+			m_BindlessHeap.DestroyFrameSet(m_GraphicsDevice.Device, Ctx.FrameResources[i].BindlessFrameSet);
+			Ctx.FrameResources[i].DescriptorAllocator.Destroy(m_GraphicsDevice.Device);
 			vkDestroySemaphore(m_GraphicsDevice.Device, Ctx.FrameResources[i].ImageAvailableSemaphore, nullptr);
 			vkDestroySemaphore(m_GraphicsDevice.Device, Ctx.FrameResources[i].RenderFinishedSemaphore, nullptr);
 			vkDestroyCommandPool(m_GraphicsDevice.Device, Ctx.FrameResources[i].CommandPool, nullptr);
+			vkDestroyQueryPool(m_GraphicsDevice.Device, Ctx.FrameResources[i].TimestampPool, nullptr);
 		}
 		
 		for (arch i = 0; i < Ctx.Swapchain.Framebuffers.Length(); i++)
@@ -408,62 +631,500 @@ namespace Locus
 		}
 		
 		vkDestroySurfaceKHR(m_GraphicsDevice.Instance, Ctx.Surface, nullptr);
+		
+		m_RenderContextPool.Destroy(RenderContext);
 	}
 	
-	void LVKGraphicsManager::BeginFrame(RenderContextHandle RenderContext)
+	void LVKGraphicsManager::WaitForFrameLatency(RenderContextHandle RenderContext)
 	{
-		LAssertMsg(m_ActiveRenderContext == HANDLE_INVALID, "There is already a frame in progress.");
+		LAssertMsg(m_ActiveRenderContext == HANDLE_INVALID, "Frame latency is waited for between frames.");
 		LAssert(m_RenderContextPool.IsValid(RenderContext));
 		
 		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(RenderContext);
+		ApplyFramesInFlight(Ctx);
 		LVKFrameResources& Frame = GetCurrentFrame(RenderContext);
-		VkCommandBuffer Cmd = Frame.CommandBuffer;
-		
-		VK_CHECK_RESULT(vkWaitForFences(m_GraphicsDevice.Device, 1, &Frame.InFlightFence, VK_TRUE, UINT64_MAX));
-		VK_CHECK_RESULT(vkResetFences(m_GraphicsDevice.Device, 1, &Frame.InFlightFence));
-		
-		VK_CHECK_RESULT(vkAcquireNextImageKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, UINT64_MAX, Frame.ImageAvailableSemaphore, nullptr, &m_ActiveImageIndex));
-		
-		VK_CHECK_RESULT(vkResetCommandBuffer(Cmd, 0));
-		VkCommandBufferBeginInfo CommandBufferBeginInfo = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-			.pNext = nullptr,
-			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-			.pInheritanceInfo = nullptr,
-		};
-		VK_CHECK_RESULT(vkBeginCommandBuffer(Cmd, &CommandBufferBeginInfo));
+		f64 WaitStart = m_LatencyClock.GetElapsedMilliseconds();
 		
-		LAssert(m_ActiveImageIndex < Ctx.Swapchain.Details.ImageCount);
-		
-		VkClearValue ClearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-		
-		VkRenderPassBeginInfo RenderPassBeginInfo = {
-			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-			.renderPass = Ctx.Swapchain.RenderPass,
-			.framebuffer = Ctx.Swapchain.Framebuffers[m_ActiveImageIndex],
-			.renderArea = {
-				.offset = {0, 0},
-				.extent = Ctx.Swapchain.Details.Extent,
-			},
-			.clearValueCount = 1,
-			.pClearValues = &ClearColor
-		};
+		// The frame FramesInFlight - 1 presents back has to be on screen, so with one frame in flight the
+		// next is only started once the last is showing, and input is never read further ahead of the display.
+		bool bMeasured = false;
+		if (m_PresentSettings.bWaitForPresent && m_GraphicsDevice.WaitForPresent != nullptr && Ctx.PresentId + 1 >= Ctx.FramesInFlight)
+		{
+			u64 PresentId = Ctx.PresentId + 1 - Ctx.FramesInFlight;
+			if (PresentId >= Ctx.FirstSwapchainPresentId)
+			{
+				VkResult Result = m_GraphicsDevice.WaitForPresent(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, PresentId, PRESENT_WAIT_TIMEOUT);
+				if (Result == VK_SUCCESS)
+				{
+					UpdateInputLatency(m_LatencyClock.GetElapsedMilliseconds() - Ctx.PresentInputMilliseconds[PresentId % PRESENT_HISTORY]);
+					bMeasured = true;
+				}
+				else if (Result == VK_ERROR_OUT_OF_DATE_KHR || Result == VK_SUBOPTIMAL_KHR)
+				{
+					Ctx.bSwapchainOutOfDate = true;
+				}
+				else if (Result != VK_TIMEOUT)
+				{
+					VK_CHECK_RESULT(Result);
+				}
+			}
+		}
 		
-		vkCmdBeginRenderPass(Cmd, &RenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// BeginFrame's wait for the slot, moved ahead of input. Without present wait latency is measured to
+		// the frame finishing on the GPU, or to now if it already had, an upper bound either way.
+		m_GraphicsDevice.GraphicsTimeline.Wait(m_GraphicsDevice.Device, Frame.TimelineValue);
+		if (!bMeasured && Frame.TimelineValue != 0)
+		{
+			UpdateInputLatency(m_LatencyClock.GetElapsedMilliseconds() - Frame.InputMilliseconds);
+		}
 		
-		m_ActiveRenderContext = RenderContext;
+		Ctx.InputMilliseconds = m_LatencyClock.GetElapsedMilliseconds();
+		Ctx.bInputSampled = true;
+		m_Stats.LatencyWaitMilliseconds = Ctx.InputMilliseconds - WaitStart;
 	}
 	
-	void LVKGraphicsManager::EndFrame(RenderContextHandle RenderContext) 
+	void LVKGraphicsManager::ApplyFramesInFlight(LVKRenderContext& Ctx)
 	{
-		LAssertMsg(m_ActiveRenderContext == RenderContext, "There is not currently a frame in progress for the given render context.");
-		
+		u32 FramesInFlight = std::clamp(m_PresentSettings.FramesInFlight, 1u, FRAMES_IN_FLIGHT_MAX);
+		m_Stats.FramesInFlight = FramesInFlight;
+		if (FramesInFlight == Ctx.FramesInFlight)
+		{
+			return;
+		}
+		
+		// Slots are picked by frame number modulo the count, a new count hands the next frames to slots
+		// out of turn. Letting every slot finish once keeps each frame's wait covering all older ones.
+		u64 LastSubmitted = 0;
+		for (const LVKFrameResources& Frame : Ctx.FrameResources)
+		{
+			LastSubmitted = std::max(LastSubmitted, Frame.TimelineValue);
+		}
+		m_GraphicsDevice.GraphicsTimeline.Wait(m_GraphicsDevice.Device, LastSubmitted);
+		Ctx.FramesInFlight = FramesInFlight;
+	}
+	
+	void LVKGraphicsManager::UpdateInputLatency(f64 Milliseconds)
+	{
+		f64& Smoothed = m_Stats.InputLatencyMilliseconds;
+		Smoothed = Smoothed == 0.0 ? Milliseconds : Smoothed + (Milliseconds - Smoothed) * INPUT_LATENCY_SMOOTHING;
+	}
+	
+	bool LVKGraphicsManager::CreateSwapchain(LVKRenderContext& Ctx, VkSwapchainKHR OldSwapchain)
+	{
+		LVKSwapchainSupportDetails SwapchainSupportDetails = LVK::QuerySwapchainSupport(Ctx.Surface, m_GraphicsDevice.PhysicalDevice);
+		
+		VkSurfaceFormatKHR SurfaceFormat = LVK::ChooseSwapchainSurfaceFormat(SwapchainSupportDetails.Formats);
+		VkPresentModeKHR PresentMode = LVK::ChooseSwapchainPresentMode(SwapchainSupportDetails.PresentModes, ToVkPresentMode(m_PresentSettings.Policy));
+		VkExtent2D Extent = LVK::ChooseSwapchainExtent(Ctx.Window, SwapchainSupportDetails.Capabilities);
+		LAssertMsg(SurfaceFormat.format == Ctx.Swapchain.Details.ImageFormat, "The surface format changed under the render pass.");
+		
+		// Minimised, there is nothing a swapchain can be made for until the window is restored.
+		if (Extent.width == 0 || Extent.height == 0)
+		{
+			return false;
+		}
+		
+		u32 ImageCount = SwapchainSupportDetails.Capabilities.minImageCount + 1;
+		if (SwapchainSupportDetails.Capabilities.maxImageCount > 0 && ImageCount > SwapchainSupportDetails.Capabilities.maxImageCount) {
+			ImageCount = SwapchainSupportDetails.Capabilities.maxImageCount;
+		}
+		
+		// Handing over the old swapchain lets the presentation engine carry on showing its images while the new ones are made.
+		VkSwapchainCreateInfoKHR SwapchainCreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+			.surface = Ctx.Surface,
+			.minImageCount = ImageCount,
+			.imageFormat = SurfaceFormat.format,
+			.imageColorSpace = SurfaceFormat.colorSpace,
+			.imageExtent = Extent,
+			.imageArrayLayers = 1,
+			.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 0,
+			.pQueueFamilyIndices = nullptr,
+			.preTransform = SwapchainSupportDetails.Capabilities.currentTransform,
+			.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+			.presentMode = PresentMode,
+			.clipped = VK_TRUE,
+			.oldSwapchain = OldSwapchain
+		};
+		
+		LVKQueueFamilyIndices QueueFamilyIndices = LVK::FindPhysicalDeviceQueueFamilies(m_GraphicsDevice.PhysicalDevice, Ctx.Surface);
+		u32 Indices[] = {QueueFamilyIndices.GraphicsFamilyIndex, QueueFamilyIndices.PresentFamilyIndex};
+		if (Indices[0] != Indices[1])
+		{
+			SwapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+			SwapchainCreateInfo.queueFamilyIndexCount = 2;
+			SwapchainCreateInfo.pQueueFamilyIndices = Indices;
+		}
+		
+		VK_CHECK_RESULT(vkCreateSwapchainKHR(m_GraphicsDevice.Device, &SwapchainCreateInfo, nullptr, &Ctx.Swapchain.Swapchain));
+		
+		// Store the details and grab the images
+		
+		Ctx.Swapchain.Details.Extent = Extent;
+		Ctx.Swapchain.Details.ImageCount = ImageCount;
+		Ctx.Policy = m_PresentSettings.Policy;
+		Ctx.FirstSwapchainPresentId = Ctx.PresentId + 1;
+		m_Stats.Policy = ToPresentPolicy(PresentMode);
+		DisplayManager::Get().GetWindowFramebufferSize(Ctx.Window, Ctx.WindowExtent.width, Ctx.WindowExtent.height);
+		
+		vkGetSwapchainImagesKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, &Ctx.Swapchain.Details.ImageCount, nullptr);
+		Ctx.Swapchain.Images.Reserve(Ctx.Swapchain.Details.ImageCount);
+		vkGetSwapchainImagesKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, &Ctx.Swapchain.Details.ImageCount, Ctx.Swapchain.Images.Data());
+		
+		// Create the image views
+		
+		Ctx.Swapchain.ImageViews.Reserve(Ctx.Swapchain.Details.ImageCount);
+		for (arch i = 0; i < Ctx.Swapchain.Images.Length(); i++)
+		{
+			VkImageViewCreateInfo ViewCreateInfo = {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.image = Ctx.Swapchain.Images[i],
+				.viewType = VK_IMAGE_VIEW_TYPE_2D,
+				.format = Ctx.Swapchain.Details.ImageFormat,
+				.components = {
+					.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+					.g = VK_COMPONENT_SWIZZLE_IDENTITY,
+					.b = VK_COMPONENT_SWIZZLE_IDENTITY,
+					.a = VK_COMPONENT_SWIZZLE_IDENTITY,
+				},
+				.subresourceRange = {
+					.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+					.baseMipLevel = 0,
+					.levelCount = 1,
+					.baseArrayLayer = 0,
+					.layerCount = 1,
+				},
+			};
+			
+			VK_CHECK_RESULT(vkCreateImageView(m_GraphicsDevice.Device, &ViewCreateInfo, nullptr, &Ctx.Swapchain.ImageViews[i]));
+		}
+		
+		// Create framebuffers
+		
+		Ctx.Swapchain.Framebuffers.Reserve(Ctx.Swapchain.Details.ImageCount);
+		for (arch i = 0; i < Ctx.Swapchain.Framebuffers.Length(); i++)
+		{
+			VkImageView Attachments[] = {Ctx.Swapchain.ImageViews[i]};
+			VkFramebufferCreateInfo FramebufferInfo = {
+				.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+				.renderPass = Ctx.Swapchain.RenderPass,
+				.attachmentCount = 1,
+				.pAttachments = Attachments,
+				.width = Ctx.Swapchain.Details.Extent.width,
+				.height = Ctx.Swapchain.Details.Extent.height,
+				.layers = 1
+			};
+			
+			VK_CHECK_RESULT(vkCreateFramebuffer(m_GraphicsDevice.Device, &FramebufferInfo, nullptr, &Ctx.Swapchain.Framebuffers[i]));
+		}
+		
+		return true;
+	}
+	
+	bool LVKGraphicsManager::RecreateSwapchain(LVKRenderContext& Ctx)
+	{
+		VkSwapchainKHR OldSwapchain = Ctx.Swapchain.Swapchain;
+		std::vector<VkImageView> OldViews(Ctx.Swapchain.ImageViews.Data(), Ctx.Swapchain.ImageViews.Data() + Ctx.Swapchain.ImageViews.Length());
+		std::vector<VkFramebuffer> OldFramebuffers(Ctx.Swapchain.Framebuffers.Data(), Ctx.Swapchain.Framebuffers.Data() + Ctx.Swapchain.Framebuffers.Length());
+		
+		// Left as it is while minimised, it is out of date but nothing is acquired from it until it is remade.
+		if (!CreateSwapchain(Ctx, OldSwapchain))
+		{
+			return false;
+		}
+		
+		// Frames still in flight may be drawing to the old images, they go once the GPU is past them
+		// rather than after a device wait. Retired, the old swapchain gives up any image not acquired.
+		RetireResource([Device = m_GraphicsDevice.Device, OldSwapchain, OldViews = std::move(OldViews), OldFramebuffers = std::move(OldFramebuffers)](){
+			for (VkFramebuffer Framebuffer : OldFramebuffers)
+			{
+				vkDestroyFramebuffer(Device, Framebuffer, nullptr);
+			}
+			for (VkImageView View : OldViews)
+			{
+				vkDestroyImageView(Device, View, nullptr);
+			}
+			vkDestroySwapchainKHR(Device, OldSwapchain, nullptr);
+		});
+		
+		Ctx.bSwapchainOutOfDate = false;
+		m_Stats.SwapchainRecreations++;
+		return true;
+	}
+	
+	bool LVKGraphicsManager::BeginFrame(RenderContextHandle RenderContext)
+	{
+		LAssertMsg(m_ActiveRenderContext == HANDLE_INVALID, "There is already a frame in progress.");
+		LAssert(m_RenderContextPool.IsValid(RenderContext));
+		
+		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(RenderContext);
+		ApplyFramesInFlight(Ctx);
+		LVKFrameResources& Frame = GetCurrentFrame(RenderContext);
+		VkCommandBuffer Cmd = Frame.CommandBuffer;
+		
+		// Only this slot's previous submission has to be done, anything newer keeps running. After
+		// WaitForFrameLatency it already is, otherwise input was read before this wait.
+		LVKTimeline& Timeline = m_GraphicsDevice.GraphicsTimeline;
+		Timeline.Wait(m_GraphicsDevice.Device, Frame.TimelineValue);
+		Timeline.Poll(m_GraphicsDevice.Device);
+		if (!Ctx.bInputSampled)
+		{
+			if (Frame.TimelineValue != 0)
+			{
+				UpdateInputLatency(m_LatencyClock.GetElapsedMilliseconds() - Frame.InputMilliseconds);
+			}
+			Ctx.InputMilliseconds = m_LatencyClock.GetElapsedMilliseconds();
+		}
+		
+		m_GraphicsDevice.RetiredResources.Flush(Timeline.Completed);
+		Frame.DescriptorAllocator.Reset(m_GraphicsDevice.Device);
+		
+		// Textures taking over new images register them in the heap, ahead of this frame's copy of it catching up.
+		m_TextureStreamer.Update();
+		const LVKTextureStats& TextureStats = m_TextureStreamer.GetStats();
+		m_Stats.Textures = TextureStats.Textures;
+		m_Stats.TexturesStreaming = TextureStats.Changing;
+		m_Stats.TextureResidentBytes = TextureStats.ResidentBytes;
+		m_Stats.TextureWantedBytes = TextureStats.WantedBytes;
+		m_Stats.TextureBudgetBytes = TextureStats.BudgetBytes;
+		m_Stats.TextureLevelsStreamedIn = TextureStats.LevelsStreamedIn;
+		m_Stats.TextureLevelsEvicted = TextureStats.LevelsEvicted;
+		
+		Frame.BindlessSet = m_BindlessHeap.Sync(m_GraphicsDevice.Device, Frame.BindlessFrameSet);
+		m_Stats.BindlessImages = m_BindlessHeap.GetCount(LVKBindlessType::SampledImage);
+		m_Stats.BindlessBuffers = m_BindlessHeap.GetCount(LVKBindlessType::StorageBuffer);
+		m_Stats.BindlessSamplers = m_BindlessHeap.GetCount(LVKBindlessType::Sampler);
+		
+		m_DescriptorCache.BeginFrame(m_GraphicsDevice.Device, Timeline.GetNextValue(), Timeline.Completed);
+		m_Stats.DescriptorCacheHits = m_DescriptorCache.GetHits();
+		m_Stats.DescriptorCacheMisses = m_DescriptorCache.GetMisses();
+		m_Stats.DescriptorCacheEntries = m_DescriptorCache.GetEntryCount();
+		
+		// This slot's timestamps are from a submission that has completed, so they are available without waiting.
+		if (Frame.bTimestampsWritten)
+		{
+			f64 TicksToMilliseconds = static_cast<f64>(m_GraphicsDevice.Capabilities.TimestampPeriod) / 1000000.0;
+			u64 Timestamps[TIMESTAMP_QUERY_COUNT] = {};
+			if (vkGetQueryPoolResults(m_GraphicsDevice.Device, Frame.TimestampPool, TIMESTAMP_FRAME_BEGIN, 2, 2 * sizeof(u64), &Timestamps[TIMESTAMP_FRAME_BEGIN], sizeof(u64), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+			{
+				f64 GpuMilliseconds = (Timestamps[TIMESTAMP_SCENE_END] - Timestamps[TIMESTAMP_FRAME_BEGIN]) * TicksToMilliseconds;
+				Ctx.RenderScale.Update(GpuMilliseconds, m_RenderScaleSettings);
+				m_Stats.GpuFrameMilliseconds = GpuMilliseconds;
+			}
+			
+			// Pairs are read one at a time, a dispatch whose pass was culled never wrote its pair.
+			m_Stats.ComputeMilliseconds = 0.0;
+			for (u32 i = 0; i < Frame.TimedDispatches; i++)
+			{
+				u32 Query = TIMESTAMP_DISPATCHES + 2 * i;
+				if (vkGetQueryPoolResults(m_GraphicsDevice.Device, Frame.TimestampPool, Query, 2, 2 * sizeof(u64), &Timestamps[Query], sizeof(u64), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+				{
+					m_Stats.ComputeMilliseconds += (Timestamps[Query + 1] - Timestamps[Query]) * TicksToMilliseconds;
+				}
+			}
+			
+			// The scene's passes, any of which may not have run.
+			f64 SceneMilliseconds[static_cast<u32>(LVKGpuSceneTiming::Count)] = {};
+			for (u32 i = 0; i < static_cast<u32>(LVKGpuSceneTiming::Count); i++)
+			{
+				u32 Query = TIMESTAMP_SCENE_PASSES + 2 * i;
+				if (vkGetQueryPoolResults(m_GraphicsDevice.Device, Frame.TimestampPool, Query, 2, 2 * sizeof(u64), &Timestamps[Query], sizeof(u64), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+				{
+					SceneMilliseconds[i] = (Timestamps[Query + 1] - Timestamps[Query]) * TicksToMilliseconds;
+				}
+			}
+			auto SceneTime = [&SceneMilliseconds](LVKGpuSceneTiming Timing) { return SceneMilliseconds[static_cast<u32>(Timing)]; };
+			m_Stats.SceneCullMilliseconds = SceneTime(LVKGpuSceneTiming::EarlyCull) + SceneTime(LVKGpuSceneTiming::LateCull);
+			m_Stats.SceneDrawMilliseconds = SceneTime(LVKGpuSceneTiming::EarlyDraw) + SceneTime(LVKGpuSceneTiming::LateDraw);
+			m_Stats.SceneOcclusionMilliseconds = SceneTime(LVKGpuSceneTiming::DepthPyramid) + SceneTime(LVKGpuSceneTiming::LateCull);
+			
+			// What the occluded objects would have cost at the average cost of the ones drawn, less what finding them cost.
+			f64 DrawMillisecondsPerObject = m_Stats.SceneVisibleObjects > 0 ? m_Stats.SceneDrawMilliseconds / m_Stats.SceneVisibleObjects : 0.0;
+			m_Stats.SceneOcclusionSavedMilliseconds = m_Stats.SceneOccludedObjects * DrawMillisecondsPerObject - m_Stats.SceneOcclusionMilliseconds;
+			Frame.bTimestampsWritten = false;
+		}
+		Frame.TimedDispatches = 0;
+		m_Stats.RenderScale = Ctx.RenderScale.GetScale();
+		
+		// Kept from a skipped frame too, the acquires it recorded nothing for are still to come.
+		m_UploadWaitValue = std::max(m_UploadWaitValue, m_UploadManager.Flush(m_GraphicsDevice.Device, m_GraphicsDevice.TransferQueue));
+		m_Stats.UploadBytesLastFrame = m_UploadManager.GetBytesLastFlush();
+		m_Stats.UploadsPending = m_UploadManager.GetPendingUploads();
+		for (auto It = m_BuffersAwaitingUpload.begin(); It != m_BuffersAwaitingUpload.end(); )
+		{
+			if (!m_UploadManager.IsComplete(It->Upload))
+			{
+				It++;
+				continue;
+			}
+			
+			LVKBuffer Destroyed = It->Buffer;
+			RetireResource([=](){
+				vmaDestroyBuffer(m_GraphicsDevice.Allocator, Destroyed.Buffer, Destroyed.Allocation);
+			});
+			It = m_BuffersAwaitingUpload.erase(It);
+		}
+		m_GpuScene.Update(Timeline.Completed);
+		m_StaticMeshes.Update(Timeline.Completed);
+		UpdatePipelines();
+		
+		// Everything above is safe to repeat next frame, a frame with nothing to present to stops here.
+		VkExtent2D WindowExtent = {};
+		DisplayManager::Get().GetWindowFramebufferSize(Ctx.Window, WindowExtent.width, WindowExtent.height);
+		if (WindowExtent.width != Ctx.WindowExtent.width || WindowExtent.height != Ctx.WindowExtent.height || Ctx.Policy != m_PresentSettings.Policy)
+		{
+			Ctx.bSwapchainOutOfDate = true;
+		}
+		if (Ctx.bSwapchainOutOfDate && !RecreateSwapchain(Ctx))
+		{
+			m_Stats.SkippedFrames++;
+			return false;
+		}
+		
+		// Out of date leaves the semaphore unsignalled, so it can be handed straight to the next acquire.
+		// Suboptimal still hands out an image and signals, that frame goes ahead and the swapchain is remade after.
+		VkResult AcquireResult = vkAcquireNextImageKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, UINT64_MAX, Frame.ImageAvailableSemaphore, nullptr, &m_ActiveImageIndex);
+		if (AcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			if (!RecreateSwapchain(Ctx))
+			{
+				m_Stats.SkippedFrames++;
+				return false;
+			}
+			AcquireResult = vkAcquireNextImageKHR(m_GraphicsDevice.Device, Ctx.Swapchain.Swapchain, UINT64_MAX, Frame.ImageAvailableSemaphore, nullptr, &m_ActiveImageIndex);
+			if (AcquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				Ctx.bSwapchainOutOfDate = true;
+				m_Stats.SkippedFrames++;
+				return false;
+			}
+		}
+		if (AcquireResult == VK_SUBOPTIMAL_KHR)
+		{
+			Ctx.bSwapchainOutOfDate = true;
+		}
+		else
+		{
+			VK_CHECK_RESULT(AcquireResult);
+		}
+		m_Stats.SwapchainWidth = Ctx.Swapchain.Details.Extent.width;
+		m_Stats.SwapchainHeight = Ctx.Swapchain.Details.Extent.height;
+		
+		VK_CHECK_RESULT(vkResetCommandBuffer(Cmd, 0));
+		VkCommandBufferBeginInfo CommandBufferBeginInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = nullptr,
+		};
+		VK_CHECK_RESULT(vkBeginCommandBuffer(Cmd, &CommandBufferBeginInfo));
+		
+		m_UploadManager.RecordAcquires(Cmd);
+		m_TextureStreamer.RecordCopies(Cmd);
+		
+		if (Frame.TimestampPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(Cmd, Frame.TimestampPool, 0, TIMESTAMP_QUERY_COUNT);
+			vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, Frame.TimestampPool, TIMESTAMP_FRAME_BEGIN);
+		}
+		
+		LAssert(m_ActiveImageIndex < Ctx.Swapchain.Details.ImageCount);
+		
+		// Passes are recorded into the graph as the frame goes and executed in EndFrame.
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[RenderContext];
+		RenderGraph.Reset();
+		
+		// The acquire semaphore is waited on at colour attachment output, the first barrier has to chain off that stage.
+		LVKGraphResourceState Acquired = {
+			.Stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.Access = 0,
+			.Layout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+		VkExtent3D BackbufferExtent = { Ctx.Swapchain.Details.Extent.width, Ctx.Swapchain.Details.Extent.height, 1 };
+		m_Backbuffer = RenderGraph.ImportImage("Backbuffer", Ctx.Swapchain.Images[m_ActiveImageIndex], Ctx.Swapchain.ImageViews[m_ActiveImageIndex], Ctx.Swapchain.Details.ImageFormat, BackbufferExtent, Acquired, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		
+		// The scene goes to an HDR image sized for the swapchain, of which only the top left corner,
+		// scaled by the controller, is rendered and then stretched over the backbuffer. A new scale
+		// then never means new memory.
+		
+		f32 RenderScale = Ctx.RenderScale.GetScale();
+		m_DrawExtent = {
+			std::max(1u, static_cast<u32>(Ctx.Swapchain.Details.Extent.width * RenderScale)),
+			std::max(1u, static_cast<u32>(Ctx.Swapchain.Details.Extent.height * RenderScale)),
+		};
+		m_DrawImage = RenderGraph.CreateImage("Draw Image", { .Format = DRAW_IMAGE_FORMAT, .Extent = BackbufferExtent });
+		m_bDrawImageResolved = false;
+		m_SceneDepth = LVK_GRAPH_RESOURCE_INVALID;
+		m_bSceneDepthWritten = false;
+		m_FrameBuffers.clear();
+		m_Stats.ComputeDispatches = 0;
+		
+		m_RenderQueue.Reset();
+		m_QueuedDraws.clear();
+		m_QueuedPushConstants.clear();
+		
+		LVKGraphResource DrawImage = m_DrawImage;
+		RenderGraph.AddPass("Clear", [DrawImage](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkClearColorValue ClearColor = {{ 0.0f, 0.0f, 0.0f, 1.0f }};
+			VkImageSubresourceRange Range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vkCmdClearColorImage(Cmd, Graph.GetImage(DrawImage), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &ClearColor, 1, &Range);
+		}).Write(DrawImage, LVKGraphAccess::TransferDst);
+		
+		m_ActiveRenderContext = RenderContext;
+		return true;
+	}
+	
+	void LVKGraphicsManager::EndFrame(RenderContextHandle RenderContext) 
+	{
+		LAssertMsg(m_ActiveRenderContext == RenderContext, "There is not currently a frame in progress for the given render context.");
+		
 		LAssert(m_RenderContextPool.IsValid(RenderContext));
 		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(RenderContext);
 		LVKFrameResources& Frame = GetCurrentFrame(RenderContext);
 		VkCommandBuffer Cmd = Frame.CommandBuffer;
 		
-		vkCmdEndRenderPass(Cmd);
+		ResolveDrawImage();
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[RenderContext];
+		RenderGraph.Compile();
+		RenderGraph.Execute(Cmd);
+		Frame.bTimestampsWritten = Frame.TimestampPool != VK_NULL_HANDLE;
+		m_Backbuffer = LVK_GRAPH_RESOURCE_INVALID;
+		m_DrawImage = LVK_GRAPH_RESOURCE_INVALID;
+		m_SceneDepth = LVK_GRAPH_RESOURCE_INVALID;
+		m_FrameBuffers.clear();
+		
+		const LVKRenderGraphStats& GraphStats = RenderGraph.GetStats();
+		m_Stats.RenderGraphPasses = GraphStats.Passes;
+		m_Stats.RenderGraphCulledPasses = GraphStats.CulledPasses;
+		m_Stats.RenderGraphBarriers = GraphStats.Barriers;
+		m_Stats.RenderGraphTransientBytes = GraphStats.TransientBytes;
+		m_Stats.RenderGraphAllocatedBytes = GraphStats.AllocatedBytes;
+		
+		const LVKGpuSceneStats& SceneStats = m_GpuScene.GetStats();
+		m_Stats.SceneMeshes = SceneStats.Meshes;
+		m_Stats.SceneObjects = SceneStats.Objects;
+		m_Stats.SceneVisibleObjects = SceneStats.VisibleObjects;
+		m_Stats.SceneDrawCalls = SceneStats.DrawCalls;
+		m_Stats.SceneRetestedObjects = SceneStats.RetestedObjects;
+		m_Stats.SceneOccludedObjects = SceneStats.OccludedObjects;
+		m_Stats.SceneGeometryBytes = SceneStats.GeometryBytes;
+		m_Stats.SceneGeometryFreeBytes = SceneStats.GeometryFreeBytes;
+		m_Stats.SceneGeometryFreeRegions = SceneStats.GeometryFreeRegions;
+		m_Stats.SceneGeometryFragmentation = SceneStats.GeometryFragmentation;
+		
+		const LVKStaticMeshStats& StaticMeshStats = m_StaticMeshes.GetStats();
+		m_Stats.StaticMeshes = StaticMeshStats.Meshes;
+		m_Stats.StaticMeshInstances = StaticMeshStats.Instances;
+		m_Stats.StaticMeshDrawCalls = StaticMeshStats.DrawCalls;
+		m_Stats.StaticMeshGeometryBytes = StaticMeshStats.GeometryBytes;
+		m_Stats.StaticMeshTestedClusters = StaticMeshStats.TestedClusters;
+		m_Stats.StaticMeshVisibleClusters = StaticMeshStats.VisibleClusters;
+		m_Stats.StaticMeshTriangles = StaticMeshStats.Triangles;
+		m_Stats.StaticMeshFullDetailTriangles = StaticMeshStats.FullDetailTriangles;
 					
 		VK_CHECK_RESULT(vkEndCommandBuffer(Cmd));
 		
@@ -474,43 +1135,62 @@ namespace Locus
 			.deviceMask = 0
 		};
 		
-		VkSemaphoreSubmitInfo ImageAvailableSemaphoreSubmitInfo = {
-			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
-			.pNext = nullptr,
-			.semaphore = Frame.ImageAvailableSemaphore,
-			.value = 1,
-			.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
-			.deviceIndex = 0,
+		VkSemaphoreSubmitInfo WaitInfos[2] = {
+			{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.pNext = nullptr,
+				.semaphore = Frame.ImageAvailableSemaphore,
+				.value = 0,
+				.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+				.deviceIndex = 0,
+			},
+			m_GraphicsDevice.GetTransferTimeline().SubmitInfo(m_UploadWaitValue, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
+		};
+		
+		// The binary semaphore feeds present, the timeline value is what the CPU waits on.
+		Frame.TimelineValue = m_GraphicsDevice.GraphicsTimeline.Advance();
+		VkSemaphoreSubmitInfo SignalInfos[2] = {
+			{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.pNext = nullptr,
+				.semaphore = Frame.RenderFinishedSemaphore,
+				.value = 0,
+				.stageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+				.deviceIndex = 0,
+			},
+			m_GraphicsDevice.GraphicsTimeline.SubmitInfo(Frame.TimelineValue, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
 		};
 		
-		VkSemaphoreSubmitInfo RenderFinishedSemaphoreSubmitInfo = {
-			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		VkSubmitInfo2 SubmitInfo = {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
 			.pNext = nullptr,
-			.semaphore = Frame.RenderFinishedSemaphore,
-			.value = 1,
-			.stageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-			.deviceIndex = 0,
+			.flags = 0,
+			.waitSemaphoreInfoCount = m_UploadWaitValue != 0 ? 2u : 1u,
+			.pWaitSemaphoreInfos = WaitInfos,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &CommandBufferSubmitInfo,
+			.signalSemaphoreInfoCount = 2,
+			.pSignalSemaphoreInfos = SignalInfos,
 		};
 		
-		VkPipelineStageFlags WaitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+		VK_CHECK_RESULT(vkQueueSubmit2(m_GraphicsDevice.GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE));
+		m_UploadWaitValue = 0;
+		Frame.InputMilliseconds = Ctx.InputMilliseconds;
+		Ctx.bInputSampled = false;
 		
-		VkSubmitInfo SubmitInfo = {
-			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		// Ids are what present wait waits on, and key the input time the latency is measured from.
+		Ctx.PresentId++;
+		Ctx.PresentInputMilliseconds[Ctx.PresentId % PRESENT_HISTORY] = Ctx.InputMilliseconds;
+		VkPresentIdKHR PresentId = {
+			.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
 			.pNext = nullptr,
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &Frame.ImageAvailableSemaphore,
-			.pWaitDstStageMask = WaitStages,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &Cmd,
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = &Frame.RenderFinishedSemaphore,
+			.swapchainCount = 1,
+			.pPresentIds = &Ctx.PresentId,
 		};
 		
-		VK_CHECK_RESULT(vkQueueSubmit(m_GraphicsDevice.GraphicsQueue, 1, &SubmitInfo, Frame.InFlightFence));
-		
 		VkPresentInfoKHR PresentInfo = {
 			.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-			.pNext = nullptr,
+			.pNext = m_GraphicsDevice.Capabilities.bPresentWait ? &PresentId : nullptr,
 			.waitSemaphoreCount = 1,
 			.pWaitSemaphores = &Frame.RenderFinishedSemaphore,
 			.swapchainCount = 1,
@@ -518,7 +1198,16 @@ namespace Locus
 			.pImageIndices = &m_ActiveImageIndex,
 		};
 		
-		VK_CHECK_RESULT(vkQueuePresentKHR(m_GraphicsDevice.PresentQueue, &PresentInfo));
+		// The frame was still submitted, only presenting it was refused, the swapchain is remade next frame.
+		VkResult PresentResult = vkQueuePresentKHR(m_GraphicsDevice.PresentQueue, &PresentInfo);
+		if (PresentResult == VK_ERROR_OUT_OF_DATE_KHR || PresentResult == VK_SUBOPTIMAL_KHR)
+		{
+			Ctx.bSwapchainOutOfDate = true;
+		}
+		else
+		{
+			VK_CHECK_RESULT(PresentResult);
+		}
 		Ctx.FrameNumber ++;
 		
 		m_ActiveRenderContext = HANDLE_INVALID;
@@ -547,12 +1236,25 @@ namespace Locus
 		LAssert(m_RenderContextPool.IsValid(m_ActiveRenderContext));
 		
 		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(m_ActiveRenderContext);
-		LVKFrameResources& Frame = GetCurrentFrame(m_ActiveRenderContext);
-		VkCommandBuffer Cmd = Frame.CommandBuffer;
+		
+		// The UI goes straight onto the backbuffer at full resolution, over the upscaled scene.
+		ResolveDrawImage();
 
 		ImGui::Render();
         ImDrawData* DrawData = ImGui::GetDrawData();
-        ImGui_ImplVulkan_RenderDrawData(DrawData, Cmd);
+		
+		// The draw data stays valid until the context's next frame, well after the graph executes.
+		ImGuiContext* Context = Ctx.ImGuiContext;
+		VkRenderPass RenderPass = Ctx.Swapchain.RenderPass;
+		VkFramebuffer Framebuffer = Ctx.Swapchain.Framebuffers[m_ActiveImageIndex];
+		VkExtent2D Extent = Ctx.Swapchain.Details.Extent;
+		
+		m_RenderGraphs[m_ActiveRenderContext]->AddPass("ImGui", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			ImGui::SetCurrentContext(Context);
+			BeginSwapchainRenderPass(Cmd, RenderPass, Framebuffer, Extent);
+			ImGui_ImplVulkan_RenderDrawData(DrawData, Cmd);
+			vkCmdEndRenderPass(Cmd);
+		}).Read(m_Backbuffer, LVKGraphAccess::ColorAttachment).Write(m_Backbuffer, LVKGraphAccess::ColorAttachment);
 	}
 	
 	ImGuiContext* LVKGraphicsManager::GetImGuiContext(RenderContextHandle RenderContext)
@@ -565,103 +1267,1438 @@ namespace Locus
 		LAssertMsg(m_ActiveRenderContext == RenderContext, "There is not currently a frame in progress for the given render context.");
 
 		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(RenderContext);
-		LVKFrameResources& Frame = GetCurrentFrame(RenderContext);
-		VkCommandBuffer Cmd = Frame.CommandBuffer;
-		
-		vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_TrianglePipelines[RenderContext]);
-		
-		VkViewport Viewport = {
-			.x = 0.0f,
-			.y = 0.0f,
-			.width = static_cast<f32>(Ctx.Swapchain.Details.Extent.width),
-			.height = static_cast<f32>(Ctx.Swapchain.Details.Extent.height),
-			.minDepth = 0.0f,
-			.maxDepth = 1.0f
-		};
-		
-		vkCmdSetViewport(Cmd, 0, 1, &Viewport);
 		
-		VkRect2D Scissor = {
-			.offset = {0, 0},
-			.extent = Ctx.Swapchain.Details.Extent
-		};
+		VkPipeline Pipeline = m_PipelineRegistry.TryGetPipeline(m_TrianglePipelines[RenderContext].Key);
+		if (Pipeline == VK_NULL_HANDLE)
+		{
+			// Still compiling in the background, skip the draw rather than stall the frame.
+			return;
+		}
 		
-		vkCmdSetScissor(Cmd, 0, 1, &Scissor);
+		LVKGraphResource DrawImage = m_DrawImage;
+		VkExtent2D Extent = m_DrawExtent;
 		
-		vkCmdDraw(Cmd, 3, 1, 0, 0);
+		m_RenderGraphs[RenderContext]->AddPass("Triangle", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkRenderingAttachmentInfo ColorAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(DrawImage), nullptr, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			VkRenderingInfo RenderingInfo = {
+				.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.renderArea = {
+					.offset = {0, 0},
+					.extent = Extent,
+				},
+				.layerCount = 1,
+				.viewMask = 0,
+				.colorAttachmentCount = 1,
+				.pColorAttachments = &ColorAttachment,
+				.pDepthAttachment = nullptr,
+				.pStencilAttachment = nullptr,
+			};
+			
+			vkCmdBeginRendering(Cmd, &RenderingInfo);
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline);
+			
+			VkViewport Viewport = {
+				.x = 0.0f,
+				.y = 0.0f,
+				.width = static_cast<f32>(Extent.width),
+				.height = static_cast<f32>(Extent.height),
+				.minDepth = 0.0f,
+				.maxDepth = 1.0f
+			};
+			
+			vkCmdSetViewport(Cmd, 0, 1, &Viewport);
+			
+			VkRect2D Scissor = {
+				.offset = {0, 0},
+				.extent = Extent
+			};
+			
+			vkCmdSetScissor(Cmd, 0, 1, &Scissor);
+			
+			vkCmdDraw(Cmd, 3, 1, 0, 0);
+			vkCmdEndRendering(Cmd);
+		}).Read(m_DrawImage, LVKGraphAccess::ColorAttachment).Write(m_DrawImage, LVKGraphAccess::ColorAttachment);
 	}
 	
-	void LVKGraphicsManager::MakePipelines(RenderContextHandle RenderContext)
+	void LVKGraphicsManager::DrawDebugRenderGraph(bool* bOpen)
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "The render graph window is drawn inside a frame.");
+		m_RenderGraphs[m_ActiveRenderContext]->DrawDebugWindow(bOpen);
+	}
+	
+	ComputePipelineHandle LVKGraphicsManager::CreateComputePipeline(const char* ShaderPath)
 	{
-		VkRenderPass RenderPass = m_RenderContextPool.Get(RenderContext).Swapchain.RenderPass;
+		TArray<u8> Code;
+		if (!VirtualFileSystem::Get().ReadFile(ShaderPath, Code))
+		{
+			LLOG(Vulkan, Error, "Failed to read compute shader %s.", ShaderPath);
+			return HANDLE_INVALID;
+		}
 		
-		VkPipelineLayoutCreateInfo TriangleLayout = {
-			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-			.pNext = nullptr,
-			.setLayoutCount = 0,
-			.pSetLayouts = nullptr
-		};
+		LVKShaderSource Shader = { VK_SHADER_STAGE_COMPUTE_BIT, Code.Data(), Code.Length() };
 		
-		VK_CHECK_RESULT(vkCreatePipelineLayout(m_GraphicsDevice.Device, &TriangleLayout, nullptr, &m_TrianglePipelineLayouts[RenderContext]));
+		LVKReflectedLayout Reflected;
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+		LVKComputePipeline Pipeline;
+		Pipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, &Shader, 1, Reflected, &SetLayouts);
+		if (Pipeline.Instance.Layout == VK_NULL_HANDLE)
+		{
+			return HANDLE_INVALID;
+		}
 		
-		const char* VertShaderPath = "./build/LocusEngine/content/shaders/triangle.vert.spv";
+		if (SetLayouts.size() > 1)
+		{
+			LLOG(Vulkan, Error, "Compute shader %s uses descriptor sets past set 0, compute passes only bind set 0.", ShaderPath);
+			ReleasePipelineInstance(Pipeline.Instance);
+			return HANDLE_INVALID;
+		}
 		
-		arch VertCodeSize;
-		LAssert(Platform::FileGetSize(VertShaderPath, VertCodeSize));
-		u8 VertShaderCode[VertCodeSize];
-		LAssert(Platform::FileReadBytes(VertShaderPath, VertShaderCode, VertCodeSize));
+		Pipeline.SetLayout = SetLayouts.empty() ? VK_NULL_HANDLE : SetLayouts[0];
+		Pipeline.PushConstants = Reflected.PushConstants;
 		
-		VkShaderModule VertShader = LVK::CreateShaderModule(m_GraphicsDevice.Device, nullptr, VertShaderCode, VertCodeSize);
+		LVKComputePipelineFactory Factory;
+		Factory.Layout = Pipeline.Instance.Layout;
+		Pipeline.Instance.Key = m_PipelineRegistry.RequestComputePipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, Factory, Shader, true);
 		
-		const char* FragShaderPath = "./build/LocusEngine/content/shaders/triangle.frag.spv";
+		return m_ComputePipelines.Create(Pipeline);
+	}
+	
+	void LVKGraphicsManager::DestroyComputePipeline(ComputePipelineHandle Pipeline)
+	{
+		LAssert(m_ComputePipelines.IsValid(Pipeline));
+		LVKPipelineInstance Instance = m_ComputePipelines.Get(Pipeline).Instance;
+		m_ComputePipelines.Destroy(Pipeline);
 		
-		arch FragCodeSize;
-		LAssert(Platform::FileGetSize(FragShaderPath, FragCodeSize));
-		u8 FragShaderCode[FragCodeSize];
-		LAssert(Platform::FileReadBytes(FragShaderPath, FragShaderCode, FragCodeSize));
+		RetireResource([=](){
+			ReleasePipelineInstance(Instance);
+		});
+	}
+	
+	GraphicsBufferHandle LVKGraphicsManager::CreateBuffer(u64 Size, const void* InitialData)
+	{
+		VkBufferUsageFlags Usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 		
-		VkShaderModule FragShader = LVK::CreateShaderModule(m_GraphicsDevice.Device, nullptr, FragShaderCode, FragCodeSize);
+		LVKGraphicsBuffer Buffer;
+		Buffer.Buffer = LVKBuffer::Allocate(Size, Usage, m_GraphicsDevice.Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		if (InitialData)
+		{
+			Buffer.Upload = m_UploadManager.UploadBuffer(Buffer.Buffer.Buffer, 0, InitialData, Size);
+		}
 		
-		LVKPipelineFactory PipelineFactory;
-		PipelineFactory.Layout = m_TrianglePipelineLayouts[RenderContext];
-		PipelineFactory.InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		PipelineFactory.Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		return m_Buffers.Create(Buffer);
+	}
+	
+	void LVKGraphicsManager::DestroyBuffer(GraphicsBufferHandle Buffer)
+	{
+		LAssert(m_Buffers.IsValid(Buffer));
+		LVKGraphicsBuffer Destroyed = m_Buffers.Get(Buffer);
+		m_Buffers.Destroy(Buffer);
+		m_DescriptorCache.InvalidateResource(LVKDescriptorResource::GraphicsBuffer, Buffer);
 		
-		PipelineFactory.ShaderStages.Push({
-			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.stage = VK_SHADER_STAGE_VERTEX_BIT,
-			.module = VertShader,
-			.pName = "main",
-			.pSpecializationInfo = nullptr,
+		// The upload manager would still copy into a buffer whose initial data has not landed.
+		if (!m_UploadManager.IsComplete(Destroyed.Upload))
+		{
+			m_BuffersAwaitingUpload.push_back(Destroyed);
+			return;
+		}
+		
+		RetireResource([=](){
+			vmaDestroyBuffer(m_GraphicsDevice.Allocator, Destroyed.Buffer.Buffer, Destroyed.Buffer.Allocation);
+		});
+	}
+	
+	void LVKGraphicsManager::Dispatch(const ComputePass& Pass, u32 GroupCountX, u32 GroupCountY, u32 GroupCountZ)
+	{
+		u32 GroupCounts[3] = { GroupCountX, GroupCountY, GroupCountZ };
+		AddComputePass(Pass, GroupCounts, HANDLE_INVALID, 0);
+	}
+	
+	void LVKGraphicsManager::DispatchIndirect(const ComputePass& Pass, GraphicsBufferHandle Arguments, u64 Offset)
+	{
+		LAssert(m_Buffers.IsValid(Arguments));
+		u32 GroupCounts[3] = {};
+		AddComputePass(Pass, GroupCounts, Arguments, Offset);
+	}
+	
+	void LVKGraphicsManager::GetSceneExtent(u32& OutWidth, u32& OutHeight) const
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "The scene extent is only known inside a frame.");
+		OutWidth = m_DrawExtent.width;
+		OutHeight = m_DrawExtent.height;
+	}
+	
+	MeshHandle LVKGraphicsManager::CreateMesh(const MeshVertex* Vertices, u32 VertexCount, const u32* Indices, u32 IndexCount)
+	{
+		return m_GpuScene.CreateMesh(Vertices, VertexCount, Indices, IndexCount);
+	}
+	
+	void LVKGraphicsManager::DestroyMesh(MeshHandle Mesh)
+	{
+		m_GpuScene.DestroyMesh(Mesh);
+	}
+	
+	SceneObjectHandle LVKGraphicsManager::CreateSceneObject(const SceneObjectDesc& Desc)
+	{
+		// Every object is lit the same way for now, so everything goes in the first batch.
+		return m_GpuScene.CreateObject(Desc, 0);
+	}
+	
+	void LVKGraphicsManager::SetSceneObjectTransform(SceneObjectHandle Object, const SceneTransform& Transform)
+	{
+		m_GpuScene.SetObjectTransform(Object, Transform);
+	}
+	
+	void LVKGraphicsManager::DestroySceneObject(SceneObjectHandle Object)
+	{
+		m_GpuScene.DestroyObject(Object);
+	}
+	
+	void LVKGraphicsManager::DrawScene()
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "The scene is drawn inside a frame.");
+		LAssertMsg(!m_bDrawImageResolved, "The scene has to be drawn before anything is drawn over it on the backbuffer.");
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[m_ActiveRenderContext];
+		
+		LVKGpuSceneView View = {};
+		View.Color = m_DrawImage;
+		View.Depth = GetSceneDepth();
+		View.bClearDepth = !m_bSceneDepthWritten;
+		View.Extent = m_DrawExtent;
+		
+		m_SceneCamera.GetViewProjection(static_cast<f32>(m_DrawExtent.width) / static_cast<f32>(m_DrawExtent.height), View.ViewProjection);
+		ExtractFrustumPlanes(View.ViewProjection, View.FrustumPlanes);
+		
+		View.Cull = {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(m_SceneCullPipeline.Instance.Key),
+			.Layout = m_SceneCullPipeline.Instance.Layout,
+			.SetLayout = m_SceneCullPipeline.SetLayout,
+		};
+		View.Batches[0] = {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(m_SceneDrawPipeline.Key),
+			.Layout = m_SceneDrawPipeline.Layout,
+			.SetLayout = m_SceneDrawSetLayout,
+		};
+		
+		// Sized like the depth it is built from, which follows the swapchain rather than the render scale.
+		VkExtent3D DepthExtent = RenderGraph.GetImageExtent(View.Depth);
+		LVKDepthPyramid& DepthPyramid = *m_DepthPyramids[m_ActiveRenderContext];
+		DepthPyramid.Resize({ DepthExtent.width, DepthExtent.height });
+		View.DepthPyramid = &DepthPyramid;
+		View.DepthPyramidBuild = {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(m_DepthPyramidPipeline.Instance.Key),
+			.Layout = m_DepthPyramidPipeline.Instance.Layout,
+			.SetLayout = m_DepthPyramidPipeline.SetLayout,
+		};
+		View.Downsampler = &m_Downsampler;
+		View.DepthPyramidDownsample = GetDownsamplePipeline(LVKDownsampleFormat::R32F);
+		
+		LVKFrameResources& Frame = GetCurrentFrame(m_ActiveRenderContext);
+		View.Descriptors = &Frame.DescriptorAllocator;
+		View.TimelineValue = m_GraphicsDevice.GraphicsTimeline.GetNextValue();
+		View.TimestampPool = Frame.TimestampPool;
+		View.FirstTimestamp = TIMESTAMP_SCENE_PASSES;
+		
+		m_bSceneDepthWritten |= m_GpuScene.Record(RenderGraph, View);
+	}
+	
+	std::string LVKGraphicsManager::GetShaderVariantPath(const char* ShaderPath) const
+	{
+		// Stages that include bindless.glsl are also built with fixed size arrays, the heap can only match those without descriptor indexing.
+		std::string Path = ShaderPath;
+		if (m_BindlessHeap.IsBindless() || Path.size() < 4 || Path.compare(Path.size() - 4, 4, ".spv") != 0)
+		{
+			return Path;
+		}
+		
+		std::string FallbackPath = Path.substr(0, Path.size() - 4) + ".fallback.spv";
+		return VirtualFileSystem::Get().Exists(FallbackPath.c_str()) ? FallbackPath : Path;
+	}
+	
+	GraphicsPipelineHandle LVKGraphicsManager::CreateGraphicsPipeline(const GraphicsPipelineDesc& Desc)
+	{
+		LAssert(Desc.VertexShaderPath != nullptr && Desc.FragmentShaderPath != nullptr);
+		
+		std::string VertPath = GetShaderVariantPath(Desc.VertexShaderPath);
+		std::string FragPath = GetShaderVariantPath(Desc.FragmentShaderPath);
+		TArray<u8> VertCode;
+		TArray<u8> FragCode;
+		if (!VirtualFileSystem::Get().ReadFile(VertPath.c_str(), VertCode) || !VirtualFileSystem::Get().ReadFile(FragPath.c_str(), FragCode))
+		{
+			LLOG(Vulkan, Error, "Failed to read graphics pipeline shaders %s and %s.", VertPath.c_str(), FragPath.c_str());
+			return HANDLE_INVALID;
+		}
+		
+		LVKShaderSource Shaders[] = {
+			{ VK_SHADER_STAGE_VERTEX_BIT, VertCode.Data(), VertCode.Length() },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT, FragCode.Data(), FragCode.Length() },
+		};
+		
+		LVKReflectedLayout Reflected;
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+		LVKGraphicsPipeline Pipeline;
+		Pipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, Shaders, 2, Reflected, &SetLayouts);
+		if (Pipeline.Instance.Layout == VK_NULL_HANDLE)
+		{
+			return HANDLE_INVALID;
+		}
+		
+		// Past set 0 only the bindless heap can be bound, and the registry has already matched it against the heap.
+		Pipeline.bBindless = SetLayouts.size() > BINDLESS_SET && SetLayouts[BINDLESS_SET] == m_BindlessHeap.GetLayout();
+		if (SetLayouts.size() > (Pipeline.bBindless ? BINDLESS_SET + 1 : 1))
+		{
+			LLOG(Vulkan, Error, "Shaders %s and %s use descriptor sets past set 0 other than the bindless heap at set %u.", Desc.VertexShaderPath, Desc.FragmentShaderPath, BINDLESS_SET);
+			ReleasePipelineInstance(Pipeline.Instance);
+			return HANDLE_INVALID;
+		}
+		
+		Pipeline.SetLayout = Reflected.Sets.empty() || Reflected.Sets[0].empty() ? VK_NULL_HANDLE : SetLayouts[0];
+		Pipeline.PushConstants = Reflected.PushConstants;
+		
+		LVKPipelineFactory Factory;
+		Factory.Layout = Pipeline.Instance.Layout;
+		Factory.InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		Factory.Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		Factory.ColorAttachmentFormat = DRAW_IMAGE_FORMAT;
+		Factory.DepthAttachmentFormat = SCENE_DEPTH_FORMAT;
+		
+		if (Desc.bDepthTest)
+		{
+			// Blended draws test against the scene but leave its depth alone.
+			Factory.DepthStencil.depthTestEnable = VK_TRUE;
+			Factory.DepthStencil.depthWriteEnable = Desc.bAlphaBlend ? VK_FALSE : VK_TRUE;
+			Factory.DepthStencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+		}
+		
+		if (Desc.bAlphaBlend)
+		{
+			Factory.ColorBlendAttachment.blendEnable = VK_TRUE;
+			Factory.ColorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+			Factory.ColorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			Factory.ColorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+			Factory.ColorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			Factory.ColorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			Factory.ColorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
+		
+		if (!Reflected.VertexAttributes.empty())
+		{
+			Factory.VertexInput.vertexBindingDescriptionCount = 1;
+			Factory.VertexInput.pVertexBindingDescriptions = &Reflected.VertexBinding;
+			Factory.VertexInput.vertexAttributeDescriptionCount = static_cast<u32>(Reflected.VertexAttributes.size());
+			Factory.VertexInput.pVertexAttributeDescriptions = Reflected.VertexAttributes.data();
+		}
+		
+		Pipeline.Instance.Key = m_PipelineRegistry.RequestPipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, Factory, Shaders, 2, VK_NULL_HANDLE, 0, true);
+		return m_GraphicsPipelines.Create(Pipeline);
+	}
+	
+	void LVKGraphicsManager::DestroyGraphicsPipeline(GraphicsPipelineHandle Pipeline)
+	{
+		LAssert(m_GraphicsPipelines.IsValid(Pipeline));
+		LVKPipelineInstance Instance = m_GraphicsPipelines.Get(Pipeline).Instance;
+		m_GraphicsPipelines.Destroy(Pipeline);
+		
+		RetireResource([=](){
+			ReleasePipelineInstance(Instance);
 		});
+	}
+	
+	MaterialHandle LVKGraphicsManager::CreateMaterial(const MaterialDesc& Desc)
+	{
+		LAssert(m_GraphicsPipelines.IsValid(Desc.Pipeline));
+		LAssertMsg(Desc.BufferCount <= MATERIAL_BUFFERS_MAX, "Material binds more buffers than MATERIAL_BUFFERS_MAX.");
 		
-		PipelineFactory.ShaderStages.Push({
-			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+		LVKMaterial Material = {
+			.Pipeline = Desc.Pipeline,
+			.BufferCount = Desc.BufferCount,
+			.Buffers = {},
+		};
+		for (u32 i = 0; i < Desc.BufferCount; i++)
+		{
+			LAssert(m_Buffers.IsValid(Desc.Buffers[i]));
+			Material.Buffers[i] = Desc.Buffers[i];
+		}
+		
+		return m_Materials.Create(Material);
+	}
+	
+	void LVKGraphicsManager::DestroyMaterial(MaterialHandle Material)
+	{
+		// Its descriptor set belongs to the cache, which evicts it once unused.
+		LAssert(m_Materials.IsValid(Material));
+		m_Materials.Destroy(Material);
+	}
+	
+	void LVKGraphicsManager::SubmitDraw(const DrawDesc& Draw)
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "Draws are submitted inside a frame.");
+		LAssertMsg(!m_bDrawImageResolved, "Draws have to be submitted before anything is drawn over the scene on the backbuffer.");
+		LAssert(m_Materials.IsValid(Draw.Material));
+		
+		const LVKMaterial& Material = m_Materials.Get(Draw.Material);
+		LAssert(m_GraphicsPipelines.IsValid(Material.Pipeline));
+		LAssertMsg(Draw.PushConstantSize <= m_GraphicsPipelines.Get(Material.Pipeline).PushConstants.size, "Draw pushes more constants than its shaders declare.");
+		
+		u32 PushConstantOffset = static_cast<u32>(m_QueuedPushConstants.size());
+		const u8* PushConstants = static_cast<const u8*>(Draw.PushConstants);
+		m_QueuedPushConstants.insert(m_QueuedPushConstants.end(), PushConstants, PushConstants + Draw.PushConstantSize);
+		
+		m_RenderQueue.Push(MakeRenderKey(Draw.Layer, HandleIndex(Material.Pipeline), HandleIndex(Draw.Material), Draw.SortDepth), static_cast<u32>(m_QueuedDraws.size()));
+		m_QueuedDraws.push_back({
+			.Material = Draw.Material,
+			.VertexBuffer = Draw.VertexBuffer,
+			.IndexBuffer = Draw.IndexBuffer,
+			.Count = Draw.Count,
+			.First = Draw.First,
+			.VertexOffset = Draw.VertexOffset,
+			.PushConstantOffset = PushConstantOffset,
+			.PushConstantSize = Draw.PushConstantSize,
+		});
+	}
+	
+	StaticMeshHandle LVKGraphicsManager::LoadStaticMesh(const char* LogicalPath)
+	{
+		// Mapped where possible, from the pack or a loose file, so the geometry is only copied into staging.
+		VirtualFileSystem& FileSystem = VirtualFileSystem::Get();
+		arch Size = 0;
+		const u8* Data = FileSystem.MapFile(LogicalPath, Size);
+		
+		Platform::FileMapping Mapping;
+		std::string LoosePath;
+		if (Data == nullptr && FileSystem.ResolveLoosePath(LogicalPath, LoosePath) && Platform::FileMap(LoosePath.c_str(), Mapping))
+		{
+			Data = Mapping.Data;
+			Size = Mapping.Size;
+		}
+		
+		TArray<u8> Contents;
+		if (Data == nullptr && FileSystem.ReadFile(LogicalPath, Contents))
+		{
+			Data = Contents.Data();
+			Size = Contents.Length();
+		}
+		
+		StaticMeshHandle Mesh = HANDLE_INVALID;
+		MeshAssetView Asset;
+		if (Data == nullptr)
+		{
+			LLOG(Vulkan, Error, "Failed to read static mesh %s.", LogicalPath);
+		}
+		else if (!ParseMeshAsset(Data, Size, Asset))
+		{
+			LLOG(Vulkan, Error, "Static mesh %s is not a valid mesh asset.", LogicalPath);
+		}
+		else
+		{
+			Mesh = m_StaticMeshes.CreateMesh(Asset);
+		}
+		
+		if (Mapping.Data != nullptr)
+		{
+			Platform::FileUnmap(Mapping);
+		}
+		return Mesh;
+	}
+	
+	void LVKGraphicsManager::DestroyStaticMesh(StaticMeshHandle Mesh)
+	{
+		m_StaticMeshes.DestroyMesh(Mesh);
+	}
+	
+	void LVKGraphicsManager::DrawStaticMesh(StaticMeshHandle Mesh, const StaticMeshInstance* Instances, u32 Count)
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "Static meshes are drawn inside a frame.");
+		LAssertMsg(!m_bDrawImageResolved, "Static meshes have to be drawn before anything is drawn over the scene on the backbuffer.");
+		m_StaticMeshes.Submit(Mesh, Instances, Count);
+	}
+	
+	TextureHandle LVKGraphicsManager::LoadTexture(const char* LogicalPath)
+	{
+		return m_TextureStreamer.LoadTexture(LogicalPath);
+	}
+	
+	void LVKGraphicsManager::DestroyTexture(TextureHandle Texture)
+	{
+		m_TextureStreamer.DestroyTexture(Texture);
+	}
+	
+	void LVKGraphicsManager::RequestTextureResolution(TextureHandle Texture, f32 ScreenPixels)
+	{
+		m_TextureStreamer.Request(Texture, ScreenPixels);
+	}
+	
+	void LVKGraphicsManager::RequestTextureAtDistance(TextureHandle Texture, f32 WorldSize, f32 Distance)
+	{
+		// Pixels per world unit at unit distance, the same scale the static mesh LODs are picked with.
+		f32 LodScale = static_cast<f32>(m_DrawExtent.height) / (2.0f * std::tan(0.5f * m_SceneCamera.VerticalFov));
+		m_TextureStreamer.Request(Texture, WorldSize * LodScale / std::max(Distance, m_SceneCamera.Near));
+	}
+	
+	bool LVKGraphicsManager::GetTextureBinding(TextureHandle Texture, u32& OutImageIndex, u32& OutSamplerIndex) const
+	{
+		return m_TextureStreamer.GetBinding(Texture, OutImageIndex, OutSamplerIndex);
+	}
+	
+	void LVKGraphicsManager::SetTextureBudget(u64 Bytes)
+	{
+		m_TextureStreamer.SetBudget(Bytes);
+	}
+	
+	VkDescriptorSet LVKGraphicsManager::AllocateFrameDescriptorSet(VkDescriptorSetLayout Layout)
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "Frame descriptor sets need a frame in progress.");
+		return GetCurrentFrame(m_ActiveRenderContext).DescriptorAllocator.Allocate(m_GraphicsDevice.Device, Layout);
+	}
+	
+	void LVKGraphicsManager::ImmediateSubmit(std::function<void(VkCommandBuffer)>&& Function)
+	{
+		VkCommandBuffer Cmd = m_GraphicsDevice.ImmediateCommandBuffer;
+		
+		VK_CHECK_RESULT(vkResetCommandBuffer(Cmd, 0));
+		VkCommandBufferBeginInfo BeginInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = nullptr,
+		};
+		VK_CHECK_RESULT(vkBeginCommandBuffer(Cmd, &BeginInfo));
+		
+		Function(Cmd);
+		
+		VK_CHECK_RESULT(vkEndCommandBuffer(Cmd));
+		
+		LVKTimeline& Timeline = m_GraphicsDevice.GraphicsTimeline;
+		u64 Value = Timeline.Advance();
+		
+		VkCommandBufferSubmitInfo CommandBufferInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.pNext = nullptr,
+			.commandBuffer = Cmd,
+			.deviceMask = 0
+		};
+		VkSemaphoreSubmitInfo SignalInfo = Timeline.SubmitInfo(Value, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+		
+		VkSubmitInfo2 SubmitInfo = {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
 			.pNext = nullptr,
 			.flags = 0,
-			.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-			.module = FragShader,
-			.pName = "main",
-			.pSpecializationInfo = nullptr,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &CommandBufferInfo,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &SignalInfo,
+		};
+		
+		VK_CHECK_RESULT(vkQueueSubmit2(m_GraphicsDevice.GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE));
+		Timeline.Wait(m_GraphicsDevice.Device, Value);
+	}
+	
+	void LVKGraphicsManager::ResolveDrawImage()
+	{
+		if (m_bDrawImageResolved)
+		{
+			return;
+		}
+		m_bDrawImageResolved = true;
+		
+		RecordStaticMeshes();
+		FlushRenderQueue();
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[m_ActiveRenderContext];
+		
+		// Timed up to here, the resolve waits on the swapchain image and that wait is not scene cost.
+		VkQueryPool TimestampPool = GetCurrentFrame(m_ActiveRenderContext).TimestampPool;
+		if (TimestampPool != VK_NULL_HANDLE)
+		{
+			RenderGraph.AddPass("Scene Timestamp", [TimestampPool](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+				vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, TimestampPool, TIMESTAMP_SCENE_END);
+			}).SideEffects();
+		}
+		
+		// A plain blit, so anything above 1.0 in the draw image clips until there is a tonemapping pass.
+		LVKGraphResource DrawImage = m_DrawImage;
+		LVKGraphResource Backbuffer = m_Backbuffer;
+		VkExtent2D DrawExtent = m_DrawExtent;
+		
+		RenderGraph.AddPass("Resolve", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkExtent3D BackbufferExtent = Graph.GetImageExtent(Backbuffer);
+			LVKImage::Blit(Cmd, Graph.GetImage(DrawImage), Graph.GetImage(Backbuffer), DrawExtent, { BackbufferExtent.width, BackbufferExtent.height });
+		}).Read(DrawImage, LVKGraphAccess::TransferSrc).Write(Backbuffer, LVKGraphAccess::TransferDst);
+	}
+	
+	void LVKGraphicsManager::FlushRenderQueue()
+	{
+		m_Stats.QueuedDraws = m_RenderQueue.GetCount();
+		m_Stats.QueueSortPasses = 0;
+		m_Stats.QueueSortMilliseconds = 0.0;
+		m_Stats.PipelineBinds = 0;
+		m_Stats.DescriptorSetBinds = 0;
+		m_Stats.VertexBufferBinds = 0;
+		m_Stats.IndexBufferBinds = 0;
+		
+		if (m_RenderQueue.GetCount() == 0)
+		{
+			return;
+		}
+		
+		if (m_bSortRenderQueue)
+		{
+			Clock SortClock;
+			SortClock.Start();
+			m_RenderQueue.Sort();
+			m_Stats.QueueSortMilliseconds = SortClock.GetElapsedMilliseconds();
+			m_Stats.QueueSortPasses = m_RenderQueue.GetLastSortPasses();
+		}
+		
+		// Resolved into commands up front, a null handle in a command means that state carries over.
+		struct QueueCommand
+		{
+			VkPipeline Pipeline;
+			VkPipelineLayout Layout;
+			VkDescriptorSet Set;
+			VkDescriptorSet BindlessSet;
+			VkBuffer VertexBuffer;
+			VkBuffer IndexBuffer;
+			VkShaderStageFlags PushConstantStages;
+			u32 PushConstantOffset;
+			u32 PushConstantSize;
+			u32 Count;
+			u32 First;
+			i32 VertexOffset;
+			bool bIndexed;
+		};
+		std::vector<QueueCommand> Commands;
+		Commands.reserve(m_RenderQueue.GetCount());
+		
+		// Every buffer the pass reads and how, each can only be used one way.
+		std::map<GraphicsBufferHandle, LVKGraphAccess> UsedBuffers;
+		auto UseBuffer = [&](GraphicsBufferHandle Handle, LVKGraphAccess Access) -> VkBuffer {
+			LAssert(m_Buffers.IsValid(Handle));
+			const LVKGraphicsBuffer& Buffer = m_Buffers.Get(Handle);
+			if (!m_UploadManager.IsComplete(Buffer.Upload))
+			{
+				return VK_NULL_HANDLE;
+			}
+			
+			auto [It, bInserted] = UsedBuffers.emplace(Handle, Access);
+			LAssertMsg(It->second == Access, "A buffer is used as more than one kind of input by the queued draws.");
+			return Buffer.Buffer.Buffer;
+		};
+		
+		MaterialHandle Material = HANDLE_INVALID;
+		bool bMaterialReady = false;
+		VkPipeline MaterialPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout MaterialLayout = VK_NULL_HANDLE;
+		VkDescriptorSet MaterialSet = VK_NULL_HANDLE;
+		VkShaderStageFlags MaterialPushConstantStages = 0;
+		bool bMaterialBindless = false;
+		
+		// The heap has a single set per frame, written by the streamer and friends rather than the descriptor cache.
+		VkDescriptorSet BindlessSet = GetCurrentFrame(m_ActiveRenderContext).BindlessSet;
+		
+		VkPipeline BoundPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout BoundLayout = VK_NULL_HANDLE;
+		VkDescriptorSet BoundSet = VK_NULL_HANDLE;
+		bool bBindlessBound = false;
+		VkBuffer BoundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer BoundIndexBuffer = VK_NULL_HANDLE;
+		
+		for (const RenderQueueEntry& Entry : m_RenderQueue.GetEntries())
+		{
+			const LVKQueuedDraw& Draw = m_QueuedDraws[Entry.Payload];
+			if (Draw.Material != Material)
+			{
+				// Sorted draws share materials, so this runs once per material rather than once per draw.
+				Material = Draw.Material;
+				const LVKMaterial& MaterialData = m_Materials.Get(Material);
+				const LVKGraphicsPipeline& Pipeline = m_GraphicsPipelines.Get(MaterialData.Pipeline);
+				
+				MaterialPipeline = m_PipelineRegistry.TryGetPipeline(Pipeline.Instance.Key);
+				MaterialLayout = Pipeline.Instance.Layout;
+				MaterialPushConstantStages = Pipeline.PushConstants.stageFlags;
+				MaterialSet = VK_NULL_HANDLE;
+				bMaterialBindless = Pipeline.bBindless;
+				bMaterialReady = MaterialPipeline != VK_NULL_HANDLE;
+				
+				if (bMaterialReady && Pipeline.SetLayout != VK_NULL_HANDLE)
+				{
+					LVKDescriptorBinding Bindings[MATERIAL_BUFFERS_MAX];
+					for (u32 i = 0; bMaterialReady && i < MaterialData.BufferCount; i++)
+					{
+						VkBuffer Buffer = UseBuffer(MaterialData.Buffers[i], LVKGraphAccess::StorageRead);
+						bMaterialReady = Buffer != VK_NULL_HANDLE;
+						Bindings[i] = {
+							.Binding = i,
+							.Type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+							.Buffer = { Buffer, 0, VK_WHOLE_SIZE },
+							.Resource = MaterialData.Buffers[i],
+							.ResourceType = LVKDescriptorResource::GraphicsBuffer,
+						};
+					}
+					
+					if (bMaterialReady)
+					{
+						MaterialSet = m_DescriptorCache.Get(m_GraphicsDevice.Device, Pipeline.SetLayout, Bindings, MaterialData.BufferCount);
+					}
+				}
+			}
+			
+			if (!bMaterialReady)
+			{
+				continue;
+			}
+			
+			VkBuffer VertexBuffer = HandleIsValid(Draw.VertexBuffer) ? UseBuffer(Draw.VertexBuffer, LVKGraphAccess::VertexRead) : VK_NULL_HANDLE;
+			VkBuffer IndexBuffer = HandleIsValid(Draw.IndexBuffer) ? UseBuffer(Draw.IndexBuffer, LVKGraphAccess::VertexRead) : VK_NULL_HANDLE;
+			if ((HandleIsValid(Draw.VertexBuffer) && VertexBuffer == VK_NULL_HANDLE) || (HandleIsValid(Draw.IndexBuffer) && IndexBuffer == VK_NULL_HANDLE))
+			{
+				continue;
+			}
+			
+			QueueCommand Command = {
+				.Pipeline = VK_NULL_HANDLE,
+				.Layout = MaterialLayout,
+				.Set = VK_NULL_HANDLE,
+				.BindlessSet = VK_NULL_HANDLE,
+				.VertexBuffer = VK_NULL_HANDLE,
+				.IndexBuffer = VK_NULL_HANDLE,
+				.PushConstantStages = MaterialPushConstantStages,
+				.PushConstantOffset = Draw.PushConstantOffset,
+				.PushConstantSize = Draw.PushConstantSize,
+				.Count = Draw.Count,
+				.First = Draw.First,
+				.VertexOffset = Draw.VertexOffset,
+				.bIndexed = IndexBuffer != VK_NULL_HANDLE,
+			};
+			
+			if (MaterialPipeline != BoundPipeline)
+			{
+				Command.Pipeline = BoundPipeline = MaterialPipeline;
+				m_Stats.PipelineBinds++;
+			}
+			if (MaterialLayout != BoundLayout)
+			{
+				// Layouts are shared between identical reflections, a different one may not be compatible.
+				BoundLayout = MaterialLayout;
+				BoundSet = VK_NULL_HANDLE;
+				bBindlessBound = false;
+			}
+			if (MaterialSet != VK_NULL_HANDLE && MaterialSet != BoundSet)
+			{
+				Command.Set = BoundSet = MaterialSet;
+				m_Stats.DescriptorSetBinds++;
+			}
+			if (bMaterialBindless && !bBindlessBound)
+			{
+				Command.BindlessSet = BindlessSet;
+				bBindlessBound = true;
+				m_Stats.DescriptorSetBinds++;
+			}
+			if (VertexBuffer != VK_NULL_HANDLE && VertexBuffer != BoundVertexBuffer)
+			{
+				Command.VertexBuffer = BoundVertexBuffer = VertexBuffer;
+				m_Stats.VertexBufferBinds++;
+			}
+			if (IndexBuffer != VK_NULL_HANDLE && IndexBuffer != BoundIndexBuffer)
+			{
+				Command.IndexBuffer = BoundIndexBuffer = IndexBuffer;
+				m_Stats.IndexBufferBinds++;
+			}
+			
+			Commands.push_back(Command);
+		}
+		
+		if (Commands.empty())
+		{
+			return;
+		}
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[m_ActiveRenderContext];
+		LVKGraphResource DrawImage = m_DrawImage;
+		LVKGraphResource Depth = GetSceneDepth();
+		bool bClearDepth = !m_bSceneDepthWritten;
+		m_bSceneDepthWritten = true;
+		VkExtent2D Extent = m_DrawExtent;
+		
+		LVKGraphPassBuilder Builder = RenderGraph.AddPass("Render Queue", [=, Commands = std::move(Commands), PushConstants = m_QueuedPushConstants](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkClearValue DepthClear = { .depthStencil = { 0.0f, 0 } };
+			VkRenderingAttachmentInfo ColorAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(DrawImage), nullptr, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			VkRenderingAttachmentInfo DepthAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(Depth), bClearDepth ? &DepthClear : nullptr, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+			VkRenderingInfo RenderingInfo = {
+				.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.renderArea = { { 0, 0 }, Extent },
+				.layerCount = 1,
+				.viewMask = 0,
+				.colorAttachmentCount = 1,
+				.pColorAttachments = &ColorAttachment,
+				.pDepthAttachment = &DepthAttachment,
+				.pStencilAttachment = nullptr,
+			};
+			vkCmdBeginRendering(Cmd, &RenderingInfo);
+			
+			VkViewport Viewport = { 0.0f, 0.0f, static_cast<f32>(Extent.width), static_cast<f32>(Extent.height), 0.0f, 1.0f };
+			VkRect2D Scissor = { { 0, 0 }, Extent };
+			vkCmdSetViewport(Cmd, 0, 1, &Viewport);
+			vkCmdSetScissor(Cmd, 0, 1, &Scissor);
+			
+			for (const QueueCommand& Command : Commands)
+			{
+				if (Command.Pipeline != VK_NULL_HANDLE)
+				{
+					vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Command.Pipeline);
+				}
+				if (Command.Set != VK_NULL_HANDLE)
+				{
+					vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Command.Layout, 0, 1, &Command.Set, 0, nullptr);
+				}
+				if (Command.BindlessSet != VK_NULL_HANDLE)
+				{
+					vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Command.Layout, BINDLESS_SET, 1, &Command.BindlessSet, 0, nullptr);
+				}
+				if (Command.VertexBuffer != VK_NULL_HANDLE)
+				{
+					VkDeviceSize Offset = 0;
+					vkCmdBindVertexBuffers(Cmd, 0, 1, &Command.VertexBuffer, &Offset);
+				}
+				if (Command.IndexBuffer != VK_NULL_HANDLE)
+				{
+					vkCmdBindIndexBuffer(Cmd, Command.IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				}
+				if (Command.PushConstantSize > 0)
+				{
+					vkCmdPushConstants(Cmd, Command.Layout, Command.PushConstantStages, 0, Command.PushConstantSize, PushConstants.data() + Command.PushConstantOffset);
+				}
+				
+				if (Command.bIndexed)
+				{
+					vkCmdDrawIndexed(Cmd, Command.Count, 1, Command.First, Command.VertexOffset, 0);
+				}
+				else
+				{
+					vkCmdDraw(Cmd, Command.Count, 1, Command.First, 0);
+				}
+			}
+			
+			vkCmdEndRendering(Cmd);
 		});
 		
-		m_TrianglePipelines[RenderContext] = PipelineFactory.Create(m_GraphicsDevice.Device, RenderPass);
+		Builder.Read(DrawImage, LVKGraphAccess::ColorAttachment).Write(DrawImage, LVKGraphAccess::ColorAttachment).Write(Depth, LVKGraphAccess::DepthAttachment);
+		if (!bClearDepth)
+		{
+			Builder.Read(Depth, LVKGraphAccess::DepthAttachment);
+		}
+		for (const auto& [Buffer, Access] : UsedBuffers)
+		{
+			Builder.Read(ImportFrameBuffer(Buffer), Access);
+		}
+	}
+	
+	void LVKGraphicsManager::RecordStaticMeshes()
+	{
+		LVKStaticMeshView View = {};
+		View.Color = m_DrawImage;
+		View.Depth = GetSceneDepth();
+		View.bClearDepth = !m_bSceneDepthWritten;
+		View.Extent = m_DrawExtent;
+		m_SceneCamera.GetViewProjection(static_cast<f32>(m_DrawExtent.width) / static_cast<f32>(m_DrawExtent.height), View.ViewProjection);
+		ExtractFrustumPlanes(View.ViewProjection, View.FrustumPlanes);
+		memcpy(View.CameraPosition, m_SceneCamera.Position, sizeof(View.CameraPosition));
+		View.LodScale = static_cast<f32>(m_DrawExtent.height) / (2.0f * std::tan(0.5f * m_SceneCamera.VerticalFov));
+		
+		View.Cull = {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(m_StaticMeshCullPipeline.Instance.Key),
+			.Layout = m_StaticMeshCullPipeline.Instance.Layout,
+			.SetLayout = m_StaticMeshCullPipeline.SetLayout,
+		};
+		View.Pipeline = {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(m_StaticMeshPipeline.Key),
+			.Layout = m_StaticMeshPipeline.Layout,
+			.SetLayout = m_StaticMeshSetLayout,
+		};
+		View.Descriptors = &GetCurrentFrame(m_ActiveRenderContext).DescriptorAllocator;
+		View.TimelineValue = m_GraphicsDevice.GraphicsTimeline.GetNextValue();
+		
+		LVKRenderGraph& RenderGraph = *m_RenderGraphs[m_ActiveRenderContext];
+		m_bSceneDepthWritten |= m_StaticMeshes.Record(RenderGraph, View);
+	}
+	
+	LVKGraphResource LVKGraphicsManager::GetSceneDepth()
+	{
+		if (m_SceneDepth == LVK_GRAPH_RESOURCE_INVALID)
+		{
+			// Sized like the draw image, so a new render scale doesn't reshape the graph.
+			LVKRenderGraph& RenderGraph = *m_RenderGraphs[m_ActiveRenderContext];
+			m_SceneDepth = RenderGraph.CreateImage("Scene Depth", { .Format = SCENE_DEPTH_FORMAT, .Extent = RenderGraph.GetImageExtent(m_Backbuffer) });
+		}
+		return m_SceneDepth;
+	}
+	
+	void LVKGraphicsManager::AddComputePass(const ComputePass& Pass, const u32 GroupCounts[3], GraphicsBufferHandle Arguments, u64 ArgumentsOffset)
+	{
+		LAssertMsg(m_ActiveRenderContext != HANDLE_INVALID, "Compute passes are recorded inside a frame.");
+		LAssert(m_ComputePipelines.IsValid(Pass.Pipeline));
 		
-		vkDestroyShaderModule(m_GraphicsDevice.Device, VertShader, nullptr);
-		vkDestroyShaderModule(m_GraphicsDevice.Device, FragShader, nullptr);
+		const LVKComputePipeline& Pipeline = m_ComputePipelines.Get(Pass.Pipeline);
+		LAssertMsg(Pass.PushConstantSize <= Pipeline.PushConstants.size, "Pass pushes more constants than its shader declares.");
 		
-		m_GraphicsDevice.GlobalDeletionQueue.Push([=](){
-			vkDestroyPipeline(m_GraphicsDevice.Device, m_TrianglePipelines[RenderContext], nullptr);
-			vkDestroyPipelineLayout(m_GraphicsDevice.Device, m_TrianglePipelineLayouts[RenderContext], nullptr);
+		VkPipeline Handle = m_PipelineRegistry.TryGetPipeline(Pipeline.Instance.Key);
+		if (Handle == VK_NULL_HANDLE)
+		{
+			// Still compiling in the background, or failed and already logged.
+			return;
+		}
+		
+		struct ResolvedBinding
+		{
+			u32 Binding;
+			LVKGraphResource Resource;
+			bool bImage;
+		};
+		
+		std::vector<ResolvedBinding> Bindings;
+		for (u32 i = 0; i < Pass.BindingCount; i++)
+		{
+			const ComputeBinding& Binding = Pass.Bindings[i];
+			if (Binding.Resource == ComputeResource::SceneColor)
+			{
+				Bindings.push_back({ Binding.Binding, m_DrawImage, true });
+				continue;
+			}
+			
+			LAssert(m_Buffers.IsValid(Binding.Buffer));
+			if (!m_UploadManager.IsComplete(m_Buffers.Get(Binding.Buffer).Upload))
+			{
+				return;
+			}
+			Bindings.push_back({ Binding.Binding, ImportFrameBuffer(Binding.Buffer), false });
+		}
+		
+		LVKGraphResource ArgumentsResource = LVK_GRAPH_RESOURCE_INVALID;
+		if (HandleIsValid(Arguments))
+		{
+			if (!m_UploadManager.IsComplete(m_Buffers.Get(Arguments).Upload))
+			{
+				return;
+			}
+			ArgumentsResource = ImportFrameBuffer(Arguments);
+		}
+		
+		// Allocated now, written once the graph has placed the transients the set points at.
+		VkDescriptorSet Set = Pipeline.SetLayout != VK_NULL_HANDLE ? AllocateFrameDescriptorSet(Pipeline.SetLayout) : VK_NULL_HANDLE;
+		
+		LVKFrameResources& Frame = GetCurrentFrame(m_ActiveRenderContext);
+		u32 TimestampQuery = UINT32_MAX;
+		if (Frame.TimestampPool != VK_NULL_HANDLE && Frame.TimedDispatches < TIMED_DISPATCHES_MAX)
+		{
+			TimestampQuery = TIMESTAMP_DISPATCHES + 2 * Frame.TimedDispatches++;
+		}
+		
+		VkDevice Device = m_GraphicsDevice.Device;
+		VkPipelineLayout Layout = Pipeline.Instance.Layout;
+		VkQueryPool TimestampPool = Frame.TimestampPool;
+		VkShaderStageFlags PushConstantStages = Pipeline.PushConstants.stageFlags;
+		std::vector<u8> PushConstants(static_cast<const u8*>(Pass.PushConstants), static_cast<const u8*>(Pass.PushConstants) + Pass.PushConstantSize);
+		u32 X = GroupCounts[0];
+		u32 Y = GroupCounts[1];
+		u32 Z = GroupCounts[2];
+		
+		LVKGraphPassBuilder Builder = m_RenderGraphs[m_ActiveRenderContext]->AddPass(Pass.Name, [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			if (Set != VK_NULL_HANDLE)
+			{
+				std::vector<VkDescriptorImageInfo> ImageInfos(Bindings.size());
+				std::vector<VkDescriptorBufferInfo> BufferInfos(Bindings.size());
+				std::vector<VkWriteDescriptorSet> Writes;
+				for (arch i = 0; i < Bindings.size(); i++)
+				{
+					ImageInfos[i] = { VK_NULL_HANDLE, Bindings[i].bImage ? Graph.GetImageView(Bindings[i].Resource) : VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL };
+					BufferInfos[i] = { Bindings[i].bImage ? VK_NULL_HANDLE : Graph.GetBuffer(Bindings[i].Resource), 0, VK_WHOLE_SIZE };
+					Writes.push_back({
+						.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+						.pNext = nullptr,
+						.dstSet = Set,
+						.dstBinding = Bindings[i].Binding,
+						.dstArrayElement = 0,
+						.descriptorCount = 1,
+						.descriptorType = Bindings[i].bImage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+						.pImageInfo = Bindings[i].bImage ? &ImageInfos[i] : nullptr,
+						.pBufferInfo = Bindings[i].bImage ? nullptr : &BufferInfos[i],
+					});
+				}
+				vkUpdateDescriptorSets(Device, static_cast<u32>(Writes.size()), Writes.data(), 0, nullptr);
+			}
+			
+			if (TimestampQuery != UINT32_MAX)
+			{
+				vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, TimestampPool, TimestampQuery);
+			}
+			
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Handle);
+			if (Set != VK_NULL_HANDLE)
+			{
+				vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, Layout, 0, 1, &Set, 0, nullptr);
+			}
+			if (!PushConstants.empty())
+			{
+				vkCmdPushConstants(Cmd, Layout, PushConstantStages, 0, static_cast<u32>(PushConstants.size()), PushConstants.data());
+			}
+			
+			if (ArgumentsResource != LVK_GRAPH_RESOURCE_INVALID)
+			{
+				vkCmdDispatchIndirect(Cmd, Graph.GetBuffer(ArgumentsResource), ArgumentsOffset);
+			}
+			else
+			{
+				vkCmdDispatch(Cmd, X, Y, Z);
+			}
+			
+			if (TimestampQuery != UINT32_MAX)
+			{
+				vkCmdWriteTimestamp2(Cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, TimestampPool, TimestampQuery + 1);
+			}
+		});
+		
+		// The graph turns these into the barriers against whatever else touches the resources this frame,
+		// compute writes made visible to the colour attachment, transfer and fragment reads that follow.
+		for (u32 i = 0; i < Pass.BindingCount; i++)
+		{
+			ComputeAccess Access = Pass.Bindings[i].Access;
+			LVKGraphResource Resource = Bindings[i].Resource;
+			if (Access == ComputeAccess::Read)
+			{
+				Builder.Read(Resource, LVKGraphAccess::StorageRead);
+			}
+			else if (Access == ComputeAccess::Write)
+			{
+				Builder.Write(Resource, LVKGraphAccess::StorageWrite);
+			}
+			else
+			{
+				Builder.Read(Resource, LVKGraphAccess::StorageWrite).Write(Resource, LVKGraphAccess::StorageWrite);
+			}
+		}
+		
+		if (ArgumentsResource != LVK_GRAPH_RESOURCE_INVALID)
+		{
+			Builder.Read(ArgumentsResource, LVKGraphAccess::IndirectRead);
+		}
+		
+		m_Stats.ComputeDispatches++;
+	}
+	
+	LVKGraphResource LVKGraphicsManager::ImportFrameBuffer(GraphicsBufferHandle Buffer)
+	{
+		auto It = m_FrameBuffers.find(Buffer);
+		if (It != m_FrameBuffers.end())
+		{
+			return It->second;
+		}
+		
+		// Last used by an earlier frame or an upload, the default state waits on all of it.
+		const LVKBuffer& Imported = m_Buffers.Get(Buffer).Buffer;
+		LVKGraphResource Resource = m_RenderGraphs[m_ActiveRenderContext]->ImportBuffer("Buffer", Imported.Buffer, Imported.Info.size);
+		m_FrameBuffers[Buffer] = Resource;
+		return Resource;
+	}
+	
+	void LVKGraphicsManager::CreateDefaultResources()
+	{
+		// 1x1 image, left cleared to zero, that empty bindless image slots point at.
+		
+		m_DefaultImage.Format = VK_FORMAT_R8G8B8A8_UNORM;
+		m_DefaultImage.Extent = { 1, 1, 1 };
+		
+		VkImageCreateInfo ImageInfo = LVKImage::CreateInfo(m_DefaultImage.Format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, m_DefaultImage.Extent);
+		VmaAllocationCreateInfo ImageAllocInfo = {
+			.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+			.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		};
+		VK_CHECK_RESULT(vmaCreateImage(m_GraphicsDevice.Allocator, &ImageInfo, &ImageAllocInfo, &m_DefaultImage.Image, &m_DefaultImage.Allocation, nullptr));
+		
+		VkImageViewCreateInfo ViewInfo = LVKImage::ViewCreateInfo(m_DefaultImage.Format, m_DefaultImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
+		VK_CHECK_RESULT(vkCreateImageView(m_GraphicsDevice.Device, &ViewInfo, nullptr, &m_DefaultImage.View));
+		
+		ImmediateSubmit([&](VkCommandBuffer Cmd) {
+			LVKImage::TransitionLazy(Cmd, LVKImage::MemoryBarrier(m_DefaultImage.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED));
+			
+			VkClearColorValue Clear = {{ 0.0f, 0.0f, 0.0f, 0.0f }};
+			VkImageSubresourceRange Range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vkCmdClearColorImage(Cmd, m_DefaultImage.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &Clear, 1, &Range);
+			
+			LVKImage::TransitionLazy(Cmd, LVKImage::MemoryBarrier(m_DefaultImage.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED));
 		});
+		
+		// Small storage buffer for empty buffer slots.
+		
+		m_DefaultBuffer = LVKBuffer::Allocate(256, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_GraphicsDevice.Allocator, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		memset(m_DefaultBuffer.Info.pMappedData, 0, 256);
+		
+		VkSamplerCreateInfo SamplerInfo = {
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.pNext = nullptr,
+			.magFilter = VK_FILTER_LINEAR,
+			.minFilter = VK_FILTER_LINEAR,
+			.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+			.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+			.maxLod = VK_LOD_CLAMP_NONE,
+		};
+		VK_CHECK_RESULT(vkCreateSampler(m_GraphicsDevice.Device, &SamplerInfo, nullptr, &m_DefaultSampler));
+		
+		m_GraphicsDevice.GlobalDeletionQueue.Push([&](){
+			vkDestroySampler(m_GraphicsDevice.Device, m_DefaultSampler, nullptr);
+			vmaDestroyBuffer(m_GraphicsDevice.Allocator, m_DefaultBuffer.Buffer, m_DefaultBuffer.Allocation);
+			vkDestroyImageView(m_GraphicsDevice.Device, m_DefaultImage.View, nullptr);
+			vmaDestroyImage(m_GraphicsDevice.Allocator, m_DefaultImage.Image, m_DefaultImage.Allocation);
+		});
+	}
+	
+	void LVKGraphicsManager::MakePipelines(RenderContextHandle RenderContext)
+	{
+		m_TrianglePipelines[RenderContext] = RequestTrianglePipeline(RenderContext);
+	}
+	
+	void LVKGraphicsManager::CreateDownsamplePipelines()
+	{
+		VirtualFileSystem& FileSystem = VirtualFileSystem::Get();
+		for (u32 i = 0; i < static_cast<u32>(LVKDownsampleFormat::Count); i++)
+		{
+			const char* ShaderPath = LVKDownsampler::GetShaderPath(static_cast<LVKDownsampleFormat>(i));
+			TArray<u8> Code;
+			if (!FileSystem.ReadFile(ShaderPath, Code))
+			{
+				LLOG(Vulkan, Warning, "Failed to read downsample shader %s, its format falls back to a dispatch per level where there is one.", ShaderPath);
+				continue;
+			}
+			
+			LVKComputePipeline& Pipeline = m_DownsamplePipelines[i];
+			LVKShaderSource Shader = { VK_SHADER_STAGE_COMPUTE_BIT, Code.Data(), Code.Length() };
+			LVKReflectedLayout Reflected;
+			std::vector<VkDescriptorSetLayout> SetLayouts;
+			Pipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, &Shader, 1, Reflected, &SetLayouts);
+			if (Pipeline.Instance.Layout != VK_NULL_HANDLE)
+			{
+				Pipeline.SetLayout = SetLayouts[0];
+				Pipeline.PushConstants = Reflected.PushConstants;
+				
+				LVKComputePipelineFactory Factory;
+				Factory.Layout = Pipeline.Instance.Layout;
+				Pipeline.Instance.Key = m_PipelineRegistry.RequestComputePipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, Factory, Shader, true);
+			}
+		}
+	}
+	
+	LVKGpuScenePipeline LVKGraphicsManager::GetDownsamplePipeline(LVKDownsampleFormat Format)
+	{
+		const LVKComputePipeline& Pipeline = m_DownsamplePipelines[static_cast<u32>(Format)];
+		return {
+			.Pipeline = m_PipelineRegistry.TryGetPipeline(Pipeline.Instance.Key),
+			.Layout = Pipeline.Instance.Layout,
+			.SetLayout = Pipeline.SetLayout,
+		};
+	}
+	
+	void LVKGraphicsManager::CreateScenePipelines()
+	{
+		TArray<u8> CullCode;
+		TArray<u8> VertCode;
+		TArray<u8> FragCode;
+		TArray<u8> PyramidCode;
+		VirtualFileSystem& FileSystem = VirtualFileSystem::Get();
+		if (!FileSystem.ReadFile("shaders/scene_cull.comp.spv", CullCode) || !FileSystem.ReadFile("shaders/scene.vert.spv", VertCode) || !FileSystem.ReadFile("shaders/scene.frag.spv", FragCode))
+		{
+			LLOG(Vulkan, Error, "Failed to read the scene shaders, the scene will not be drawn.");
+			return;
+		}
+		
+		// Depth pyramid, without it the scene is culled by the frustum alone
+		
+		if (FileSystem.ReadFile("shaders/depth_pyramid.comp.spv", PyramidCode))
+		{
+			LVKShaderSource PyramidShader = { VK_SHADER_STAGE_COMPUTE_BIT, PyramidCode.Data(), PyramidCode.Length() };
+			LVKReflectedLayout PyramidReflected;
+			std::vector<VkDescriptorSetLayout> PyramidSetLayouts;
+			m_DepthPyramidPipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, &PyramidShader, 1, PyramidReflected, &PyramidSetLayouts);
+			if (m_DepthPyramidPipeline.Instance.Layout != VK_NULL_HANDLE)
+			{
+				m_DepthPyramidPipeline.SetLayout = PyramidSetLayouts[0];
+				m_DepthPyramidPipeline.PushConstants = PyramidReflected.PushConstants;
+				
+				LVKComputePipelineFactory PyramidFactory;
+				PyramidFactory.Layout = m_DepthPyramidPipeline.Instance.Layout;
+				m_DepthPyramidPipeline.Instance.Key = m_PipelineRegistry.RequestComputePipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, PyramidFactory, PyramidShader, true);
+			}
+		}
+		else
+		{
+			LLOG(Vulkan, Warning, "Failed to read the depth pyramid shader, the scene will not be occlusion culled.");
+		}
+		
+		// Cull
+		
+		LVKShaderSource CullShader = { VK_SHADER_STAGE_COMPUTE_BIT, CullCode.Data(), CullCode.Length() };
+		LVKReflectedLayout CullReflected;
+		std::vector<VkDescriptorSetLayout> CullSetLayouts;
+		m_SceneCullPipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, &CullShader, 1, CullReflected, &CullSetLayouts);
+		if (m_SceneCullPipeline.Instance.Layout != VK_NULL_HANDLE)
+		{
+			m_SceneCullPipeline.SetLayout = CullSetLayouts[0];
+			m_SceneCullPipeline.PushConstants = CullReflected.PushConstants;
+			
+			LVKComputePipelineFactory CullFactory;
+			CullFactory.Layout = m_SceneCullPipeline.Instance.Layout;
+			m_SceneCullPipeline.Instance.Key = m_PipelineRegistry.RequestComputePipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, CullFactory, CullShader, true);
+		}
+		
+		// Draw, vertices are pulled from storage so there is no vertex input
+		
+		LVKShaderSource DrawShaders[] = {
+			{ VK_SHADER_STAGE_VERTEX_BIT, VertCode.Data(), VertCode.Length() },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT, FragCode.Data(), FragCode.Length() },
+		};
+		LVKReflectedLayout DrawReflected;
+		std::vector<VkDescriptorSetLayout> DrawSetLayouts;
+		m_SceneDrawPipeline.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, DrawShaders, 2, DrawReflected, &DrawSetLayouts);
+		if (m_SceneDrawPipeline.Layout == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		m_SceneDrawSetLayout = DrawSetLayouts[0];
+		
+		LVKPipelineFactory DrawFactory;
+		DrawFactory.Layout = m_SceneDrawPipeline.Layout;
+		DrawFactory.InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		DrawFactory.Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		DrawFactory.ColorAttachmentFormat = DRAW_IMAGE_FORMAT;
+		DrawFactory.DepthAttachmentFormat = SCENE_DEPTH_FORMAT;
+		
+		// Reverse Z, nearer is greater.
+		DrawFactory.DepthStencil.depthTestEnable = VK_TRUE;
+		DrawFactory.DepthStencil.depthWriteEnable = VK_TRUE;
+		DrawFactory.DepthStencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+		
+		m_SceneDrawPipeline.Key = m_PipelineRegistry.RequestPipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, DrawFactory, DrawShaders, 2, VK_NULL_HANDLE, 0, true);
+	}
+	
+	void LVKGraphicsManager::CreateStaticMeshPipeline()
+	{
+		TArray<u8> CullCode;
+		TArray<u8> VertCode;
+		TArray<u8> FragCode;
+		VirtualFileSystem& FileSystem = VirtualFileSystem::Get();
+		if (!FileSystem.ReadFile("shaders/static_mesh_cull.comp.spv", CullCode) || !FileSystem.ReadFile("shaders/static_mesh.vert.spv", VertCode) || !FileSystem.ReadFile("shaders/scene.frag.spv", FragCode))
+		{
+			LLOG(Vulkan, Error, "Failed to read the static mesh shaders, static meshes will not be drawn.");
+			return;
+		}
+		
+		// Cull
+		
+		LVKShaderSource CullShader = { VK_SHADER_STAGE_COMPUTE_BIT, CullCode.Data(), CullCode.Length() };
+		LVKReflectedLayout CullReflected;
+		std::vector<VkDescriptorSetLayout> CullSetLayouts;
+		m_StaticMeshCullPipeline.Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, &CullShader, 1, CullReflected, &CullSetLayouts);
+		if (m_StaticMeshCullPipeline.Instance.Layout != VK_NULL_HANDLE)
+		{
+			m_StaticMeshCullPipeline.SetLayout = CullSetLayouts[0];
+			m_StaticMeshCullPipeline.PushConstants = CullReflected.PushConstants;
+			
+			LVKComputePipelineFactory CullFactory;
+			CullFactory.Layout = m_StaticMeshCullPipeline.Instance.Layout;
+			m_StaticMeshCullPipeline.Instance.Key = m_PipelineRegistry.RequestComputePipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, CullFactory, CullShader, true);
+		}
+		
+		// Draw, shares the scene's fragment shader and vertices are pulled from storage so there is no vertex input
+		
+		LVKShaderSource Shaders[] = {
+			{ VK_SHADER_STAGE_VERTEX_BIT, VertCode.Data(), VertCode.Length() },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT, FragCode.Data(), FragCode.Length() },
+		};
+		LVKReflectedLayout Reflected;
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+		m_StaticMeshPipeline.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, Shaders, 2, Reflected, &SetLayouts);
+		if (m_StaticMeshPipeline.Layout == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		m_StaticMeshSetLayout = SetLayouts[0];
+		
+		LVKPipelineFactory Factory;
+		Factory.Layout = m_StaticMeshPipeline.Layout;
+		Factory.InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		Factory.Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		Factory.ColorAttachmentFormat = DRAW_IMAGE_FORMAT;
+		Factory.DepthAttachmentFormat = SCENE_DEPTH_FORMAT;
+		
+		// Reverse Z, nearer is greater.
+		Factory.DepthStencil.depthTestEnable = VK_TRUE;
+		Factory.DepthStencil.depthWriteEnable = VK_TRUE;
+		Factory.DepthStencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+		
+		m_StaticMeshPipeline.Key = m_PipelineRegistry.RequestPipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, Factory, Shaders, 2, VK_NULL_HANDLE, 0, true);
+	}
+	
+	LVKPipelineInstance LVKGraphicsManager::RequestTrianglePipeline(RenderContextHandle RenderContext)
+	{
+		TArray<u8> VertShaderCode;
+		LAssert(VirtualFileSystem::Get().ReadFile("shaders/triangle.vert.spv", VertShaderCode));
+		
+		TArray<u8> FragShaderCode;
+		LAssert(VirtualFileSystem::Get().ReadFile("shaders/triangle.frag.spv", FragShaderCode));
+		
+		LVKShaderSource Shaders[] = {
+			{ VK_SHADER_STAGE_VERTEX_BIT, VertShaderCode.Data(), VertShaderCode.Length() },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT, FragShaderCode.Data(), FragShaderCode.Length() },
+		};
+		
+		// The layout and vertex input come straight from the SPIR-V.
+		LVKReflectedLayout Reflected;
+		LVKPipelineInstance Instance;
+		Instance.Layout = m_PipelineRegistry.AcquireReflectedLayout(m_GraphicsDevice.Device, Shaders, 2, Reflected);
+		if (Instance.Layout == VK_NULL_HANDLE)
+		{
+			return Instance;
+		}
+		
+		LVKPipelineFactory PipelineFactory;
+		PipelineFactory.Layout = Instance.Layout;
+		PipelineFactory.InputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		PipelineFactory.Rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		PipelineFactory.ColorAttachmentFormat = DRAW_IMAGE_FORMAT;
+		
+		if (!Reflected.VertexAttributes.empty())
+		{
+			PipelineFactory.VertexInput.vertexBindingDescriptionCount = 1;
+			PipelineFactory.VertexInput.pVertexBindingDescriptions = &Reflected.VertexBinding;
+			PipelineFactory.VertexInput.vertexAttributeDescriptionCount = static_cast<u32>(Reflected.VertexAttributes.size());
+			PipelineFactory.VertexInput.pVertexAttributeDescriptions = Reflected.VertexAttributes.data();
+		}
+		
+		// Renders into the draw image, so every context shares one pipeline and only the first compiles it.
+		Instance.Key = m_PipelineRegistry.RequestPipeline(m_GraphicsDevice.Device, m_GraphicsDevice.PipelineCache.Cache, PipelineFactory, Shaders, 2, VK_NULL_HANDLE, 0, true);
+		return Instance;
+	}
+	
+	void LVKGraphicsManager::ReleasePipelineInstance(const LVKPipelineInstance& Instance)
+	{
+		if (Instance.Key != LVK_PIPELINE_KEY_INVALID)
+		{
+			m_PipelineRegistry.ReleasePipeline(m_GraphicsDevice.Device, Instance.Key);
+		}
+		
+		if (Instance.Layout != VK_NULL_HANDLE)
+		{
+			m_PipelineRegistry.ReleaseLayout(m_GraphicsDevice.Device, Instance.Layout);
+		}
+	}
+	
+	void LVKGraphicsManager::DestroyPipelines(RenderContextHandle RenderContext)
+	{
+		if (m_PendingTrianglePipelines.count(RenderContext))
+		{
+			ReleasePipelineInstance(m_PendingTrianglePipelines[RenderContext]);
+			m_PendingTrianglePipelines.erase(RenderContext);
+		}
+		
+		if (m_TrianglePipelines.count(RenderContext))
+		{
+			ReleasePipelineInstance(m_TrianglePipelines[RenderContext]);
+			m_TrianglePipelines.erase(RenderContext);
+		}
+	}
+	
+	void LVKGraphicsManager::UpdatePipelines()
+	{
+		// Swap in reloaded pipelines that finished compiling, the old ones stay alive until the frames using them retire.
+		for (auto It = m_PendingTrianglePipelines.begin(); It != m_PendingTrianglePipelines.end(); )
+		{
+			auto [Handle, Pending] = *It;
+			LVKPipelineStatus Status = m_PipelineRegistry.GetPipelineStatus(Pending.Key);
+			if (Status == LVKPipelineStatus::Pending)
+			{
+				It++;
+				continue;
+			}
+			
+			if (Status == LVKPipelineStatus::Ready)
+			{
+				LVKPipelineInstance Old = m_TrianglePipelines[Handle];
+				m_TrianglePipelines[Handle] = Pending;
+				RetireResource([=](){
+					ReleasePipelineInstance(Old);
+				});
+				LLOG(Vulkan, Info, "Hot reloaded triangle pipeline.");
+			}
+			else
+			{
+				// Creation failed, keep drawing with what we had.
+				ReleasePipelineInstance(Pending);
+			}
+			
+			It = m_PendingTrianglePipelines.erase(It);
+		}
+		
+		if (m_ShaderHotReloader)
+		{
+			m_ShaderHotReloader->Update();
+			
+			std::vector<std::string> Reloaded;
+			m_ShaderHotReloader->ConsumeReloadedShaders(Reloaded);
+			
+			bool bTriangleChanged = false;
+			for (const std::string& Path : Reloaded)
+			{
+				bTriangleChanged |= (Path == "shaders/triangle.vert.spv" || Path == "shaders/triangle.frag.spv");
+			}
+			
+			for (arch i = 0; bTriangleChanged && i < m_RenderContextPool.Count(); i++)
+			{
+				if (!m_RenderContextPool.IsValidAt(i))
+				{
+					continue;
+				}
+				
+				RenderContextHandle Handle = m_RenderContextPool.GetHandleAt(i);
+				LVKPipelineInstance New = RequestTrianglePipeline(Handle);
+				
+				if (m_PendingTrianglePipelines.count(Handle))
+				{
+					// Superseded by an even newer edit.
+					ReleasePipelineInstance(m_PendingTrianglePipelines[Handle]);
+					m_PendingTrianglePipelines.erase(Handle);
+				}
+				
+				if (New.Key == m_TrianglePipelines[Handle].Key)
+				{
+					// Recompiled to identical SPIR-V, nothing to swap.
+					ReleasePipelineInstance(New);
+					continue;
+				}
+				
+				m_PendingTrianglePipelines[Handle] = New;
+			}
+		}
+		
+		m_Stats.PipelinesCreated = m_PipelineRegistry.GetPipelinesCreated();
+		m_Stats.PipelineRegistryHits = m_PipelineRegistry.GetPipelineHits();
+		m_Stats.PipelineCompilesPending = m_PipelineRegistry.GetCompilesInFlight();
+		m_Stats.PipelineCreateMilliseconds = m_PipelineRegistry.GetPipelineCreateMilliseconds();
+	}
+	
+	void LVKGraphicsManager::RetireResource(std::function<void()>&& DeletionFunction)
+	{
+		// The frame being recorded, if any, signals the next value, so nothing can reference the resource past it.
+		m_GraphicsDevice.RetiredResources.Push(m_GraphicsDevice.GraphicsTimeline.GetNextValue(), std::move(DeletionFunction));
 	}
 	
 	LVKFrameResources& LVKGraphicsManager::GetCurrentFrame(RenderContextHandle RenderContext)
 	{
 		LAssert(m_RenderContextPool.IsValid(RenderContext));
 		LVKRenderContext& Ctx = m_RenderContextPool.GetMut(RenderContext);
-		return Ctx.FrameResources[Ctx.FrameNumber % FRAMES_IN_FLIGHT];
+		return Ctx.FrameResources[Ctx.FrameNumber % Ctx.FramesInFlight];
 	}
 }
\ No newline at end of file
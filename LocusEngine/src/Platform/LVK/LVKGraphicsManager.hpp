@@ -1,26 +1,37 @@
 #pragma once
 
 #include "Core/DisplayManager.hpp"
+#include "Core/Time.hpp"
 #include "Graphics/GraphicsManager.hpp"
+#include "Graphics/ShaderHotReloader.hpp"
 
+#include "LVKBindlessHeap.hpp"
 #include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKDescriptorCache.hpp"
+#include "LVKDownsampler.hpp"
+#include "LVKDepthPyramid.hpp"
+#include "LVKGpuScene.hpp"
+#include "LVKStaticMeshRenderer.hpp"
+#include "LVKTextureStreamer.hpp"
+#include "LVKPipelineCache.hpp"
+#include "LVKPipelineRegistry.hpp"
+#include "LVKRenderGraph.hpp"
 #include "LVKTypes.hpp"
 #include "LVKResources.hpp"
+#include "LVKTimeline.hpp"
+#include "LVKUploadManager.hpp"
 #include "imgui_internal.h"
 
 #include <deque>
 #include <map>
+#include <string>
 #include <vma/vk_mem_alloc.h>
 #include <vulkan/vulkan_core.h>
 
-/*
-	TODO:
-	- Implement window resizing
-*/
-
 namespace Locus
 {
-	constexpr u32 FRAMES_IN_FLIGHT = 2;
+	constexpr u32 PRESENT_HISTORY = 8; // Present ids whose input time is remembered, more than are ever queued
 	
 	struct LVKDeletionQueue
 	{
@@ -29,13 +40,35 @@ namespace Locus
 		void Flush();
 	};
 	
+	// Deletions that wait for a timeline value, pushed in non-decreasing order of value.
+	struct LVKTimelineDeletionQueue
+	{
+		struct Deletor
+		{
+			u64 TimelineValue;
+			std::function<void()> Function;
+		};
+		
+		std::deque<Deletor> Deletors;
+		void Push(u64 TimelineValue, std::function<void()>&& DeletionFunction);
+		void Flush(u64 CompletedValue);
+		void FlushAll();
+	};
+	
 	struct LVKFrameResources
 	{
-		VkSemaphore ImageAvailableSemaphore;
+		VkSemaphore ImageAvailableSemaphore; // Binary, swapchain acquire and present cannot use timelines
 		VkSemaphore RenderFinishedSemaphore;
-		VkFence InFlightFence;
+		u64 TimelineValue = 0; // Graphics timeline value signalled by this slot's last submission
 		VkCommandPool CommandPool;
 		VkCommandBuffer CommandBuffer;
+		LVKDescriptorAllocator DescriptorAllocator; // Transient sets, reset once TimelineValue is reached
+		u32 BindlessFrameSet = 0;
+		VkDescriptorSet BindlessSet = VK_NULL_HANDLE; // Synced with the heap at the start of each frame
+		VkQueryPool TimestampPool = VK_NULL_HANDLE; // Start of the frame, end of the scene, then pairs around dispatches
+		bool bTimestampsWritten = false;
+		u32 TimedDispatches = 0;
+		f64 InputMilliseconds = 0.0; // When input was sampled for this slot's last submission
 	};
 	
 	struct LVKGraphicsDevice
@@ -48,19 +81,89 @@ namespace Locus
 		VkDescriptorPool ImGuiDescriptorPool = VK_NULL_HANDLE;
 		VmaAllocator Allocator;
 		LVKQueueFamilyIndices QueueFamilyIndices {};
+		LVKDeviceCapabilities Capabilities {};
 		VkQueue GraphicsQueue;
 		VkQueue PresentQueue;
+		VkQueue TransferQueue; // The graphics queue when there is no dedicated transfer family
+		VkQueue ComputeQueue; // The graphics queue when there is no dedicated compute family
+		VkCommandPool ImmediateCommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer ImmediateCommandBuffer = VK_NULL_HANDLE;
+		LVKTimeline GraphicsTimeline;
+		LVKTimeline TransferTimeline; // Only created for a dedicated transfer queue
+		LVKPipelineCache PipelineCache;
 		LVKDeletionQueue GlobalDeletionQueue;
+		LVKTimelineDeletionQueue RetiredResources; // Keyed on the graphics timeline
+		PFN_vkWaitForPresentKHR WaitForPresent = nullptr; // Null without present id and present wait
+		
+		LVKTimeline& GetTransferTimeline() { return QueueFamilyIndices.TransferFamilyPresent ? TransferTimeline : GraphicsTimeline; }
 	};
 	
 	struct LVKRenderContext
 	{
+		WindowHandle Window = HANDLE_INVALID;
 		VkSurfaceKHR Surface;
 		LVKSwapchain Swapchain;
+		bool bSwapchainOutOfDate = false; // Suboptimal or out of date at the last acquire or present, recreated next frame
+		VkExtent2D WindowExtent = {}; // Of the window when the swapchain was made, a resize is caught without waiting for present to notice
 		u32 FrameNumber = 0;
-		LVKFrameResources FrameResources[FRAMES_IN_FLIGHT];
+		u32 FramesInFlight = 2; // Slots in use, of every one created
+		LVKFrameResources FrameResources[FRAMES_IN_FLIGHT_MAX];
+		PresentPolicy Policy = PresentPolicy::Fifo; // Requested when the swapchain was made
+		u64 PresentId = 0; // Of the last present, ids count up across swapchains
+		u64 FirstSwapchainPresentId = 1; // Earlier ids went to retired swapchains and can't be waited on
+		f64 InputMilliseconds = 0.0; // Of the frame being built
+		bool bInputSampled = false; // By WaitForFrameLatency, ahead of the frame being built
+		f64 PresentInputMilliseconds[PRESENT_HISTORY] = {}; // By present id
 		LVKDeletionQueue PerContextDeletionQueue;
 		ImGuiContext* ImGuiContext = nullptr;
+		RenderScaleController RenderScale;
+	};
+	
+	struct LVKPipelineInstance
+	{
+		LVKPipelineKey Key = LVK_PIPELINE_KEY_INVALID;
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+	};
+	
+	struct LVKComputePipeline
+	{
+		LVKPipelineInstance Instance;
+		VkDescriptorSetLayout SetLayout = VK_NULL_HANDLE; // Set 0, owned by the registry, null without bindings
+		VkPushConstantRange PushConstants = {};
+	};
+	
+	struct LVKGraphicsBuffer
+	{
+		LVKBuffer Buffer;
+		LVKUploadTicket Upload = LVK_UPLOAD_TICKET_NONE; // Initial data
+	};
+	
+	struct LVKGraphicsPipeline
+	{
+		LVKPipelineInstance Instance;
+		VkDescriptorSetLayout SetLayout = VK_NULL_HANDLE; // Set 0, owned by the registry, null without bindings
+		VkPushConstantRange PushConstants = {};
+		bool bBindless = false; // Samples the bindless heap at BINDLESS_SET
+	};
+	
+	struct LVKMaterial
+	{
+		GraphicsPipelineHandle Pipeline;
+		u32 BufferCount;
+		GraphicsBufferHandle Buffers[MATERIAL_BUFFERS_MAX];
+	};
+	
+	// A submitted draw, what the render queue's payloads index.
+	struct LVKQueuedDraw
+	{
+		MaterialHandle Material;
+		GraphicsBufferHandle VertexBuffer;
+		GraphicsBufferHandle IndexBuffer;
+		u32 Count;
+		u32 First;
+		i32 VertexOffset;
+		u32 PushConstantOffset; // Into the frame's push constant bytes
+		u32 PushConstantSize;
 	};
 	
 	class LVKGraphicsManager : public GraphicsManager
@@ -72,7 +175,8 @@ namespace Locus
 		virtual RenderContextHandle CreateRenderContext(const WindowHandle Window) override;
 		virtual void DestroyRenderContext(RenderContextHandle RenderContext) override;
 		
-		virtual void BeginFrame(RenderContextHandle RenderContext) override;
+		virtual bool BeginFrame(RenderContextHandle RenderContext) override;
+		virtual void WaitForFrameLatency(RenderContextHandle RenderContext) override;
 		virtual void EndFrame(RenderContextHandle RenderContext) override;
 		
 		virtual void BeginFrameImGui() override;
@@ -81,18 +185,127 @@ namespace Locus
 		virtual ImGuiContext* GetImGuiContext(RenderContextHandle RenderContext) override;
 		
 		virtual void TestDraw(RenderContextHandle RenderContext) override;		
+		virtual void DrawDebugRenderGraph(bool* bOpen) override;
+		
+		virtual ComputePipelineHandle CreateComputePipeline(const char* ShaderPath) override;
+		virtual void DestroyComputePipeline(ComputePipelineHandle Pipeline) override;
+		virtual GraphicsBufferHandle CreateBuffer(u64 Size, const void* InitialData = nullptr) override;
+		virtual void DestroyBuffer(GraphicsBufferHandle Buffer) override;
 		
+		virtual void Dispatch(const ComputePass& Pass, u32 GroupCountX, u32 GroupCountY, u32 GroupCountZ) override;
+		virtual void DispatchIndirect(const ComputePass& Pass, GraphicsBufferHandle Arguments, u64 Offset = 0) override;
+		virtual void GetSceneExtent(u32& OutWidth, u32& OutHeight) const override;
+		
+		virtual MeshHandle CreateMesh(const MeshVertex* Vertices, u32 VertexCount, const u32* Indices, u32 IndexCount) override;
+		virtual void DestroyMesh(MeshHandle Mesh) override;
+		virtual SceneObjectHandle CreateSceneObject(const SceneObjectDesc& Desc) override;
+		virtual void SetSceneObjectTransform(SceneObjectHandle Object, const SceneTransform& Transform) override;
+		virtual void DestroySceneObject(SceneObjectHandle Object) override;
+		virtual void DrawScene() override;
+		
+		virtual GraphicsPipelineHandle CreateGraphicsPipeline(const GraphicsPipelineDesc& Desc) override;
+		virtual void DestroyGraphicsPipeline(GraphicsPipelineHandle Pipeline) override;
+		virtual MaterialHandle CreateMaterial(const MaterialDesc& Desc) override;
+		virtual void DestroyMaterial(MaterialHandle Material) override;
+		virtual void SubmitDraw(const DrawDesc& Draw) override;
+		
+		virtual StaticMeshHandle LoadStaticMesh(const char* LogicalPath) override;
+		virtual void DestroyStaticMesh(StaticMeshHandle Mesh) override;
+		virtual void DrawStaticMesh(StaticMeshHandle Mesh, const StaticMeshInstance* Instances, u32 Count) override;
+		
+		virtual TextureHandle LoadTexture(const char* LogicalPath) override;
+		virtual void DestroyTexture(TextureHandle Texture) override;
+		virtual void RequestTextureResolution(TextureHandle Texture, f32 ScreenPixels) override;
+		virtual void RequestTextureAtDistance(TextureHandle Texture, f32 WorldSize, f32 Distance) override;
+		virtual bool GetTextureBinding(TextureHandle Texture, u32& OutImageIndex, u32& OutSamplerIndex) const override;
+		virtual void SetTextureBudget(u64 Bytes) override;
+	
 	protected:
 		LVKGraphicsDevice m_GraphicsDevice;
 		Pool<LVKRenderContext> m_RenderContextPool;
 		
 		u32 m_ActiveImageIndex = 0;
+		u64 m_UploadWaitValue = 0; // Transfer timeline value the active frame's submission waits on
+		LVKGraphResource m_Backbuffer = LVK_GRAPH_RESOURCE_INVALID; // Active frame's swapchain image
+		LVKGraphResource m_DrawImage = LVK_GRAPH_RESOURCE_INVALID; // Active frame's HDR scene target
+		LVKGraphResource m_SceneDepth = LVK_GRAPH_RESOURCE_INVALID;
+		bool m_bSceneDepthWritten = false;
+		VkExtent2D m_DrawExtent = {}; // Part of the draw image rendered to at the current render scale
+		bool m_bDrawImageResolved = false;
 		bool m_ImGuiInProgress = false;
 		
-		std::map<RenderContextHandle, VkPipelineLayout> m_TrianglePipelineLayouts;
-		std::map<RenderContextHandle, VkPipeline> m_TrianglePipelines;
+		LVKBindlessHeap m_BindlessHeap;
+		LVKImage m_DefaultImage;
+		LVKBuffer m_DefaultBuffer;
+		VkSampler m_DefaultSampler = VK_NULL_HANDLE;
+		LVKDescriptorCache m_DescriptorCache;
+		LVKUploadManager m_UploadManager;
+		std::map<RenderContextHandle, Unique<LVKRenderGraph>> m_RenderGraphs; // Rebuilt every frame
+		
+		LVKPipelineRegistry m_PipelineRegistry;
+		std::map<RenderContextHandle, LVKPipelineInstance> m_TrianglePipelines;
+		std::map<RenderContextHandle, LVKPipelineInstance> m_PendingTrianglePipelines; // Reloaded, swapped in once compiled
+		
+		Pool<LVKComputePipeline> m_ComputePipelines;
+		Pool<LVKGraphicsBuffer> m_Buffers;
+		std::map<GraphicsBufferHandle, LVKGraphResource> m_FrameBuffers; // Buffers imported into the active frame's graph
+		std::vector<LVKGraphicsBuffer> m_BuffersAwaitingUpload; // Destroyed with their initial data still in flight
+		
+		LVKDownsampler m_Downsampler;
+		LVKComputePipeline m_DownsamplePipelines[static_cast<u32>(LVKDownsampleFormat::Count)];
+		
+		LVKGpuScene m_GpuScene;
+		LVKComputePipeline m_SceneCullPipeline;
+		LVKComputePipeline m_DepthPyramidPipeline;
+		std::map<RenderContextHandle, Unique<LVKDepthPyramid>> m_DepthPyramids; // Built from the scene's depth, kept for the next frame
+		LVKPipelineInstance m_SceneDrawPipeline;
+		VkDescriptorSetLayout m_SceneDrawSetLayout = VK_NULL_HANDLE;
+		
+		LVKStaticMeshRenderer m_StaticMeshes;
+		LVKComputePipeline m_StaticMeshCullPipeline;
+		LVKPipelineInstance m_StaticMeshPipeline;
+		VkDescriptorSetLayout m_StaticMeshSetLayout = VK_NULL_HANDLE;
+		
+		LVKTextureStreamer m_TextureStreamer;
+		
+		Pool<LVKGraphicsPipeline> m_GraphicsPipelines;
+		Pool<LVKMaterial> m_Materials;
+		RenderQueue m_RenderQueue; // Active frame's draws
+		std::vector<LVKQueuedDraw> m_QueuedDraws;
+		std::vector<u8> m_QueuedPushConstants;
+		
+		Unique<ShaderHotReloader> m_ShaderHotReloader;
+		Clock m_LatencyClock; // Input and presentation times are measured on it
 
+		VkDescriptorSet AllocateFrameDescriptorSet(VkDescriptorSetLayout Layout); // Valid for the active frame only
+		void ImmediateSubmit(std::function<void(VkCommandBuffer)>&& Function); // Blocks until the GPU has finished
+		void CreateDefaultResources();
+		void ResolveDrawImage(); // Once per frame, before anything draws over the scene on the backbuffer
+		void FlushRenderQueue(); // Sorts the queued draws and records them, part of the resolve
+		void RecordStaticMeshes(); // Part of the resolve, ahead of the render queue
+		LVKGraphResource GetSceneDepth(); // Created on first use, whoever writes it first in a frame clears it
+		
+		// Indirect when Arguments is valid, GroupCounts is ignored then.
+		void AddComputePass(const ComputePass& Pass, const u32 GroupCounts[3], GraphicsBufferHandle Arguments, u64 ArgumentsOffset);
+		LVKGraphResource ImportFrameBuffer(GraphicsBufferHandle Buffer);
+		
+		// The swapchain, its views and framebuffers, for the context's current surface extent. The render
+		// pass is kept, so pipelines built against it never change. False while the window has no area.
+		bool CreateSwapchain(LVKRenderContext& Ctx, VkSwapchainKHR OldSwapchain);
+		bool RecreateSwapchain(LVKRenderContext& Ctx); // Retires the old one rather than waiting for the device
 		void MakePipelines(RenderContextHandle RenderContext);
+		void CreateDownsamplePipelines();
+		LVKGpuScenePipeline GetDownsamplePipeline(LVKDownsampleFormat Format); // Null pipeline while compiling
+		void CreateScenePipelines();
+		void CreateStaticMeshPipeline();
+		LVKPipelineInstance RequestTrianglePipeline(RenderContextHandle RenderContext);
+		void ReleasePipelineInstance(const LVKPipelineInstance& Instance);
+		std::string GetShaderVariantPath(const char* ShaderPath) const; // The .fallback.spv build when the heap needs one
+		void DestroyPipelines(RenderContextHandle RenderContext);
+		void UpdatePipelines();
+		void ApplyFramesInFlight(LVKRenderContext& Ctx); // Waits for every slot when the count changes
+		void UpdateInputLatency(f64 Milliseconds);
+		void RetireResource(std::function<void()>&& DeletionFunction);
 		LVKFrameResources& GetCurrentFrame(RenderContextHandle RenderContext);
 	};
 }
\ No newline at end of file
@@ -149,6 +149,23 @@ bool Locus::LVK::CheckPhysicalDeviceFeatures(VkPhysicalDeviceFeatures& RequiredF
 	return true;
 }
 
+bool Locus::LVK::IsDeviceExtensionSupported(VkPhysicalDevice PhysicalDevice, const char* Extension)
+{
+	u32 DeviceExtensionCount;
+	vkEnumerateDeviceExtensionProperties(PhysicalDevice, nullptr, &DeviceExtensionCount, nullptr);
+	TArray<VkExtensionProperties> AvailableDeviceExtensions(DeviceExtensionCount);
+	vkEnumerateDeviceExtensionProperties(PhysicalDevice, nullptr, &DeviceExtensionCount, AvailableDeviceExtensions.Data());
+	
+	for (i32 i = 0; i < AvailableDeviceExtensions.Length(); i++)
+	{
+		if (strcmp(AvailableDeviceExtensions.GetElement(i).extensionName, Extension) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 bool Locus::LVK::CheckPhysicalDeviceSuitability(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<VkPhysicalDeviceType>& AllowedDeviceTypes, const TArray<const char*>& RequiredDeviceExtensions)
 {
 	VkPhysicalDeviceFeatures PhysicalDeviceFeatures;
@@ -234,11 +251,63 @@ LVKQueueFamilyIndices Locus::LVK::FindPhysicalDeviceQueueFamilies(VkPhysicalDevi
 		}
 	}
 	
+	// Prefer presenting from the graphics family, which avoids sharing swapchain images.
 	VkBool32 PresentSupport = false;
-	vkGetPhysicalDeviceSurfaceSupportKHR(PhysicalDevice, QueueFamilyIndices.PresentFamilyIndex, Surface, &PresentSupport);
-	if (PresentSupport)
+	if (QueueFamilyIndices.GraphicsFamilyPresent)
+	{
+		vkGetPhysicalDeviceSurfaceSupportKHR(PhysicalDevice, QueueFamilyIndices.GraphicsFamilyIndex, Surface, &PresentSupport);
+		if (PresentSupport)
+		{
+			QueueFamilyIndices.PresentFamilyPresent = true;
+			QueueFamilyIndices.PresentFamilyIndex = QueueFamilyIndices.GraphicsFamilyIndex;
+		}
+	}
+	
+	for (i32 i = 0; i < QueueFamilyProperties.Length() && !QueueFamilyIndices.PresentFamilyPresent; i++)
 	{
-		QueueFamilyIndices.PresentFamilyPresent = true;
+		vkGetPhysicalDeviceSurfaceSupportKHR(PhysicalDevice, i, Surface, &PresentSupport);
+		if (PresentSupport)
+		{
+			QueueFamilyIndices.PresentFamilyPresent = true;
+			QueueFamilyIndices.PresentFamilyIndex = i;
+		}
+	}
+	
+	// Transfer-only families are usually backed by copy engines, take one over a compute family that can also copy.
+	for (i32 i = 0; i < QueueFamilyProperties.Length(); i++)
+	{
+		VkQueueFlags Flags = QueueFamilyProperties.GetElement(i).queueFlags;
+		if ((Flags & VK_QUEUE_TRANSFER_BIT) && !(Flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			bool bTransferOnly = !(Flags & VK_QUEUE_COMPUTE_BIT);
+			if (!QueueFamilyIndices.TransferFamilyPresent || bTransferOnly)
+			{
+				QueueFamilyIndices.TransferFamilyPresent = true;
+				QueueFamilyIndices.TransferFamilyIndex = i;
+			}
+			if (bTransferOnly)
+			{
+				break;
+			}
+		}
+	}
+	
+	for (i32 i = 0; i < QueueFamilyProperties.Length(); i++)
+	{
+		VkQueueFlags Flags = QueueFamilyProperties.GetElement(i).queueFlags;
+		if ((Flags & VK_QUEUE_COMPUTE_BIT) && !(Flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			bool bSharedWithTransfer = QueueFamilyIndices.TransferFamilyPresent && QueueFamilyIndices.TransferFamilyIndex == (u32)i;
+			if (!QueueFamilyIndices.ComputeFamilyPresent || !bSharedWithTransfer)
+			{
+				QueueFamilyIndices.ComputeFamilyPresent = true;
+				QueueFamilyIndices.ComputeFamilyIndex = i;
+			}
+			if (!bSharedWithTransfer)
+			{
+				break;
+			}
+		}
 	}
 	
 	return QueueFamilyIndices;
@@ -269,7 +338,85 @@ LVKSwapchainSupportDetails Locus::LVK::QuerySwapchainSupport(VkSurfaceKHR Surfac
 	return SwapchainSupportDetails;
 }
 
-bool Locus::LVK::CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkDevice& OutDevice, LVKQueueFamilyIndices& QueueFamilyIndices, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<const char*>& RequiredDeviceExtensions, const TArray<const char*>& ValidationLayers, const VkAllocationCallbacks *Allocator)
+void Locus::LVK::QueryDeviceCapabilities(VkPhysicalDevice PhysicalDevice, LVKDeviceCapabilities& OutCapabilities, VkPhysicalDeviceVulkan12Features& OutEnabledFeatures12, VkPhysicalDeviceVulkan13Features& OutEnabledFeatures13, VkPhysicalDevicePresentIdFeaturesKHR& OutEnabledPresentId, VkPhysicalDevicePresentWaitFeaturesKHR& OutEnabledPresentWait)
+{
+	// Present features are only queried from devices that have the extensions.
+	bool bPresentExtensions = IsDeviceExtensionSupported(PhysicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) && IsDeviceExtensionSupported(PhysicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	VkPhysicalDevicePresentWaitFeaturesKHR SupportedPresentWait = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+	VkPhysicalDevicePresentIdFeaturesKHR SupportedPresentId = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR, .pNext = &SupportedPresentWait };
+	VkPhysicalDeviceVulkan13Features Supported13 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES, .pNext = bPresentExtensions ? &SupportedPresentId : nullptr };
+	VkPhysicalDeviceVulkan12Features Supported12 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES, .pNext = &Supported13 };
+	VkPhysicalDeviceFeatures2 Supported = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &Supported12 };
+	vkGetPhysicalDeviceFeatures2(PhysicalDevice, &Supported);
+	
+	OutEnabledFeatures13 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+	OutEnabledFeatures12 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES, .pNext = &OutEnabledFeatures13 };
+	
+	// Frame synchronization and offscreen rendering are built on these, all are mandatory in Vulkan 1.3.
+	LAssertMsg(Supported12.timelineSemaphore && Supported13.synchronization2 && Supported13.dynamicRendering, "Timeline semaphores, synchronization2 and dynamic rendering are required.");
+	OutEnabledFeatures12.timelineSemaphore = VK_TRUE;
+	OutEnabledFeatures13.synchronization2 = VK_TRUE;
+	OutEnabledFeatures13.dynamicRendering = VK_TRUE;
+	
+	OutCapabilities.bDrawIndirectCount = Supported12.drawIndirectCount;
+	OutEnabledFeatures12.drawIndirectCount = Supported12.drawIndirectCount;
+	
+	OutCapabilities.bTextureCompressionBC = Supported.features.textureCompressionBC;
+	
+	OutEnabledPresentWait = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+	OutEnabledPresentId = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR, .pNext = &OutEnabledPresentWait };
+	OutCapabilities.bPresentWait = bPresentExtensions && SupportedPresentId.presentId && SupportedPresentWait.presentWait;
+	if (OutCapabilities.bPresentWait)
+	{
+		OutEnabledPresentId.presentId = VK_TRUE;
+		OutEnabledPresentWait.presentWait = VK_TRUE;
+		OutEnabledFeatures13.pNext = &OutEnabledPresentId;
+	}
+	
+	OutCapabilities.bDescriptorIndexing = Supported12.descriptorIndexing &&
+		Supported12.runtimeDescriptorArray &&
+		Supported12.descriptorBindingPartiallyBound &&
+		Supported12.descriptorBindingSampledImageUpdateAfterBind &&
+		Supported12.descriptorBindingStorageBufferUpdateAfterBind &&
+		Supported12.descriptorBindingUpdateUnusedWhilePending &&
+		Supported12.shaderSampledImageArrayNonUniformIndexing &&
+		Supported12.shaderStorageBufferArrayNonUniformIndexing;
+	
+	if (OutCapabilities.bDescriptorIndexing)
+	{
+		OutEnabledFeatures12.descriptorIndexing = VK_TRUE;
+		OutEnabledFeatures12.runtimeDescriptorArray = VK_TRUE;
+		OutEnabledFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+		OutEnabledFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		OutEnabledFeatures12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		OutEnabledFeatures12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		OutEnabledFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		OutEnabledFeatures12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+	}
+	
+	LLOG(Vulkan, Info, "Descriptor indexing is %s.", OutCapabilities.bDescriptorIndexing ? "supported" : "not supported, using the fallback descriptor path");
+	LLOG(Vulkan, Info, "Draw indirect count is %s.", OutCapabilities.bDrawIndirectCount ? "supported" : "not supported, culled draws are zeroed instead of compacted");
+	LLOG(Vulkan, Info, "Present wait is %s.", OutCapabilities.bPresentWait ? "supported" : "not supported, latency is measured to the end of the frame");
+}
+
+f32 Locus::LVK::QueryTimestampPeriod(VkPhysicalDevice PhysicalDevice, u32 QueueFamily)
+{
+	VkPhysicalDeviceProperties Properties;
+	vkGetPhysicalDeviceProperties(PhysicalDevice, &Properties);
+	
+	u32 QueueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, nullptr);
+	TArray<VkQueueFamilyProperties> QueueFamilyProperties(QueueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(PhysicalDevice, &QueueFamilyCount, QueueFamilyProperties.Data());
+	
+	if (QueueFamily >= QueueFamilyCount || QueueFamilyProperties.GetElement(QueueFamily).timestampValidBits == 0)
+	{
+		return 0.0f;
+	}
+	return Properties.limits.timestampPeriod;
+}
+
+bool Locus::LVK::CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkDevice& OutDevice, LVKQueueFamilyIndices& QueueFamilyIndices, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<const char*>& RequiredDeviceExtensions, const TArray<const char*>& ValidationLayers, const void* FeatureChain, const VkAllocationCallbacks *Allocator)
 {
 	VK_CHECK_HANDLE(PhysicalDevice);
 	VK_CHECK_HANDLE(Surface);
@@ -278,7 +425,9 @@ bool Locus::LVK::CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceK
 	
 	std::set<u32> UniqueQueueFamilyIndices = {
 		QueueFamilyIndices.GraphicsFamilyIndex,
-		QueueFamilyIndices.PresentFamilyIndex
+		QueueFamilyIndices.PresentFamilyIndex,
+		QueueFamilyIndices.GetTransferFamily(),
+		QueueFamilyIndices.GetComputeFamily()
 	};
 	
 	f32 QueuePriorities[1] = {1.0f};
@@ -287,7 +436,7 @@ bool Locus::LVK::CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceK
 	{
 		QueueCreateInfos.Push({
 			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-			.queueFamilyIndex = QueueFamilyIndices.GraphicsFamilyIndex,
+			.queueFamilyIndex = QueueFamilyIndex,
 			.queueCount = 1,
 			.pQueuePriorities = &QueuePriorities[0]
 		});
@@ -295,7 +444,7 @@ bool Locus::LVK::CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceK
 	
 	VkDeviceCreateInfo DeviceCreateInfo = {
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-		.pNext = nullptr,
+		.pNext = FeatureChain,
 		.queueCreateInfoCount = (u32)QueueCreateInfos.Length(),
 		.pQueueCreateInfos = QueueCreateInfos.Data(),
 		.enabledLayerCount = (u32)ValidationLayers.Length(),
@@ -341,12 +490,27 @@ VkSurfaceFormatKHR Locus::LVK::ChooseSwapchainSurfaceFormat(const TArray<VkSurfa
 	return AvailableFormats.GetElement(0);
 }
 
-VkPresentModeKHR Locus::LVK::ChooseSwapchainPresentMode(const TArray<VkPresentModeKHR>& AvailablePresentModes)
+VkPresentModeKHR Locus::LVK::ChooseSwapchainPresentMode(const TArray<VkPresentModeKHR>& AvailablePresentModes, VkPresentModeKHR Preferred)
 {
-	for (i32 i = 0; i < AvailablePresentModes.Length(); i++)
+	auto IsAvailable = [&AvailablePresentModes](VkPresentModeKHR Mode) {
+		for (i32 i = 0; i < AvailablePresentModes.Length(); i++)
+		{
+			if (AvailablePresentModes.GetElement(i) == Mode)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	
+	// Anything but FIFO asked not to block on vsync, mailbox is the closest to immediate that still doesn't. FIFO is always there.
+	if (Preferred != VK_PRESENT_MODE_FIFO_KHR)
 	{
-		const auto& AvailablePresentMode = AvailablePresentModes.GetElement(i);
-		if (AvailablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+		if (IsAvailable(Preferred))
+		{
+			return Preferred;
+		}
+		if (IsAvailable(VK_PRESENT_MODE_MAILBOX_KHR))
 		{
 			return VK_PRESENT_MODE_MAILBOX_KHR;
 		}
@@ -372,7 +536,7 @@ VkExtent2D Locus::LVK::ChooseSwapchainExtent(const WindowHandle Window, const Vk
 		};
 		
 		Actual.width = Math::Clamp(Actual.width, Capabilities.minImageExtent.width, Capabilities.maxImageExtent.width);
-		Actual.width = Math::Clamp(Actual.height, Capabilities.minImageExtent.height, Capabilities.maxImageExtent.height);
+		Actual.height = Math::Clamp(Actual.height, Capabilities.minImageExtent.height, Capabilities.maxImageExtent.height);
 	
 		return Actual;
 	}
@@ -403,4 +567,37 @@ VkShaderModule Locus::LVK::CreateShaderModule(VkDevice Device, const VkAllocatio
 	VkShaderModule ShaderModule;
 	LCheck(vkCreateShaderModule(Device, &ShaderModuleCreateInfo, Allocator, &ShaderModule) == VK_SUCCESS);
 	return ShaderModule;
+}
+
+u64 Locus::LVK::RenderPassCompatibilityHash(const VkRenderPassCreateInfo& CreateInfo)
+{
+	// Compatibility only considers attachment formats and sample counts, and how subpasses reference them.
+	u64 Key = Hash::FNV1a64Value(CreateInfo.attachmentCount);
+	for (u32 i = 0; i < CreateInfo.attachmentCount; i++)
+	{
+		Key = Hash::FNV1a64Value(CreateInfo.pAttachments[i].format, Key);
+		Key = Hash::FNV1a64Value(CreateInfo.pAttachments[i].samples, Key);
+	}
+	
+	Key = Hash::FNV1a64Value(CreateInfo.subpassCount, Key);
+	for (u32 i = 0; i < CreateInfo.subpassCount; i++)
+	{
+		const VkSubpassDescription& Subpass = CreateInfo.pSubpasses[i];
+		Key = Hash::FNV1a64Value(Subpass.colorAttachmentCount, Key);
+		for (u32 j = 0; j < Subpass.colorAttachmentCount; j++)
+		{
+			Key = Hash::FNV1a64Value(Subpass.pColorAttachments[j].attachment, Key);
+		}
+		
+		u32 DepthAttachment = Subpass.pDepthStencilAttachment ? Subpass.pDepthStencilAttachment->attachment : VK_ATTACHMENT_UNUSED;
+		Key = Hash::FNV1a64Value(DepthAttachment, Key);
+		
+		Key = Hash::FNV1a64Value(Subpass.inputAttachmentCount, Key);
+		for (u32 j = 0; j < Subpass.inputAttachmentCount; j++)
+		{
+			Key = Hash::FNV1a64Value(Subpass.pInputAttachments[j].attachment, Key);
+		}
+	}
+	
+	return Key;
 }
\ No newline at end of file
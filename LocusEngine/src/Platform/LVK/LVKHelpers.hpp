@@ -16,21 +16,29 @@ namespace Locus::LVK
 	bool ChoosePhysicalDevice(VkInstance Instance, VkSurfaceKHR Surface, VkPhysicalDevice& OutPhysicalDevice, VkPhysicalDeviceFeatures& RequiredDeviceFeatures, const TArray<VkPhysicalDeviceType>& AllowedDeviceTypes, const TArray<const char*>& RequiredDeviceExtensions);
 	
 	bool CheckPhysicalDeviceFeatures(VkPhysicalDeviceFeatures& RequiredFeatures, VkPhysicalDeviceFeatures& PhysicalDeviceFeatures);
+	bool IsDeviceExtensionSupported(VkPhysicalDevice PhysicalDevice, const char* Extension);
 	bool CheckPhysicalDeviceSuitability(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<VkPhysicalDeviceType>& AllowedDeviceTypes, const TArray<const char*>& RequiredDeviceExtensions);
 
 	LVKQueueFamilyIndices FindPhysicalDeviceQueueFamilies(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface);
 	LVKSwapchainSupportDetails QuerySwapchainSupport(VkSurfaceKHR Surface, VkPhysicalDevice PhysicalDevice);
 
-	bool CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkDevice& OutDevice, LVKQueueFamilyIndices& QueueFamilyIndices, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<const char*>& RequiredDeviceExtensions, const TArray<const char*>& ValidationLayers, const VkAllocationCallbacks *Allocator = nullptr);
+	// Fills the feature structs with what to enable and chains 12 to 13, then to present id and present wait when
+	// both are supported, pass &OutEnabledFeatures12 to CreateLogicalDevice. Their extensions are left to the caller.
+	void QueryDeviceCapabilities(VkPhysicalDevice PhysicalDevice, LVKDeviceCapabilities& OutCapabilities, VkPhysicalDeviceVulkan12Features& OutEnabledFeatures12, VkPhysicalDeviceVulkan13Features& OutEnabledFeatures13, VkPhysicalDevicePresentIdFeaturesKHR& OutEnabledPresentId, VkPhysicalDevicePresentWaitFeaturesKHR& OutEnabledPresentWait);
+	f32 QueryTimestampPeriod(VkPhysicalDevice PhysicalDevice, u32 QueueFamily); // Zero if the family has no timestamps
+	bool CreateLogicalDevice(VkPhysicalDevice PhysicalDevice, VkSurfaceKHR Surface, VkDevice& OutDevice, LVKQueueFamilyIndices& QueueFamilyIndices, VkPhysicalDeviceFeatures& RequiredFeatures, const TArray<const char*>& RequiredDeviceExtensions, const TArray<const char*>& ValidationLayers, const void* FeatureChain = nullptr, const VkAllocationCallbacks *Allocator = nullptr);
 	void DestroyDevice(VkDevice& Device, const VkAllocationCallbacks *Allocator = nullptr);
 	
 	bool CreateSurface(const WindowHandle Window, VkInstance Instance, VkSurfaceKHR& OutSurface, const VkAllocationCallbacks* Allocator = nullptr);
 	void DestroySurface(VkInstance sInstance, VkSurfaceKHR& sSurface, const VkAllocationCallbacks *Allocator = nullptr);
 	
 	VkSurfaceFormatKHR ChooseSwapchainSurfaceFormat(const TArray<VkSurfaceFormatKHR>& AvailableFormats);
-	VkPresentModeKHR ChooseSwapchainPresentMode(const TArray<VkPresentModeKHR>& AvailablePresentModes);
+	VkPresentModeKHR ChooseSwapchainPresentMode(const TArray<VkPresentModeKHR>& AvailablePresentModes, VkPresentModeKHR Preferred); // Falls back towards FIFO
 	VkExtent2D ChooseSwapchainExtent(const WindowHandle Window, const VkSurfaceCapabilitiesKHR& Capabilities);
 	
+	// Render passes that hash equal are compatible, so pipelines built against one can be used with the other.
+	u64 RenderPassCompatibilityHash(const VkRenderPassCreateInfo& CreateInfo);
+	
 	VkShaderModule CreateShaderModule(VkDevice Device, const VkAllocationCallbacks* Allocator, const u8* Code, arch CodeSize);
 	
 	VkRenderingAttachmentInfo RenderingAttachmentInfo(VkImageView View, VkClearValue* Clear, VkImageLayout Layout);
@@ -0,0 +1,132 @@
+#include "LVKPipelineCache.hpp"
+
+#include "Base/Hash.hpp"
+#include "Platform/Platform.hpp"
+
+#include <vector>
+
+namespace Locus
+{
+	static LVKPipelineCacheFileHeader MakeHeader(VkPhysicalDevice PhysicalDevice)
+	{
+		VkPhysicalDeviceProperties Properties;
+		vkGetPhysicalDeviceProperties(PhysicalDevice, &Properties);
+		
+		LVKPipelineCacheFileHeader Header = {
+			.Magic = PIPELINE_CACHE_MAGIC,
+			.Version = PIPELINE_CACHE_VERSION,
+			.VendorID = Properties.vendorID,
+			.DeviceID = Properties.deviceID,
+			.DriverVersion = Properties.driverVersion,
+			.Reserved = 0,
+		};
+		memcpy(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+		return Header;
+	}
+	
+	void LVKPipelineCache::Load(VkDevice Device, VkPhysicalDevice PhysicalDevice, const char* Path)
+	{
+		LVKPipelineCacheFileHeader Expected = MakeHeader(PhysicalDevice);
+		
+		std::vector<u8> File;
+		arch FileSize = 0;
+		if (Platform::FileGetSize(Path, FileSize) && FileSize >= sizeof(LVKPipelineCacheFileHeader))
+		{
+			File.resize(FileSize);
+			if (!Platform::FileReadBytes(Path, File.data(), FileSize))
+			{
+				File.clear();
+			}
+		}
+		
+		const u8* InitialData = nullptr;
+		arch InitialDataSize = 0;
+		
+		if (!File.empty())
+		{
+			LVKPipelineCacheFileHeader Header;
+			memcpy(&Header, File.data(), sizeof(Header));
+			const u8* Data = File.data() + sizeof(Header);
+			
+			bool bHeaderMatches = Header.Magic == Expected.Magic
+				&& Header.Version == Expected.Version
+				&& Header.VendorID == Expected.VendorID
+				&& Header.DeviceID == Expected.DeviceID
+				&& Header.DriverVersion == Expected.DriverVersion
+				&& memcmp(Header.PipelineCacheUUID, Expected.PipelineCacheUUID, VK_UUID_SIZE) == 0;
+			
+			bool bDataIntact = Header.DataSize == FileSize - sizeof(Header)
+				&& Header.DataHash == Hash::FNV1a64(Data, Header.DataSize);
+			
+			if (bHeaderMatches && bDataIntact)
+			{
+				InitialData = Data;
+				InitialDataSize = Header.DataSize;
+			}
+			else
+			{
+				LLOG(Vulkan, Warning, "Discarding pipeline cache %s, it was written by a different device or driver, or is corrupt.", Path);
+			}
+		}
+		
+		VkPipelineCacheCreateInfo CreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.initialDataSize = InitialDataSize,
+			.pInitialData = InitialData,
+		};
+		
+		VkResult Result = vkCreatePipelineCache(Device, &CreateInfo, nullptr, &Cache);
+		if (Result != VK_SUCCESS && InitialData != nullptr)
+		{
+			// The driver rejected the blob, start cold rather than failing.
+			LLOG(Vulkan, Warning, "Driver rejected pipeline cache data: %s", string_VkResult(Result));
+			CreateInfo.initialDataSize = 0;
+			CreateInfo.pInitialData = nullptr;
+			InitialData = nullptr;
+			Result = vkCreatePipelineCache(Device, &CreateInfo, nullptr, &Cache);
+		}
+		VK_CHECK_RESULT(Result);
+		
+		bWarm = (InitialData != nullptr);
+		LLOG(Vulkan, Info, "Pipeline cache is %s (%zu bytes loaded).", bWarm ? "warm" : "cold", InitialDataSize);
+	}
+	
+	bool LVKPipelineCache::Save(VkDevice Device, VkPhysicalDevice PhysicalDevice, const char* Path)
+	{
+		if (Cache == VK_NULL_HANDLE)
+		{
+			LLOG(Vulkan, Warning, "No pipeline cache to save to %s", Path);
+			return false;
+		}
+		
+		arch DataSize = 0;
+		VK_CHECK_RESULT(vkGetPipelineCacheData(Device, Cache, &DataSize, nullptr));
+		
+		std::vector<u8> File(sizeof(LVKPipelineCacheFileHeader) + DataSize);
+		u8* Data = File.data() + sizeof(LVKPipelineCacheFileHeader);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(Device, Cache, &DataSize, Data));
+		File.resize(sizeof(LVKPipelineCacheFileHeader) + DataSize);
+		
+		LVKPipelineCacheFileHeader Header = MakeHeader(PhysicalDevice);
+		Header.DataSize = DataSize;
+		Header.DataHash = Hash::FNV1a64(Data, DataSize);
+		memcpy(File.data(), &Header, sizeof(Header));
+		
+		if (!Platform::FileWriteBytesAtomic(Path, File.data(), File.size()))
+		{
+			LLOG(Vulkan, Error, "Failed to write pipeline cache to %s, the next run starts cold", Path);
+			return false;
+		}
+		
+		LLOG(Vulkan, Info, "Saved pipeline cache (%zu bytes) to %s", DataSize, Path);
+		return true;
+	}
+	
+	void LVKPipelineCache::Destroy(VkDevice Device)
+	{
+		vkDestroyPipelineCache(Device, Cache, nullptr);
+		Cache = VK_NULL_HANDLE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+
+/*
+	Device-wide VkPipelineCache persisted between runs.
+	
+	The file on disk is our own header followed by the opaque driver blob. The header pins
+	the blob to the exact device and driver that produced it so that a GPU or driver change
+	silently falls back to a cold cache instead of handing the driver stale data.
+*/
+
+namespace Locus
+{
+	constexpr u32 PIPELINE_CACHE_MAGIC = 0x4843504C; // "LPCH"
+	constexpr u32 PIPELINE_CACHE_VERSION = 1;
+	
+	struct LVKPipelineCacheFileHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 VendorID;
+		u32 DeviceID;
+		u32 DriverVersion;
+		u32 Reserved;
+		u8 PipelineCacheUUID[VK_UUID_SIZE];
+		u64 DataSize;
+		u64 DataHash;
+	};
+	
+	struct LVKPipelineCache
+	{
+		VkPipelineCache Cache = VK_NULL_HANDLE;
+		bool bWarm = false; // True if the cache was seeded from disk
+		
+		void Load(VkDevice Device, VkPhysicalDevice PhysicalDevice, const char* Path);
+		bool Save(VkDevice Device, VkPhysicalDevice PhysicalDevice, const char* Path);
+		void Destroy(VkDevice Device);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,482 @@
+#include "LVKPipelineRegistry.hpp"
+#include "LVKBindlessHeap.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKHelpers.hpp"
+
+#include "Base/Hash.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Time.hpp"
+#include "Platform/Platform.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Locus
+{
+	// A self-contained copy of everything a compile needs, safe to hand to a worker.
+	struct LVKPipelineRegistry::CompileRequest
+	{
+		bool bCompute = false;
+		LVKPipelineFactory Factory;
+		LVKComputePipelineFactory ComputeFactory;
+		std::vector<VkVertexInputBindingDescription> Bindings;
+		std::vector<VkVertexInputAttributeDescription> Attributes;
+		std::vector<VkSampleMask> SampleMask;
+		
+		std::vector<VkShaderStageFlagBits> Stages;
+		std::vector<std::vector<u8>> Code;
+		std::vector<std::string> EntryPoints;
+		
+		VkRenderPass RenderPass;
+	};
+	
+	// Appended to a pipeline's full key, the bytes a hash hit is checked against.
+	static void WriteShaderKey(std::vector<u8>& OutKey, const LVKShaderSource& Shader)
+	{
+		const u8* Stage = reinterpret_cast<const u8*>(&Shader.Stage);
+		const u8* CodeSize = reinterpret_cast<const u8*>(&Shader.CodeSize);
+		OutKey.insert(OutKey.end(), Stage, Stage + sizeof(Shader.Stage));
+		OutKey.insert(OutKey.end(), Shader.EntryPoint, Shader.EntryPoint + strlen(Shader.EntryPoint) + 1);
+		OutKey.insert(OutKey.end(), CodeSize, CodeSize + sizeof(Shader.CodeSize));
+		OutKey.insert(OutKey.end(), Shader.Code, Shader.Code + Shader.CodeSize);
+	}
+	
+	VkPipelineLayout LVKPipelineRegistry::AcquireLayout(VkDevice Device, const VkPipelineLayoutCreateInfo& CreateInfo)
+	{
+		// Set layouts are themselves handles, so two layouts are identical if they reference the same set layouts.
+		u64 Key = Hash::FNV1a64Value(CreateInfo.flags);
+		Key = Hash::FNV1a64(CreateInfo.pSetLayouts, sizeof(VkDescriptorSetLayout) * CreateInfo.setLayoutCount, Key);
+		for (u32 i = 0; i < CreateInfo.pushConstantRangeCount; i++)
+		{
+			const VkPushConstantRange& Range = CreateInfo.pPushConstantRanges[i];
+			Key = Hash::FNV1a64Value(Range.stageFlags, Key);
+			Key = Hash::FNV1a64Value(Range.offset, Key);
+			Key = Hash::FNV1a64Value(Range.size, Key);
+		}
+		
+		auto It = m_Layouts.find(Key);
+		if (It != m_Layouts.end())
+		{
+			It->second.RefCount++;
+			return It->second.Handle;
+		}
+		
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		VK_CHECK_RESULT(vkCreatePipelineLayout(Device, &CreateInfo, nullptr, &Layout));
+		
+		m_Layouts[Key] = { Layout, 1 };
+		m_LayoutKeys[Layout] = Key;
+		return Layout;
+	}
+	
+	void LVKPipelineRegistry::ReleaseLayout(VkDevice Device, VkPipelineLayout Layout)
+	{
+		auto KeyIt = m_LayoutKeys.find(Layout);
+		LAssertMsg(KeyIt != m_LayoutKeys.end(), "Releasing a pipeline layout the registry does not own.");
+		
+		auto It = m_Layouts.find(KeyIt->second);
+		if (--It->second.RefCount == 0)
+		{
+			vkDestroyPipelineLayout(Device, Layout, nullptr);
+			m_Layouts.erase(It);
+			m_LayoutKeys.erase(KeyIt);
+		}
+	}
+	
+	VkPipelineLayout LVKPipelineRegistry::AcquireReflectedLayout(VkDevice Device, const LVKShaderSource* Shaders, u32 ShaderCount, LVKReflectedLayout& OutReflected, std::vector<VkDescriptorSetLayout>* OutSetLayouts)
+	{
+		std::vector<const LVKShaderReflection*> Reflections;
+		for (u32 i = 0; i < ShaderCount; i++)
+		{
+			const LVKShaderReflection* Reflection = Reflect(Shaders[i]);
+			if (Reflection == nullptr)
+			{
+				return VK_NULL_HANDLE;
+			}
+			Reflections.push_back(Reflection);
+		}
+		
+		if (!LVK::MergeShaderReflections(Reflections.data(), ShaderCount, OutReflected))
+		{
+			return VK_NULL_HANDLE;
+		}
+		
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+		for (u32 Set = 0; Set < OutReflected.Sets.size(); Set++)
+		{
+			SetLayouts.push_back(GetSetLayout(Device, Set, OutReflected.Sets[Set]));
+			if (SetLayouts.back() == VK_NULL_HANDLE)
+			{
+				return VK_NULL_HANDLE;
+			}
+		}
+		
+		if (OutSetLayouts)
+		{
+			*OutSetLayouts = SetLayouts;
+		}
+		
+		bool bHasPushConstants = OutReflected.PushConstants.size > 0;
+		VkPipelineLayoutCreateInfo CreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.setLayoutCount = static_cast<u32>(SetLayouts.size()),
+			.pSetLayouts = SetLayouts.data(),
+			.pushConstantRangeCount = bHasPushConstants ? 1u : 0u,
+			.pPushConstantRanges = bHasPushConstants ? &OutReflected.PushConstants : nullptr,
+		};
+		
+		return AcquireLayout(Device, CreateInfo);
+	}
+	
+	const LVKShaderReflection* LVKPipelineRegistry::Reflect(const LVKShaderSource& Shader)
+	{
+		u64 Key = Hash::FNV1a64(Shader.Code, Shader.CodeSize);
+		auto It = m_Reflections.find(Key);
+		if (It != m_Reflections.end())
+		{
+			return &It->second;
+		}
+		
+		LVKShaderReflection Reflection;
+		if (!LVK::ReflectShader(Shader.Code, Shader.CodeSize, Reflection))
+		{
+			return nullptr;
+		}
+		
+		if (Reflection.Stage != Shader.Stage)
+		{
+			LLOG(Shaders, Error, "Shader was loaded as %s but its entry point is %s.", string_VkShaderStageFlagBits(Shader.Stage), string_VkShaderStageFlagBits(Reflection.Stage));
+			return nullptr;
+		}
+		
+		return &(m_Reflections[Key] = std::move(Reflection));
+	}
+	
+	VkDescriptorSetLayout LVKPipelineRegistry::GetSetLayout(VkDevice Device, u32 Set, const std::vector<VkDescriptorSetLayoutBinding>& ReflectedBindings)
+	{
+		// Reflection order depends on the shader, sorted so the same set from any shader hashes to the same layout.
+		std::vector<VkDescriptorSetLayoutBinding> Bindings = ReflectedBindings;
+		std::sort(Bindings.begin(), Bindings.end(), [](const VkDescriptorSetLayoutBinding& A, const VkDescriptorSetLayoutBinding& B) {
+			return A.binding < B.binding;
+		});
+		
+		// Only the heap's own set index, anything else is written through the descriptor cache, which can't allocate it.
+		if (Set == BINDLESS_SET && m_BindlessHeap && m_BindlessHeap->MatchesLayout(Bindings))
+		{
+			return m_BindlessHeap->GetLayout();
+		}
+		
+		u64 Key = Hash::FNV1a64Value(Bindings.size());
+		for (const VkDescriptorSetLayoutBinding& Binding : Bindings)
+		{
+			if (Binding.descriptorCount == 0)
+			{
+				LLOG(Shaders, Error, "Binding %u is a runtime sized descriptor array that does not match the bindless heap.", Binding.binding);
+				return VK_NULL_HANDLE;
+			}
+			
+			Key = Hash::FNV1a64Value(Binding.binding, Key);
+			Key = Hash::FNV1a64Value(Binding.descriptorType, Key);
+			Key = Hash::FNV1a64Value(Binding.descriptorCount, Key);
+			Key = Hash::FNV1a64Value(Binding.stageFlags, Key);
+		}
+		
+		auto It = m_SetLayouts.find(Key);
+		if (It != m_SetLayouts.end())
+		{
+			return It->second;
+		}
+		
+		LVKDescriptorLayoutFactory Factory;
+		for (const VkDescriptorSetLayoutBinding& Binding : Bindings)
+		{
+			Factory.Push(Binding.binding, Binding.descriptorType, Binding.descriptorCount, Binding.stageFlags);
+		}
+		
+		VkDescriptorSetLayout SetLayout = Factory.Create(Device, 0);
+		m_SetLayouts[Key] = SetLayout;
+		return SetLayout;
+	}
+	
+	LVKPipelineKey LVKPipelineRegistry::RequestPipeline(VkDevice Device, VkPipelineCache Cache, const LVKPipelineFactory& Factory, const LVKShaderSource* Shaders, u32 ShaderCount, VkRenderPass RenderPass, u64 RenderPassKey, bool bAsync)
+	{
+		LAssertMsg(Factory.ShaderStages.Empty(), "Pipeline registry expects shader stages as sources.");
+		
+		LVKPipelineKey Key = Hash::Combine(Factory.HashState(), RenderPassKey);
+		for (u32 i = 0; i < ShaderCount; i++)
+		{
+			Key = Hash::Combine(Key, HashShader(Shaders[i]));
+		}
+		
+		std::vector<u8> FullKey;
+		Factory.WriteState(FullKey);
+		const u8* RenderPassKeyBytes = reinterpret_cast<const u8*>(&RenderPassKey);
+		FullKey.insert(FullKey.end(), RenderPassKeyBytes, RenderPassKeyBytes + sizeof(RenderPassKey));
+		for (u32 i = 0; i < ShaderCount; i++)
+		{
+			WriteShaderKey(FullKey, Shaders[i]);
+		}
+		
+		if (FindPipeline(Key, FullKey, bAsync))
+		{
+			return Key;
+		}
+		
+		auto Request = std::make_shared<CompileRequest>();
+		Request->Factory = Factory;
+		Request->RenderPass = RenderPass;
+		
+		const VkPipelineVertexInputStateCreateInfo& VertexInput = Factory.VertexInput;
+		Request->Bindings.assign(VertexInput.pVertexBindingDescriptions, VertexInput.pVertexBindingDescriptions + VertexInput.vertexBindingDescriptionCount);
+		Request->Attributes.assign(VertexInput.pVertexAttributeDescriptions, VertexInput.pVertexAttributeDescriptions + VertexInput.vertexAttributeDescriptionCount);
+		Request->Factory.VertexInput.pVertexBindingDescriptions = Request->Bindings.data();
+		Request->Factory.VertexInput.pVertexAttributeDescriptions = Request->Attributes.data();
+		
+		if (Factory.Multisampling.pSampleMask)
+		{
+			arch MaskWords = (Factory.Multisampling.rasterizationSamples + 31) / 32;
+			Request->SampleMask.assign(Factory.Multisampling.pSampleMask, Factory.Multisampling.pSampleMask + MaskWords);
+			Request->Factory.Multisampling.pSampleMask = Request->SampleMask.data();
+		}
+		
+		for (u32 i = 0; i < ShaderCount; i++)
+		{
+			Request->Stages.push_back(Shaders[i].Stage);
+			Request->Code.emplace_back(Shaders[i].Code, Shaders[i].Code + Shaders[i].CodeSize);
+			Request->EntryPoints.emplace_back(Shaders[i].EntryPoint);
+		}
+		
+		Schedule(Device, Cache, Key, std::move(FullKey), std::move(Request), bAsync);
+		return Key;
+	}
+	
+	LVKPipelineKey LVKPipelineRegistry::RequestComputePipeline(VkDevice Device, VkPipelineCache Cache, const LVKComputePipelineFactory& Factory, const LVKShaderSource& Shader, bool bAsync)
+	{
+		LAssertMsg(Shader.Stage == VK_SHADER_STAGE_COMPUTE_BIT, "Compute pipelines take a single compute stage.");
+		
+		LVKPipelineKey Key = Hash::Combine(Factory.HashState(), HashShader(Shader));
+		
+		std::vector<u8> FullKey;
+		Factory.WriteState(FullKey);
+		WriteShaderKey(FullKey, Shader);
+		
+		if (FindPipeline(Key, FullKey, bAsync))
+		{
+			return Key;
+		}
+		
+		auto Request = std::make_shared<CompileRequest>();
+		Request->bCompute = true;
+		Request->ComputeFactory = Factory;
+		Request->RenderPass = VK_NULL_HANDLE;
+		Request->Stages.push_back(Shader.Stage);
+		Request->Code.emplace_back(Shader.Code, Shader.Code + Shader.CodeSize);
+		Request->EntryPoints.emplace_back(Shader.EntryPoint);
+		
+		Schedule(Device, Cache, Key, std::move(FullKey), std::move(Request), bAsync);
+		return Key;
+	}
+	
+	u64 LVKPipelineRegistry::HashShader(const LVKShaderSource& Shader)
+	{
+		u64 ShaderKey = Hash::FNV1a64Value(Shader.Stage);
+		ShaderKey = Hash::FNV1a64String(Shader.EntryPoint, ShaderKey);
+		return Hash::FNV1a64(Shader.Code, Shader.CodeSize, ShaderKey);
+	}
+	
+	bool LVKPipelineRegistry::FindPipeline(LVKPipelineKey& Key, const std::vector<u8>& FullKey, bool bAsync)
+	{
+		if (Key == LVK_PIPELINE_KEY_INVALID)
+		{
+			Key = 1;
+		}
+		
+		// A different pipeline under the same hash moves this one along to the next free key.
+		auto It = m_Pipelines.find(Key);
+		while (It != m_Pipelines.end() && It->second->FullKey != FullKey)
+		{
+			LLOG(Vulkan, Warning, "Pipeline key %llu collides with a different pipeline, trying the next key.", static_cast<unsigned long long>(Key));
+			Key = (Key + 1 == LVK_PIPELINE_KEY_INVALID) ? 1 : Key + 1;
+			It = m_Pipelines.find(Key);
+		}
+		
+		if (It == m_Pipelines.end())
+		{
+			return false;
+		}
+		
+		It->second->RefCount++;
+		m_PipelineHits++;
+		if (!bAsync)
+		{
+			WaitForCompile(*It->second);
+		}
+		return true;
+	}
+	
+	void LVKPipelineRegistry::Schedule(VkDevice Device, VkPipelineCache Cache, LVKPipelineKey Key, std::vector<u8>&& FullKey, std::shared_ptr<CompileRequest>&& Request, bool bAsync)
+	{
+		PipelineEntry& Entry = *(m_Pipelines[Key] = std::make_unique<PipelineEntry>());
+		Entry.FullKey = std::move(FullKey);
+		Entry.RefCount = 1;
+		
+		if (!bAsync)
+		{
+			Compile(Device, Cache, *Request, Entry);
+			return;
+		}
+		
+		// The entry is heap allocated and outlives the job, Destroy and ReleasePipeline wait for it.
+		m_CompilesInFlight++;
+		JobSystem::Get().Submit([this, Device, Cache, Request = std::move(Request), &Entry]() {
+			Compile(Device, Cache, *Request, Entry);
+			m_CompilesInFlight--;
+		});
+	}
+	
+	void LVKPipelineRegistry::Compile(VkDevice Device, VkPipelineCache Cache, CompileRequest& Request, PipelineEntry& Entry)
+	{
+		Clock PipelineClock;
+		PipelineClock.Start();
+		
+		std::vector<VkPipelineShaderStageCreateInfo> ShaderStages;
+		for (arch i = 0; i < Request.Stages.size(); i++)
+		{
+			ShaderStages.push_back({
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.stage = Request.Stages[i],
+				.module = LVK::CreateShaderModule(Device, nullptr, Request.Code[i].data(), Request.Code[i].size()),
+				.pName = Request.EntryPoints[i].c_str(),
+				.pSpecializationInfo = nullptr,
+			});
+		}
+		
+		// VkPipelineCache is internally synchronized, so workers can share it.
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		if (Request.bCompute)
+		{
+			Request.ComputeFactory.ShaderStage = ShaderStages[0];
+			Pipeline = Request.ComputeFactory.Create(Device, Cache);
+		}
+		else
+		{
+			for (const VkPipelineShaderStageCreateInfo& Stage : ShaderStages)
+			{
+				Request.Factory.ShaderStages.Push(Stage);
+			}
+			Pipeline = Request.Factory.Create(Device, Request.RenderPass, Cache);
+		}
+		
+		for (const VkPipelineShaderStageCreateInfo& Stage : ShaderStages)
+		{
+			vkDestroyShaderModule(Device, Stage.module, nullptr);
+		}
+		
+		if (Pipeline == VK_NULL_HANDLE)
+		{
+			Entry.Status = LVKPipelineStatus::Failed;
+			return;
+		}
+		
+		{
+			std::lock_guard<std::mutex> Lock(m_StatsMutex);
+			m_PipelinesCreated++;
+			m_PipelineCreateMilliseconds += PipelineClock.GetElapsedMilliseconds();
+		}
+		
+		// Publish the handle before the status so readers that see Ready also see the handle.
+		Entry.Handle = Pipeline;
+		Entry.Status = LVKPipelineStatus::Ready;
+	}
+	
+	void LVKPipelineRegistry::WaitForCompile(const PipelineEntry& Entry) const
+	{
+		while (Entry.Status.load() == LVKPipelineStatus::Pending)
+		{
+			Platform::SleepThisThread(0);
+		}
+	}
+	
+	void LVKPipelineRegistry::ReleasePipeline(VkDevice Device, LVKPipelineKey Key)
+	{
+		auto It = m_Pipelines.find(Key);
+		LAssertMsg(It != m_Pipelines.end(), "Releasing a pipeline the registry does not own.");
+		
+		PipelineEntry& Entry = *It->second;
+		if (--Entry.RefCount == 0)
+		{
+			// Rare, the last user gave up on a pipeline that is still compiling.
+			WaitForCompile(Entry);
+			vkDestroyPipeline(Device, Entry.Handle.load(), nullptr);
+			m_Pipelines.erase(It);
+		}
+	}
+	
+	VkPipeline LVKPipelineRegistry::TryGetPipeline(LVKPipelineKey Key) const
+	{
+		auto It = m_Pipelines.find(Key);
+		if (It == m_Pipelines.end() || It->second->Status.load() != LVKPipelineStatus::Ready)
+		{
+			return VK_NULL_HANDLE;
+		}
+		return It->second->Handle.load();
+	}
+	
+	LVKPipelineStatus LVKPipelineRegistry::GetPipelineStatus(LVKPipelineKey Key) const
+	{
+		auto It = m_Pipelines.find(Key);
+		return It == m_Pipelines.end() ? LVKPipelineStatus::Failed : It->second->Status.load();
+	}
+	
+	void LVKPipelineRegistry::Destroy(VkDevice Device)
+	{
+		while (m_CompilesInFlight.load() > 0)
+		{
+			Platform::SleepThisThread(1);
+		}
+		
+		if (!m_Pipelines.empty() || !m_Layouts.empty())
+		{
+			LLOG(Vulkan, Warning, "Pipeline registry destroyed with %zu pipelines and %zu layouts still referenced.", m_Pipelines.size(), m_Layouts.size());
+		}
+		
+		for (auto& [Key, Entry] : m_Pipelines)
+		{
+			vkDestroyPipeline(Device, Entry->Handle.load(), nullptr);
+		}
+		
+		for (auto& [Key, Layout] : m_Layouts)
+		{
+			vkDestroyPipelineLayout(Device, Layout.Handle, nullptr);
+		}
+		
+		for (auto& [Key, SetLayout] : m_SetLayouts)
+		{
+			vkDestroyDescriptorSetLayout(Device, SetLayout, nullptr);
+		}
+		
+		m_Pipelines.clear();
+		m_Layouts.clear();
+		m_LayoutKeys.clear();
+		m_SetLayouts.clear();
+		m_Reflections.clear();
+	}
+	
+	u32 LVKPipelineRegistry::GetPipelinesCreated()
+	{
+		std::lock_guard<std::mutex> Lock(m_StatsMutex);
+		return m_PipelinesCreated;
+	}
+	
+	f64 LVKPipelineRegistry::GetPipelineCreateMilliseconds()
+	{
+		std::lock_guard<std::mutex> Lock(m_StatsMutex);
+		return m_PipelineCreateMilliseconds;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKResources.hpp"
+#include "LVKShaderReflection.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Deduplicates pipelines and pipeline layouts across render contexts.
+	
+	A pipeline is keyed by the fixed function state of its factory, the hashes of its SPIR-V
+	stages and the compatibility hash of the render pass it targets (compute pipelines only have
+	the layout and their one stage). Anything that produces
+	the same key shares the same VkPipeline, which is reference counted and destroyed when the
+	last user releases it. Shader modules are only created on a miss. Every entry keeps the bytes
+	its key was hashed from and a hit is checked against them, so two descriptions that collide
+	get separate pipelines under neighbouring keys.
+	
+	Pipelines can be requested asynchronously, in which case the compile runs on the job system
+	and the key becomes usable once TryGetPipeline returns a handle. Until then the caller picks
+	its own fallback, usually skipping the draw or binding a cheaper pipeline it already has.
+*/
+
+namespace Locus
+{
+	using LVKPipelineKey = u64;
+	constexpr LVKPipelineKey LVK_PIPELINE_KEY_INVALID = 0;
+	
+	enum class LVKPipelineStatus : u32
+	{
+		Pending,
+		Ready,
+		Failed,
+	};
+	
+	struct LVKShaderSource
+	{
+		VkShaderStageFlagBits Stage;
+		const u8* Code;
+		arch CodeSize;
+		const char* EntryPoint = "main";
+	};
+	
+	class LVKBindlessHeap;
+	
+	struct LVKPipelineRegistry
+	{
+		// Reflected sets at BINDLESS_SET that match the heap's bindings use its layout instead of a new one.
+		void SetBindlessHeap(const LVKBindlessHeap* Heap) { m_BindlessHeap = Heap; }
+		
+		VkPipelineLayout AcquireLayout(VkDevice Device, const VkPipelineLayoutCreateInfo& CreateInfo);
+		void ReleaseLayout(VkDevice Device, VkPipelineLayout Layout);
+		
+		// Reflects each stage, cached by code hash, and builds the layout from the merged result.
+		// Returns VK_NULL_HANDLE if the stages disagree. Release the layout with ReleaseLayout.
+		// The set layouts belong to the registry and live as long as it does.
+		VkPipelineLayout AcquireReflectedLayout(VkDevice Device, const LVKShaderSource* Shaders, u32 ShaderCount, LVKReflectedLayout& OutReflected, std::vector<VkDescriptorSetLayout>* OutSetLayouts = nullptr);
+		
+		// Factory.ShaderStages must be empty, the registry builds them from Shaders on a miss.
+		// Everything the factory and sources point to is copied, so they can go away once this returns.
+		// For dynamic rendering pass no render pass and a zero key, the factory's attachment formats are hashed instead.
+		LVKPipelineKey RequestPipeline(VkDevice Device, VkPipelineCache Cache, const LVKPipelineFactory& Factory, const LVKShaderSource* Shaders, u32 ShaderCount, VkRenderPass RenderPass, u64 RenderPassKey, bool bAsync);
+		
+		// Same rules as RequestPipeline, Factory.ShaderStage is filled in from Shader on a miss.
+		LVKPipelineKey RequestComputePipeline(VkDevice Device, VkPipelineCache Cache, const LVKComputePipelineFactory& Factory, const LVKShaderSource& Shader, bool bAsync);
+		void ReleasePipeline(VkDevice Device, LVKPipelineKey Key);
+		
+		// Non-blocking, returns VK_NULL_HANDLE while the pipeline is pending or if it failed to compile.
+		VkPipeline TryGetPipeline(LVKPipelineKey Key) const;
+		LVKPipelineStatus GetPipelineStatus(LVKPipelineKey Key) const;
+		
+		void Destroy(VkDevice Device);
+		
+		u32 GetPipelinesCreated();
+		u32 GetPipelineHits() const { return m_PipelineHits; }
+		u32 GetCompilesInFlight() const { return m_CompilesInFlight.load(); }
+		f64 GetPipelineCreateMilliseconds();
+	
+	private:
+		struct PipelineEntry
+		{
+			std::atomic<VkPipeline> Handle {VK_NULL_HANDLE};
+			std::atomic<LVKPipelineStatus> Status {LVKPipelineStatus::Pending};
+			u32 RefCount = 0;
+			std::vector<u8> FullKey; // Everything the key hashes, compared on a hit
+		};
+		
+		struct LayoutEntry
+		{
+			VkPipelineLayout Handle;
+			u32 RefCount;
+		};
+		
+		struct CompileRequest;
+		static u64 HashShader(const LVKShaderSource& Shader);
+		bool FindPipeline(LVKPipelineKey& Key, const std::vector<u8>& FullKey, bool bAsync); // Takes a reference on a hit, remaps the invalid key and collisions
+		void Schedule(VkDevice Device, VkPipelineCache Cache, LVKPipelineKey Key, std::vector<u8>&& FullKey, std::shared_ptr<CompileRequest>&& Request, bool bAsync);
+		void Compile(VkDevice Device, VkPipelineCache Cache, CompileRequest& Request, PipelineEntry& Entry);
+		void WaitForCompile(const PipelineEntry& Entry) const;
+		
+		const LVKShaderReflection* Reflect(const LVKShaderSource& Shader);
+		VkDescriptorSetLayout GetSetLayout(VkDevice Device, u32 Set, const std::vector<VkDescriptorSetLayoutBinding>& ReflectedBindings);
+		
+		const LVKBindlessHeap* m_BindlessHeap = nullptr;
+		std::unordered_map<u64, LVKShaderReflection> m_Reflections;
+		std::unordered_map<u64, VkDescriptorSetLayout> m_SetLayouts; // Kept for the registry's lifetime
+		std::unordered_map<u64, LayoutEntry> m_Layouts;
+		std::unordered_map<VkPipelineLayout, u64> m_LayoutKeys;
+		std::unordered_map<LVKPipelineKey, Unique<PipelineEntry>> m_Pipelines;
+		
+		std::atomic<u32> m_CompilesInFlight {0};
+		u32 m_PipelineHits = 0;
+		
+		std::mutex m_StatsMutex;
+		u32 m_PipelinesCreated = 0;
+		f64 m_PipelineCreateMilliseconds = 0.0;
+	};
+}
\ No newline at end of file
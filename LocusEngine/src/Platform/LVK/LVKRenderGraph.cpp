@@ -0,0 +1,880 @@
+#include "LVKRenderGraph.hpp"
+
+#include "Base/Asserts.hpp"
+#include "Base/Hash.hpp"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace Locus
+{
+	struct LVKGraphAccessInfo
+	{
+		VkPipelineStageFlags2 Stages;
+		VkAccessFlags2 Access;
+		VkImageLayout Layout;
+		VkImageUsageFlags ImageUsage;
+		VkBufferUsageFlags BufferUsage;
+		bool bCanWrite;
+	};
+	
+	// Indexed by LVKGraphAccess.
+	static constexpr LVKGraphAccessInfo ACCESS_INFO[] = {
+		{ // ColorAttachment
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, true
+		},
+		{ // DepthAttachment
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, true
+		},
+		{ // DepthRead
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, false
+		},
+		{ // SampledRead
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, false
+		},
+		{ // StorageRead
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false
+		},
+		{ // StorageWrite
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true
+		},
+		{ // TransferSrc
+			VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false
+		},
+		{ // TransferDst
+			VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+			VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, true
+		},
+		{ // IndirectRead
+			VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+			VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false
+		},
+		{ // VertexRead
+			VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+			VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false
+		},
+		{ // UniformRead
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_UNIFORM_READ_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false
+		},
+	};
+	static_assert(std::size(ACCESS_INFO) == static_cast<arch>(LVKGraphAccess::Count));
+	
+	static constexpr VkAccessFlags2 WRITE_ACCESS_MASK =
+		VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+	
+	static const LVKGraphAccessInfo& GetAccessInfo(LVKGraphAccess Access)
+	{
+		return ACCESS_INFO[static_cast<u32>(Access)];
+	}
+	
+	static VkImageAspectFlags AspectFromFormat(VkFormat Format)
+	{
+		switch (Format)
+		{
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			case VK_FORMAT_S8_UINT:
+				return VK_IMAGE_ASPECT_STENCIL_BIT;
+			default:
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+	
+	static VkDeviceSize AlignUp(VkDeviceSize Value, VkDeviceSize Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+	
+	LVKGraphPassBuilder& LVKGraphPassBuilder::Read(LVKGraphResource Resource, LVKGraphAccess Access)
+	{
+		LAssert(Resource < Graph->m_Resources.size());
+		
+		auto& Usages = Graph->m_Passes[Pass].Usages;
+		auto It = std::find_if(Usages.begin(), Usages.end(), [=](const auto& Usage) { return Usage.Resource == Resource; });
+		if (It == Usages.end())
+		{
+			Usages.push_back({ Resource, Access, true, false });
+			return *this;
+		}
+		
+		LAssertMsg(It->Access == Access, "A pass can only use a resource one way.");
+		It->bRead = true;
+		return *this;
+	}
+	
+	LVKGraphPassBuilder& LVKGraphPassBuilder::Write(LVKGraphResource Resource, LVKGraphAccess Access)
+	{
+		LAssert(Resource < Graph->m_Resources.size());
+		LAssertMsg(GetAccessInfo(Access).bCanWrite, "Access does not write.");
+		
+		auto& Usages = Graph->m_Passes[Pass].Usages;
+		auto It = std::find_if(Usages.begin(), Usages.end(), [=](const auto& Usage) { return Usage.Resource == Resource; });
+		if (It == Usages.end())
+		{
+			Usages.push_back({ Resource, Access, false, true });
+			return *this;
+		}
+		
+		LAssertMsg(It->Access == Access, "A pass can only use a resource one way.");
+		It->bWrite = true;
+		return *this;
+	}
+	
+	LVKGraphPassBuilder& LVKGraphPassBuilder::SideEffects()
+	{
+		Graph->m_Passes[Pass].bSideEffects = true;
+		return *this;
+	}
+	
+	void LVKRenderGraph::Init(VkDevice Device, VmaAllocator Allocator, std::function<void(std::function<void()>&&)>&& Retire)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		m_Retire = std::move(Retire);
+	}
+	
+	void LVKRenderGraph::Destroy()
+	{
+		Reset();
+		
+		for (PhysicalResource& Physical : m_Physical)
+		{
+			vkDestroyImageView(m_Device, Physical.View, nullptr);
+			vkDestroyImage(m_Device, Physical.Image, nullptr);
+			vkDestroyBuffer(m_Device, Physical.Buffer, nullptr);
+			if (Physical.DedicatedAllocation != VK_NULL_HANDLE)
+			{
+				vmaFreeMemory(m_Allocator, Physical.DedicatedAllocation);
+			}
+		}
+		
+		if (m_TransientMemory != VK_NULL_HANDLE)
+		{
+			vmaFreeMemory(m_Allocator, m_TransientMemory);
+		}
+		
+		m_Physical.clear();
+		m_TransientMemory = VK_NULL_HANDLE;
+		m_PhysicalHash = 0;
+	}
+	
+	void LVKRenderGraph::Reset()
+	{
+		m_Passes.clear();
+		m_Resources.clear();
+		m_Order.clear();
+		m_FinalBarriers.clear();
+	}
+	
+	LVKGraphResource LVKRenderGraph::AddResource(Resource&& NewResource)
+	{
+		m_Resources.push_back(std::move(NewResource));
+		return static_cast<LVKGraphResource>(m_Resources.size() - 1);
+	}
+	
+	LVKGraphResource LVKRenderGraph::ImportImage(const char* Name, VkImage Image, VkImageView View, VkFormat Format, VkExtent3D Extent, const LVKGraphResourceState& Initial, VkImageLayout FinalLayout)
+	{
+		Resource NewResource;
+		NewResource.Name = Name;
+		NewResource.bImported = true;
+		NewResource.ImageDesc.Format = Format;
+		NewResource.ImageDesc.Extent = Extent;
+		NewResource.Initial = Initial;
+		NewResource.FinalLayout = FinalLayout;
+		NewResource.Image = Image;
+		NewResource.View = View;
+		return AddResource(std::move(NewResource));
+	}
+	
+	LVKGraphResource LVKRenderGraph::ImportBuffer(const char* Name, VkBuffer Buffer, VkDeviceSize Size, const LVKGraphResourceState& Initial)
+	{
+		Resource NewResource;
+		NewResource.Name = Name;
+		NewResource.bImage = false;
+		NewResource.bImported = true;
+		NewResource.BufferDesc.Size = Size;
+		NewResource.Initial = Initial;
+		NewResource.Buffer = Buffer;
+		return AddResource(std::move(NewResource));
+	}
+	
+	LVKGraphResource LVKRenderGraph::CreateImage(const char* Name, const LVKGraphImageDesc& Desc)
+	{
+		Resource NewResource;
+		NewResource.Name = Name;
+		NewResource.ImageDesc = Desc;
+		return AddResource(std::move(NewResource));
+	}
+	
+	LVKGraphResource LVKRenderGraph::CreateBuffer(const char* Name, const LVKGraphBufferDesc& Desc)
+	{
+		Resource NewResource;
+		NewResource.Name = Name;
+		NewResource.bImage = false;
+		NewResource.BufferDesc = Desc;
+		return AddResource(std::move(NewResource));
+	}
+	
+	LVKGraphPassBuilder LVKRenderGraph::AddPass(const char* Name, LVKGraphExecuteFn&& Execute)
+	{
+		Pass NewPass;
+		NewPass.Name = Name;
+		NewPass.Execute = std::move(Execute);
+		m_Passes.push_back(std::move(NewPass));
+		return { this, static_cast<u32>(m_Passes.size() - 1) };
+	}
+	
+	void LVKRenderGraph::Compile()
+	{
+		LAssertMsg(m_Order.empty(), "Compile once per Reset.");
+		
+		m_Stats = {};
+		m_Stats.Passes = static_cast<u32>(m_Passes.size());
+		
+		Cull();
+		ComputeLifetimes();
+		AllocateTransients();
+		BuildBarriers();
+	}
+	
+	void LVKRenderGraph::Cull()
+	{
+		// Passes only ever read what earlier passes wrote, so declaration order is already a valid order.
+		std::vector<u32> LastWriter(m_Resources.size(), UINT32_MAX);
+		std::vector<u32> Stack;
+		
+		for (u32 i = 0; i < m_Passes.size(); i++)
+		{
+			Pass& CurrentPass = m_Passes[i];
+			bool bRoot = CurrentPass.bSideEffects;
+			
+			for (const Usage& Use : CurrentPass.Usages)
+			{
+				if (Use.bRead && LastWriter[Use.Resource] != UINT32_MAX)
+				{
+					CurrentPass.Dependencies.push_back(LastWriter[Use.Resource]);
+				}
+			}
+			
+			for (const Usage& Use : CurrentPass.Usages)
+			{
+				if (Use.bWrite)
+				{
+					LastWriter[Use.Resource] = i;
+					bRoot |= m_Resources[Use.Resource].bImported;
+				}
+			}
+			
+			if (bRoot)
+			{
+				CurrentPass.bLive = true;
+				Stack.push_back(i);
+			}
+		}
+		
+		while (!Stack.empty())
+		{
+			u32 Index = Stack.back();
+			Stack.pop_back();
+			
+			for (u32 Dependency : m_Passes[Index].Dependencies)
+			{
+				if (!m_Passes[Dependency].bLive)
+				{
+					m_Passes[Dependency].bLive = true;
+					Stack.push_back(Dependency);
+				}
+			}
+		}
+		
+		for (u32 i = 0; i < m_Passes.size(); i++)
+		{
+			if (m_Passes[i].bLive)
+			{
+				m_Order.push_back(i);
+			}
+			else
+			{
+				m_Stats.CulledPasses++;
+			}
+		}
+	}
+	
+	void LVKRenderGraph::ComputeLifetimes()
+	{
+		for (u32 Position = 0; Position < m_Order.size(); Position++)
+		{
+			for (const Usage& Use : m_Passes[m_Order[Position]].Usages)
+			{
+				Resource& Res = m_Resources[Use.Resource];
+				Res.FirstPass = std::min(Res.FirstPass, Position);
+				Res.LastPass = std::max(Res.LastPass, Position);
+				
+				const LVKGraphAccessInfo& Info = GetAccessInfo(Use.Access);
+				LAssertMsg(Res.bImage ? Info.ImageUsage != 0 : Info.BufferUsage != 0, "Access does not apply to this kind of resource.");
+				if (Res.bImage)
+				{
+					Res.ImageDesc.Usage |= Info.ImageUsage;
+				}
+				else
+				{
+					Res.BufferDesc.Usage |= Info.BufferUsage;
+				}
+			}
+		}
+	}
+	
+	u64 LVKRenderGraph::HashTransients() const
+	{
+		u64 Key = Hash::FNV1A_OFFSET_BASIS;
+		for (const Resource& Res : m_Resources)
+		{
+			if (Res.bImported || Res.FirstPass == UINT32_MAX)
+			{
+				continue;
+			}
+			
+			Key = Hash::FNV1a64Value(Res.bImage, Key);
+			Key = Hash::FNV1a64Value(Res.FirstPass, Key);
+			Key = Hash::FNV1a64Value(Res.LastPass, Key);
+			if (Res.bImage)
+			{
+				Key = Hash::FNV1a64Value(Res.ImageDesc.Format, Key);
+				Key = Hash::FNV1a64Value(Res.ImageDesc.Extent, Key);
+				Key = Hash::FNV1a64Value(Res.ImageDesc.MipLevels, Key);
+				Key = Hash::FNV1a64Value(Res.ImageDesc.Usage, Key);
+			}
+			else
+			{
+				Key = Hash::FNV1a64Value(Res.BufferDesc.Size, Key);
+				Key = Hash::FNV1a64Value(Res.BufferDesc.Usage, Key);
+			}
+		}
+		return Key;
+	}
+	
+	void LVKRenderGraph::DestroyPhysical()
+	{
+		if (m_Physical.empty() && m_TransientMemory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		m_Retire([Device = m_Device, Allocator = m_Allocator, Physical = m_Physical, Memory = m_TransientMemory](){
+			for (const PhysicalResource& Res : Physical)
+			{
+				vkDestroyImageView(Device, Res.View, nullptr);
+				vkDestroyImage(Device, Res.Image, nullptr);
+				vkDestroyBuffer(Device, Res.Buffer, nullptr);
+				if (Res.DedicatedAllocation != VK_NULL_HANDLE)
+				{
+					vmaFreeMemory(Allocator, Res.DedicatedAllocation);
+				}
+			}
+			
+			if (Memory != VK_NULL_HANDLE)
+			{
+				vmaFreeMemory(Allocator, Memory);
+			}
+		});
+		
+		m_Physical.clear();
+		m_TransientMemory = VK_NULL_HANDLE;
+	}
+	
+	void LVKRenderGraph::AllocateTransients()
+	{
+		std::vector<u32> Transients;
+		for (u32 i = 0; i < m_Resources.size(); i++)
+		{
+			if (!m_Resources[i].bImported && m_Resources[i].FirstPass != UINT32_MAX)
+			{
+				Transients.push_back(i);
+			}
+		}
+		
+		u64 Key = HashTransients();
+		bool bReuse = (Key == m_PhysicalHash && m_Physical.size() == Transients.size());
+		
+		if (!bReuse)
+		{
+			DestroyPhysical();
+			m_PhysicalHash = Key;
+			m_DebugResources.clear();
+			m_DebugHeapSize = 0;
+			
+			// Create everything unbound first, placement needs the memory requirements.
+			
+			std::vector<VkMemoryRequirements> Requirements(Transients.size());
+			m_Physical.resize(Transients.size());
+			
+			for (u32 i = 0; i < Transients.size(); i++)
+			{
+				const Resource& Res = m_Resources[Transients[i]];
+				if (Res.bImage)
+				{
+					VkImageCreateInfo ImageInfo = LVKImage::CreateInfo(Res.ImageDesc.Format, Res.ImageDesc.Usage, Res.ImageDesc.Extent);
+					ImageInfo.mipLevels = Res.ImageDesc.MipLevels;
+					VK_CHECK_RESULT(vkCreateImage(m_Device, &ImageInfo, nullptr, &m_Physical[i].Image));
+					vkGetImageMemoryRequirements(m_Device, m_Physical[i].Image, &Requirements[i]);
+				}
+				else
+				{
+					VkBufferCreateInfo BufferInfo = {
+						.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+						.pNext = nullptr,
+						.size = Res.BufferDesc.Size,
+						.usage = Res.BufferDesc.Usage,
+					};
+					VK_CHECK_RESULT(vkCreateBuffer(m_Device, &BufferInfo, nullptr, &m_Physical[i].Buffer));
+					vkGetBufferMemoryRequirements(m_Device, m_Physical[i].Buffer, &Requirements[i]);
+				}
+			}
+			
+			// Biggest first, each at the lowest offset that doesn't collide with a placed resource
+			// whose lifetime overlaps. Buffers and images can share a range, so everything is kept
+			// apart by the buffer-image granularity as well as its own alignment.
+			
+			const VkPhysicalDeviceProperties* Properties = nullptr;
+			vmaGetPhysicalDeviceProperties(m_Allocator, &Properties);
+			VkDeviceSize Granularity = Properties->limits.bufferImageGranularity;
+			
+			std::vector<u32> PlacementOrder(Transients.size());
+			for (u32 i = 0; i < PlacementOrder.size(); i++)
+			{
+				PlacementOrder[i] = i;
+			}
+			std::sort(PlacementOrder.begin(), PlacementOrder.end(), [&](u32 A, u32 B) { return Requirements[A].size > Requirements[B].size; });
+			
+			VmaAllocationCreateInfo AllocInfo = {
+				.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+				.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			};
+			
+			u32 MemoryTypeBits = UINT32_MAX;
+			VkDeviceSize HeapAlignment = 1;
+			VkDeviceSize HeapSize = 0;
+			std::vector<u32> Placed;
+			std::vector<u32> Overlapping;
+			
+			for (u32 Index : PlacementOrder)
+			{
+				const Resource& Res = m_Resources[Transients[Index]];
+				PhysicalResource& Physical = m_Physical[Index];
+				const VkMemoryRequirements& Required = Requirements[Index];
+				VkDeviceSize Alignment = std::max(Required.alignment, Granularity);
+				Physical.Size = AlignUp(Required.size, Granularity);
+				
+				if ((MemoryTypeBits & Required.memoryTypeBits) == 0)
+				{
+					// Can't share the block's memory type, gets memory of its own.
+					VK_CHECK_RESULT(vmaAllocateMemory(m_Allocator, &Required, &AllocInfo, &Physical.DedicatedAllocation, nullptr));
+					continue;
+				}
+				MemoryTypeBits &= Required.memoryTypeBits;
+				
+				Overlapping.clear();
+				for (u32 Other : Placed)
+				{
+					const Resource& OtherRes = m_Resources[Transients[Other]];
+					if (Res.FirstPass <= OtherRes.LastPass && OtherRes.FirstPass <= Res.LastPass)
+					{
+						Overlapping.push_back(Other);
+					}
+				}
+				std::sort(Overlapping.begin(), Overlapping.end(), [&](u32 A, u32 B) { return m_Physical[A].Offset < m_Physical[B].Offset; });
+				
+				VkDeviceSize Offset = 0;
+				for (u32 Other : Overlapping)
+				{
+					if (AlignUp(Offset, Alignment) + Physical.Size <= m_Physical[Other].Offset)
+					{
+						break;
+					}
+					Offset = std::max(Offset, m_Physical[Other].Offset + m_Physical[Other].Size);
+				}
+				
+				Physical.Offset = AlignUp(Offset, Alignment);
+				HeapSize = std::max(HeapSize, Physical.Offset + Physical.Size);
+				HeapAlignment = std::max(HeapAlignment, Alignment);
+				Placed.push_back(Index);
+			}
+			
+			if (HeapSize > 0)
+			{
+				VkMemoryRequirements HeapRequirements = {
+					.size = HeapSize,
+					.alignment = HeapAlignment,
+					.memoryTypeBits = MemoryTypeBits,
+				};
+				VK_CHECK_RESULT(vmaAllocateMemory(m_Allocator, &HeapRequirements, &AllocInfo, &m_TransientMemory, nullptr));
+			}
+			m_DebugHeapSize = HeapSize;
+			
+			for (u32 i = 0; i < Transients.size(); i++)
+			{
+				const Resource& Res = m_Resources[Transients[i]];
+				PhysicalResource& Physical = m_Physical[i];
+				bool bDedicated = Physical.DedicatedAllocation != VK_NULL_HANDLE;
+				VmaAllocation Memory = bDedicated ? Physical.DedicatedAllocation : m_TransientMemory;
+				VkDeviceSize Offset = bDedicated ? 0 : Physical.Offset;
+				
+				if (Res.bImage)
+				{
+					VK_CHECK_RESULT(vmaBindImageMemory2(m_Allocator, Memory, Offset, Physical.Image, nullptr));
+					
+					VkImageAspectFlags Aspect = AspectFromFormat(Res.ImageDesc.Format);
+					VkImageViewCreateInfo ViewInfo = LVKImage::ViewCreateInfo(Res.ImageDesc.Format, Physical.Image, (Aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : Aspect);
+					VK_CHECK_RESULT(vkCreateImageView(m_Device, &ViewInfo, nullptr, &Physical.View));
+				}
+				else
+				{
+					VK_CHECK_RESULT(vmaBindBufferMemory2(m_Allocator, Memory, Offset, Physical.Buffer, nullptr));
+				}
+				
+				m_DebugResources.push_back({ Res.Name, Res.FirstPass, Res.LastPass, Physical.Offset, Physical.Size, bDedicated });
+			}
+		}
+		
+		for (u32 i = 0; i < Transients.size(); i++)
+		{
+			Resource& Res = m_Resources[Transients[i]];
+			Res.Physical = i;
+			Res.Image = m_Physical[i].Image;
+			Res.View = m_Physical[i].View;
+			Res.Buffer = m_Physical[i].Buffer;
+			
+			m_Stats.TransientBytes += m_Physical[i].Size;
+			if (m_Physical[i].DedicatedAllocation != VK_NULL_HANDLE)
+			{
+				m_Stats.AllocatedBytes += m_Physical[i].Size;
+			}
+		}
+		
+		m_Stats.TransientResources = static_cast<u32>(Transients.size());
+		m_Stats.AllocatedBytes += m_DebugHeapSize;
+	}
+	
+	void LVKRenderGraph::BuildBarriers()
+	{
+		// Per resource: the last write (or layout transition), the reads since, and which stages
+		// and accesses have already been made to wait for that write.
+		struct TrackedState
+		{
+			VkPipelineStageFlags2 WriteStages;
+			VkAccessFlags2 WriteAccess;
+			VkPipelineStageFlags2 ReadStages;
+			VkPipelineStageFlags2 SyncedStages;
+			VkAccessFlags2 VisibleAccess;
+			VkImageLayout Layout;
+		};
+		
+		std::vector<TrackedState> States(m_Resources.size());
+		for (u32 i = 0; i < m_Resources.size(); i++)
+		{
+			// A transient's memory may have last been used by anything, including the previous frame,
+			// so its first barrier waits on all earlier work. Its contents are discarded regardless.
+			LVKGraphResourceState Initial = m_Resources[i].bImported ? m_Resources[i].Initial : LVKGraphResourceState{};
+			States[i] = { Initial.Stages, Initial.Access, 0, 0, 0, Initial.Layout };
+		}
+		
+		m_DebugPasses.clear();
+		
+		for (Pass& CurrentPass : m_Passes)
+		{
+			DebugPass& Debug = m_DebugPasses.emplace_back(DebugPass{ CurrentPass.Name, !CurrentPass.bLive, {} });
+			if (!CurrentPass.bLive)
+			{
+				continue;
+			}
+			
+			for (const Usage& Use : CurrentPass.Usages)
+			{
+				const Resource& Res = m_Resources[Use.Resource];
+				const LVKGraphAccessInfo& Info = GetAccessInfo(Use.Access);
+				TrackedState& State = States[Use.Resource];
+				VkImageLayout OldLayout = State.Layout;
+				
+				bool bLayoutChange = Res.bImage && State.Layout != Info.Layout;
+				VkPipelineStageFlags2 SrcStages = 0;
+				VkAccessFlags2 SrcAccess = 0;
+				bool bBarrier = false;
+				
+				if (Use.bWrite || bLayoutChange)
+				{
+					// Write after write and write after read, a transition counts as a write.
+					SrcStages = State.WriteStages | State.ReadStages;
+					SrcAccess = State.WriteAccess;
+					bBarrier = SrcStages != 0 || bLayoutChange;
+					
+					if (Use.bWrite)
+					{
+						State = { Info.Stages, Info.Access & WRITE_ACCESS_MASK, 0, 0, 0, Info.Layout };
+					}
+					else
+					{
+						State = { Info.Stages, 0, Info.Stages, Info.Stages, Info.Access, Info.Layout };
+					}
+				}
+				else if (State.WriteStages != 0 && ((Info.Stages & ~State.SyncedStages) != 0 || (Info.Access & ~State.VisibleAccess) != 0))
+				{
+					// Read after write. Further reads only need a barrier for stages or accesses not yet covered.
+					SrcStages = State.WriteStages;
+					SrcAccess = State.WriteAccess;
+					bBarrier = true;
+					State.SyncedStages |= Info.Stages;
+					State.VisibleAccess |= Info.Access;
+				}
+				
+				if (!Use.bWrite)
+				{
+					State.ReadStages |= Info.Stages;
+				}
+				
+				if (!bBarrier)
+				{
+					continue;
+				}
+				
+				if (Res.bImage)
+				{
+					CurrentPass.ImageBarriers.push_back(LVKImage::MemoryBarrier2(Res.Image, AspectFromFormat(Res.ImageDesc.Format), SrcStages, SrcAccess, Info.Stages, Info.Access, OldLayout, Info.Layout));
+				}
+				else
+				{
+					CurrentPass.BufferBarriers.push_back({
+						.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+						.pNext = nullptr,
+						.srcStageMask = SrcStages,
+						.srcAccessMask = SrcAccess,
+						.dstStageMask = Info.Stages,
+						.dstAccessMask = Info.Access,
+						.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.buffer = Res.Buffer,
+						.offset = 0,
+						.size = VK_WHOLE_SIZE,
+					});
+				}
+				
+				Debug.Barriers.push_back({ Res.Name, Res.bImage, OldLayout, Res.bImage ? Info.Layout : OldLayout, SrcStages, Info.Stages });
+			}
+			
+			u32 BarrierCount = static_cast<u32>(CurrentPass.ImageBarriers.size() + CurrentPass.BufferBarriers.size());
+			m_Stats.Barriers += BarrierCount;
+			m_Stats.BarrierBatches += BarrierCount > 0 ? 1 : 0;
+		}
+		
+		// Imported images end up where the caller asked, ready for whatever follows the graph.
+		
+		DebugPass FinalDebug = { "End of graph", false, {} };
+		for (u32 i = 0; i < m_Resources.size(); i++)
+		{
+			const Resource& Res = m_Resources[i];
+			const TrackedState& State = States[i];
+			if (!Res.bImported || !Res.bImage || Res.FinalLayout == VK_IMAGE_LAYOUT_UNDEFINED || Res.FinalLayout == State.Layout)
+			{
+				continue;
+			}
+			
+			VkPipelineStageFlags2 SrcStages = State.WriteStages | State.ReadStages;
+			m_FinalBarriers.push_back(LVKImage::MemoryBarrier2(Res.Image, AspectFromFormat(Res.ImageDesc.Format), SrcStages, State.WriteAccess, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, 0, State.Layout, Res.FinalLayout));
+			FinalDebug.Barriers.push_back({ Res.Name, true, State.Layout, Res.FinalLayout, SrcStages, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT });
+		}
+		
+		if (!m_FinalBarriers.empty())
+		{
+			m_Stats.Barriers += static_cast<u32>(m_FinalBarriers.size());
+			m_Stats.BarrierBatches++;
+			m_DebugPasses.push_back(std::move(FinalDebug));
+		}
+	}
+	
+	void LVKRenderGraph::Execute(VkCommandBuffer Cmd)
+	{
+		for (u32 Index : m_Order)
+		{
+			const Pass& CurrentPass = m_Passes[Index];
+			if (!CurrentPass.ImageBarriers.empty() || !CurrentPass.BufferBarriers.empty())
+			{
+				VkDependencyInfo Dependency = {
+					.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+					.pNext = nullptr,
+					.dependencyFlags = 0,
+					.bufferMemoryBarrierCount = static_cast<u32>(CurrentPass.BufferBarriers.size()),
+					.pBufferMemoryBarriers = CurrentPass.BufferBarriers.data(),
+					.imageMemoryBarrierCount = static_cast<u32>(CurrentPass.ImageBarriers.size()),
+					.pImageMemoryBarriers = CurrentPass.ImageBarriers.data(),
+				};
+				vkCmdPipelineBarrier2(Cmd, &Dependency);
+			}
+			
+			CurrentPass.Execute(Cmd, *this);
+		}
+		
+		if (!m_FinalBarriers.empty())
+		{
+			VkDependencyInfo Dependency = {
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.pNext = nullptr,
+				.dependencyFlags = 0,
+				.imageMemoryBarrierCount = static_cast<u32>(m_FinalBarriers.size()),
+				.pImageMemoryBarriers = m_FinalBarriers.data(),
+			};
+			vkCmdPipelineBarrier2(Cmd, &Dependency);
+		}
+	}
+	
+	VkImage LVKRenderGraph::GetImage(LVKGraphResource Resource) const
+	{
+		LAssert(Resource < m_Resources.size() && m_Resources[Resource].bImage);
+		return m_Resources[Resource].Image;
+	}
+	
+	VkImageView LVKRenderGraph::GetImageView(LVKGraphResource Resource) const
+	{
+		LAssert(Resource < m_Resources.size() && m_Resources[Resource].bImage);
+		return m_Resources[Resource].View;
+	}
+	
+	VkExtent3D LVKRenderGraph::GetImageExtent(LVKGraphResource Resource) const
+	{
+		LAssert(Resource < m_Resources.size() && m_Resources[Resource].bImage);
+		return m_Resources[Resource].ImageDesc.Extent;
+	}
+	
+	VkBuffer LVKRenderGraph::GetBuffer(LVKGraphResource Resource) const
+	{
+		LAssert(Resource < m_Resources.size() && !m_Resources[Resource].bImage);
+		return m_Resources[Resource].Buffer;
+	}
+	
+	static const char* LayoutName(VkImageLayout Layout)
+	{
+		static constexpr const char* PREFIX = "VK_IMAGE_LAYOUT_";
+		const char* Name = string_VkImageLayout(Layout);
+		return strncmp(Name, PREFIX, strlen(PREFIX)) == 0 ? Name + strlen(PREFIX) : Name;
+	}
+	
+	void LVKRenderGraph::DrawDebugWindow(bool* bOpen) const
+	{
+		if (!ImGui::Begin("Render Graph", bOpen))
+		{
+			ImGui::End();
+			return;
+		}
+		
+		const f64 KB = 1024.0;
+		ImGui::Text("Passes: %u, %u culled", m_Stats.Passes, m_Stats.CulledPasses);
+		ImGui::Text("Barriers: %u in %u batches", m_Stats.Barriers, m_Stats.BarrierBatches);
+		ImGui::Text("Transients: %u, %.1lfKB in %.1lfKB, %.1lfKB saved by aliasing",
+			m_Stats.TransientResources, m_Stats.TransientBytes / KB, m_Stats.AllocatedBytes / KB,
+			(m_Stats.TransientBytes - std::min(m_Stats.TransientBytes, m_Stats.AllocatedBytes)) / KB);
+		
+		if (ImGui::CollapsingHeader("Passes", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			for (u32 i = 0; i < m_DebugPasses.size(); i++)
+			{
+				const DebugPass& Debug = m_DebugPasses[i];
+				ImGui::PushID(static_cast<i32>(i));
+				
+				if (Debug.bCulled)
+				{
+					ImGui::TextDisabled("%s (culled)", Debug.Name.c_str());
+				}
+				else if (ImGui::TreeNodeEx(Debug.Name.c_str(), Debug.Barriers.empty() ? ImGuiTreeNodeFlags_Leaf : ImGuiTreeNodeFlags_DefaultOpen, "%s (%u barriers)", Debug.Name.c_str(), static_cast<u32>(Debug.Barriers.size())))
+				{
+					for (const DebugBarrier& Barrier : Debug.Barriers)
+					{
+						if (Barrier.bImage)
+						{
+							ImGui::BulletText("%s: %s -> %s", Barrier.Resource.c_str(), LayoutName(Barrier.OldLayout), LayoutName(Barrier.NewLayout));
+						}
+						else
+						{
+							ImGui::BulletText("%s: buffer", Barrier.Resource.c_str());
+						}
+						
+						if (ImGui::IsItemHovered())
+						{
+							ImGui::SetTooltip("Src stages 0x%llx\nDst stages 0x%llx", (unsigned long long)Barrier.SrcStages, (unsigned long long)Barrier.DstStages);
+						}
+					}
+					ImGui::TreePop();
+				}
+				
+				ImGui::PopID();
+			}
+		}
+		
+		if (ImGui::CollapsingHeader("Transient Memory", ImGuiTreeNodeFlags_DefaultOpen) && m_DebugHeapSize > 0)
+		{
+			// Passes run left to right, memory offsets top to bottom. Boxes that share rows are aliased.
+			
+			u32 LivePasses = std::max(m_Stats.Passes - m_Stats.CulledPasses, 1u);
+			ImVec2 Origin = ImGui::GetCursorScreenPos();
+			ImVec2 Size = ImVec2(std::max(ImGui::GetContentRegionAvail().x, 64.0f), 160.0f);
+			ImDrawList* DrawList = ImGui::GetWindowDrawList();
+			DrawList->AddRect(Origin, ImVec2(Origin.x + Size.x, Origin.y + Size.y), IM_COL32(128, 128, 128, 255));
+			
+			for (u32 i = 0; i < m_DebugResources.size(); i++)
+			{
+				const DebugResource& Res = m_DebugResources[i];
+				if (Res.bDedicated)
+				{
+					continue;
+				}
+				
+				ImVec2 Min = ImVec2(Origin.x + Size.x * Res.FirstPass / LivePasses, Origin.y + Size.y * static_cast<f32>(static_cast<f64>(Res.Offset) / m_DebugHeapSize));
+				ImVec2 Max = ImVec2(Origin.x + Size.x * (Res.LastPass + 1) / LivePasses, Origin.y + Size.y * static_cast<f32>(static_cast<f64>(Res.Offset + Res.Size) / m_DebugHeapSize));
+				DrawList->AddRectFilled(Min, Max, ImColor::HSV(std::fmod(0.13f * i, 1.0f), 0.6f, 0.8f));
+				DrawList->AddRect(Min, Max, IM_COL32(0, 0, 0, 255));
+				
+				if (ImGui::IsMouseHoveringRect(Min, Max))
+				{
+					ImGui::SetTooltip("%s\n%.1lfKB at %.1lfKB\nPasses %u to %u", Res.Name.c_str(), Res.Size / KB, Res.Offset / KB, Res.FirstPass, Res.LastPass);
+				}
+			}
+			
+			ImGui::Dummy(Size);
+			
+			for (const DebugResource& Res : m_DebugResources)
+			{
+				ImGui::BulletText("%s: %.1lfKB %s, passes %u to %u", Res.Name.c_str(), Res.Size / KB, Res.bDedicated ? "dedicated" : "shared", Res.FirstPass, Res.LastPass);
+			}
+		}
+		
+		ImGui::End();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKResources.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+	Per-frame render graph.
+	
+	Passes are added in submission order and declare every image and buffer they touch, and how.
+	Compile culls the passes whose results never reach an imported resource or a pass with side
+	effects, then walks the survivors in order tracking each resource's last writes and reads, so
+	a barrier is only recorded where there is a hazard or a layout change. The barriers in front
+	of a pass go out as a single vkCmdPipelineBarrier2.
+	
+	Transient resources are created by the graph and only live within the frame. Their memory comes
+	from one shared block, and resources whose lifetimes (first to last live pass that uses them)
+	don't overlap are placed in the same range. The physical resources are kept while the shape of
+	the graph stays the same, so a steady frame creates nothing.
+	
+	A pass that reads and writes the same resource keeps its previous contents, a pass that only
+	writes it does not depend on earlier writers.
+*/
+
+namespace Locus
+{
+	using LVKGraphResource = u32;
+	constexpr LVKGraphResource LVK_GRAPH_RESOURCE_INVALID = UINT32_MAX;
+	
+	enum class LVKGraphAccess : u32
+	{
+		ColorAttachment,
+		DepthAttachment,
+		DepthRead,
+		SampledRead,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		IndirectRead,
+		VertexRead, // Vertex and index buffers
+		UniformRead,
+		
+		Count
+	};
+	
+	struct LVKGraphImageDesc
+	{
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		VkExtent3D Extent = { 1, 1, 1 };
+		u32 MipLevels = 1;
+		VkImageUsageFlags Usage = 0; // Added to the usage implied by the declared accesses
+	};
+	
+	struct LVKGraphBufferDesc
+	{
+		VkDeviceSize Size = 0;
+		VkBufferUsageFlags Usage = 0;
+	};
+	
+	// What an imported resource was last used for, the first barrier waits on it.
+	struct LVKGraphResourceState
+	{
+		VkPipelineStageFlags2 Stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 Access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+	
+	struct LVKRenderGraphStats
+	{
+		u32 Passes = 0;
+		u32 CulledPasses = 0;
+		u32 Barriers = 0; // Individual image and buffer barriers
+		u32 BarrierBatches = 0; // vkCmdPipelineBarrier2 calls
+		u32 TransientResources = 0;
+		VkDeviceSize TransientBytes = 0; // What the transients would take without aliasing
+		VkDeviceSize AllocatedBytes = 0;
+	};
+	
+	class LVKRenderGraph;
+	using LVKGraphExecuteFn = std::function<void(VkCommandBuffer Cmd, const LVKRenderGraph& Graph)>;
+	
+	struct LVKGraphPassBuilder
+	{
+		LVKRenderGraph* Graph;
+		u32 Pass;
+		
+		LVKGraphPassBuilder& Read(LVKGraphResource Resource, LVKGraphAccess Access);
+		LVKGraphPassBuilder& Write(LVKGraphResource Resource, LVKGraphAccess Access);
+		LVKGraphPassBuilder& SideEffects(); // Never culled, for passes with results outside the graph
+	};
+	
+	class LVKRenderGraph
+	{
+	public:
+		// Physical resources that go out of use are handed to Retire, which must keep them alive until the GPU is done.
+		void Init(VkDevice Device, VmaAllocator Allocator, std::function<void(std::function<void()>&&)>&& Retire);
+		void Destroy(); // The GPU must be idle
+		
+		// Clears the passes and resources declared last frame. The physical resources stay.
+		void Reset();
+		
+		LVKGraphResource ImportImage(const char* Name, VkImage Image, VkImageView View, VkFormat Format, VkExtent3D Extent, const LVKGraphResourceState& Initial, VkImageLayout FinalLayout);
+		LVKGraphResource ImportBuffer(const char* Name, VkBuffer Buffer, VkDeviceSize Size, const LVKGraphResourceState& Initial = {});
+		LVKGraphResource CreateImage(const char* Name, const LVKGraphImageDesc& Desc);
+		LVKGraphResource CreateBuffer(const char* Name, const LVKGraphBufferDesc& Desc);
+		
+		LVKGraphPassBuilder AddPass(const char* Name, LVKGraphExecuteFn&& Execute);
+		
+		void Compile();
+		void Execute(VkCommandBuffer Cmd);
+		
+		// Valid inside pass callbacks, and for imported resources at any time.
+		VkImage GetImage(LVKGraphResource Resource) const;
+		VkImageView GetImageView(LVKGraphResource Resource) const;
+		VkExtent3D GetImageExtent(LVKGraphResource Resource) const;
+		VkBuffer GetBuffer(LVKGraphResource Resource) const;
+		
+		const LVKRenderGraphStats& GetStats() const { return m_Stats; }
+		
+		// Passes, barriers and the transient memory layout from the last Compile.
+		void DrawDebugWindow(bool* bOpen) const;
+	
+	private:
+		friend struct LVKGraphPassBuilder;
+		
+		struct Usage
+		{
+			LVKGraphResource Resource;
+			LVKGraphAccess Access;
+			bool bRead = false;
+			bool bWrite = false;
+		};
+		
+		struct Pass
+		{
+			std::string Name;
+			LVKGraphExecuteFn Execute;
+			std::vector<Usage> Usages;
+			std::vector<u32> Dependencies; // Passes whose writes this one reads
+			bool bSideEffects = false;
+			bool bLive = false;
+			
+			std::vector<VkImageMemoryBarrier2> ImageBarriers; // Recorded before Execute
+			std::vector<VkBufferMemoryBarrier2> BufferBarriers;
+		};
+		
+		struct Resource
+		{
+			std::string Name;
+			bool bImage = true;
+			bool bImported = false;
+			
+			LVKGraphImageDesc ImageDesc;
+			LVKGraphBufferDesc BufferDesc;
+			LVKGraphResourceState Initial;
+			VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			
+			u32 FirstPass = UINT32_MAX; // Lifetime in execution order, transients only
+			u32 LastPass = 0;
+			u32 Physical = UINT32_MAX; // Index into m_Physical
+		};
+		
+		// A transient placed in memory, reused across frames while the graph keeps its shape.
+		struct PhysicalResource
+		{
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VmaAllocation DedicatedAllocation = VK_NULL_HANDLE; // Only when no shared memory type fits
+			VkDeviceSize Offset = 0;
+			VkDeviceSize Size = 0;
+		};
+		
+		struct DebugBarrier
+		{
+			std::string Resource;
+			bool bImage;
+			VkImageLayout OldLayout;
+			VkImageLayout NewLayout;
+			VkPipelineStageFlags2 SrcStages;
+			VkPipelineStageFlags2 DstStages;
+		};
+		
+		struct DebugPass
+		{
+			std::string Name;
+			bool bCulled;
+			std::vector<DebugBarrier> Barriers;
+		};
+		
+		struct DebugResource
+		{
+			std::string Name;
+			u32 FirstPass;
+			u32 LastPass;
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+			bool bDedicated;
+		};
+		
+		LVKGraphResource AddResource(Resource&& NewResource);
+		void Cull();
+		void ComputeLifetimes();
+		void AllocateTransients();
+		void DestroyPhysical();
+		void BuildBarriers();
+		u64 HashTransients() const;
+		
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		std::function<void(std::function<void()>&&)> m_Retire;
+		
+		std::vector<Pass> m_Passes;
+		std::vector<Resource> m_Resources;
+		std::vector<u32> m_Order; // Live passes in execution order
+		
+		std::vector<PhysicalResource> m_Physical;
+		VmaAllocation m_TransientMemory = VK_NULL_HANDLE;
+		u64 m_PhysicalHash = 0;
+		
+		std::vector<VkImageMemoryBarrier2> m_FinalBarriers; // Imported images into their final layouts
+		
+		LVKRenderGraphStats m_Stats;
+		std::vector<DebugPass> m_DebugPasses;
+		std::vector<DebugResource> m_DebugResources;
+		VkDeviceSize m_DebugHeapSize = 0;
+	};
+}
\ No newline at end of file
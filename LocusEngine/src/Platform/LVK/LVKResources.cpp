@@ -3,6 +3,19 @@
 
 namespace Locus
 {
+	template <typename T>
+	static void WriteStateValue(std::vector<u8>& OutState, const T& Value)
+	{
+		const u8* Bytes = reinterpret_cast<const u8*>(&Value);
+		OutState.insert(OutState.end(), Bytes, Bytes + sizeof(T));
+	}
+	
+	static void WriteStateBytes(std::vector<u8>& OutState, const void* Data, arch Size)
+	{
+		const u8* Bytes = static_cast<const u8*>(Data);
+		OutState.insert(OutState.end(), Bytes, Bytes + Size);
+	}
+	
 	void LVKPipelineFactory::Clear()
 	{
 		ShaderStages.Clear();
@@ -56,9 +69,12 @@ namespace Locus
 		bDynamicViewport = true;
 		Viewport = {};
 		Scissor = {};
+		
+		ColorAttachmentFormat = VK_FORMAT_UNDEFINED;
+		DepthAttachmentFormat = VK_FORMAT_UNDEFINED;
 	}
 	
-	VkPipeline LVKPipelineFactory::Create(VkDevice Device, VkRenderPass RenderPass)
+	VkPipeline LVKPipelineFactory::Create(VkDevice Device, VkRenderPass RenderPass, VkPipelineCache Cache)
 	{
 		VkPipelineViewportStateCreateInfo ViewportState = {
 			.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
@@ -109,8 +125,23 @@ namespace Locus
 			.renderPass = RenderPass,
 		};
 		
+		VkPipelineRenderingCreateInfo RenderingInfo = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+			.pNext = nullptr,
+			.viewMask = 0,
+			.colorAttachmentCount = ColorAttachmentFormat != VK_FORMAT_UNDEFINED ? 1u : 0u,
+			.pColorAttachmentFormats = &ColorAttachmentFormat,
+			.depthAttachmentFormat = DepthAttachmentFormat,
+			.stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+		};
+		
+		if (RenderPass == VK_NULL_HANDLE)
+		{
+			PipelineInfo.pNext = &RenderingInfo;
+		}
+		
 		VkPipeline Pipeline;
-		VkResult Result = vkCreateGraphicsPipelines(Device, VK_NULL_HANDLE, 1, &PipelineInfo, nullptr, &Pipeline);
+		VkResult Result = vkCreateGraphicsPipelines(Device, Cache, 1, &PipelineInfo, nullptr, &Pipeline);
 		if (Result != VK_SUCCESS)
 		{
 			LLOG(Vulkan, Error, "Failed to create pipeline object: %s", string_VkResult(Result));
@@ -119,6 +150,118 @@ namespace Locus
 		return Pipeline;
 	}
 	
+	void LVKPipelineFactory::WriteState(std::vector<u8>& OutState) const
+	{
+		// Field by field, the create infos carry pointers and padding that must not leak into the key.
+		WriteStateValue(OutState, ColorBlendAttachment);
+		
+		WriteStateValue(OutState, VertexInput.vertexBindingDescriptionCount);
+		WriteStateBytes(OutState, VertexInput.pVertexBindingDescriptions, sizeof(VkVertexInputBindingDescription) * VertexInput.vertexBindingDescriptionCount);
+		WriteStateValue(OutState, VertexInput.vertexAttributeDescriptionCount);
+		WriteStateBytes(OutState, VertexInput.pVertexAttributeDescriptions, sizeof(VkVertexInputAttributeDescription) * VertexInput.vertexAttributeDescriptionCount);
+		
+		WriteStateValue(OutState, InputAssembly.topology);
+		WriteStateValue(OutState, InputAssembly.primitiveRestartEnable);
+		
+		WriteStateValue(OutState, Rasterizer.depthClampEnable);
+		WriteStateValue(OutState, Rasterizer.rasterizerDiscardEnable);
+		WriteStateValue(OutState, Rasterizer.polygonMode);
+		WriteStateValue(OutState, Rasterizer.cullMode);
+		WriteStateValue(OutState, Rasterizer.frontFace);
+		WriteStateValue(OutState, Rasterizer.depthBiasEnable);
+		WriteStateValue(OutState, Rasterizer.depthBiasConstantFactor);
+		WriteStateValue(OutState, Rasterizer.depthBiasClamp);
+		WriteStateValue(OutState, Rasterizer.depthBiasSlopeFactor);
+		WriteStateValue(OutState, Rasterizer.lineWidth);
+		
+		WriteStateValue(OutState, DepthStencil.depthTestEnable);
+		WriteStateValue(OutState, DepthStencil.depthWriteEnable);
+		WriteStateValue(OutState, DepthStencil.depthCompareOp);
+		WriteStateValue(OutState, DepthStencil.depthBoundsTestEnable);
+		WriteStateValue(OutState, DepthStencil.stencilTestEnable);
+		WriteStateValue(OutState, DepthStencil.front);
+		WriteStateValue(OutState, DepthStencil.back);
+		WriteStateValue(OutState, DepthStencil.minDepthBounds);
+		WriteStateValue(OutState, DepthStencil.maxDepthBounds);
+		
+		WriteStateValue(OutState, Multisampling.rasterizationSamples);
+		WriteStateValue(OutState, Multisampling.sampleShadingEnable);
+		WriteStateValue(OutState, Multisampling.minSampleShading);
+		WriteStateValue(OutState, Multisampling.alphaToCoverageEnable);
+		WriteStateValue(OutState, Multisampling.alphaToOneEnable);
+		if (Multisampling.pSampleMask)
+		{
+			WriteStateBytes(OutState, Multisampling.pSampleMask, sizeof(VkSampleMask) * ((Multisampling.rasterizationSamples + 31) / 32));
+		}
+		
+		WriteStateValue(OutState, Layout);
+		WriteStateValue(OutState, bDynamicViewport);
+		if (!bDynamicViewport)
+		{
+			WriteStateValue(OutState, Viewport);
+			WriteStateValue(OutState, Scissor);
+		}
+		
+		WriteStateValue(OutState, ColorAttachmentFormat);
+		WriteStateValue(OutState, DepthAttachmentFormat);
+	}
+	
+	u64 LVKPipelineFactory::HashState() const
+	{
+		std::vector<u8> State;
+		WriteState(State);
+		return Hash::FNV1a64(State.data(), State.size());
+	}
+	
+	void LVKComputePipelineFactory::Clear()
+	{
+		ShaderStage = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pName = "main",
+		};
+		
+		Layout = VK_NULL_HANDLE;
+		Flags = 0;
+	}
+	
+	VkPipeline LVKComputePipelineFactory::Create(VkDevice Device, VkPipelineCache Cache)
+	{
+		VkComputePipelineCreateInfo PipelineInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = Flags,
+			.stage = ShaderStage,
+			.layout = Layout,
+			.basePipelineHandle = VK_NULL_HANDLE,
+			.basePipelineIndex = -1,
+		};
+		
+		VkPipeline Pipeline;
+		VkResult Result = vkCreateComputePipelines(Device, Cache, 1, &PipelineInfo, nullptr, &Pipeline);
+		if (Result != VK_SUCCESS)
+		{
+			LLOG(Vulkan, Error, "Failed to create compute pipeline object: %s", string_VkResult(Result));
+			return VK_NULL_HANDLE;
+		}
+		return Pipeline;
+	}
+	
+	void LVKComputePipelineFactory::WriteState(std::vector<u8>& OutState) const
+	{
+		// Tagged so a compute pipeline never shares a key with a graphics pipeline built from the same layout.
+		WriteStateValue(OutState, VK_PIPELINE_BIND_POINT_COMPUTE);
+		WriteStateValue(OutState, Layout);
+		WriteStateValue(OutState, Flags);
+	}
+	
+	u64 LVKComputePipelineFactory::HashState() const
+	{
+		std::vector<u8> State;
+		WriteState(State);
+		return Hash::FNV1a64(State.data(), State.size());
+	}
+	
 	VkImageCreateInfo LVKImage::CreateInfo(VkFormat Format, VkImageUsageFlags UsageFlags, VkExtent3D Extent)
 	{
 		return {
@@ -153,7 +296,7 @@ namespace Locus
 		};
 	}
 	
-	VkImageMemoryBarrier LVKImage::MemoryBarrier(VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 InitialQueue, u32 FinalQueue)
+	VkImageMemoryBarrier LVKImage::MemoryBarrier(VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 InitialQueue, u32 FinalQueue, u32 BaseMipLevel, u32 MipLevelCount)
 	{
 		VkImageAspectFlags AspectMask = (Final == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
 		return {
@@ -168,8 +311,8 @@ namespace Locus
 			.image = Image,
 			.subresourceRange = {
 				.aspectMask = AspectMask,
-				.baseMipLevel = 0,
-				.levelCount = VK_REMAINING_MIP_LEVELS,
+				.baseMipLevel = BaseMipLevel,
+				.levelCount = MipLevelCount,
 				.baseArrayLayer = 0,
 				.layerCount = VK_REMAINING_ARRAY_LAYERS
 			},
@@ -188,6 +331,45 @@ namespace Locus
 		);	
 	}
 	
+	VkImageMemoryBarrier2 LVKImage::MemoryBarrier2(VkImage Image, VkImageAspectFlags AspectMask, VkPipelineStageFlags2 SrcStages, VkAccessFlags2 SrcAccess, VkPipelineStageFlags2 DstStages, VkAccessFlags2 DstAccess, VkImageLayout Initial, VkImageLayout Final)
+	{
+		return {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = SrcStages,
+			.srcAccessMask = SrcAccess,
+			.dstStageMask = DstStages,
+			.dstAccessMask = DstAccess,
+			.oldLayout = Initial,
+			.newLayout = Final,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = Image,
+			.subresourceRange = {
+				.aspectMask = AspectMask,
+				.baseMipLevel = 0,
+				.levelCount = VK_REMAINING_MIP_LEVELS,
+				.baseArrayLayer = 0,
+				.layerCount = VK_REMAINING_ARRAY_LAYERS
+			},
+		};
+	}
+	
+	void LVKImage::ReleaseOwnership(VkCommandBuffer Cmd, VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 SrcFamily, u32 DstFamily, u32 BaseMipLevel, u32 MipLevelCount)
+	{
+		// Access masks on the half of the barrier that runs on the other queue are ignored.
+		VkImageMemoryBarrier Barrier = MemoryBarrier(Image, Initial, Final, SrcFamily, DstFamily, BaseMipLevel, MipLevelCount);
+		Barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &Barrier);
+	}
+	
+	void LVKImage::AcquireOwnership(VkCommandBuffer Cmd, VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 SrcFamily, u32 DstFamily, u32 BaseMipLevel, u32 MipLevelCount)
+	{
+		VkImageMemoryBarrier Barrier = MemoryBarrier(Image, Initial, Final, SrcFamily, DstFamily, BaseMipLevel, MipLevelCount);
+		Barrier.srcAccessMask = 0;
+		vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &Barrier);
+	}
+	
 	void LVKImage::Blit(VkCommandBuffer Cmd, VkImage Src, VkImage Dst, VkExtent2D SrcExtent, VkExtent2D DstExtent)
 	{
 		VkImageBlit BlitRegion = {
@@ -237,4 +419,19 @@ namespace Locus
 		VK_CHECK_RESULT(vmaCreateBuffer(Allocator, &BufferInfo, &VmaAllocInfo, &OutBuffer.Buffer, &OutBuffer.Allocation, &OutBuffer.Info));
 		return OutBuffer;
 	}
+	
+	VkBufferMemoryBarrier LVKBuffer::OwnershipBarrier(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Size, u32 SrcFamily, u32 DstFamily)
+	{
+		return {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
+			.srcQueueFamilyIndex = SrcFamily,
+			.dstQueueFamilyIndex = DstFamily,
+			.buffer = Buffer,
+			.offset = Offset,
+			.size = Size,
+		};
+	}
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "LVKCommon.hpp"
 
+#include <vector>
+
 namespace Locus
 {
 	// SWAPCHAIN
@@ -21,6 +23,7 @@ namespace Locus
 		TArray<VkImage> Images = {};
 		TArray<VkImageView> ImageViews = {};
 		TArray<VkFramebuffer> Framebuffers = {};
+		u64 RenderPassKey = 0; // See LVK::RenderPassCompatibilityHash
 	};
 	
 	// PIPELINE
@@ -30,7 +33,9 @@ namespace Locus
 		LVKPipelineFactory() { Clear(); }
 		
 		void Clear();
-		VkPipeline Create(VkDevice Device, VkRenderPass RenderPass);
+		VkPipeline Create(VkDevice Device, VkRenderPass RenderPass, VkPipelineCache Cache = VK_NULL_HANDLE);
+		void WriteState(std::vector<u8>& OutState) const; // Everything except the shader stages, which are keyed by their code
+		u64 HashState() const; // Of WriteState
 
 		TArray<VkPipelineShaderStageCreateInfo> ShaderStages;
 		
@@ -46,6 +51,24 @@ namespace Locus
 		bool bDynamicViewport = true;
 		VkViewport Viewport;
 		VkRect2D Scissor;
+		
+		// Attachment formats for dynamic rendering, used when Create is given no render pass.
+		VkFormat ColorAttachmentFormat;
+		VkFormat DepthAttachmentFormat;
+	};
+	
+	struct LVKComputePipelineFactory
+	{
+		LVKComputePipelineFactory() { Clear(); }
+		
+		void Clear();
+		VkPipeline Create(VkDevice Device, VkPipelineCache Cache = VK_NULL_HANDLE);
+		void WriteState(std::vector<u8>& OutState) const; // Everything except the shader stage, which is keyed by its code
+		u64 HashState() const; // Of WriteState
+		
+		VkPipelineShaderStageCreateInfo ShaderStage;
+		VkPipelineLayout Layout;
+		VkPipelineCreateFlags Flags;
 	};
 	
 	// IMAGE
@@ -61,8 +84,16 @@ namespace Locus
 		static VkImageCreateInfo CreateInfo(VkFormat Format, VkImageUsageFlags UsageFlags, VkExtent3D Extent);
 		static VkImageViewCreateInfo ViewCreateInfo(VkFormat Format, VkImage Image, VkImageAspectFlags AspectFlags);
 		
-		static VkImageMemoryBarrier MemoryBarrier(VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 InitialQueue, u32 FinalQueue);
+		static VkImageMemoryBarrier MemoryBarrier(VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 InitialQueue, u32 FinalQueue, u32 BaseMipLevel = 0, u32 MipLevelCount = VK_REMAINING_MIP_LEVELS);
 		static void TransitionLazy(VkCommandBuffer Cmd, const VkImageMemoryBarrier& ImageBarrier);
+		
+		// Synchronization2 barrier with explicit scopes, for when ALL_COMMANDS is too blunt.
+		static VkImageMemoryBarrier2 MemoryBarrier2(VkImage Image, VkImageAspectFlags AspectMask, VkPipelineStageFlags2 SrcStages, VkAccessFlags2 SrcAccess, VkPipelineStageFlags2 DstStages, VkAccessFlags2 DstAccess, VkImageLayout Initial, VkImageLayout Final);
+		
+		// Queue family ownership transfer. Record the release on the source queue and the matching acquire,
+		// with identical arguments, on the destination queue after a semaphore wait. Both perform the layout change.
+		static void ReleaseOwnership(VkCommandBuffer Cmd, VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 SrcFamily, u32 DstFamily, u32 BaseMipLevel = 0, u32 MipLevelCount = VK_REMAINING_MIP_LEVELS);
+		static void AcquireOwnership(VkCommandBuffer Cmd, VkImage Image, VkImageLayout Initial, VkImageLayout Final, u32 SrcFamily, u32 DstFamily, u32 BaseMipLevel = 0, u32 MipLevelCount = VK_REMAINING_MIP_LEVELS);
 		static void Blit(VkCommandBuffer Cmd, VkImage Src, VkImage Dst, VkExtent2D SrcExtent, VkExtent2D DstExtent);
 	};
 	
@@ -75,5 +106,7 @@ namespace Locus
 		VmaAllocationInfo Info;
 		
 		static LVKBuffer Allocate(arch Size, VkBufferUsageFlags UsageFlags, VmaAllocator Allocator, VmaMemoryUsage MemoryUsage);
+		
+		static VkBufferMemoryBarrier OwnershipBarrier(VkBuffer Buffer, VkDeviceSize Offset, VkDeviceSize Size, u32 SrcFamily, u32 DstFamily);
 	};
 };
\ No newline at end of file
@@ -0,0 +1,622 @@
+#include "LVKShaderReflection.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace Locus
+{
+	namespace
+	{
+		// The subset of the SPIR-V specification the reflection cares about.
+		
+		constexpr u32 SPIRV_MAGIC = 0x07230203;
+		constexpr u32 SPIRV_HEADER_WORDS = 5;
+		
+		enum SpvOp : u32
+		{
+			SpvOpEntryPoint = 15,
+			SpvOpTypeInt = 21,
+			SpvOpTypeFloat = 22,
+			SpvOpTypeVector = 23,
+			SpvOpTypeMatrix = 24,
+			SpvOpTypeImage = 25,
+			SpvOpTypeSampler = 26,
+			SpvOpTypeSampledImage = 27,
+			SpvOpTypeArray = 28,
+			SpvOpTypeRuntimeArray = 29,
+			SpvOpTypeStruct = 30,
+			SpvOpTypePointer = 32,
+			SpvOpConstant = 43,
+			SpvOpSpecConstant = 50,
+			SpvOpVariable = 59,
+			SpvOpDecorate = 71,
+			SpvOpMemberDecorate = 72,
+			SpvOpTypeAccelerationStructureKHR = 5341,
+		};
+		
+		enum SpvDecoration : u32
+		{
+			SpvDecorationBlock = 2,
+			SpvDecorationBufferBlock = 3,
+			SpvDecorationArrayStride = 6,
+			SpvDecorationMatrixStride = 7,
+			SpvDecorationBuiltIn = 11,
+			SpvDecorationLocation = 30,
+			SpvDecorationBinding = 33,
+			SpvDecorationDescriptorSet = 34,
+			SpvDecorationOffset = 35,
+		};
+		
+		enum SpvStorageClass : u32
+		{
+			SpvStorageClassUniformConstant = 0,
+			SpvStorageClassInput = 1,
+			SpvStorageClassUniform = 2,
+			SpvStorageClassOutput = 3,
+			SpvStorageClassPushConstant = 9,
+			SpvStorageClassStorageBuffer = 12,
+		};
+		
+		enum SpvDim : u32
+		{
+			SpvDimBuffer = 5,
+			SpvDimSubpassData = 6,
+		};
+		
+		struct SpvId
+		{
+			u32 Opcode = 0;
+			u32 Operands = 0; // Word index of the first operand after the result id
+			u32 OperandCount = 0;
+			u32 TypeId = 0;
+			u32 StorageClass = 0;
+			u32 ArrayStride = 0;
+			u32 Set = 0;
+			u32 Binding = 0;
+			u32 Location = 0;
+			bool bHasSet = false;
+			bool bHasBinding = false;
+			bool bHasLocation = false;
+			bool bBuiltIn = false;
+			bool bBlock = false;
+			bool bBufferBlock = false;
+		};
+		
+		struct SpvMember
+		{
+			u32 Offset = 0;
+			u32 MatrixStride = 0;
+		};
+		
+		struct SpvModule
+		{
+			const u32* Words;
+			std::vector<SpvId> Ids;
+			std::unordered_map<u64, SpvMember> Members; // (Struct << 32) | Member
+			
+			const u32* Operands(u32 Id) const { return Words + Ids[Id].Operands; }
+			
+			SpvMember GetMember(u32 Struct, u32 Member) const
+			{
+				auto It = Members.find((static_cast<u64>(Struct) << 32) | Member);
+				return It != Members.end() ? It->second : SpvMember {};
+			}
+			
+			u32 GetConstant(u32 Id) const
+			{
+				const SpvId& Constant = Ids[Id];
+				bool bIsConstant = Constant.Opcode == SpvOpConstant || Constant.Opcode == SpvOpSpecConstant;
+				return bIsConstant ? Words[Constant.Operands] : 1;
+			}
+			
+			u32 GetTypeSize(u32 Type, u32 MatrixStride = 0) const
+			{
+				const SpvId& Info = Ids[Type];
+				const u32* Ops = Operands(Type);
+				switch (Info.Opcode)
+				{
+					case SpvOpTypeInt:
+					case SpvOpTypeFloat:
+						return Ops[0] / 8;
+					case SpvOpTypeVector:
+						return Ops[1] * GetTypeSize(Ops[0]);
+					case SpvOpTypeMatrix:
+						return Ops[1] * (MatrixStride ? MatrixStride : GetTypeSize(Ops[0]));
+					case SpvOpTypeArray:
+						return GetConstant(Ops[1]) * (Info.ArrayStride ? Info.ArrayStride : GetTypeSize(Ops[0]));
+					case SpvOpTypeStruct:
+					{
+						u32 Size = 0;
+						for (u32 i = 0; i < Info.OperandCount; i++)
+						{
+							SpvMember Member = GetMember(Type, i);
+							Size = std::max(Size, Member.Offset + GetTypeSize(Ops[i], Member.MatrixStride));
+						}
+						return Size;
+					}
+					default:
+						return 0;
+				}
+			}
+			
+			VkFormat GetFormat(u32 Type) const
+			{
+				u32 ComponentType = Type;
+				u32 ComponentCount = 1;
+				if (Ids[Type].Opcode == SpvOpTypeVector)
+				{
+					ComponentType = Operands(Type)[0];
+					ComponentCount = Operands(Type)[1];
+				}
+				
+				const SpvId& Component = Ids[ComponentType];
+				const u32* Ops = Operands(ComponentType);
+				if (Ops[0] != 32 || ComponentCount < 1 || ComponentCount > 4)
+				{
+					return VK_FORMAT_UNDEFINED;
+				}
+				
+				static const VkFormat FloatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+				static const VkFormat SintFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+				static const VkFormat UintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+				
+				if (Component.Opcode == SpvOpTypeFloat)
+				{
+					return FloatFormats[ComponentCount - 1];
+				}
+				if (Component.Opcode == SpvOpTypeInt)
+				{
+					return Ops[1] ? SintFormats[ComponentCount - 1] : UintFormats[ComponentCount - 1];
+				}
+				return VK_FORMAT_UNDEFINED;
+			}
+		};
+		
+		VkShaderStageFlagBits GetStage(u32 ExecutionModel)
+		{
+			switch (ExecutionModel)
+			{
+				case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+				case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+				case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+				case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+				case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+				case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+				default: return VK_SHADER_STAGE_ALL;
+			}
+		}
+		
+		bool GetDescriptorType(const SpvModule& Module, u32 StorageClass, u32 Type, VkDescriptorType& OutType)
+		{
+			const SpvId& Info = Module.Ids[Type];
+			
+			if (StorageClass == SpvStorageClassStorageBuffer)
+			{
+				OutType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				return true;
+			}
+			
+			if (StorageClass == SpvStorageClassUniform)
+			{
+				// Before SPIR-V 1.3 storage buffers were Uniform blocks decorated BufferBlock.
+				OutType = Info.bBufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				return true;
+			}
+			
+			switch (Info.Opcode)
+			{
+				case SpvOpTypeSampler:
+					OutType = VK_DESCRIPTOR_TYPE_SAMPLER;
+					return true;
+				case SpvOpTypeSampledImage:
+					OutType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					return true;
+				case SpvOpTypeAccelerationStructureKHR:
+					OutType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+					return true;
+				case SpvOpTypeImage:
+				{
+					const u32* Ops = Module.Operands(Type);
+					u32 Dim = Ops[1];
+					bool bStorage = (Ops[5] == 2);
+					if (Dim == SpvDimBuffer)
+					{
+						OutType = bStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					}
+					else if (Dim == SpvDimSubpassData)
+					{
+						OutType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					}
+					else
+					{
+						OutType = bStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					}
+					return true;
+				}
+				default:
+					return false;
+			}
+		}
+	}
+	
+	bool LVK::ReflectShader(const u8* Code, arch CodeSize, LVKShaderReflection& OutReflection)
+	{
+		OutReflection = {};
+		
+		if (CodeSize < SPIRV_HEADER_WORDS * 4 || CodeSize % 4 != 0)
+		{
+			LLOG(Shaders, Error, "Reflection failed, %zu bytes is not a SPIR-V module.", CodeSize);
+			return false;
+		}
+		
+		SpvModule Module;
+		Module.Words = reinterpret_cast<const u32*>(Code);
+		u32 WordCount = static_cast<u32>(CodeSize / 4);
+		
+		if (Module.Words[0] != SPIRV_MAGIC)
+		{
+			LLOG(Shaders, Error, "Reflection failed, bad SPIR-V magic.");
+			return false;
+		}
+		
+		u32 Bound = Module.Words[3];
+		Module.Ids.resize(Bound);
+		
+		std::vector<u32> Variables;
+		bool bFoundEntryPoint = false;
+		
+		for (u32 Word = SPIRV_HEADER_WORDS; Word < WordCount; )
+		{
+			u32 Opcode = Module.Words[Word] & 0xFFFF;
+			u32 Length = Module.Words[Word] >> 16;
+			if (Length == 0 || Word + Length > WordCount)
+			{
+				LLOG(Shaders, Error, "Reflection failed, truncated instruction at word %u.", Word);
+				return false;
+			}
+			
+			const u32* Ops = Module.Words + Word + 1;
+			u32 OpCount = Length - 1;
+			
+			switch (Opcode)
+			{
+				case SpvOpEntryPoint:
+				{
+					if (!bFoundEntryPoint)
+					{
+						OutReflection.Stage = GetStage(Ops[0]);
+						bFoundEntryPoint = true;
+					}
+					break;
+				}
+				
+				case SpvOpTypeInt:
+				case SpvOpTypeFloat:
+				case SpvOpTypeVector:
+				case SpvOpTypeMatrix:
+				case SpvOpTypeImage:
+				case SpvOpTypeSampler:
+				case SpvOpTypeSampledImage:
+				case SpvOpTypeArray:
+				case SpvOpTypeRuntimeArray:
+				case SpvOpTypeStruct:
+				case SpvOpTypeAccelerationStructureKHR:
+				{
+					if (Ops[0] < Bound)
+					{
+						SpvId& Id = Module.Ids[Ops[0]];
+						Id.Opcode = Opcode;
+						Id.Operands = Word + 2;
+						Id.OperandCount = OpCount - 1;
+					}
+					break;
+				}
+				
+				case SpvOpTypePointer:
+				{
+					if (Ops[0] < Bound)
+					{
+						SpvId& Id = Module.Ids[Ops[0]];
+						Id.Opcode = Opcode;
+						Id.StorageClass = Ops[1];
+						Id.TypeId = Ops[2];
+					}
+					break;
+				}
+				
+				case SpvOpConstant:
+				case SpvOpSpecConstant:
+				{
+					if (Ops[1] < Bound)
+					{
+						SpvId& Id = Module.Ids[Ops[1]];
+						Id.Opcode = Opcode;
+						Id.TypeId = Ops[0];
+						Id.Operands = Word + 3;
+					}
+					break;
+				}
+				
+				case SpvOpVariable:
+				{
+					if (Ops[1] < Bound)
+					{
+						SpvId& Id = Module.Ids[Ops[1]];
+						Id.Opcode = Opcode;
+						Id.TypeId = Ops[0];
+						Id.StorageClass = Ops[2];
+						Variables.push_back(Ops[1]);
+					}
+					break;
+				}
+				
+				case SpvOpDecorate:
+				{
+					if (Ops[0] >= Bound || OpCount < 2)
+					{
+						break;
+					}
+					
+					SpvId& Id = Module.Ids[Ops[0]];
+					switch (Ops[1])
+					{
+						case SpvDecorationBlock: Id.bBlock = true; break;
+						case SpvDecorationBufferBlock: Id.bBufferBlock = true; break;
+						case SpvDecorationBuiltIn: Id.bBuiltIn = true; break;
+						case SpvDecorationArrayStride: Id.ArrayStride = Ops[2]; break;
+						case SpvDecorationLocation: Id.Location = Ops[2]; Id.bHasLocation = true; break;
+						case SpvDecorationBinding: Id.Binding = Ops[2]; Id.bHasBinding = true; break;
+						case SpvDecorationDescriptorSet: Id.Set = Ops[2]; Id.bHasSet = true; break;
+						default: break;
+					}
+					break;
+				}
+				
+				case SpvOpMemberDecorate:
+				{
+					if (Ops[0] >= Bound || OpCount < 3)
+					{
+						break;
+					}
+					
+					u64 Key = (static_cast<u64>(Ops[0]) << 32) | Ops[1];
+					if (Ops[2] == SpvDecorationOffset)
+					{
+						Module.Members[Key].Offset = Ops[3];
+					}
+					else if (Ops[2] == SpvDecorationMatrixStride)
+					{
+						Module.Members[Key].MatrixStride = Ops[3];
+					}
+					else if (Ops[2] == SpvDecorationBuiltIn)
+					{
+						Module.Ids[Ops[0]].bBuiltIn = true;
+					}
+					break;
+				}
+				
+				default:
+					break;
+			}
+			
+			Word += Length;
+		}
+		
+		if (!bFoundEntryPoint)
+		{
+			LLOG(Shaders, Error, "Reflection failed, the module has no entry point.");
+			return false;
+		}
+		
+		for (u32 Variable : Variables)
+		{
+			const SpvId& Info = Module.Ids[Variable];
+			const SpvId& Pointer = Module.Ids[Info.TypeId];
+			u32 Type = Pointer.TypeId;
+			
+			switch (Info.StorageClass)
+			{
+				case SpvStorageClassUniformConstant:
+				case SpvStorageClassUniform:
+				case SpvStorageClassStorageBuffer:
+				{
+					if (!Info.bHasBinding)
+					{
+						break;
+					}
+					
+					// Arrays of descriptors, possibly nested or runtime sized for bindless tables.
+					u32 Count = 1;
+					while (Module.Ids[Type].Opcode == SpvOpTypeArray || Module.Ids[Type].Opcode == SpvOpTypeRuntimeArray)
+					{
+						const u32* Ops = Module.Operands(Type);
+						Count = Module.Ids[Type].Opcode == SpvOpTypeArray ? Count * Module.GetConstant(Ops[1]) : 0;
+						Type = Ops[0];
+					}
+					
+					VkDescriptorType DescriptorType;
+					if (!GetDescriptorType(Module, Info.StorageClass, Type, DescriptorType))
+					{
+						LLOG(Shaders, Warning, "Reflection skipped binding %u.%u, unrecognised resource type.", Info.Set, Info.Binding);
+						break;
+					}
+					
+					OutReflection.Bindings.push_back({ Info.Set, Info.Binding, DescriptorType, Count });
+					break;
+				}
+				
+				case SpvStorageClassPushConstant:
+				{
+					// Offsets are absolute, so the range starts at the lowest member offset.
+					const SpvId& Block = Module.Ids[Type];
+					u32 Begin = UINT32_MAX;
+					for (u32 i = 0; i < Block.OperandCount; i++)
+					{
+						Begin = std::min(Begin, Module.GetMember(Type, i).Offset);
+					}
+					
+					u32 End = Module.GetTypeSize(Type);
+					OutReflection.PushConstantOffset = (Begin == UINT32_MAX) ? 0 : Begin;
+					OutReflection.PushConstantSize = End - OutReflection.PushConstantOffset;
+					break;
+				}
+				
+				case SpvStorageClassInput:
+				case SpvStorageClassOutput:
+				{
+					if (Info.bBuiltIn || Module.Ids[Type].bBuiltIn || !Info.bHasLocation)
+					{
+						break;
+					}
+					
+					VkFormat Format = Module.GetFormat(Type);
+					if (Format == VK_FORMAT_UNDEFINED)
+					{
+						LLOG(Shaders, Warning, "Reflection skipped interface location %u, only 32 bit scalars and vectors are supported.", Info.Location);
+						break;
+					}
+					
+					auto& Interface = (Info.StorageClass == SpvStorageClassInput) ? OutReflection.Inputs : OutReflection.Outputs;
+					Interface.push_back({ Info.Location, Format });
+					break;
+				}
+				
+				default:
+					break;
+			}
+		}
+		
+		auto ByLocation = [](const LVKReflectedInterfaceVariable& A, const LVKReflectedInterfaceVariable& B) { return A.Location < B.Location; };
+		std::sort(OutReflection.Inputs.begin(), OutReflection.Inputs.end(), ByLocation);
+		std::sort(OutReflection.Outputs.begin(), OutReflection.Outputs.end(), ByLocation);
+		
+		return true;
+	}
+	
+	bool LVK::MergeShaderReflections(const LVKShaderReflection* const* Reflections, u32 ReflectionCount, LVKReflectedLayout& OutLayout)
+	{
+		OutLayout = {};
+		
+		u32 PushConstantBegin = UINT32_MAX;
+		u32 PushConstantEnd = 0;
+		
+		for (u32 i = 0; i < ReflectionCount; i++)
+		{
+			const LVKShaderReflection& Reflection = *Reflections[i];
+			
+			for (const LVKReflectedBinding& Binding : Reflection.Bindings)
+			{
+				if (Binding.Set >= OutLayout.Sets.size())
+				{
+					OutLayout.Sets.resize(Binding.Set + 1);
+				}
+				
+				auto& Set = OutLayout.Sets[Binding.Set];
+				auto Existing = std::find_if(Set.begin(), Set.end(), [&](const VkDescriptorSetLayoutBinding& Other) { return Other.binding == Binding.Binding; });
+				
+				if (Existing == Set.end())
+				{
+					Set.push_back({
+						.binding = Binding.Binding,
+						.descriptorType = Binding.Type,
+						.descriptorCount = Binding.Count,
+						.stageFlags = static_cast<VkShaderStageFlags>(Reflection.Stage),
+						.pImmutableSamplers = nullptr,
+					});
+					continue;
+				}
+				
+				if (Existing->descriptorType != Binding.Type || Existing->descriptorCount != Binding.Count)
+				{
+					LLOG(Shaders, Error, "Layout mismatch at set %u binding %u: %s[%u] in one stage, %s[%u] in another.",
+						Binding.Set, Binding.Binding,
+						string_VkDescriptorType(Existing->descriptorType), Existing->descriptorCount,
+						string_VkDescriptorType(Binding.Type), Binding.Count);
+					return false;
+				}
+				
+				Existing->stageFlags |= Reflection.Stage;
+			}
+			
+			if (Reflection.PushConstantSize > 0)
+			{
+				PushConstantBegin = std::min(PushConstantBegin, Reflection.PushConstantOffset);
+				PushConstantEnd = std::max(PushConstantEnd, Reflection.PushConstantOffset + Reflection.PushConstantSize);
+				OutLayout.PushConstants.stageFlags |= Reflection.Stage;
+			}
+			
+			if (Reflection.Stage == VK_SHADER_STAGE_VERTEX_BIT)
+			{
+				u32 Offset = 0;
+				for (const LVKReflectedInterfaceVariable& Input : Reflection.Inputs)
+				{
+					OutLayout.VertexAttributes.push_back({
+						.location = Input.Location,
+						.binding = 0,
+						.format = Input.Format,
+						.offset = Offset,
+					});
+					Offset += GetFormatSize(Input.Format);
+				}
+				
+				OutLayout.VertexBinding = {
+					.binding = 0,
+					.stride = Offset,
+					.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+				};
+			}
+			
+			// Every input must be fed by the previous stage, stages are expected in pipeline order.
+			if (i > 0 && Reflection.Stage != VK_SHADER_STAGE_COMPUTE_BIT)
+			{
+				const LVKShaderReflection& Previous = *Reflections[i - 1];
+				for (const LVKReflectedInterfaceVariable& Input : Reflection.Inputs)
+				{
+					auto Output = std::find_if(Previous.Outputs.begin(), Previous.Outputs.end(), [&](const LVKReflectedInterfaceVariable& Other) { return Other.Location == Input.Location; });
+					if (Output == Previous.Outputs.end() || Output->Format != Input.Format)
+					{
+						LLOG(Shaders, Error, "Interface mismatch at location %u: %s reads %s but %s writes %s.",
+							Input.Location,
+							string_VkShaderStageFlagBits(Reflection.Stage), string_VkFormat(Input.Format),
+							string_VkShaderStageFlagBits(Previous.Stage), Output == Previous.Outputs.end() ? "nothing" : string_VkFormat(Output->Format));
+						return false;
+					}
+				}
+			}
+		}
+		
+		if (PushConstantEnd > 0)
+		{
+			OutLayout.PushConstants.offset = PushConstantBegin;
+			OutLayout.PushConstants.size = PushConstantEnd - PushConstantBegin;
+		}
+		
+		return true;
+	}
+	
+	u32 LVK::GetFormatSize(VkFormat Format)
+	{
+		switch (Format)
+		{
+			case VK_FORMAT_R32_SFLOAT:
+			case VK_FORMAT_R32_SINT:
+			case VK_FORMAT_R32_UINT:
+				return 4;
+			case VK_FORMAT_R32G32_SFLOAT:
+			case VK_FORMAT_R32G32_SINT:
+			case VK_FORMAT_R32G32_UINT:
+				return 8;
+			case VK_FORMAT_R32G32B32_SFLOAT:
+			case VK_FORMAT_R32G32B32_SINT:
+			case VK_FORMAT_R32G32B32_UINT:
+				return 12;
+			case VK_FORMAT_R32G32B32A32_SFLOAT:
+			case VK_FORMAT_R32G32B32A32_SINT:
+			case VK_FORMAT_R32G32B32A32_UINT:
+				return 16;
+			default:
+				LAssertMsg(false, "GetFormatSize: unhandled format.");
+				return 0;
+		}
+	}
+}
\ No newline at end of file
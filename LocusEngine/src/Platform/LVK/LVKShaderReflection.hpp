@@ -0,0 +1,60 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+
+#include <vector>
+
+/*
+	Minimal SPIR-V reflection, enough to derive pipeline layouts from compiled shaders.
+	
+	We walk the module once and pull out the descriptor bindings, the push constant block and the
+	stage interface. Reflections of the stages in one pipeline are then merged, which is where any
+	disagreement between stages is reported, long before it could turn into a device fault.
+*/
+
+namespace Locus
+{
+	struct LVKReflectedBinding
+	{
+		u32 Set;
+		u32 Binding;
+		VkDescriptorType Type;
+		u32 Count; // 0 for runtime sized arrays
+	};
+	
+	struct LVKReflectedInterfaceVariable
+	{
+		u32 Location;
+		VkFormat Format;
+	};
+	
+	struct LVKShaderReflection
+	{
+		VkShaderStageFlagBits Stage = VK_SHADER_STAGE_ALL;
+		std::vector<LVKReflectedBinding> Bindings;
+		u32 PushConstantOffset = 0;
+		u32 PushConstantSize = 0;
+		std::vector<LVKReflectedInterfaceVariable> Inputs;
+		std::vector<LVKReflectedInterfaceVariable> Outputs;
+	};
+	
+	struct LVKReflectedLayout
+	{
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> Sets; // Indexed by set number, gaps are empty
+		VkPushConstantRange PushConstants = {}; // Covers every stage that declares a block, size is 0 if none do
+		
+		// Vertex shader inputs, tightly packed in location order into binding 0.
+		VkVertexInputBindingDescription VertexBinding = {};
+		std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+	};
+}
+
+namespace Locus::LVK
+{
+	bool ReflectShader(const u8* Code, arch CodeSize, LVKShaderReflection& OutReflection);
+	
+	// Fails, and logs why, if two stages disagree about a binding or a stage consumes an output the previous one never writes.
+	bool MergeShaderReflections(const LVKShaderReflection* const* Reflections, u32 ReflectionCount, LVKReflectedLayout& OutLayout);
+	
+	u32 GetFormatSize(VkFormat Format);
+}
\ No newline at end of file
@@ -0,0 +1,585 @@
+#include "LVKStaticMeshRenderer.hpp"
+#include "LVKHelpers.hpp"
+#include "Math/Numerics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Locus
+{
+	static constexpr u32 FRAME_SLOTS_INITIAL = 4;
+	static constexpr VkDeviceSize INSTANCE_BUFFER_SIZE_MIN = 64 * 1024;
+	static constexpr VkDeviceSize BATCH_ALIGNMENT = 256; // minStorageBufferOffsetAlignment is at most this
+	static constexpr u32 DRAW_COMMAND_SIZE = sizeof(VkDrawIndexedIndirectCommand);
+	static constexpr u32 COMMAND_STREAMS = 2;
+	static constexpr u32 COUNTER_COUNT = 4; // A draw count per stream, triangles, clusters
+	static constexpr u32 CULL_GROUP_SIZE = 64;
+	static constexpr u32 KEY_NONE = 0xFFFFFFFF; // Instance of a mesh that is not drawn
+	
+	static u32 PackColor(const f32 Color[4])
+	{
+		u32 Packed = 0;
+		for (u32 i = 0; i < 4; i++)
+		{
+			Packed |= static_cast<u32>(std::lround(std::clamp(Color[i], 0.0f, 1.0f) * 255.0f)) << (i * 8);
+		}
+		return Packed;
+	}
+	
+	void LVKStaticMeshRenderer::Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, bool bDrawIndirectCount, const LVKStaticMeshConfig& Config)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		m_Uploads = Uploads;
+		m_bDrawIndirectCount = bDrawIndirectCount;
+		m_Config = Config;
+		
+		m_Vertices = LVKBuffer::Allocate(sizeof(MeshAssetVertex) * static_cast<VkDeviceSize>(Config.MaxVertices), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_Indices = LVKBuffer::Allocate(sizeof(u32) * static_cast<VkDeviceSize>(Config.MaxIndexWords), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		m_Meshlets = LVKBuffer::Allocate(sizeof(MeshAssetMeshlet) * static_cast<VkDeviceSize>(Config.MaxMeshlets), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, Allocator, VMA_MEMORY_USAGE_GPU_ONLY);
+		
+		m_Meshes = std::make_unique<Pool<Mesh>>(Config.MaxMeshes);
+		m_VertexRanges = std::make_unique<OffsetAllocator>(Config.MaxVertices, Config.MaxMeshes);
+		m_IndexRanges = std::make_unique<OffsetAllocator>(Config.MaxIndexWords, Config.MaxMeshes);
+		m_MeshletRanges = std::make_unique<OffsetAllocator>(Config.MaxMeshlets, Config.MaxMeshes);
+		m_FrameSlots.resize(FRAME_SLOTS_INITIAL);
+		
+		LLOG(Vulkan, Info, "Static mesh renderer created, %u vertices, %u index words, %u meshlets, %u meshes.", Config.MaxVertices, Config.MaxIndexWords, Config.MaxMeshlets, Config.MaxMeshes);
+	}
+	
+	void LVKStaticMeshRenderer::Destroy()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		for (FrameSlot& Slot : m_FrameSlots)
+		{
+			for (LVKBuffer* Buffer : { &Slot.Instances, &Slot.Readback })
+			{
+				if (Buffer->Buffer != VK_NULL_HANDLE)
+				{
+					vmaDestroyBuffer(m_Allocator, Buffer->Buffer, Buffer->Allocation);
+				}
+			}
+		}
+		m_FrameSlots.clear();
+		
+		for (LVKBuffer* Buffer : { &m_Vertices, &m_Indices, &m_Meshlets })
+		{
+			vmaDestroyBuffer(m_Allocator, Buffer->Buffer, Buffer->Allocation);
+			*Buffer = {};
+		}
+		
+		m_Meshes.reset();
+		m_VertexRanges.reset();
+		m_IndexRanges.reset();
+		m_MeshletRanges.reset();
+		m_RetiredGeometry.clear();
+		m_Submissions.clear();
+		m_Instances.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+	
+	StaticMeshHandle LVKStaticMeshRenderer::CreateMesh(const MeshAssetView& Asset)
+	{
+		LAssert(Asset.Header != nullptr);
+		const MeshAssetHeader& Header = *Asset.Header;
+		
+		if (m_Stats.Meshes >= m_Config.MaxMeshes)
+		{
+			LLOG(Vulkan, Error, "Static mesh renderer already holds %u meshes, mesh not created.", m_Stats.Meshes);
+			return HANDLE_INVALID;
+		}
+		
+		u64 IndexBytes = static_cast<u64>(Header.IndexCount) * Asset.GetIndexSize();
+		u32 IndexWords = static_cast<u32>((IndexBytes + sizeof(u32) - 1) / sizeof(u32));
+		OffsetAllocation VertexRange = m_VertexRanges->Allocate(Header.VertexCount);
+		OffsetAllocation IndexRange = VertexRange.IsValid() ? m_IndexRanges->Allocate(IndexWords) : OffsetAllocation{};
+		OffsetAllocation MeshletRange = IndexRange.IsValid() ? m_MeshletRanges->Allocate(Header.MeshletCount) : OffsetAllocation{};
+		if (!MeshletRange.IsValid())
+		{
+			if (IndexRange.IsValid())
+			{
+				m_IndexRanges->Free(IndexRange);
+			}
+			if (VertexRange.IsValid())
+			{
+				m_VertexRanges->Free(VertexRange);
+			}
+			LLOG(Vulkan, Error, "Static mesh geometry has no free range for a mesh of %u vertices, %u indices and %u meshlets, mesh not created.", Header.VertexCount, Header.IndexCount, Header.MeshletCount);
+			return HANDLE_INVALID;
+		}
+		
+		// Already in the layout the shaders read, so the mapped bytes go up unchanged.
+		m_Uploads->UploadBuffer(m_Vertices.Buffer, sizeof(MeshAssetVertex) * static_cast<VkDeviceSize>(VertexRange.Offset), Asset.Vertices, sizeof(MeshAssetVertex) * static_cast<VkDeviceSize>(Header.VertexCount));
+		m_Uploads->UploadBuffer(m_Indices.Buffer, sizeof(u32) * static_cast<VkDeviceSize>(IndexRange.Offset), Asset.Indices, IndexBytes);
+		LVKUploadTicket Upload = m_Uploads->UploadBuffer(m_Meshlets.Buffer, sizeof(MeshAssetMeshlet) * static_cast<VkDeviceSize>(MeshletRange.Offset), Asset.Meshlets, sizeof(MeshAssetMeshlet) * static_cast<VkDeviceSize>(Header.MeshletCount));
+		
+		Mesh NewMesh = {
+			.Vertices = VertexRange,
+			.Indices = IndexRange,
+			.Meshlets = MeshletRange,
+			.bIndices16 = (Header.Flags & MESH_ASSET_INDICES_16) != 0,
+			.BoundsMin = { Header.BoundsMin[0], Header.BoundsMin[1], Header.BoundsMin[2] },
+			.BoundsExtent = { Header.BoundsExtent[0], Header.BoundsExtent[1], Header.BoundsExtent[2] },
+			.Reach = std::sqrt(Header.Sphere[0] * Header.Sphere[0] + Header.Sphere[1] * Header.Sphere[1] + Header.Sphere[2] * Header.Sphere[2]) + Header.Sphere[3],
+			.LodCount = Header.LodCount,
+			.Lods = {},
+			.Upload = Upload,
+		};
+		for (u32 i = 0; i < Header.LodCount; i++)
+		{
+			const MeshAssetLod& AssetLod = Asset.Lods[i];
+			NewMesh.Lods[i] = { AssetLod.FirstMeshlet, AssetLod.MeshletCount, AssetLod.IndexCount, AssetLod.Error };
+		}
+		
+		m_Stats.Meshes++;
+		m_Stats.GeometryBytes += sizeof(MeshAssetVertex) * static_cast<u64>(Header.VertexCount) + sizeof(u32) * static_cast<u64>(IndexWords) + sizeof(MeshAssetMeshlet) * static_cast<u64>(Header.MeshletCount);
+		return m_Meshes->Create(NewMesh);
+	}
+	
+	void LVKStaticMeshRenderer::DestroyMesh(StaticMeshHandle Handle)
+	{
+		LAssert(m_Meshes->IsValid(Handle));
+		
+		// Frames already recorded may still draw it, and its upload may still be in flight.
+		const Mesh& Destroyed = m_Meshes->Get(Handle);
+		m_RetiredGeometry.push_back({ Destroyed.Vertices, Destroyed.Indices, Destroyed.Meshlets, Destroyed.Upload, m_LastRecordedValue });
+		
+		m_Stats.Meshes--;
+		m_Stats.GeometryBytes -= sizeof(MeshAssetVertex) * static_cast<u64>(m_VertexRanges->GetAllocationSize(Destroyed.Vertices)) + sizeof(u32) * static_cast<u64>(m_IndexRanges->GetAllocationSize(Destroyed.Indices));
+		m_Stats.GeometryBytes -= sizeof(MeshAssetMeshlet) * static_cast<u64>(m_MeshletRanges->GetAllocationSize(Destroyed.Meshlets));
+		m_Meshes->Destroy(Handle);
+	}
+	
+	void LVKStaticMeshRenderer::Submit(StaticMeshHandle Handle, const StaticMeshInstance* Instances, u32 Count)
+	{
+		LAssert(m_Meshes->IsValid(Handle));
+		if (Count == 0)
+		{
+			return;
+		}
+		
+		const Mesh& Drawn = m_Meshes->Get(Handle);
+		m_Submissions.push_back({ Handle, static_cast<u32>(m_Instances.size()), Count });
+		for (u32 i = 0; i < Count; i++)
+		{
+			const SceneTransform& Transform = Instances[i].Transform;
+			LVKStaticMeshInstance& Instance = m_Instances.emplace_back();
+			memcpy(Instance.PositionScale, Transform.Position, sizeof(Transform.Position));
+			Instance.PositionScale[3] = Transform.Scale;
+			memcpy(Instance.Rotation, Transform.Rotation, sizeof(Instance.Rotation));
+			memcpy(Instance.BoundsMin, Drawn.BoundsMin, sizeof(Instance.BoundsMin));
+			memcpy(Instance.BoundsExtent, Drawn.BoundsExtent, sizeof(Instance.BoundsExtent));
+			Instance.Color = PackColor(Instances[i].Color);
+			Instance.Pad = 0;
+		}
+	}
+	
+	void LVKStaticMeshRenderer::Update(u64 CompletedValue)
+	{
+		for (arch i = 0; i < m_RetiredGeometry.size();)
+		{
+			const RetiredGeometry& Retired = m_RetiredGeometry[i];
+			if (Retired.TimelineValue > CompletedValue || !m_Uploads->IsComplete(Retired.Upload))
+			{
+				i++;
+				continue;
+			}
+			
+			m_VertexRanges->Free(Retired.Vertices);
+			m_IndexRanges->Free(Retired.Indices);
+			m_MeshletRanges->Free(Retired.Meshlets);
+			m_RetiredGeometry[i] = m_RetiredGeometry.back();
+			m_RetiredGeometry.pop_back();
+		}
+		
+		// Counters of the newest finished frame.
+		for (FrameSlot& Slot : m_FrameSlots)
+		{
+			if (Slot.TimelineValue == 0 || Slot.TimelineValue > CompletedValue)
+			{
+				continue;
+			}
+			
+			if (Slot.bReadback && Slot.TimelineValue > m_LatestReadback)
+			{
+				VK_CHECK_RESULT(vmaInvalidateAllocation(m_Allocator, Slot.Readback.Allocation, 0, VK_WHOLE_SIZE));
+				const u32* Counters = static_cast<const u32*>(Slot.Readback.Info.pMappedData);
+				m_Stats.Triangles = Counters[2];
+				m_Stats.VisibleClusters = Counters[3];
+				m_LatestReadback = Slot.TimelineValue;
+			}
+			
+			Slot.TimelineValue = 0;
+			Slot.bReadback = false;
+		}
+	}
+	
+	bool LVKStaticMeshRenderer::Record(LVKRenderGraph& Graph, const LVKStaticMeshView& View)
+	{
+		m_Stats.Instances = 0;
+		m_Stats.DrawCalls = 0;
+		m_Stats.TestedClusters = 0;
+		m_Stats.FullDetailTriangles = 0;
+		m_LastRecordedValue = View.TimelineValue;
+		
+		// Counting sort by mesh then LOD, skipping meshes destroyed since or still uploading.
+		
+		u32 KeyCount = m_Config.MaxMeshes * MESH_ASSET_LODS_MAX;
+		std::vector<u32> Keys(m_Instances.size(), KEY_NONE);
+		std::vector<u32> FirstInstance(KeyCount + 1, 0);
+		for (const Submission& Submitted : m_Submissions)
+		{
+			if (!m_Meshes->IsValid(Submitted.Mesh) || !m_Uploads->IsComplete(m_Meshes->Get(Submitted.Mesh).Upload))
+			{
+				continue;
+			}
+			
+			const Mesh& Drawn = m_Meshes->Get(Submitted.Mesh);
+			u32 FirstKey = HandleIndex(Submitted.Mesh) * MESH_ASSET_LODS_MAX;
+			for (u32 i = Submitted.FirstInstance; i < Submitted.FirstInstance + Submitted.Count; i++)
+			{
+				Keys[i] = FirstKey + SelectLod(Drawn, m_Instances[i], View);
+				FirstInstance[Keys[i] + 1]++;
+			}
+		}
+		for (u32 i = 0; i < KeyCount; i++)
+		{
+			FirstInstance[i + 1] += FirstInstance[i];
+		}
+		
+		u32 InstanceCount = FirstInstance[KeyCount];
+		if (InstanceCount == 0 || View.Cull.Pipeline == VK_NULL_HANDLE || View.Pipeline.Pipeline == VK_NULL_HANDLE)
+		{
+			m_Submissions.clear();
+			m_Instances.clear();
+			return false;
+		}
+		
+		// One batch per mesh and LOD with instances, each instance meshlet pair is one cull thread.
+		
+		std::vector<LVKStaticMeshBatch> Batches;
+		u32 WorkCount = 0;
+		u32 StreamCapacity[COMMAND_STREAMS] = {};
+		for (u32 Key = 0; Key < KeyCount; Key++)
+		{
+			u32 Count = FirstInstance[Key + 1] - FirstInstance[Key];
+			if (Count == 0)
+			{
+				continue;
+			}
+			
+			const Mesh& Drawn = m_Meshes->GetValueAt(Key / MESH_ASSET_LODS_MAX);
+			const Lod& Selected = Drawn.Lods[Key % MESH_ASSET_LODS_MAX];
+			u32 Stream = Drawn.bIndices16 ? 0 : 1;
+			Batches.push_back({
+				.FirstWork = WorkCount,
+				.FirstInstance = FirstInstance[Key],
+				.FirstMeshlet = Drawn.Meshlets.Offset + Selected.FirstMeshlet,
+				.MeshletCount = Selected.MeshletCount,
+				.IndexBase = Drawn.bIndices16 ? Drawn.Indices.Offset * 2 : Drawn.Indices.Offset,
+				.VertexOffset = static_cast<i32>(Drawn.Vertices.Offset),
+				.Stream = Stream,
+				.Pad = 0,
+			});
+			WorkCount += Count * Selected.MeshletCount;
+			StreamCapacity[Stream] += Count * Selected.MeshletCount;
+			m_Stats.FullDetailTriangles += static_cast<u64>(Count) * (Drawn.Lods[0].IndexCount / 3);
+		}
+		m_Stats.Instances = InstanceCount;
+		m_Stats.TestedClusters = WorkCount;
+		
+		VkDeviceSize InstancesSize = sizeof(LVKStaticMeshInstance) * static_cast<VkDeviceSize>(InstanceCount);
+		VkDeviceSize BatchesOffset = (InstancesSize + BATCH_ALIGNMENT - 1) & ~(BATCH_ALIGNMENT - 1);
+		VkDeviceSize BatchesSize = sizeof(LVKStaticMeshBatch) * Batches.size();
+		FrameSlot& Slot = AcquireFrameSlot(BatchesOffset + BatchesSize, View.TimelineValue);
+		u8* Mapped = static_cast<u8*>(Slot.Instances.Info.pMappedData);
+		
+		LVKStaticMeshInstance* MappedInstances = reinterpret_cast<LVKStaticMeshInstance*>(Mapped);
+		std::vector<u32> Cursor(FirstInstance.begin(), FirstInstance.end() - 1);
+		for (arch i = 0; i < m_Instances.size(); i++)
+		{
+			if (Keys[i] != KEY_NONE)
+			{
+				MappedInstances[Cursor[Keys[i]]++] = m_Instances[i];
+			}
+		}
+		memcpy(Mapped + BatchesOffset, Batches.data(), BatchesSize);
+		VK_CHECK_RESULT(vmaFlushAllocation(m_Allocator, Slot.Instances.Allocation, 0, BatchesOffset + BatchesSize));
+		m_Submissions.clear();
+		m_Instances.clear();
+		
+		// Resources, the command streams sit back to back
+		
+		LVKGraphResource Vertices = Graph.ImportBuffer("Static Mesh Vertices", m_Vertices.Buffer, m_Vertices.Info.size);
+		LVKGraphResource Indices = Graph.ImportBuffer("Static Mesh Indices", m_Indices.Buffer, m_Indices.Info.size);
+		LVKGraphResource Meshlets = Graph.ImportBuffer("Static Mesh Meshlets", m_Meshlets.Buffer, m_Meshlets.Info.size);
+		
+		// Rounded up so the transient keeps its shape while the instance count moves.
+		VkDeviceSize CommandsSize = DRAW_COMMAND_SIZE * Math::NextPowerOfTwo(std::max(WorkCount, 64u));
+		LVKGraphResource Commands = Graph.CreateBuffer("Static Mesh Commands", { .Size = CommandsSize });
+		LVKGraphResource Counters = Graph.CreateBuffer("Static Mesh Counters", { .Size = sizeof(u32) * COUNTER_COUNT });
+		
+		// Clear
+		
+		bool bDrawIndirectCount = m_bDrawIndirectCount;
+		LVKGraphPassBuilder Clear = Graph.AddPass("Static Mesh Clear", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			vkCmdFillBuffer(Cmd, Graph.GetBuffer(Counters), 0, VK_WHOLE_SIZE, 0);
+			if (!bDrawIndirectCount)
+			{
+				// Drawn in full, the slots culling leaves untouched must be empty draws.
+				vkCmdFillBuffer(Cmd, Graph.GetBuffer(Commands), 0, VK_WHOLE_SIZE, 0);
+			}
+		}).Write(Counters, LVKGraphAccess::TransferDst);
+		if (!bDrawIndirectCount)
+		{
+			Clear.Write(Commands, LVKGraphAccess::TransferDst);
+		}
+		
+		// Cull
+		
+		struct
+		{
+			f32 Planes[FRUSTUM_PLANE_COUNT][4];
+			f32 CameraPosition[3];
+			u32 BatchCount;
+			u32 WorkCount;
+			u32 StreamCapacity[COMMAND_STREAMS];
+		} CullConstants;
+		memcpy(CullConstants.Planes, View.FrustumPlanes, sizeof(CullConstants.Planes));
+		memcpy(CullConstants.CameraPosition, View.CameraPosition, sizeof(CullConstants.CameraPosition));
+		CullConstants.BatchCount = static_cast<u32>(Batches.size());
+		CullConstants.WorkCount = WorkCount;
+		memcpy(CullConstants.StreamCapacity, StreamCapacity, sizeof(StreamCapacity));
+		
+		VkDevice Device = m_Device;
+		LVKGpuScenePipeline CullPipeline = View.Cull;
+		LVKGpuScenePipeline Pipeline = View.Pipeline;
+		VkDescriptorSet CullSet = View.Descriptors->Allocate(Device, CullPipeline.SetLayout);
+		VkDescriptorSet Set = View.Descriptors->Allocate(Device, Pipeline.SetLayout);
+		VkBuffer VerticesBuffer = m_Vertices.Buffer;
+		VkBuffer IndicesBuffer = m_Indices.Buffer;
+		VkBuffer MeshletsBuffer = m_Meshlets.Buffer;
+		VkBuffer FrameBuffer = Slot.Instances.Buffer;
+		
+		LVKGraphPassBuilder Cull = Graph.AddPass("Static Mesh Cull", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkDescriptorBufferInfo BufferInfos[5] = {
+				{ FrameBuffer, 0, InstancesSize },
+				{ FrameBuffer, BatchesOffset, BatchesSize },
+				{ MeshletsBuffer, 0, VK_WHOLE_SIZE },
+				{ Graph.GetBuffer(Commands), 0, VK_WHOLE_SIZE },
+				{ Graph.GetBuffer(Counters), 0, VK_WHOLE_SIZE },
+			};
+			VkWriteDescriptorSet Writes[5];
+			for (u32 i = 0; i < 5; i++)
+			{
+				Writes[i] = {
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.pNext = nullptr,
+					.dstSet = CullSet,
+					.dstBinding = i,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					.pImageInfo = nullptr,
+					.pBufferInfo = &BufferInfos[i],
+				};
+			}
+			vkUpdateDescriptorSets(Device, 5, Writes, 0, nullptr);
+			
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, CullPipeline.Pipeline);
+			vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_COMPUTE, CullPipeline.Layout, 0, 1, &CullSet, 0, nullptr);
+			vkCmdPushConstants(Cmd, CullPipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &CullConstants);
+			vkCmdDispatch(Cmd, (CullConstants.WorkCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+		});
+		Cull.Read(Meshlets, LVKGraphAccess::StorageRead);
+		Cull.Read(Counters, LVKGraphAccess::StorageWrite).Write(Counters, LVKGraphAccess::StorageWrite);
+		if (!bDrawIndirectCount)
+		{
+			Cull.Read(Commands, LVKGraphAccess::StorageWrite);
+		}
+		Cull.Write(Commands, LVKGraphAccess::StorageWrite);
+		
+		// Draw, one indirect draw per stream with commands
+		
+		std::vector<u32> Streams;
+		for (u32 Stream = 0; Stream < COMMAND_STREAMS; Stream++)
+		{
+			if (StreamCapacity[Stream] > 0)
+			{
+				Streams.push_back(Stream);
+			}
+		}
+		m_Stats.DrawCalls = static_cast<u32>(Streams.size());
+		
+		LVKGraphResource Color = View.Color;
+		LVKGraphResource Depth = View.Depth;
+		bool bClearDepth = View.bClearDepth;
+		VkExtent2D Extent = View.Extent;
+		std::array<f32, 16> ViewProjection;
+		memcpy(ViewProjection.data(), View.ViewProjection, sizeof(View.ViewProjection));
+		
+		LVKGraphPassBuilder Pass = Graph.AddPass("Static Meshes", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkDescriptorBufferInfo BufferInfos[2] = {
+				{ VerticesBuffer, 0, VK_WHOLE_SIZE },
+				{ FrameBuffer, 0, InstancesSize },
+			};
+			VkWriteDescriptorSet Writes[2];
+			for (u32 i = 0; i < 2; i++)
+			{
+				Writes[i] = {
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.pNext = nullptr,
+					.dstSet = Set,
+					.dstBinding = i,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+					.pImageInfo = nullptr,
+					.pBufferInfo = &BufferInfos[i],
+				};
+			}
+			vkUpdateDescriptorSets(Device, 2, Writes, 0, nullptr);
+			
+			VkClearValue DepthClear = { .depthStencil = { 0.0f, 0 } }; // Reverse Z, far is zero
+			VkRenderingAttachmentInfo ColorAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(Color), nullptr, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			VkRenderingAttachmentInfo DepthAttachment = LVK::RenderingAttachmentInfo(Graph.GetImageView(Depth), bClearDepth ? &DepthClear : nullptr, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+			VkRenderingInfo RenderingInfo = {
+				.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.renderArea = { { 0, 0 }, Extent },
+				.layerCount = 1,
+				.viewMask = 0,
+				.colorAttachmentCount = 1,
+				.pColorAttachments = &ColorAttachment,
+				.pDepthAttachment = &DepthAttachment,
+				.pStencilAttachment = nullptr,
+			};
+			vkCmdBeginRendering(Cmd, &RenderingInfo);
+			
+			VkViewport Viewport = { 0.0f, 0.0f, static_cast<f32>(Extent.width), static_cast<f32>(Extent.height), 0.0f, 1.0f };
+			VkRect2D Scissor = { { 0, 0 }, Extent };
+			vkCmdSetViewport(Cmd, 0, 1, &Viewport);
+			vkCmdSetScissor(Cmd, 0, 1, &Scissor);
+			
+			vkCmdBindPipeline(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.Pipeline);
+			vkCmdBindDescriptorSets(Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.Layout, 0, 1, &Set, 0, nullptr);
+			vkCmdPushConstants(Cmd, Pipeline.Layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(f32) * 16, ViewProjection.data());
+			
+			// Indices of both sizes share the buffer, each stream's firstIndex counts in its own size.
+			VkBuffer CommandsBuffer = Graph.GetBuffer(Commands);
+			VkBuffer CountersBuffer = Graph.GetBuffer(Counters);
+			for (u32 Stream : Streams)
+			{
+				vkCmdBindIndexBuffer(Cmd, IndicesBuffer, 0, Stream == 0 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+				VkDeviceSize CommandsOffset = Stream == 0 ? 0 : static_cast<VkDeviceSize>(CullConstants.StreamCapacity[0]) * DRAW_COMMAND_SIZE;
+				if (bDrawIndirectCount)
+				{
+					vkCmdDrawIndexedIndirectCount(Cmd, CommandsBuffer, CommandsOffset, CountersBuffer, sizeof(u32) * Stream, CullConstants.StreamCapacity[Stream], DRAW_COMMAND_SIZE);
+				}
+				else
+				{
+					vkCmdDrawIndexedIndirect(Cmd, CommandsBuffer, CommandsOffset, CullConstants.StreamCapacity[Stream], DRAW_COMMAND_SIZE);
+				}
+			}
+			
+			vkCmdEndRendering(Cmd);
+		});
+		Pass.Read(Color, LVKGraphAccess::ColorAttachment).Write(Color, LVKGraphAccess::ColorAttachment).Write(Depth, LVKGraphAccess::DepthAttachment);
+		if (!bClearDepth)
+		{
+			Pass.Read(Depth, LVKGraphAccess::DepthAttachment);
+		}
+		Pass.Read(Commands, LVKGraphAccess::IndirectRead).Read(Indices, LVKGraphAccess::VertexRead).Read(Vertices, LVKGraphAccess::StorageRead);
+		if (bDrawIndirectCount)
+		{
+			Pass.Read(Counters, LVKGraphAccess::IndirectRead);
+		}
+		
+		// Readback of the counters, picked up by Update once the frame has finished.
+		
+		VkBuffer ReadbackBuffer = Slot.Readback.Buffer;
+		Slot.bReadback = true;
+		Graph.AddPass("Static Mesh Readback", [=](VkCommandBuffer Cmd, const LVKRenderGraph& Graph){
+			VkBufferCopy Region = { 0, 0, sizeof(u32) * COUNTER_COUNT };
+			vkCmdCopyBuffer(Cmd, Graph.GetBuffer(Counters), ReadbackBuffer, 1, &Region);
+			
+			VkMemoryBarrier2 HostBarrier = {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+				.pNext = nullptr,
+				.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+				.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+				.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+			};
+			VkDependencyInfo Dependency = {
+				.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+				.pNext = nullptr,
+				.memoryBarrierCount = 1,
+				.pMemoryBarriers = &HostBarrier,
+			};
+			vkCmdPipelineBarrier2(Cmd, &Dependency);
+		}).Read(Counters, LVKGraphAccess::TransferSrc).SideEffects();
+		
+		return true;
+	}
+	
+	u32 LVKStaticMeshRenderer::SelectLod(const Mesh& Drawn, const LVKStaticMeshInstance& Instance, const LVKStaticMeshView& View) const
+	{
+		// Nearest the mesh could be, from a sphere around the instance's origin that holds every vertex.
+		f32 Scale = std::fabs(Instance.PositionScale[3]);
+		f32 X = Instance.PositionScale[0] - View.CameraPosition[0];
+		f32 Y = Instance.PositionScale[1] - View.CameraPosition[1];
+		f32 Z = Instance.PositionScale[2] - View.CameraPosition[2];
+		f32 Distance = std::sqrt(X * X + Y * Y + Z * Z) - Drawn.Reach * Scale;
+		if (Distance <= 0.0f)
+		{
+			return 0;
+		}
+		
+		// Errors grow down the chain, so the first LOD too coarse ends the search.
+		f32 PixelsPerUnit = Scale * View.LodScale / Distance;
+		u32 Selected = 0;
+		while (Selected + 1 < Drawn.LodCount && Drawn.Lods[Selected + 1].Error * PixelsPerUnit <= m_Config.LodErrorPixels)
+		{
+			Selected++;
+		}
+		return Selected;
+	}
+	
+	LVKStaticMeshRenderer::FrameSlot& LVKStaticMeshRenderer::AcquireFrameSlot(VkDeviceSize Size, u64 TimelineValue)
+	{
+		auto Free = std::find_if(m_FrameSlots.begin(), m_FrameSlots.end(), [](const FrameSlot& Slot){ return Slot.TimelineValue == 0; });
+		if (Free == m_FrameSlots.end())
+		{
+			// More frames in flight than slots, grow rather than wait.
+			m_FrameSlots.emplace_back();
+			Free = m_FrameSlots.end() - 1;
+		}
+		
+		FrameSlot& Slot = *Free;
+		Slot.TimelineValue = TimelineValue;
+		Slot.bReadback = false;
+		
+		if (Slot.Readback.Buffer == VK_NULL_HANDLE)
+		{
+			Slot.Readback = LVKBuffer::Allocate(sizeof(u32) * COUNTER_COUNT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, m_Allocator, VMA_MEMORY_USAGE_GPU_TO_CPU);
+		}
+		if (Slot.Instances.Buffer == VK_NULL_HANDLE || Slot.Instances.Info.size < Size)
+		{
+			// The slot is free, so the GPU is done with its old buffer.
+			if (Slot.Instances.Buffer != VK_NULL_HANDLE)
+			{
+				vmaDestroyBuffer(m_Allocator, Slot.Instances.Buffer, Slot.Instances.Allocation);
+			}
+			Slot.Instances = LVKBuffer::Allocate(Math::NextPowerOfTwo(std::max(Size, INSTANCE_BUFFER_SIZE_MIN)), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_Allocator, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		}
+		return Slot;
+	}
+}
\ No newline at end of file
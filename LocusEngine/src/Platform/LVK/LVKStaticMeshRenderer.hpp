@@ -0,0 +1,202 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKDescriptor.hpp"
+#include "LVKGpuScene.hpp"
+#include "LVKRenderGraph.hpp"
+#include "LVKResources.hpp"
+#include "LVKUploadManager.hpp"
+#include "Base/Handles.hpp"
+#include "Core/OffsetAllocator.hpp"
+#include "Graphics/GraphicsManager.hpp"
+#include "Graphics/MeshAsset.hpp"
+
+#include <vector>
+
+/*
+	Instanced static meshes.
+	
+	Meshes come from cooked .lmesh assets, whose quantised vertices and indices are uploaded as
+	they are, straight from the mapped file, into one shared vertex and one shared index buffer.
+	Vertices are pulled and decoded in the vertex shader, three words each.
+	
+	Instances are submitted every frame they are drawn. At record time each picks the coarsest LOD
+	whose simplification error projects to under LodErrorPixels, and they are grouped by mesh and
+	LOD with a counting sort into a host visible buffer of the frame's own. A compute pass then
+	tests every meshlet of every instance on its own, its bounding sphere against the frustum and
+	its normal cone against the camera, and appends the survivors as one indirect command each.
+	The draw is one vkCmdDrawIndexedIndirectCount per index size, whatever the number of meshes,
+	so triangles drawn follow how much of the screen the instances cover, not how dense the
+	assets are. Without draw indirect count the command ranges are zeroed and drawn in full.
+	
+	Meshlets are contiguous index ranges drawn by the ordinary vertex pipeline, there are no mesh
+	shaders. Instance data is fetched by firstInstance, which is the instance's own index.
+*/
+
+namespace Locus
+{
+	// Mirrors StaticMeshInstance in static_mesh.glsl.
+	struct LVKStaticMeshInstance
+	{
+		f32 PositionScale[4];
+		f32 Rotation[4];
+		f32 BoundsMin[3]; // The mesh's quantisation box
+		u32 Color; // RGBA8 unorm
+		f32 BoundsExtent[3];
+		u32 Pad;
+	};
+	static_assert(sizeof(LVKStaticMeshInstance) == 64);
+	
+	// Mirrors StaticMeshBatch in static_mesh.glsl, the instances drawing one LOD of one mesh.
+	struct LVKStaticMeshBatch
+	{
+		u32 FirstWork; // Instance and meshlet pairs of the batches before
+		u32 FirstInstance;
+		u32 FirstMeshlet;
+		u32 MeshletCount;
+		u32 IndexBase; // The mesh's first index, counted in its own index size
+		i32 VertexOffset;
+		u32 Stream; // Command stream, 0 for 16-bit indices and 1 for 32-bit
+		u32 Pad;
+	};
+	static_assert(sizeof(LVKStaticMeshBatch) == 32);
+	
+	struct LVKStaticMeshConfig
+	{
+		u32 MaxVertices = 1 << 20;
+		u32 MaxIndexWords = 1 << 21; // 32-bit words, a word holds two 16-bit indices
+		u32 MaxMeshlets = 1 << 18;
+		u32 MaxMeshes = 1024;
+		f32 LodErrorPixels = 1.0f; // Simplification error allowed on screen
+	};
+	
+	struct LVKStaticMeshView
+	{
+		LVKGraphResource Color;
+		LVKGraphResource Depth;
+		bool bClearDepth; // Otherwise drawn over what is there
+		VkExtent2D Extent;
+		f32 ViewProjection[16];
+		f32 FrustumPlanes[FRUSTUM_PLANE_COUNT][4];
+		f32 CameraPosition[3];
+		f32 LodScale; // Pixels an object space unit covers at distance one, height / (2 tan(fov / 2))
+		
+		LVKGpuScenePipeline Cull;
+		LVKGpuScenePipeline Pipeline;
+		LVKDescriptorAllocator* Descriptors; // The frame's
+		u64 TimelineValue; // Graphics timeline value the frame signals
+	};
+	
+	struct LVKStaticMeshStats
+	{
+		u32 Meshes = 0;
+		u32 Instances = 0; // Drawn last frame
+		u32 DrawCalls = 0;
+		u64 GeometryBytes = 0;
+		
+		u32 TestedClusters = 0; // Meshlets of the selected LODs, before culling
+		u32 VisibleClusters = 0; // Read back, a few frames late
+		u64 Triangles = 0; // Read back, a few frames late
+		u64 FullDetailTriangles = 0; // Had every instance drawn its finest LOD unculled
+	};
+	
+	class LVKStaticMeshRenderer
+	{
+	public:
+		LVKStaticMeshRenderer() = default;
+		LVKStaticMeshRenderer(const LVKStaticMeshRenderer&) = delete;
+		LVKStaticMeshRenderer& operator=(const LVKStaticMeshRenderer&) = delete;
+		
+		void Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, bool bDrawIndirectCount, const LVKStaticMeshConfig& Config);
+		void Destroy(); // The GPU must be idle
+		
+		// The asset's memory is copied before this returns, it can be unmapped straight after.
+		StaticMeshHandle CreateMesh(const MeshAssetView& Asset);
+		void DestroyMesh(StaticMeshHandle Mesh);
+		
+		// Copied, drawn in the frame recorded next.
+		void Submit(StaticMeshHandle Mesh, const StaticMeshInstance* Instances, u32 Count);
+		
+		// Frees what finished frames were using and picks up their readbacks, CompletedValue is the graphics timeline's.
+		void Update(u64 CompletedValue);
+		
+		// Adds the frame's cull, draw and readback passes and clears the submissions. False if nothing was drawn.
+		bool Record(LVKRenderGraph& Graph, const LVKStaticMeshView& View);
+		
+		const LVKStaticMeshStats& GetStats() const { return m_Stats; }
+	
+	private:
+		struct Lod
+		{
+			u32 FirstMeshlet; // From the mesh's first
+			u32 MeshletCount;
+			u32 IndexCount;
+			f32 Error;
+		};
+		
+		struct Mesh
+		{
+			OffsetAllocation Vertices;
+			OffsetAllocation Indices; // In words
+			OffsetAllocation Meshlets;
+			bool bIndices16;
+			f32 BoundsMin[3];
+			f32 BoundsExtent[3];
+			f32 Reach; // Furthest any vertex is from the origin
+			u32 LodCount;
+			Lod Lods[MESH_ASSET_LODS_MAX];
+			LVKUploadTicket Upload;
+		};
+		
+		struct Submission
+		{
+			StaticMeshHandle Mesh;
+			u32 FirstInstance; // Into m_Instances
+			u32 Count;
+		};
+		
+		// Host visible buffers of one recorded frame, reused once its timeline value is reached.
+		struct FrameSlot
+		{
+			LVKBuffer Instances = {}; // Then the batches
+			LVKBuffer Readback = {}; // Draw counts, triangles and clusters
+			u64 TimelineValue = 0; // Zero when free
+			bool bReadback = false;
+		};
+		
+		struct RetiredGeometry
+		{
+			OffsetAllocation Vertices;
+			OffsetAllocation Indices;
+			OffsetAllocation Meshlets;
+			LVKUploadTicket Upload;
+			u64 TimelineValue;
+		};
+		
+		FrameSlot& AcquireFrameSlot(VkDeviceSize Size, u64 TimelineValue);
+		u32 SelectLod(const Mesh& Drawn, const LVKStaticMeshInstance& Instance, const LVKStaticMeshView& View) const;
+		
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		LVKUploadManager* m_Uploads = nullptr;
+		bool m_bDrawIndirectCount = false;
+		LVKStaticMeshConfig m_Config;
+		
+		LVKBuffer m_Vertices;
+		LVKBuffer m_Indices;
+		LVKBuffer m_Meshlets;
+		Unique<OffsetAllocator> m_VertexRanges; // In vertices
+		Unique<OffsetAllocator> m_IndexRanges; // In words
+		Unique<OffsetAllocator> m_MeshletRanges; // In meshlets
+		std::vector<RetiredGeometry> m_RetiredGeometry;
+		u64 m_LastRecordedValue = 0;
+		
+		Unique<Pool<Mesh>> m_Meshes;
+		std::vector<Submission> m_Submissions;
+		std::vector<LVKStaticMeshInstance> m_Instances;
+		std::vector<FrameSlot> m_FrameSlots;
+		u64 m_LatestReadback = 0;
+		
+		LVKStaticMeshStats m_Stats;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,616 @@
+#include "LVKTextureStreamer.hpp"
+#include "LVKResources.hpp"
+#include "Core/JobSystem.hpp"
+#include "Platform/Platform.hpp"
+#include "Platform/VirtualFileSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Locus
+{
+	struct StreamedFormat
+	{
+		VkFormat Format;
+		u32 BlockExtent; // Texels a block is wide and high
+		u32 BlockSize; // Bytes
+	};
+	
+	static constexpr StreamedFormat STREAMED_FORMATS[] = {
+		{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC2_UNORM_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC2_SRGB_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC3_UNORM_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC3_SRGB_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC4_UNORM_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC4_SNORM_BLOCK, 4, 8 },
+		{ VK_FORMAT_BC5_UNORM_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC5_SNORM_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC6H_UFLOAT_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC6H_SFLOAT_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC7_UNORM_BLOCK, 4, 16 },
+		{ VK_FORMAT_BC7_SRGB_BLOCK, 4, 16 },
+		{ VK_FORMAT_R8G8B8A8_UNORM, 1, 4 },
+		{ VK_FORMAT_R8G8B8A8_SRGB, 1, 4 },
+	};
+	
+	static const StreamedFormat* FindStreamedFormat(u32 Format)
+	{
+		for (const StreamedFormat& Streamed : STREAMED_FORMATS)
+		{
+			if (static_cast<u32>(Streamed.Format) == Format)
+			{
+				return &Streamed;
+			}
+		}
+		return nullptr;
+	}
+	
+	// Mapped where possible, from the pack or a loose file, so levels are only copied out once.
+	static bool ReadTextureFile(const char* LogicalPath, const std::function<void(const u8*, arch)>& Function)
+	{
+		VirtualFileSystem& FileSystem = VirtualFileSystem::Get();
+		arch Size = 0;
+		const u8* Data = FileSystem.MapFile(LogicalPath, Size);
+		
+		Platform::FileMapping Mapping;
+		std::string LoosePath;
+		if (Data == nullptr && FileSystem.ResolveLoosePath(LogicalPath, LoosePath) && Platform::FileMap(LoosePath.c_str(), Mapping))
+		{
+			Data = Mapping.Data;
+			Size = Mapping.Size;
+		}
+		
+		TArray<u8> Contents;
+		if (Data == nullptr && FileSystem.ReadFile(LogicalPath, Contents))
+		{
+			Data = Contents.Data();
+			Size = Contents.Length();
+		}
+		
+		if (Data != nullptr)
+		{
+			Function(Data, Size);
+		}
+		
+		if (Mapping.Data != nullptr)
+		{
+			Platform::FileUnmap(Mapping);
+		}
+		return Data != nullptr;
+	}
+	
+	void LVKTextureStreamer::Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, LVKBindlessHeap* Bindless, VkSampler Sampler, bool bTextureCompressionBC, std::function<void(std::function<void()>&&)>&& Retire, const LVKTextureStreamerConfig& Config)
+	{
+		m_Device = Device;
+		m_Allocator = Allocator;
+		m_Uploads = Uploads;
+		m_Bindless = Bindless;
+		m_bTextureCompressionBC = bTextureCompressionBC;
+		m_Retire = std::move(Retire);
+		m_Config = Config;
+		
+		m_Textures = std::make_unique<Pool<Texture>>(Config.MaxTextures);
+		m_Paths.resize(Config.MaxTextures);
+		m_Sampler = Bindless->AddSampler(Device, Sampler);
+		m_Stats.BudgetBytes = Config.BudgetBytes;
+		
+		LLOG(Vulkan, Info, "Texture streaming within %.1lfMB%s.", Config.BudgetBytes / (1024.0 * 1024.0), bTextureCompressionBC ? "" : ", block compressed textures are not supported by the device");
+	}
+	
+	void LVKTextureStreamer::Destroy()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		// Read jobs reference this object, let them drain.
+		while (m_ReadsInFlight.load() > 0)
+		{
+			Platform::SleepThisThread(1);
+		}
+		
+		auto DestroyImage = [this](const Image& Destroyed){
+			if (Destroyed.Image != VK_NULL_HANDLE)
+			{
+				vkDestroyImageView(m_Device, Destroyed.View, nullptr);
+				vmaDestroyImage(m_Allocator, Destroyed.Image, Destroyed.Allocation);
+			}
+		};
+		
+		for (arch i = 0; i < m_Textures->Count(); i++)
+		{
+			if (m_Textures->IsValidAt(i))
+			{
+				const Texture& Streamed = m_Textures->GetValueAt(i);
+				DestroyImage(Streamed.Current);
+				DestroyImage(Streamed.Next);
+			}
+		}
+		
+		for (const AbandonedImage& Abandoned : m_Abandoned)
+		{
+			DestroyImage(Abandoned.Abandoned);
+		}
+		
+		m_Textures.reset();
+		m_Paths.clear();
+		m_Abandoned.clear();
+		m_FinishedReads.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+	
+	TextureHandle LVKTextureStreamer::LoadTexture(const char* LogicalPath)
+	{
+		if (m_Stats.Textures >= m_Config.MaxTextures)
+		{
+			LLOG(Vulkan, Error, "Texture streamer already holds %u textures, %s not loaded.", m_Stats.Textures, LogicalPath);
+			return HANDLE_INVALID;
+		}
+		
+		TextureHandle Handle = HANDLE_INVALID;
+		bool bRead = ReadTextureFile(LogicalPath, [&](const u8* Data, arch Size){
+			Texture NewTexture = {};
+			if (!ParseTextureAsset(Data, Size, NewTexture.Info))
+			{
+				LLOG(Vulkan, Error, "Texture %s is not a valid KTX2 texture.", LogicalPath);
+				return;
+			}
+			
+			const StreamedFormat* Format = FindStreamedFormat(NewTexture.Info.Format);
+			if (Format == nullptr || (Format->BlockExtent > 1 && !m_bTextureCompressionBC))
+			{
+				LLOG(Vulkan, Error, "Texture %s has format %u, which this device can not stream.", LogicalPath, NewTexture.Info.Format);
+				return;
+			}
+			NewTexture.Format = Format->Format;
+			NewTexture.BlockExtent = Format->BlockExtent;
+			NewTexture.BlockSize = Format->BlockSize;
+			
+			// Levels are uploaded exactly as they are stored, so they have to be exactly the size the format makes them.
+			for (u32 Level = 0; Level < NewTexture.Info.LevelCount; Level++)
+			{
+				if (NewTexture.Info.Levels[Level].ByteLength != GetLevelBytes(NewTexture, Level))
+				{
+					LLOG(Vulkan, Error, "Texture %s level %u is not the size its format makes it.", LogicalPath, Level);
+					return;
+				}
+			}
+			
+			u32 TailLevel = NewTexture.Info.LevelCount - 1;
+			while (TailLevel > 0 && std::max(NewTexture.Info.GetLevelWidth(TailLevel - 1), NewTexture.Info.GetLevelHeight(TailLevel - 1)) <= m_Config.TailExtent)
+			{
+				TailLevel--;
+			}
+			NewTexture.TailLevel = TailLevel;
+			NewTexture.GrantedLevel = TailLevel;
+			
+			// The tail arrives the way any other change does, only with nothing resident before it.
+			NewTexture.Current.FirstLevel = NewTexture.Info.LevelCount;
+			NewTexture.bChanging = true;
+			NewTexture.Next = CreateImage(NewTexture, TailLevel);
+			NewTexture.bCopied = true;
+			for (u32 Level = TailLevel; Level < NewTexture.Info.LevelCount; Level++)
+			{
+				QueueUpload(NewTexture, Level, Data + NewTexture.Info.Levels[Level].ByteOffset);
+			}
+			Handle = m_Textures->Create(NewTexture);
+		});
+		
+		if (!bRead)
+		{
+			LLOG(Vulkan, Error, "Failed to read texture %s.", LogicalPath);
+		}
+		
+		if (Handle != HANDLE_INVALID)
+		{
+			m_Paths[HandleIndex(Handle)] = LogicalPath;
+			m_Stats.Textures++;
+		}
+		return Handle;
+	}
+	
+	void LVKTextureStreamer::DestroyTexture(TextureHandle Texture)
+	{
+		if (!m_Textures->IsValid(Texture))
+		{
+			return;
+		}
+		
+		// A read still in flight finds the handle gone and is dropped.
+		const LVKTextureStreamer::Texture& Destroyed = m_Textures->Get(Texture);
+		RetireImage(Destroyed.Current, LVK_UPLOAD_TICKET_NONE);
+		RetireImage(Destroyed.Next, Destroyed.Upload);
+		
+		m_Paths[HandleIndex(Texture)].clear();
+		m_Textures->Destroy(Texture);
+		m_Stats.Textures--;
+	}
+	
+	void LVKTextureStreamer::Request(TextureHandle Texture, f32 ScreenPixels)
+	{
+		if (!m_Textures->IsValid(Texture))
+		{
+			return;
+		}
+		
+		LVKTextureStreamer::Texture& Requested = m_Textures->GetMut(Texture);
+		if (Requested.RequestedFrame != m_Frame)
+		{
+			Requested.RequestedFrame = m_Frame;
+			Requested.RequestedPixels = 0.0f;
+		}
+		Requested.RequestedPixels = std::max(Requested.RequestedPixels, ScreenPixels);
+	}
+	
+	bool LVKTextureStreamer::GetBinding(TextureHandle Texture, u32& OutImageIndex, u32& OutSamplerIndex) const
+	{
+		if (!m_Textures->IsValid(Texture))
+		{
+			return false;
+		}
+		
+		const LVKTextureStreamer::Texture& Bound = m_Textures->Get(Texture);
+		if (Bound.Current.Bindless == HANDLE_INVALID)
+		{
+			return false;
+		}
+		
+		OutImageIndex = HandleIndex(Bound.Current.Bindless);
+		OutSamplerIndex = HandleIndex(m_Sampler);
+		return true;
+	}
+	
+	void LVKTextureStreamer::Update()
+	{
+		// Levels read since the last frame go up into the images waiting for them.
+		std::vector<LevelRead> FinishedReads;
+		{
+			std::lock_guard<std::mutex> Lock(m_ReadMutex);
+			FinishedReads.swap(m_FinishedReads);
+		}
+		
+		for (const LevelRead& Read : FinishedReads)
+		{
+			if (!m_Textures->IsValid(Read.Texture))
+			{
+				continue;
+			}
+			
+			Texture& Streamed = m_Textures->GetMut(Read.Texture);
+			if (!Streamed.bChanging || Streamed.ReadId != Read.ReadId)
+			{
+				continue;
+			}
+			Streamed.ReadId = 0;
+			
+			if (Read.bFailed)
+			{
+				LLOG(Vulkan, Error, "Failed to read levels of texture %s, it keeps the levels it has.", m_Paths[HandleIndex(Read.Texture)].c_str());
+				RetireImage(Streamed.Next, LVK_UPLOAD_TICKET_NONE);
+				Streamed.Next = {};
+				Streamed.bChanging = false;
+				Streamed.bReadFailed = true;
+				continue;
+			}
+			
+			const u8* Data = Read.Data.data();
+			for (u32 Level = Streamed.Next.FirstLevel; Level < Streamed.Current.FirstLevel; Level++)
+			{
+				QueueUpload(Streamed, Level, Data);
+				Data += GetLevelBytes(Streamed, Level);
+			}
+		}
+		
+		for (auto It = m_Abandoned.begin(); It != m_Abandoned.end(); )
+		{
+			if (!m_Uploads->IsComplete(It->Upload))
+			{
+				It++;
+				continue;
+			}
+			
+			RetireImage(It->Abandoned, LVK_UPLOAD_TICKET_NONE);
+			It = m_Abandoned.erase(It);
+		}
+		
+		// Changes that have landed take over, then every texture puts forward the levels it wants past its tail.
+		u64 TailBytes = 0;
+		m_Stats.Changing = 0;
+		m_Stats.ResidentBytes = 0;
+		m_Stats.WantedBytes = 0;
+		m_Candidates.clear();
+		
+		for (arch i = 0; i < m_Textures->Count(); i++)
+		{
+			if (!m_Textures->IsValidAt(i))
+			{
+				continue;
+			}
+			
+			TextureHandle Handle = m_Textures->GetHandleAt(i);
+			Texture& Streamed = m_Textures->GetMut(Handle);
+			u32 LevelCount = Streamed.Info.LevelCount;
+			
+			if (Streamed.bChanging && Streamed.ReadId == 0 && Streamed.bCopied && m_Uploads->IsComplete(Streamed.Upload))
+			{
+				// The tail arriving is not counted, it always does.
+				if (Streamed.Current.Image != VK_NULL_HANDLE && Streamed.Next.FirstLevel < Streamed.Current.FirstLevel)
+				{
+					m_Stats.LevelsStreamedIn += Streamed.Current.FirstLevel - Streamed.Next.FirstLevel;
+				}
+				else if (Streamed.Current.Image != VK_NULL_HANDLE)
+				{
+					m_Stats.LevelsEvicted += Streamed.Next.FirstLevel - Streamed.Current.FirstLevel;
+				}
+				
+				RetireImage(Streamed.Current, LVK_UPLOAD_TICKET_NONE);
+				Streamed.Current = Streamed.Next;
+				Streamed.Current.Bindless = m_Bindless->AddImage(m_Device, Streamed.Current.View);
+				Streamed.Next = {};
+				Streamed.bChanging = false;
+			}
+			
+			// The level about as wide as the texture is drawn. Levels already resident stay wanted while it is
+			// still drawn, should the budget allow them, and a texture whose reads failed asks for nothing more.
+			u32 Wanted = Streamed.TailLevel;
+			if (m_Frame - Streamed.RequestedFrame <= m_Config.UnusedFrames && Streamed.RequestedPixels > 0.0f)
+			{
+				f32 Level = std::floor(std::log2(static_cast<f32>(Streamed.Info.Width) / Streamed.RequestedPixels));
+				Wanted = static_cast<u32>(std::clamp(Level, 0.0f, static_cast<f32>(Streamed.TailLevel)));
+				Wanted = std::min(Wanted, Streamed.Current.FirstLevel);
+				if (Streamed.bReadFailed)
+				{
+					Wanted = std::max(Wanted, std::min(Streamed.Current.FirstLevel, Streamed.TailLevel));
+				}
+			}
+			
+			for (u32 Level = Wanted; Level < Streamed.TailLevel; Level++)
+			{
+				m_Candidates.push_back({ Streamed.RequestedPixels / Streamed.Info.GetLevelWidth(Level), Handle, Level });
+			}
+			
+			Streamed.GrantedLevel = Streamed.TailLevel;
+			TailBytes += GetRangeBytes(Streamed, Streamed.TailLevel);
+			m_Stats.WantedBytes += GetRangeBytes(Streamed, Wanted);
+			m_Stats.ResidentBytes += Streamed.Current.FirstLevel < LevelCount ? GetRangeBytes(Streamed, Streamed.Current.FirstLevel) : 0;
+			m_Stats.Changing += Streamed.bChanging ? 1 : 0;
+		}
+		
+		// Levels are granted by worth until the budget runs out. Within a texture every level is worth
+		// twice the next finer one, so a texture's levels are always granted coarse to fine.
+		std::sort(m_Candidates.begin(), m_Candidates.end(), [](const Candidate& A, const Candidate& B){
+			return A.Worth != B.Worth ? A.Worth > B.Worth : A.Level > B.Level;
+		});
+		
+		u64 Remaining = m_Config.BudgetBytes > TailBytes ? m_Config.BudgetBytes - TailBytes : 0;
+		for (const Candidate& Granted : m_Candidates)
+		{
+			Texture& Streamed = m_Textures->GetMut(Granted.Texture);
+			u64 Bytes = GetLevelBytes(Streamed, Granted.Level);
+			if (Granted.Level + 1 == Streamed.GrantedLevel && Bytes <= Remaining)
+			{
+				Streamed.GrantedLevel = Granted.Level;
+				Remaining -= Bytes;
+			}
+		}
+		
+		// Evictions start first so their memory is back soonest, then the most worthwhile promotions.
+		u32 ChangesInFlight = m_Stats.Changing;
+		for (arch i = 0; i < m_Textures->Count() && ChangesInFlight < m_Config.MaxChangesInFlight; i++)
+		{
+			if (!m_Textures->IsValidAt(i))
+			{
+				continue;
+			}
+			
+			TextureHandle Handle = m_Textures->GetHandleAt(i);
+			Texture& Streamed = m_Textures->GetMut(Handle);
+			if (!Streamed.bChanging && Streamed.Current.FirstLevel < Streamed.Info.LevelCount && Streamed.GrantedLevel > Streamed.Current.FirstLevel)
+			{
+				StartChange(Handle, Streamed, Streamed.GrantedLevel);
+				ChangesInFlight++;
+			}
+		}
+		
+		for (const Candidate& Granted : m_Candidates)
+		{
+			if (ChangesInFlight >= m_Config.MaxChangesInFlight)
+			{
+				break;
+			}
+			
+			Texture& Streamed = m_Textures->GetMut(Granted.Texture);
+			if (!Streamed.bChanging && Streamed.Current.FirstLevel < Streamed.Info.LevelCount && Streamed.GrantedLevel < Streamed.Current.FirstLevel)
+			{
+				StartChange(Granted.Texture, Streamed, Streamed.GrantedLevel);
+				ChangesInFlight++;
+			}
+		}
+		
+		m_Stats.BudgetBytes = m_Config.BudgetBytes;
+		m_Frame++;
+	}
+	
+	void LVKTextureStreamer::RecordCopies(VkCommandBuffer Cmd)
+	{
+		std::vector<Texture*> Copied;
+		std::vector<VkImageMemoryBarrier> Barriers;
+		for (arch i = 0; i < m_Textures->Count(); i++)
+		{
+			if (!m_Textures->IsValidAt(i))
+			{
+				continue;
+			}
+			
+			Texture& Streamed = m_Textures->GetMut(m_Textures->GetHandleAt(i));
+			if (!Streamed.bChanging || Streamed.bCopied)
+			{
+				continue;
+			}
+			
+			// Frames before this one may still be sampling the levels being copied, the barrier waits for them.
+			u32 FirstLevel = std::max(Streamed.Current.FirstLevel, Streamed.Next.FirstLevel);
+			u32 LevelCount = Streamed.Info.LevelCount - FirstLevel;
+			Barriers.push_back(LVKImage::MemoryBarrier(Streamed.Current.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, FirstLevel - Streamed.Current.FirstLevel, LevelCount));
+			Barriers.push_back(LVKImage::MemoryBarrier(Streamed.Next.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, FirstLevel - Streamed.Next.FirstLevel, LevelCount));
+			Copied.push_back(&Streamed);
+		}
+		
+		if (Copied.empty())
+		{
+			return;
+		}
+		
+		vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<u32>(Barriers.size()), Barriers.data());
+		Barriers.clear();
+		
+		std::vector<VkImageCopy> Regions;
+		for (Texture* Streamed : Copied)
+		{
+			u32 FirstLevel = std::max(Streamed->Current.FirstLevel, Streamed->Next.FirstLevel);
+			u32 LevelCount = Streamed->Info.LevelCount - FirstLevel;
+			
+			Regions.clear();
+			for (u32 Level = FirstLevel; Level < Streamed->Info.LevelCount; Level++)
+			{
+				Regions.push_back({
+					.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, Level - Streamed->Current.FirstLevel, 0, 1 },
+					.srcOffset = { 0, 0, 0 },
+					.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, Level - Streamed->Next.FirstLevel, 0, 1 },
+					.dstOffset = { 0, 0, 0 },
+					.extent = { Streamed->Info.GetLevelWidth(Level), Streamed->Info.GetLevelHeight(Level), 1 },
+				});
+			}
+			vkCmdCopyImage(Cmd, Streamed->Current.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Streamed->Next.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<u32>(Regions.size()), Regions.data());
+			
+			Barriers.push_back(LVKImage::MemoryBarrier(Streamed->Current.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, FirstLevel - Streamed->Current.FirstLevel, LevelCount));
+			Barriers.push_back(LVKImage::MemoryBarrier(Streamed->Next.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, FirstLevel - Streamed->Next.FirstLevel, LevelCount));
+			Streamed->bCopied = true;
+		}
+		
+		vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, static_cast<u32>(Barriers.size()), Barriers.data());
+	}
+	
+	u64 LVKTextureStreamer::GetLevelBytes(const Texture& Streamed, u32 Level) const
+	{
+		u64 BlocksWide = (Streamed.Info.GetLevelWidth(Level) + Streamed.BlockExtent - 1) / Streamed.BlockExtent;
+		u64 BlocksHigh = (Streamed.Info.GetLevelHeight(Level) + Streamed.BlockExtent - 1) / Streamed.BlockExtent;
+		return BlocksWide * BlocksHigh * Streamed.BlockSize;
+	}
+	
+	u64 LVKTextureStreamer::GetRangeBytes(const Texture& Streamed, u32 FirstLevel) const
+	{
+		u64 Bytes = 0;
+		for (u32 Level = FirstLevel; Level < Streamed.Info.LevelCount; Level++)
+		{
+			Bytes += GetLevelBytes(Streamed, Level);
+		}
+		return Bytes;
+	}
+	
+	LVKTextureStreamer::Image LVKTextureStreamer::CreateImage(const Texture& Streamed, u32 FirstLevel)
+	{
+		// Also a copy source, for the image that replaces it.
+		VkExtent3D Extent = { Streamed.Info.GetLevelWidth(FirstLevel), Streamed.Info.GetLevelHeight(FirstLevel), 1 };
+		VkImageCreateInfo ImageInfo = LVKImage::CreateInfo(Streamed.Format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, Extent);
+		ImageInfo.mipLevels = Streamed.Info.LevelCount - FirstLevel;
+		VmaAllocationCreateInfo AllocInfo = {
+			.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+			.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		};
+		
+		Image NewImage;
+		NewImage.FirstLevel = FirstLevel;
+		VK_CHECK_RESULT(vmaCreateImage(m_Allocator, &ImageInfo, &AllocInfo, &NewImage.Image, &NewImage.Allocation, nullptr));
+		
+		VkImageViewCreateInfo ViewInfo = LVKImage::ViewCreateInfo(Streamed.Format, NewImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
+		ViewInfo.subresourceRange.levelCount = ImageInfo.mipLevels;
+		VK_CHECK_RESULT(vkCreateImageView(m_Device, &ViewInfo, nullptr, &NewImage.View));
+		return NewImage;
+	}
+	
+	void LVKTextureStreamer::RetireImage(const Image& Retired, LVKUploadTicket Upload)
+	{
+		if (Retired.Image == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		
+		// Uploads into it may not even have been recorded yet, it waits for them before the frames.
+		if (!m_Uploads->IsComplete(Upload))
+		{
+			m_Abandoned.push_back({ Retired, Upload });
+			return;
+		}
+		
+		VkDevice Device = m_Device;
+		VmaAllocator Allocator = m_Allocator;
+		LVKBindlessHeap* Bindless = m_Bindless;
+		m_Retire([=](){
+			if (Retired.Bindless != HANDLE_INVALID)
+			{
+				Bindless->Remove(Device, LVKBindlessType::SampledImage, Retired.Bindless);
+			}
+			vkDestroyImageView(Device, Retired.View, nullptr);
+			vmaDestroyImage(Allocator, Retired.Image, Retired.Allocation);
+		});
+	}
+	
+	void LVKTextureStreamer::StartChange(TextureHandle Handle, Texture& Streamed, u32 FirstLevel)
+	{
+		Streamed.bChanging = true;
+		Streamed.Next = CreateImage(Streamed, FirstLevel);
+		Streamed.Upload = LVK_UPLOAD_TICKET_NONE;
+		Streamed.bCopied = false;
+		Streamed.ReadId = 0;
+		
+		// Levels finer than any resident come from the file, read off the main thread.
+		if (FirstLevel < Streamed.Current.FirstLevel)
+		{
+			Streamed.ReadId = m_NextReadId++;
+			m_ReadsInFlight++;
+			JobSystem::Get().Submit([this, Handle, ReadId = Streamed.ReadId, Path = m_Paths[HandleIndex(Handle)], Info = Streamed.Info, FirstLevel, EndLevel = Streamed.Current.FirstLevel]() {
+				ReadLevels(Handle, ReadId, Path, Info, FirstLevel, EndLevel);
+				m_ReadsInFlight--;
+			});
+		}
+	}
+	
+	void LVKTextureStreamer::QueueUpload(Texture& Streamed, u32 Level, const u8* Data)
+	{
+		VkExtent3D Extent = { Streamed.Info.GetLevelWidth(Level), Streamed.Info.GetLevelHeight(Level), 1 };
+		Streamed.Upload = m_Uploads->UploadImageLevel(Streamed.Next.Image, Level - Streamed.Next.FirstLevel, Extent, Streamed.BlockExtent, Streamed.BlockSize, Data);
+	}
+	
+	void LVKTextureStreamer::ReadLevels(TextureHandle Handle, u32 ReadId, const std::string& Path, const TextureAssetInfo& Info, u32 FirstLevel, u32 EndLevel)
+	{
+		LevelRead Read = {
+			.Texture = Handle,
+			.ReadId = ReadId,
+			.Data = {},
+			.bFailed = true,
+		};
+		
+		ReadTextureFile(Path.c_str(), [&](const u8* Data, arch Size){
+			for (u32 Level = FirstLevel; Level < EndLevel; Level++)
+			{
+				// The file may have changed since it was loaded.
+				const TextureAssetLevel& Range = Info.Levels[Level];
+				if (Range.ByteOffset > Size || Range.ByteLength > Size - Range.ByteOffset)
+				{
+					return;
+				}
+				Read.Data.insert(Read.Data.end(), Data + Range.ByteOffset, Data + Range.ByteOffset + Range.ByteLength);
+			}
+			Read.bFailed = false;
+		});
+		
+		std::lock_guard<std::mutex> Lock(m_ReadMutex);
+		m_FinishedReads.push_back(std::move(Read));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "LVKBindlessHeap.hpp"
+#include "LVKCommon.hpp"
+#include "LVKUploadManager.hpp"
+#include "Base/Handles.hpp"
+#include "Graphics/GraphicsManager.hpp"
+#include "Graphics/TextureAsset.hpp"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Streamed textures.
+	
+	Textures are KTX2 files of BC1 to BC7, or plain RGBA8, see TextureAsset.hpp. Each one keeps
+	only the levels it needs resident. Its tail, every level no bigger than TailExtent, arrives with
+	it and stays until it is destroyed. Finer levels come in once they are asked for: every frame a
+	texture is drawn, the caller requests how many pixels wide it ends up on screen, and the level
+	about that wide is the finest the texture wants. Levels already resident are kept while the
+	texture is still being requested, and a texture nothing has requested for UnusedFrames falls
+	back to its tail.
+	
+	Everything wanted has to fit in a byte budget. A level is worth the pixels requested over its
+	own width, so levels the screen would sample finest come first and levels past what the screen
+	needs come last. Levels are granted in that order, always coarse to fine within a texture, until
+	the next one would not fit.
+	
+	There is no sparse residency. A texture changing its resident levels gets a new image holding
+	exactly the new range. Levels both images hold are copied across on the graphics queue, finer
+	ones are read from the file by a job and streamed in through the upload manager. Once all of it
+	has landed the new image takes over under a new bindless slot, and the old image is retired
+	with the frames that may still sample it, so the texture can be sampled throughout.
+*/
+
+namespace Locus
+{
+	struct LVKTextureStreamerConfig
+	{
+		u64 BudgetBytes = 256ull * 1024 * 1024; // Every texture's resident levels together
+		u32 MaxTextures = 4096;
+		u32 TailExtent = 128; // Levels this wide and high or smaller are always resident
+		u32 MaxChangesInFlight = 8; // Textures being reallocated at once
+		u32 UnusedFrames = 120; // Without a request before a texture drops to its tail
+	};
+	
+	struct LVKTextureStats
+	{
+		u32 Textures = 0;
+		u32 Changing = 0; // Reallocating to a new range of levels
+		u64 ResidentBytes = 0;
+		u64 WantedBytes = 0; // Would be resident with no budget
+		u64 BudgetBytes = 0;
+		u32 LevelsStreamedIn = 0; // Since start
+		u32 LevelsEvicted = 0;
+	};
+	
+	class LVKTextureStreamer
+	{
+	public:
+		LVKTextureStreamer() = default;
+		LVKTextureStreamer(const LVKTextureStreamer&) = delete;
+		LVKTextureStreamer& operator=(const LVKTextureStreamer&) = delete;
+		
+		// Textures are sampled with Sampler, block compressed ones only load with bTextureCompressionBC.
+		void Init(VkDevice Device, VmaAllocator Allocator, LVKUploadManager* Uploads, LVKBindlessHeap* Bindless, VkSampler Sampler, bool bTextureCompressionBC, std::function<void(std::function<void()>&&)>&& Retire, const LVKTextureStreamerConfig& Config);
+		void Destroy(); // The GPU must be idle, waits for reads in flight
+		
+		// Reads the file's header and tail, finer levels follow once they are requested.
+		TextureHandle LoadTexture(const char* LogicalPath);
+		void DestroyTexture(TextureHandle Texture);
+		
+		// ScreenPixels is how wide the texture ends up on screen, the largest of this frame's requests counts.
+		void Request(TextureHandle Texture, f32 ScreenPixels);
+		
+		// Bindless indices to sample with, false until the tail has arrived. The image index changes
+		// whenever the resident levels do, so it has to be fetched every frame.
+		bool GetBinding(TextureHandle Texture, u32& OutImageIndex, u32& OutSamplerIndex) const;
+		
+		void SetBudget(u64 Bytes) { m_Config.BudgetBytes = Bytes; }
+		
+		// Once a frame, before the bindless heap is synced for it. Takes over finished changes, shares
+		// the budget out from the last frame's requests and starts the changes that follow.
+		void Update();
+		
+		// Copies of the levels changing textures keep, into the frame's command buffer ahead of its passes.
+		void RecordCopies(VkCommandBuffer Cmd);
+		
+		const LVKTextureStats& GetStats() const { return m_Stats; }
+	
+	private:
+		struct Image
+		{
+			VkImage Image = VK_NULL_HANDLE;
+			VmaAllocation Allocation = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			LVKBindlessHandle Bindless = HANDLE_INVALID;
+			u32 FirstLevel = 0; // Of the texture, the image's level 0
+		};
+		
+		// Plain data, it lives in a Pool. The path is kept in m_Paths at the same index.
+		struct Texture
+		{
+			TextureAssetInfo Info;
+			VkFormat Format;
+			u32 BlockExtent;
+			u32 BlockSize;
+			u32 TailLevel;
+			u32 GrantedLevel;
+			f32 RequestedPixels; // Largest of the frame it was last requested in
+			u64 RequestedFrame;
+			
+			Image Current; // FirstLevel is the level count until the tail has arrived
+			bool bChanging;
+			Image Next;
+			u32 ReadId; // Non-zero while the job reading Next's new levels runs
+			LVKUploadTicket Upload; // Last of Next's new levels
+			bool bCopied; // Levels kept from Current have been recorded into a frame
+			bool bReadFailed; // Stays with the levels it has
+		};
+		
+		struct LevelRead
+		{
+			TextureHandle Texture;
+			u32 ReadId;
+			std::vector<u8> Data; // Consecutive levels, finest first
+			bool bFailed;
+		};
+		
+		struct AbandonedImage
+		{
+			Image Abandoned;
+			LVKUploadTicket Upload; // Retired once the uploads into it are done
+		};
+		
+		u64 GetLevelBytes(const Texture& Streamed, u32 Level) const;
+		u64 GetRangeBytes(const Texture& Streamed, u32 FirstLevel) const;
+		Image CreateImage(const Texture& Streamed, u32 FirstLevel);
+		void RetireImage(const Image& Retired, LVKUploadTicket Upload);
+		void StartChange(TextureHandle Handle, Texture& Streamed, u32 FirstLevel);
+		void QueueUpload(Texture& Streamed, u32 Level, const u8* Data);
+		void ReadLevels(TextureHandle Handle, u32 ReadId, const std::string& Path, const TextureAssetInfo& Info, u32 FirstLevel, u32 EndLevel); // On a job
+		
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		LVKUploadManager* m_Uploads = nullptr;
+		LVKBindlessHeap* m_Bindless = nullptr;
+		LVKBindlessHandle m_Sampler = HANDLE_INVALID;
+		bool m_bTextureCompressionBC = false;
+		std::function<void(std::function<void()>&&)> m_Retire;
+		LVKTextureStreamerConfig m_Config;
+		
+		Unique<Pool<Texture>> m_Textures;
+		std::vector<std::string> m_Paths;
+		std::vector<AbandonedImage> m_Abandoned;
+		u64 m_Frame = 0;
+		u32 m_NextReadId = 1;
+		
+		struct Candidate
+		{
+			f32 Worth;
+			TextureHandle Texture;
+			u32 Level;
+		};
+		std::vector<Candidate> m_Candidates; // Reused every frame
+		
+		std::mutex m_ReadMutex;
+		std::vector<LevelRead> m_FinishedReads;
+		std::atomic<u32> m_ReadsInFlight {0};
+		
+		LVKTextureStats m_Stats;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "LVKTimeline.hpp"
+
+namespace Locus
+{
+	void LVKTimeline::Init(VkDevice Device)
+	{
+		VkSemaphoreTypeCreateInfo TypeInfo = {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.pNext = nullptr,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+		
+		VkSemaphoreCreateInfo CreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &TypeInfo,
+			.flags = 0,
+		};
+		
+		VK_CHECK_RESULT(vkCreateSemaphore(Device, &CreateInfo, nullptr, &Semaphore));
+		LastSubmitted = 0;
+		Completed = 0;
+	}
+	
+	void LVKTimeline::Destroy(VkDevice Device)
+	{
+		vkDestroySemaphore(Device, Semaphore, nullptr);
+		Semaphore = VK_NULL_HANDLE;
+	}
+	
+	u64 LVKTimeline::Poll(VkDevice Device)
+	{
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(Device, Semaphore, &Completed));
+		return Completed;
+	}
+	
+	void LVKTimeline::Wait(VkDevice Device, u64 Value)
+	{
+		if (Value <= Completed)
+		{
+			return;
+		}
+		
+		VkSemaphoreWaitInfo WaitInfo = {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.semaphoreCount = 1,
+			.pSemaphores = &Semaphore,
+			.pValues = &Value,
+		};
+		
+		VK_CHECK_RESULT(vkWaitSemaphores(Device, &WaitInfo, UINT64_MAX));
+		Poll(Device);
+	}
+	
+	VkSemaphoreSubmitInfo LVKTimeline::SubmitInfo(u64 Value, VkPipelineStageFlags2 Stages) const
+	{
+		return {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.semaphore = Semaphore,
+			.value = Value,
+			.stageMask = Stages,
+			.deviceIndex = 0,
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+
+/*
+	Timeline semaphore for one queue. Every submission to the queue signals the next value, so
+	"has submission N finished" becomes a single counter comparison instead of a fence per frame.
+*/
+
+namespace Locus
+{
+	struct LVKTimeline
+	{
+		VkSemaphore Semaphore = VK_NULL_HANDLE;
+		u64 LastSubmitted = 0;
+		u64 Completed = 0; // Cached, refreshed by Poll and Wait
+		
+		void Init(VkDevice Device);
+		void Destroy(VkDevice Device);
+		
+		// The value the next submission will signal. Anything used before then is free once it completes.
+		u64 GetNextValue() const { return LastSubmitted + 1; }
+		u64 Advance() { return ++LastSubmitted; } // Claim the value for a submission about to be made
+		
+		u64 Poll(VkDevice Device);
+		void Wait(VkDevice Device, u64 Value);
+		bool IsComplete(u64 Value) const { return Value <= Completed; }
+		
+		VkSemaphoreSubmitInfo SubmitInfo(u64 Value, VkPipelineStageFlags2 Stages) const;
+	};
+}
\ No newline at end of file
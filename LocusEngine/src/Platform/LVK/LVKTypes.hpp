@@ -15,6 +15,16 @@ namespace Locus
 		TArray<VkPhysicalDeviceType> AllowedDeviceTypes;
 	};
 
+	// Optional features detected on the physical device and enabled on the logical device.
+	struct LVKDeviceCapabilities
+	{
+		bool bDescriptorIndexing = false; // Update-after-bind, partially bound, runtime sized descriptor arrays
+		f32 TimestampPeriod = 0.0f; // Nanoseconds per tick, zero if the graphics queue can't write timestamps
+		bool bDrawIndirectCount = false; // vkCmdDrawIndexedIndirectCount, optional in Vulkan 1.2
+		bool bTextureCompressionBC = false; // BC1 to BC7 images, near universal on desktop
+		bool bPresentWait = false; // VK_KHR_present_id and VK_KHR_present_wait, waiting on a present reaching the screen
+	};
+	
 	struct LVKQueueFamilyIndices
 	{
 		bool GraphicsFamilyPresent = false;
@@ -23,7 +33,16 @@ namespace Locus
 		bool PresentFamilyPresent = false;
 		u32 PresentFamilyIndex = 0;
 		
+		// Dedicated families, without graphics. Work falls back to the graphics family when absent.
+		bool TransferFamilyPresent = false;
+		u32 TransferFamilyIndex = 0;
+		
+		bool ComputeFamilyPresent = false;
+		u32 ComputeFamilyIndex = 0;
+		
 		inline bool IsComplete();
+		inline u32 GetTransferFamily() const { return TransferFamilyPresent ? TransferFamilyIndex : GraphicsFamilyIndex; }
+		inline u32 GetComputeFamily() const { return ComputeFamilyPresent ? ComputeFamilyIndex : GraphicsFamilyIndex; }
 	};
 	
 	bool LVKQueueFamilyIndices::IsComplete() 
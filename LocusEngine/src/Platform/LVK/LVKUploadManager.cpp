@@ -0,0 +1,338 @@
+#include "LVKUploadManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Locus
+{
+	static constexpr VkDeviceSize UPLOAD_ALIGNMENT = 16; // Covers optimalBufferCopyOffsetAlignment and texel sizes in practice
+	
+	void LVKUploadManager::Init(VkDevice Device, VmaAllocator Allocator, LVKTimeline* Timeline, const LVKUploadManagerConfig& Config)
+	{
+		m_Config = Config;
+		m_Timeline = Timeline;
+		
+		m_Ring = LVKBuffer::Allocate(Config.RingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, Allocator, VMA_MEMORY_USAGE_CPU_ONLY);
+		m_RingData = static_cast<u8*>(m_Ring.Info.pMappedData);
+		
+		VkCommandPoolCreateInfo PoolInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+			.queueFamilyIndex = Config.QueueFamily
+		};
+		
+		
+		for (Batch& Batch : m_Batches)
+		{
+			VK_CHECK_RESULT(vkCreateCommandPool(Device, &PoolInfo, nullptr, &Batch.CommandPool));
+			
+			VkCommandBufferAllocateInfo AllocInfo = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.commandPool = Batch.CommandPool,
+				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1,
+			};
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(Device, &AllocInfo, &Batch.CommandBuffer));
+		}
+		
+		LLOG(Vulkan, Info, "Uploads use %s.", IsCrossQueue() ? "a dedicated transfer queue" : "the graphics queue");
+	}
+	
+	void LVKUploadManager::Destroy(VkDevice Device, VmaAllocator Allocator)
+	{
+		for (Batch& Batch : m_Batches)
+		{
+			if (Batch.bInFlight)
+			{
+				m_Timeline->Wait(Device, Batch.TimelineValue);
+			}
+			vkDestroyCommandPool(Device, Batch.CommandPool, nullptr);
+			Batch = {};
+		}
+		
+		vmaDestroyBuffer(Allocator, m_Ring.Buffer, m_Ring.Allocation);
+		m_RingData = nullptr;
+		m_Pending.clear();
+	}
+	
+	LVKUploadTicket LVKUploadManager::UploadBuffer(VkBuffer Dst, VkDeviceSize DstOffset, const void* Data, VkDeviceSize Size)
+	{
+		Request& NewRequest = m_Pending.emplace_back();
+		NewRequest.Ticket = m_NextTicket++;
+		NewRequest.Data.assign(static_cast<const u8*>(Data), static_cast<const u8*>(Data) + Size);
+		NewRequest.Buffer = Dst;
+		NewRequest.BufferOffset = DstOffset;
+		return NewRequest.Ticket;
+	}
+	
+	LVKUploadTicket LVKUploadManager::UploadImage(VkImage Dst, VkExtent3D Extent, u32 TexelSize, const void* Data, VkImageLayout FinalLayout)
+	{
+		return UploadImageLevel(Dst, 0, Extent, 1, TexelSize, Data, FinalLayout);
+	}
+	
+	LVKUploadTicket LVKUploadManager::UploadImageLevel(VkImage Dst, u32 MipLevel, VkExtent3D Extent, u32 BlockExtent, u32 BlockSize, const void* Data, VkImageLayout FinalLayout)
+	{
+		LAssertMsg(Extent.depth == 1, "Only 2D images can be uploaded.");
+		
+		arch BlocksWide = (Extent.width + BlockExtent - 1) / BlockExtent;
+		arch BlocksHigh = (Extent.height + BlockExtent - 1) / BlockExtent;
+		LAssertMsg(BlocksWide * BlockSize <= m_Config.RingSize, "A single image row does not fit in the staging ring.");
+		
+		Request& NewRequest = m_Pending.emplace_back();
+		NewRequest.Ticket = m_NextTicket++;
+		NewRequest.Data.assign(static_cast<const u8*>(Data), static_cast<const u8*>(Data) + BlocksWide * BlocksHigh * BlockSize);
+		NewRequest.bImage = true;
+		NewRequest.Image = Dst;
+		NewRequest.MipLevel = MipLevel;
+		NewRequest.Extent = Extent;
+		NewRequest.BlockExtent = BlockExtent;
+		NewRequest.BlockSize = BlockSize;
+		NewRequest.FinalLayout = FinalLayout;
+		return NewRequest.Ticket;
+	}
+	
+	void LVKUploadManager::Retire(VkDevice Device)
+	{
+		// Oldest first, the ring tail can only move past batches that finished in order.
+		m_Timeline->Poll(Device);
+		for (u32 i = 0; i < BATCH_COUNT; i++)
+		{
+			Batch& Oldest = m_Batches[(m_NextBatch + i) % BATCH_COUNT];
+			if (!Oldest.bInFlight)
+			{
+				continue;
+			}
+			
+			if (!m_Timeline->IsComplete(Oldest.TimelineValue))
+			{
+				break;
+			}
+			
+			Oldest.bInFlight = false;
+			m_RingTail = Oldest.RingEnd;
+			m_CompletedTicket = Oldest.LastTicket;
+		}
+	}
+	
+	bool LVKUploadManager::AllocateRing(VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& OutOffset)
+	{
+		u64 Offset = (m_RingHead + Alignment - 1) & ~(Alignment - 1);
+		u64 Position = Offset % m_Config.RingSize;
+		if (Position + Size > m_Config.RingSize)
+		{
+			// Never split a copy across the end, skip ahead to the start of the ring.
+			Offset += m_Config.RingSize - Position;
+		}
+		
+		if (Offset + Size - m_RingTail > m_Config.RingSize)
+		{
+			return false;
+		}
+		
+		OutOffset = Offset % m_Config.RingSize;
+		m_RingHead = Offset + Size;
+		return true;
+	}
+	
+	u64 LVKUploadManager::Flush(VkDevice Device, VkQueue Queue)
+	{
+		Retire(Device);
+		m_BytesLastFlush = 0;
+		
+		if (m_Pending.empty())
+		{
+			return 0;
+		}
+		
+		Batch& Current = m_Batches[m_NextBatch];
+		if (Current.bInFlight)
+		{
+			// Every batch is still on the GPU, try again next frame rather than wait.
+			return 0;
+		}
+		
+		VK_CHECK_RESULT(vkResetCommandPool(Device, Current.CommandPool, 0));
+		VkCommandBufferBeginInfo BeginInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = nullptr,
+		};
+		VK_CHECK_RESULT(vkBeginCommandBuffer(Current.CommandBuffer, &BeginInfo));
+		
+		VkCommandBuffer Cmd = Current.CommandBuffer;
+		VkDeviceSize Budget = m_Config.FrameBudget;
+		LVKUploadTicket LastTicket = m_Batches[(m_NextBatch + BATCH_COUNT - 1) % BATCH_COUNT].LastTicket;
+		LastTicket = std::max(LastTicket, m_CompletedTicket);
+		
+		while (!m_Pending.empty() && Budget > 0)
+		{
+			Request& Upload = m_Pending.front();
+			VkDeviceSize Remaining = Upload.Data.size() - Upload.Uploaded;
+			VkDeviceSize ChunkSize = std::min({ Remaining, Budget, m_Config.RingSize });
+			
+			// Rows of blocks for images, a block is a texel unless the format is compressed.
+			u32 FirstRow = 0;
+			u32 RowCount = 0;
+			if (Upload.bImage)
+			{
+				VkDeviceSize RowSize = static_cast<VkDeviceSize>((Upload.Extent.width + Upload.BlockExtent - 1) / Upload.BlockExtent) * Upload.BlockSize;
+				FirstRow = static_cast<u32>(Upload.Uploaded / RowSize);
+				RowCount = static_cast<u32>(ChunkSize / RowSize);
+				if (RowCount == 0 && m_BytesLastFlush == 0)
+				{
+					// A row wider than the budget still has to go through in one piece.
+					RowCount = 1;
+				}
+				if (RowCount == 0)
+				{
+					break;
+				}
+				ChunkSize = RowCount * RowSize;
+			}
+			
+			VkDeviceSize Offset;
+			if (!AllocateRing(ChunkSize, UPLOAD_ALIGNMENT, Offset))
+			{
+				break;
+			}
+			
+			memcpy(m_RingData + Offset, Upload.Data.data() + Upload.Uploaded, ChunkSize);
+			
+			if (Upload.bImage)
+			{
+				if (Upload.Uploaded == 0)
+				{
+					LVKImage::TransitionLazy(Cmd, LVKImage::MemoryBarrier(Upload.Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, Upload.MipLevel, 1));
+				}
+				
+				// The last row of blocks can run past the level's edge, the copy stops at it.
+				u32 FirstTexelRow = FirstRow * Upload.BlockExtent;
+				u32 TexelRows = std::min(RowCount * Upload.BlockExtent, Upload.Extent.height - FirstTexelRow);
+				
+				VkBufferImageCopy Region = {
+					.bufferOffset = Offset,
+					.bufferRowLength = 0,
+					.bufferImageHeight = 0,
+					.imageSubresource = {
+						.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+						.mipLevel = Upload.MipLevel,
+						.baseArrayLayer = 0,
+						.layerCount = 1,
+					},
+					.imageOffset = { 0, static_cast<i32>(FirstTexelRow), 0 },
+					.imageExtent = { Upload.Extent.width, TexelRows, 1 },
+				};
+				vkCmdCopyBufferToImage(Cmd, m_Ring.Buffer, Upload.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Region);
+			}
+			else
+			{
+				VkBufferCopy Region = {
+					.srcOffset = Offset,
+					.dstOffset = Upload.BufferOffset + Upload.Uploaded,
+					.size = ChunkSize,
+				};
+				vkCmdCopyBuffer(Cmd, m_Ring.Buffer, Upload.Buffer, 1, &Region);
+				
+				if (IsCrossQueue())
+				{
+					VkBufferMemoryBarrier Release = LVKBuffer::OwnershipBarrier(Upload.Buffer, Region.dstOffset, ChunkSize, m_Config.QueueFamily, m_Config.DstQueueFamily);
+					Release.dstAccessMask = 0;
+					vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &Release, 0, nullptr);
+					
+					VkBufferMemoryBarrier Acquire = LVKBuffer::OwnershipBarrier(Upload.Buffer, Region.dstOffset, ChunkSize, m_Config.QueueFamily, m_Config.DstQueueFamily);
+					Acquire.srcAccessMask = 0;
+					m_BufferAcquires.push_back(Acquire);
+				}
+			}
+			
+			Upload.Uploaded += ChunkSize;
+			Budget -= std::min(Budget, ChunkSize);
+			m_BytesLastFlush += ChunkSize;
+			
+			if (Upload.Uploaded == Upload.Data.size())
+			{
+				if (Upload.bImage && IsCrossQueue())
+				{
+					LVKImage::ReleaseOwnership(Cmd, Upload.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, Upload.FinalLayout, m_Config.QueueFamily, m_Config.DstQueueFamily, Upload.MipLevel, 1);
+					m_ImageAcquires.push_back({ Upload.Image, Upload.MipLevel, Upload.FinalLayout });
+				}
+				else if (Upload.bImage)
+				{
+					LVKImage::TransitionLazy(Cmd, LVKImage::MemoryBarrier(Upload.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, Upload.FinalLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, Upload.MipLevel, 1));
+				}
+				LastTicket = Upload.Ticket;
+				m_Pending.pop_front();
+			}
+		}
+		
+		if (m_BytesLastFlush == 0)
+		{
+			// The ring is full of data still in flight.
+			VK_CHECK_RESULT(vkEndCommandBuffer(Cmd));
+			return 0;
+		}
+		
+		if (!IsCrossQueue())
+		{
+			// Make the copies visible to whatever the next submissions on this queue do with them.
+			VkMemoryBarrier Barrier = {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+			};
+			vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &Barrier, 0, nullptr, 0, nullptr);
+		}
+		
+		VK_CHECK_RESULT(vkEndCommandBuffer(Cmd));
+		
+		Current.TimelineValue = m_Timeline->Advance();
+		
+		VkCommandBufferSubmitInfo CommandBufferInfo = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.pNext = nullptr,
+			.commandBuffer = Cmd,
+			.deviceMask = 0
+		};
+		VkSemaphoreSubmitInfo SignalInfo = m_Timeline->SubmitInfo(Current.TimelineValue, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+		
+		VkSubmitInfo2 SubmitInfo = {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.pNext = nullptr,
+			.flags = 0,
+			.waitSemaphoreInfoCount = 0,
+			.pWaitSemaphoreInfos = nullptr,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &CommandBufferInfo,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &SignalInfo,
+		};
+		VK_CHECK_RESULT(vkQueueSubmit2(Queue, 1, &SubmitInfo, VK_NULL_HANDLE));
+		
+		Current.bInFlight = true;
+		Current.RingEnd = m_RingHead;
+		Current.LastTicket = LastTicket;
+		m_NextBatch = (m_NextBatch + 1) % BATCH_COUNT;
+		
+		// On the same queue submission order already covers it.
+		return IsCrossQueue() ? Current.TimelineValue : 0;
+	}
+	
+	void LVKUploadManager::RecordAcquires(VkCommandBuffer Cmd)
+	{
+		if (!m_BufferAcquires.empty())
+		{
+			vkCmdPipelineBarrier(Cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, static_cast<u32>(m_BufferAcquires.size()), m_BufferAcquires.data(), 0, nullptr);
+			m_BufferAcquires.clear();
+		}
+		
+		for (const ImageAcquire& Acquire : m_ImageAcquires)
+		{
+			LVKImage::AcquireOwnership(Cmd, Acquire.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, Acquire.Layout, m_Config.QueueFamily, m_Config.DstQueueFamily, Acquire.MipLevel, 1);
+		}
+		m_ImageAcquires.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "LVKCommon.hpp"
+#include "LVKResources.hpp"
+#include "LVKTimeline.hpp"
+
+#include <deque>
+#include <vector>
+
+/*
+	Streams data to the GPU through a persistently mapped staging ring.
+	
+	Uploads are queued with their own copy of the data and recorded in Flush, once per frame,
+	into a single transfer submission. Each batch signals a value on the queue's timeline, and
+	completed batches release their part of the ring when polled at the start of the next
+	Flush, so nothing ever waits on the GPU. A per-frame byte budget caps how much is copied each frame; bigger uploads are
+	split into chunks (whole rows of texels or compressed blocks for images) and continue over the following frames.
+	
+	On a dedicated transfer queue the copies overlap with rendering. Each batch then releases
+	what it wrote to the destination family, and the consuming queue waits for the batch's
+	timeline value and records the matching acquires with RecordAcquires.
+*/
+
+namespace Locus
+{
+	using LVKUploadTicket = u64; // Monotonic, compare against GetCompletedTicket
+	constexpr LVKUploadTicket LVK_UPLOAD_TICKET_NONE = 0;
+	
+	struct LVKUploadManagerConfig
+	{
+		VkDeviceSize RingSize = 32 * 1024 * 1024;
+		VkDeviceSize FrameBudget = 8 * 1024 * 1024;
+		u32 QueueFamily = 0; // Family the copies are submitted to
+		u32 DstQueueFamily = 0; // Family that uses the results
+	};
+	
+	class LVKUploadManager
+	{
+	public:
+		// Timeline belongs to the queue Flush submits to and must outlive the manager.
+		void Init(VkDevice Device, VmaAllocator Allocator, LVKTimeline* Timeline, const LVKUploadManagerConfig& Config);
+		void Destroy(VkDevice Device, VmaAllocator Allocator); // Waits for batches in flight
+		
+		LVKUploadTicket UploadBuffer(VkBuffer Dst, VkDeviceSize DstOffset, const void* Data, VkDeviceSize Size);
+		
+		// Whole 2D image of a single level, tightly packed rows. The image ends in FinalLayout.
+		LVKUploadTicket UploadImage(VkImage Dst, VkExtent3D Extent, u32 TexelSize, const void* Data, VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		
+		// One level of a 2D image, Extent being the level's own. Data is tightly packed rows of square
+		// blocks of BlockExtent texels and BlockSize bytes, one texel for plain formats and four for
+		// block compressed ones. Only this level changes layout, the others are left as they are.
+		LVKUploadTicket UploadImageLevel(VkImage Dst, u32 MipLevel, VkExtent3D Extent, u32 BlockExtent, u32 BlockSize, const void* Data, VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		
+		// Records and submits this frame's batch. Call before the frame's own submission.
+		// Returns the timeline value that submission has to wait on, or 0 if it need not wait.
+		u64 Flush(VkDevice Device, VkQueue Queue);
+		
+		// Ownership acquires for the last flushed batch, into a command buffer of the destination family.
+		void RecordAcquires(VkCommandBuffer Cmd);
+		
+		bool IsCrossQueue() const { return m_Config.QueueFamily != m_Config.DstQueueFamily; }
+		
+		bool IsComplete(LVKUploadTicket Ticket) const { return Ticket <= m_CompletedTicket; }
+		LVKUploadTicket GetCompletedTicket() const { return m_CompletedTicket; }
+		
+		u32 GetPendingUploads() const { return static_cast<u32>(m_Pending.size()); }
+		VkDeviceSize GetBytesLastFlush() const { return m_BytesLastFlush; }
+	
+	private:
+		struct Request
+		{
+			LVKUploadTicket Ticket;
+			std::vector<u8> Data;
+			VkDeviceSize Uploaded = 0;
+			
+			bool bImage = false;
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VkDeviceSize BufferOffset = 0;
+			VkImage Image = VK_NULL_HANDLE;
+			u32 MipLevel = 0;
+			VkExtent3D Extent = {};
+			u32 BlockExtent = 1;
+			u32 BlockSize = 0; // Bytes, a texel's for plain formats
+			VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+		
+		struct Batch
+		{
+			VkCommandPool CommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			u64 TimelineValue = 0;
+			bool bInFlight = false;
+			u64 RingEnd = 0; // Ring head once this batch was recorded
+			LVKUploadTicket LastTicket = LVK_UPLOAD_TICKET_NONE; // Highest ticket finished by this batch
+		};
+		
+		void Retire(VkDevice Device);
+		bool AllocateRing(VkDeviceSize Size, VkDeviceSize Alignment, VkDeviceSize& OutOffset);
+		
+		static constexpr u32 BATCH_COUNT = 4;
+		
+		LVKUploadManagerConfig m_Config;
+		LVKTimeline* m_Timeline = nullptr;
+		LVKBuffer m_Ring = {};
+		u8* m_RingData = nullptr;
+		u64 m_RingHead = 0; // Both grow forever, positions are taken modulo the ring size
+		u64 m_RingTail = 0;
+		
+		Batch m_Batches[BATCH_COUNT];
+		u32 m_NextBatch = 0;
+		
+		struct ImageAcquire
+		{
+			VkImage Image;
+			u32 MipLevel;
+			VkImageLayout Layout;
+		};
+		
+		std::deque<Request> m_Pending;
+		std::vector<VkBufferMemoryBarrier> m_BufferAcquires;
+		std::vector<ImageAcquire> m_ImageAcquires;
+		LVKUploadTicket m_NextTicket = 1;
+		LVKUploadTicket m_CompletedTicket = LVK_UPLOAD_TICKET_NONE;
+		VkDeviceSize m_BytesLastFlush = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "PackFile.hpp"
+
+#include "Base/Compression.hpp"
+#include "Base/Hash.hpp"
+#include "Platform/Platform.hpp"
+
+#include <algorithm>
+
+namespace Locus
+{
+	static u64 AlignUp(u64 Value, u64 Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+	
+	u64 PackHashPath(const char* LogicalPath)
+	{
+		return Hash::FNV1a64String(LogicalPath);
+	}
+	
+	void PackWriter::AddFile(const char* LogicalPath, const u8* Data, arch Size, bool bCompress)
+	{
+		PendingFile File;
+		File.LogicalPath = LogicalPath;
+		File.Size = Size;
+		File.Flags = 0;
+		
+		if (bCompress && Size > 0)
+		{
+			std::vector<u8> Compressed(Compression::LZ4CompressBound(Size));
+			arch CompressedSize = Compression::LZ4Compress(Data, Size, Compressed.data(), Compressed.size());
+			
+			// Only keep the compressed form when it is worth the decode cost.
+			if (CompressedSize > 0 && CompressedSize < (Size - Size / 8))
+			{
+				Compressed.resize(CompressedSize);
+				File.Data = std::move(Compressed);
+				File.Flags |= PACK_ENTRY_COMPRESSED_LZ4;
+			}
+		}
+		
+		if (!(File.Flags & PACK_ENTRY_COMPRESSED_LZ4))
+		{
+			File.Data.assign(Data, Data + Size);
+		}
+		
+		m_Files.push_back(std::move(File));
+	}
+	
+	bool PackWriter::Write(const char* OutputPath)
+	{
+		std::vector<PackEntry> Entries(m_Files.size());
+		std::vector<u32> Order(m_Files.size());
+		for (arch i = 0; i < m_Files.size(); i++)
+		{
+			Entries[i].PathHash = PackHashPath(m_Files[i].LogicalPath.c_str());
+			Order[i] = static_cast<u32>(i);
+		}
+		
+		std::sort(Order.begin(), Order.end(), [&](u32 A, u32 B) {
+			if (Entries[A].PathHash != Entries[B].PathHash)
+			{
+				return Entries[A].PathHash < Entries[B].PathHash;
+			}
+			return m_Files[A].LogicalPath < m_Files[B].LogicalPath;
+		});
+		
+		std::vector<char> StringTable;
+		for (u32 Index : Order)
+		{
+			Entries[Index].PathOffset = static_cast<u32>(StringTable.size());
+			const std::string& Path = m_Files[Index].LogicalPath;
+			StringTable.insert(StringTable.end(), Path.begin(), Path.end());
+			StringTable.push_back('\0');
+		}
+		
+		u64 StringTableOffset = sizeof(PackHeader) + sizeof(PackEntry) * m_Files.size();
+		PackHeader Header = {
+			.Magic = PACK_MAGIC,
+			.Version = PACK_VERSION,
+			.EntryCount = static_cast<u32>(m_Files.size()),
+			.Reserved = 0,
+			.TocOffset = sizeof(PackHeader),
+			.StringTableOffset = StringTableOffset,
+			.StringTableSize = StringTable.size(),
+			.DataOffset = AlignUp(StringTableOffset + StringTable.size(), PACK_ALIGNMENT),
+		};
+		
+		u64 Cursor = Header.DataOffset;
+		for (u32 Index : Order)
+		{
+			PackEntry& Entry = Entries[Index];
+			const PendingFile& File = m_Files[Index];
+			Entry.Offset = Cursor;
+			Entry.StoredSize = File.Data.size();
+			Entry.Size = File.Size;
+			Entry.Flags = File.Flags;
+			Cursor = AlignUp(Cursor + Entry.StoredSize, PACK_ALIGNMENT);
+		}
+		
+		std::vector<u8> Output(Cursor, 0);
+		memcpy(Output.data(), &Header, sizeof(PackHeader));
+		
+		u8* Toc = Output.data() + Header.TocOffset;
+		for (u32 Index : Order)
+		{
+			memcpy(Toc, &Entries[Index], sizeof(PackEntry));
+			Toc += sizeof(PackEntry);
+			
+			if (!m_Files[Index].Data.empty())
+			{
+				memcpy(Output.data() + Entries[Index].Offset, m_Files[Index].Data.data(), m_Files[Index].Data.size());
+			}
+		}
+		
+		if (!StringTable.empty())
+		{
+			memcpy(Output.data() + Header.StringTableOffset, StringTable.data(), StringTable.size());
+		}
+		
+		return Platform::FileWriteBytes(OutputPath, Output.data(), Output.size());
+	}
+}
\ No newline at end of file
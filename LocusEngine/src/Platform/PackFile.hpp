@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+	Locus pack file (.lpak) layout:
+	
+	[PackHeader]
+	[PackEntry x EntryCount]		- sorted by PathHash for binary search
+	[String table]					- null terminated logical paths, referenced by PackEntry::PathOffset
+	[Entry data ...]				- each entry starts on a PACK_ALIGNMENT boundary
+	
+	Logical paths are relative to the content root and always use '/' separators,
+	e.g. "shaders/triangle.vert.spv". All integers are little endian.
+*/
+
+namespace Locus
+{
+	constexpr u32 PACK_MAGIC = 0x4B41504C; // "LPAK"
+	constexpr u32 PACK_VERSION = 1;
+	constexpr u64 PACK_ALIGNMENT = 64;
+	
+	enum PackEntryFlags : u32
+	{
+		PACK_ENTRY_COMPRESSED_LZ4 = 1 << 0,
+	};
+	
+	struct PackHeader
+	{
+		u32 Magic;
+		u32 Version;
+		u32 EntryCount;
+		u32 Reserved;
+		u64 TocOffset;
+		u64 StringTableOffset;
+		u64 StringTableSize;
+		u64 DataOffset;
+	};
+	CHECK_SIZE_COMPTIME(PackHeader, 48)
+	
+	struct PackEntry
+	{
+		u64 PathHash;
+		u64 Offset;			// From the start of the file
+		u64 StoredSize;		// Size in the pack, compressed or not
+		u64 Size;			// Size once decompressed
+		u32 PathOffset;		// Into the string table
+		u32 Flags;
+	};
+	CHECK_SIZE_COMPTIME(PackEntry, 40)
+	
+	u64 PackHashPath(const char* LogicalPath);
+	
+	class PackWriter
+	{
+	public:
+		void AddFile(const char* LogicalPath, const u8* Data, arch Size, bool bCompress);
+		bool Write(const char* OutputPath);
+		
+		arch GetEntryCount() const { return m_Files.size(); }
+	
+	private:
+		struct PendingFile
+		{
+			std::string LogicalPath;
+			std::vector<u8> Data;
+			u64 Size;
+			u32 Flags;
+		};
+		
+		std::vector<PendingFile> m_Files;
+	};
+}
\ No newline at end of file
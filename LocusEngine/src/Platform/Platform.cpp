@@ -5,8 +5,18 @@
 
 #include <chrono>
 #include <thread>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 
+#if LOCUS_PLATFORM_LINUX || LOCUS_PLATFORM_MACOS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
 namespace Locus
 {
 	namespace Platform
@@ -16,6 +26,25 @@ namespace Locus
 			std::this_thread::sleep_for(std::chrono::milliseconds(Milliseconds));
 		}
 		
+		bool FileExists(const char* Path)
+		{
+			std::ifstream File(Path, std::ios::binary);
+			return File.is_open();
+		}
+		
+		bool ListDirectory(const char* Directory, std::vector<std::string>& OutFiles)
+		{
+			std::error_code Error;
+			for (const std::filesystem::directory_entry& Entry : std::filesystem::directory_iterator(Directory, Error))
+			{
+				if (Entry.is_regular_file(Error))
+				{
+					OutFiles.push_back(Entry.path().string());
+				}
+			}
+			return !Error;
+		}
+		
 		bool FileGetSize(const char* Path, arch& Size)
 		{
 			std::ifstream File(Path, std::ios::ate | std::ios::binary);
@@ -41,5 +70,133 @@ namespace Locus
 			File.close();
 			return true;
 		}
+		
+		bool FileWriteBytes(const char* Path, const u8* Data, arch Size)
+		{
+			std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+			if (!File.is_open())
+			{
+				return false;
+			}
+			
+			File.write((const char*)Data, Size);
+			bool bSuccess = File.good();
+			File.close();
+			return bSuccess;
+		}
+		
+		bool FileWriteBytesAtomic(const char* Path, const u8* Data, arch Size)
+		{
+			std::string TempPath = std::string(Path) + ".tmp";
+			if (!FileWriteBytes(TempPath.c_str(), Data, Size))
+			{
+				std::remove(TempPath.c_str());
+				return false;
+			}
+			
+			// rename() replaces the destination atomically on POSIX filesystems.
+			return std::rename(TempPath.c_str(), Path) == 0;
+		}
+
+#if LOCUS_PLATFORM_LINUX || LOCUS_PLATFORM_MACOS
+		bool FileMap(const char* Path, FileMapping& OutMapping)
+		{
+			OutMapping = {};
+			
+			i32 Descriptor = open(Path, O_RDONLY);
+			if (Descriptor < 0)
+			{
+				return false;
+			}
+			
+			struct stat Stat;
+			if (fstat(Descriptor, &Stat) != 0 || Stat.st_size == 0)
+			{
+				close(Descriptor);
+				return false;
+			}
+			
+			void* Address = mmap(nullptr, Stat.st_size, PROT_READ, MAP_PRIVATE, Descriptor, 0);
+			close(Descriptor); // The mapping keeps its own reference to the file
+			
+			if (Address == MAP_FAILED)
+			{
+				return false;
+			}
+			
+			OutMapping.Data = static_cast<const u8*>(Address);
+			OutMapping.Size = Stat.st_size;
+			OutMapping.bMapped = true;
+			return true;
+		}
+		
+		void FileUnmap(FileMapping& Mapping)
+		{
+			if (Mapping.Data != nullptr)
+			{
+				munmap(const_cast<u8*>(Mapping.Data), Mapping.Size);
+			}
+			Mapping = {};
+		}
+#else
+		bool FileMap(const char* Path, FileMapping& OutMapping)
+		{
+			OutMapping = {};
+			
+			arch Size;
+			if (!FileGetSize(Path, Size) || Size == 0)
+			{
+				return false;
+			}
+			
+			u8* Data = static_cast<u8*>(malloc(Size));
+			if (!FileReadBytes(Path, Data, Size))
+			{
+				free(Data);
+				return false;
+			}
+			
+			OutMapping.Data = Data;
+			OutMapping.Size = Size;
+			OutMapping.bMapped = false;
+			return true;
+		}
+		
+		void FileUnmap(FileMapping& Mapping)
+		{
+			free(const_cast<u8*>(Mapping.Data));
+			Mapping = {};
+		}
+#endif
+		
+		i32 RunProcess(const char* CommandLine, std::string* OutOutput)
+		{
+#if LOCUS_PLATFORM_WINDOWS
+			FILE* Pipe = _popen(CommandLine, "r");
+#else
+			std::string Command = std::string(CommandLine) + " 2>&1";
+			FILE* Pipe = popen(Command.c_str(), "r");
+#endif
+			if (Pipe == nullptr)
+			{
+				return -1;
+			}
+			
+			char Buffer[256];
+			while (fgets(Buffer, sizeof(Buffer), Pipe) != nullptr)
+			{
+				if (OutOutput != nullptr)
+				{
+					OutOutput->append(Buffer);
+				}
+			}
+
+#if LOCUS_PLATFORM_WINDOWS
+			return _pclose(Pipe);
+#else
+			i32 Status = pclose(Pipe);
+			return WIFEXITED(Status) ? WEXITSTATUS(Status) : -1;
+#endif
+		}
 	}
 };
\ No newline at end of file
@@ -2,12 +2,34 @@
 
 #include "Base/Base.hpp"
 
+#include <string>
+#include <vector>
+
 namespace Locus
 {
 	namespace Platform
 	{
+		struct FileMapping
+		{
+			const u8* Data = nullptr;
+			arch Size = 0;
+			bool bMapped = false; // False when the platform fell back to reading into heap memory
+		};
+		
 		void SleepThisThread(u32 Milliseconds);
+		bool FileExists(const char* Path);
 		bool FileGetSize(const char* Path, arch& Size);
 		bool FileReadBytes(const char* Path, u8* Data, arch Size);
+		bool FileWriteBytes(const char* Path, const u8* Data, arch Size);
+		bool FileWriteBytesAtomic(const char* Path, const u8* Data, arch Size); // Readers see either the old or the new file, never a partial one
+		
+		// Full paths of the regular files directly inside Directory, false if it can't be read.
+		bool ListDirectory(const char* Directory, std::vector<std::string>& OutFiles);
+		
+		bool FileMap(const char* Path, FileMapping& OutMapping);
+		void FileUnmap(FileMapping& Mapping);
+		
+		// Runs a shell command to completion, returns its exit code or -1 if it could not be started.
+		i32 RunProcess(const char* CommandLine, std::string* OutOutput = nullptr);
 	};
 };
\ No newline at end of file
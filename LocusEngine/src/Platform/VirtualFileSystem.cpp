@@ -0,0 +1,236 @@
+#include "VirtualFileSystem.hpp"
+
+#include "Base/Compression.hpp"
+#include "Base/Logging.hpp"
+
+#include <cstring>
+
+namespace Locus
+{
+	VirtualFileSystem::VirtualFileSystem()
+	{
+	}
+	
+	VirtualFileSystem::~VirtualFileSystem()
+	{
+		UnmountAll();
+	}
+	
+	bool VirtualFileSystem::MountDirectory(const char* Path)
+	{
+		std::string Directory = Path;
+		if (!Directory.empty() && Directory.back() != '/')
+		{
+			Directory.push_back('/');
+		}
+		
+		m_Directories.push_back(Directory);
+		LLOG(FileSystem, Info, "Mounted directory %s", Path);
+		return true;
+	}
+	
+	bool VirtualFileSystem::MountPack(const char* Path)
+	{
+		MountedPack Pack;
+		Pack.Path = Path;
+		
+		if (!Platform::FileMap(Path, Pack.Mapping))
+		{
+			LLOG(FileSystem, Warning, "Could not map pack file %s", Path);
+			return false;
+		}
+		
+		const PackHeader* Header = reinterpret_cast<const PackHeader*>(Pack.Mapping.Data);
+		bool bValid = Pack.Mapping.Size >= sizeof(PackHeader)
+			&& Header->Magic == PACK_MAGIC
+			&& Header->Version == PACK_VERSION
+			&& Header->TocOffset + (u64)Header->EntryCount * sizeof(PackEntry) <= Pack.Mapping.Size
+			&& Header->StringTableOffset + Header->StringTableSize <= Pack.Mapping.Size;
+		
+		if (!bValid)
+		{
+			LLOG(FileSystem, Error, "Pack file %s is corrupt or from an incompatible version", Path);
+			Platform::FileUnmap(Pack.Mapping);
+			return false;
+		}
+		
+		Pack.Header = Header;
+		Pack.Entries = reinterpret_cast<const PackEntry*>(Pack.Mapping.Data + Header->TocOffset);
+		Pack.Strings = reinterpret_cast<const char*>(Pack.Mapping.Data + Header->StringTableOffset);
+		
+		m_Packs.push_back(Pack);
+		LLOG(FileSystem, Info, "Mounted pack %s (%u entries)", Path, Header->EntryCount);
+		return true;
+	}
+	
+	void VirtualFileSystem::UnmountAll()
+	{
+		for (MountedPack& Pack : m_Packs)
+		{
+			Platform::FileUnmap(Pack.Mapping);
+		}
+		m_Packs.clear();
+		m_Directories.clear();
+	}
+	
+	const PackEntry* VirtualFileSystem::FindPackEntry(const char* LogicalPath, const MountedPack** OutPack) const
+	{
+		u64 PathHash = PackHashPath(LogicalPath);
+		
+		// Later mounts override earlier ones, like patches over a base pack.
+		for (auto It = m_Packs.rbegin(); It != m_Packs.rend(); It++)
+		{
+			const MountedPack& Pack = *It;
+			
+			u32 Low = 0;
+			u32 High = Pack.Header->EntryCount;
+			while (Low < High)
+			{
+				u32 Mid = Low + (High - Low) / 2;
+				if (Pack.Entries[Mid].PathHash < PathHash)
+				{
+					Low = Mid + 1;
+				}
+				else
+				{
+					High = Mid;
+				}
+			}
+			
+			for (u32 i = Low; i < Pack.Header->EntryCount && Pack.Entries[i].PathHash == PathHash; i++)
+			{
+				const PackEntry& Entry = Pack.Entries[i];
+				if (Entry.PathOffset < Pack.Header->StringTableSize && strcmp(Pack.Strings + Entry.PathOffset, LogicalPath) == 0)
+				{
+					*OutPack = &Pack;
+					return &Entry;
+				}
+			}
+		}
+		
+		return nullptr;
+	}
+	
+	bool VirtualFileSystem::FindLooseFile(const char* LogicalPath, std::string& OutPath) const
+	{
+		for (auto It = m_Directories.rbegin(); It != m_Directories.rend(); It++)
+		{
+			std::string Candidate = *It + LogicalPath;
+			if (Platform::FileExists(Candidate.c_str()))
+			{
+				OutPath = Candidate;
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	bool VirtualFileSystem::Exists(const char* LogicalPath) const
+	{
+		arch Size;
+		return GetFileSize(LogicalPath, Size);
+	}
+	
+	bool VirtualFileSystem::GetFileSize(const char* LogicalPath, arch& OutSize) const
+	{
+		std::string LoosePath;
+		const MountedPack* Pack = nullptr;
+		
+		if (m_bPreferLooseFiles && FindLooseFile(LogicalPath, LoosePath))
+		{
+			return Platform::FileGetSize(LoosePath.c_str(), OutSize);
+		}
+		
+		if (const PackEntry* Entry = FindPackEntry(LogicalPath, &Pack))
+		{
+			OutSize = Entry->Size;
+			return true;
+		}
+		
+		if (!m_bPreferLooseFiles && FindLooseFile(LogicalPath, LoosePath))
+		{
+			return Platform::FileGetSize(LoosePath.c_str(), OutSize);
+		}
+		
+		return false;
+	}
+	
+	bool VirtualFileSystem::ReadFile(const char* LogicalPath, u8* Data, arch Size) const
+	{
+		std::string LoosePath;
+		const MountedPack* Pack = nullptr;
+		
+		if (m_bPreferLooseFiles && FindLooseFile(LogicalPath, LoosePath))
+		{
+			return Platform::FileReadBytes(LoosePath.c_str(), Data, Size);
+		}
+		
+		if (const PackEntry* Entry = FindPackEntry(LogicalPath, &Pack))
+		{
+			if (Size < Entry->Size || Entry->Offset + Entry->StoredSize > Pack->Mapping.Size)
+			{
+				return false;
+			}
+			
+			const u8* Stored = Pack->Mapping.Data + Entry->Offset;
+			if (Entry->Flags & PACK_ENTRY_COMPRESSED_LZ4)
+			{
+				if (!Compression::LZ4Decompress(Stored, Entry->StoredSize, Data, Entry->Size))
+				{
+					LLOG(FileSystem, Error, "Failed to decompress %s from %s", LogicalPath, Pack->Path.c_str());
+					return false;
+				}
+				return true;
+			}
+			
+			memcpy(Data, Stored, Entry->Size);
+			return true;
+		}
+		
+		if (!m_bPreferLooseFiles && FindLooseFile(LogicalPath, LoosePath))
+		{
+			return Platform::FileReadBytes(LoosePath.c_str(), Data, Size);
+		}
+		
+		LLOG(FileSystem, Warning, "Could not resolve %s", LogicalPath);
+		return false;
+	}
+	
+	bool VirtualFileSystem::ReadFile(const char* LogicalPath, TArray<u8>& OutData) const
+	{
+		arch Size;
+		if (!GetFileSize(LogicalPath, Size))
+		{
+			LLOG(FileSystem, Warning, "Could not resolve %s", LogicalPath);
+			return false;
+		}
+		
+		OutData.Reserve(Size);
+		return ReadFile(LogicalPath, OutData.Data(), Size);
+	}
+	
+	const u8* VirtualFileSystem::MapFile(const char* LogicalPath, arch& OutSize) const
+	{
+		std::string LoosePath;
+		if (m_bPreferLooseFiles && FindLooseFile(LogicalPath, LoosePath))
+		{
+			return nullptr;
+		}
+		
+		const MountedPack* Pack = nullptr;
+		const PackEntry* Entry = FindPackEntry(LogicalPath, &Pack);
+		if (Entry == nullptr || (Entry->Flags & PACK_ENTRY_COMPRESSED_LZ4))
+		{
+			return nullptr;
+		}
+		
+		OutSize = Entry->Size;
+		return Pack->Mapping.Data + Entry->Offset;
+	}
+	
+	bool VirtualFileSystem::ResolveLoosePath(const char* LogicalPath, std::string& OutPath) const
+	{
+		return FindLooseFile(LogicalPath, OutPath);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Base/Base.hpp"
+#include "Platform/PackFile.hpp"
+#include "Platform/Platform.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+	Resolves logical content paths (e.g. "shaders/triangle.vert.spv") to either
+	an entry inside a mounted pack file or a loose file under a mounted directory.
+	
+	- Packs are mapped once at mount time, lookups are a binary search over the TOC.
+	- In development builds loose files take priority so that freshly built content
+	  wins over whatever was packed last.
+	- Mounts are expected to happen up front; lookups are safe from any thread afterwards.
+*/
+
+namespace Locus
+{
+	class VirtualFileSystem : public Singleton<VirtualFileSystem>
+	{
+	public:
+		VirtualFileSystem();
+		~VirtualFileSystem();
+		
+		bool MountDirectory(const char* Path);
+		bool MountPack(const char* Path);
+		void UnmountAll();
+		
+		void SetPreferLooseFiles(bool bPreferLoose) { m_bPreferLooseFiles = bPreferLoose; }
+		
+		bool Exists(const char* LogicalPath) const;
+		bool GetFileSize(const char* LogicalPath, arch& OutSize) const;
+		bool ReadFile(const char* LogicalPath, u8* Data, arch Size) const;
+		bool ReadFile(const char* LogicalPath, TArray<u8>& OutData) const;
+		
+		// Zero-copy access to uncompressed pack entries, returns nullptr for anything else.
+		const u8* MapFile(const char* LogicalPath, arch& OutSize) const;
+		
+		// Resolves to a path on disk if the file is loose, used by tooling such as hot reload.
+		bool ResolveLoosePath(const char* LogicalPath, std::string& OutPath) const;
+	
+	private:
+		struct MountedPack
+		{
+			std::string Path;
+			Platform::FileMapping Mapping;
+			const PackHeader* Header = nullptr;
+			const PackEntry* Entries = nullptr;
+			const char* Strings = nullptr;
+		};
+		
+		const PackEntry* FindPackEntry(const char* LogicalPath, const MountedPack** OutPack) const;
+		bool FindLooseFile(const char* LogicalPath, std::string& OutPath) const;
+		
+		std::vector<std::string> m_Directories;
+		std::vector<MountedPack> m_Packs;
+		bool m_bPreferLooseFiles = LOCUS_DEVELOPMENT;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "Locus.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/*
+	Usage: LocusBench [ThousandInstances=10] [Frames=500] [Mesh=meshes/torus_knot.lmesh]
+	
+	Draws a grid of instances of one static mesh into a hidden window and reports the average CPU
+	frame time, GPU frame time and draw calls. Dynamic resolution is off so every frame renders at
+	full size. The renderer presents through a swapchain, so it still needs a display to run on.
+*/
+
+using namespace Locus;
+
+static constexpr u32 WARMUP_FRAMES_MAX = 1000; // Waiting for the pipeline to compile and the mesh to upload
+
+i32 main(i32 argc, char* argv[])
+{
+	u32 InstanceCount = 1000 * static_cast<u32>(argc > 1 ? std::max(atoi(argv[1]), 1) : 10);
+	u32 FrameCount = static_cast<u32>(argc > 2 ? std::max(atoi(argv[2]), 1) : 500);
+	const char* MeshPath = argc > 3 ? argv[3] : "meshes/torus_knot.lmesh";
+	
+	Engine::Get().Init();
+	
+	WindowHandle Window = DisplayManager::Get().CreateWindow("LocusBench", 1280, 720, true, true);
+	RenderContextHandle RenderContext = DisplayManager::Get().GetWindowRenderContext(Window);
+	
+	GraphicsManager& GraphicsManager = GraphicsManager::Get();
+	GraphicsManager.GetRenderScaleSettings().bEnabled = false;
+	
+	StaticMeshHandle Mesh = GraphicsManager.LoadStaticMesh(MeshPath);
+	if (!HandleIsValid(Mesh))
+	{
+		LLOG(LocusBench, Error, "Could not load %s", MeshPath);
+		Engine::Get().Shutdown();
+		return 1;
+	}
+	
+	// A square grid, each instance turned and tinted differently, with the camera looking down over all of it.
+	std::vector<StaticMeshInstance> Instances(InstanceCount);
+	u32 Side = static_cast<u32>(ceil(sqrt(static_cast<f64>(InstanceCount))));
+	for (u32 i = 0; i < InstanceCount; i++)
+	{
+		f32 Angle = 0.37f * i;
+		StaticMeshInstance& Instance = Instances[i];
+		Instance.Transform.Position[0] = 4.0f * (static_cast<f32>(i % Side) - 0.5f * (Side - 1));
+		Instance.Transform.Position[2] = 4.0f * (static_cast<f32>(i / Side) - 0.5f * (Side - 1));
+		Instance.Transform.Rotation[1] = sinf(0.5f * Angle);
+		Instance.Transform.Rotation[3] = cosf(0.5f * Angle);
+		Instance.Color[0] = 0.5f + 0.5f * sinf(0.11f * i);
+		Instance.Color[1] = 0.5f + 0.5f * sinf(0.07f * i + 2.0f);
+		Instance.Color[2] = 0.5f + 0.5f * sinf(0.05f * i + 4.0f);
+	}
+	
+	Camera& SceneCamera = GraphicsManager.GetSceneCamera();
+	SceneCamera.Position[1] = 3.0f * Side;
+	SceneCamera.Position[2] = 2.0f * Side;
+	SceneCamera.Pitch = -atanf(1.5f);
+	
+	f64 CpuMilliseconds = 0.0;
+	f64 GpuMilliseconds = 0.0;
+	u32 DrawCalls = 0;
+	u64 Triangles = 0;
+	u64 FullDetailTriangles = 0;
+	u32 MeasuredFrames = 0;
+	u32 WarmupFrames = 0;
+	bool bShouldQuit = false;
+	
+	Clock FrameClock;
+	while (!bShouldQuit && MeasuredFrames < FrameCount)
+	{
+		// Stats describe the last frame, so measuring starts the frame after the mesh was first drawn.
+		bool bMeasuring = GraphicsManager.GetStats().StaticMeshDrawCalls > 0;
+		if (!bMeasuring && ++WarmupFrames > WARMUP_FRAMES_MAX)
+		{
+			LLOG(LocusBench, Error, "Nothing was drawn after %u frames", WARMUP_FRAMES_MAX);
+			break;
+		}
+		
+		FrameClock.Reset(true);
+		DisplayManager::Get().PollEvents(bShouldQuit);
+		
+		GraphicsManager.BeginFrame(RenderContext);
+		GraphicsManager.DrawStaticMesh(Mesh, Instances.data(), InstanceCount);
+		GraphicsManager.BeginFrameImGui();
+		GraphicsManager.EndFrameImGui();
+		GraphicsManager.EndFrame(RenderContext);
+		
+		if (bMeasuring)
+		{
+			const GraphicsStats& Stats = GraphicsManager.GetStats();
+			CpuMilliseconds += FrameClock.GetElapsedMilliseconds();
+			GpuMilliseconds += Stats.GpuFrameMilliseconds;
+			DrawCalls = Stats.StaticMeshDrawCalls;
+			Triangles = Stats.StaticMeshTriangles;
+			FullDetailTriangles = Stats.StaticMeshFullDetailTriangles;
+			MeasuredFrames++;
+		}
+	}
+	
+	if (MeasuredFrames > 0)
+	{
+		LLOG(LocusBench, Info, "%u instances over %u frames: CPU %.3lfms, GPU %.3lfms a frame, %u draw calls, %llu of %llu triangles drawn", InstanceCount, MeasuredFrames, CpuMilliseconds / MeasuredFrames, GpuMilliseconds / MeasuredFrames, DrawCalls, (unsigned long long)Triangles, (unsigned long long)FullDetailTriangles);
+	}
+	
+	GraphicsManager.DestroyStaticMesh(Mesh);
+	Engine::Get().Shutdown();
+	return MeasuredFrames > 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,1426 @@
+#include "MeshCooker.hpp"
+#include "Graphics/MeshAsset.hpp"
+#include "Platform/Platform.hpp"
+
+#include "yaml-cpp/yaml.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+namespace Locus
+{
+	static constexpr u32 INDEX_NONE = 0xFFFFFFFF;
+	
+	using Vec3 = std::array<f32, 3>;
+	
+	static Vec3 Cross(const Vec3& A, const Vec3& B)
+	{
+		return { A[1] * B[2] - A[2] * B[1], A[2] * B[0] - A[0] * B[2], A[0] * B[1] - A[1] * B[0] };
+	}
+	
+	static void Normalize(f32 Vector[3])
+	{
+		f32 Length = std::sqrt(Vector[0] * Vector[0] + Vector[1] * Vector[1] + Vector[2] * Vector[2]);
+		if (Length > 0.0f)
+		{
+			Vector[0] /= Length;
+			Vector[1] /= Length;
+			Vector[2] /= Length;
+		}
+	}
+	
+	// Smooth normals for the vertices flagged in bNeedsNormal, shared between vertices with the same SharedId.
+	static void GenerateNormals(MeshSource& Mesh, u32 FirstVertex, u32 FirstIndex, const std::vector<u32>& SharedIds, const std::vector<bool>& bNeedsNormal)
+	{
+		u32 SharedCount = 0;
+		for (u32 Id : SharedIds)
+		{
+			SharedCount = std::max(SharedCount, Id + 1);
+		}
+		std::vector<Vec3> Accumulated(SharedCount, Vec3{ 0.0f, 0.0f, 0.0f });
+		
+		for (arch i = FirstIndex; i + 2 < Mesh.Indices.size(); i += 3)
+		{
+			const f32* P0 = Mesh.Vertices[Mesh.Indices[i + 0]].Position;
+			const f32* P1 = Mesh.Vertices[Mesh.Indices[i + 1]].Position;
+			const f32* P2 = Mesh.Vertices[Mesh.Indices[i + 2]].Position;
+			
+			// Unnormalised, so larger faces weigh more.
+			Vec3 Normal = Cross({ P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] }, { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] });
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				Vec3& Sum = Accumulated[SharedIds[Mesh.Indices[i + Corner] - FirstVertex]];
+				Sum[0] += Normal[0];
+				Sum[1] += Normal[1];
+				Sum[2] += Normal[2];
+			}
+		}
+		
+		for (u32 i = 0; i < SharedIds.size(); i++)
+		{
+			if (bNeedsNormal[i])
+			{
+				MeshSourceVertex& Vertex = Mesh.Vertices[FirstVertex + i];
+				memcpy(Vertex.Normal, Accumulated[SharedIds[i]].data(), sizeof(Vertex.Normal));
+				Normalize(Vertex.Normal);
+			}
+		}
+	}
+	
+	// OBJ
+	
+	static const char* SkipSpaces(const char* Cursor, const char* End)
+	{
+		while (Cursor < End && (*Cursor == ' ' || *Cursor == '\t'))
+		{
+			Cursor++;
+		}
+		return Cursor;
+	}
+	
+	static bool ParseObjIndex(const char*& Cursor, const char* End, u32 Count, u32& OutIndex)
+	{
+		char* ParseEnd = nullptr;
+		long Value = strtol(Cursor, &ParseEnd, 10);
+		if (ParseEnd == Cursor || ParseEnd > End)
+		{
+			return false;
+		}
+		Cursor = ParseEnd;
+		
+		// One based, negative counts back from the latest element.
+		i64 Index = Value > 0 ? Value - 1 : static_cast<i64>(Count) + Value;
+		if (Value == 0 || Index < 0 || Index >= Count)
+		{
+			return false;
+		}
+		OutIndex = static_cast<u32>(Index);
+		return true;
+	}
+	
+	bool ImportObj(const u8* Data, arch Size, MeshSource& OutMesh, std::string& OutError)
+	{
+		OutMesh = {};
+		
+		std::vector<Vec3> Positions;
+		std::vector<Vec3> Normals;
+		std::unordered_map<u64, u32> VertexLookup; // Position and normal index pair to vertex
+		std::vector<u32> VertexPositions;
+		std::vector<bool> bNeedsNormal;
+		std::vector<u32> Polygon;
+		
+		const char* Cursor = reinterpret_cast<const char*>(Data);
+		const char* FileEnd = Cursor + Size;
+		u32 LineNumber = 0;
+		
+		while (Cursor < FileEnd)
+		{
+			const char* LineEnd = static_cast<const char*>(memchr(Cursor, '\n', FileEnd - Cursor));
+			LineEnd = LineEnd != nullptr ? LineEnd : FileEnd;
+			std::string Line(Cursor, LineEnd);
+			Cursor = LineEnd + 1;
+			LineNumber++;
+			
+			const char* It = SkipSpaces(Line.c_str(), Line.c_str() + Line.size());
+			const char* End = Line.c_str() + Line.size();
+			if (It + 1 >= End || *It == '#')
+			{
+				continue;
+			}
+			
+			if (It[0] == 'v' && (It[1] == ' ' || It[1] == '\t' || It[1] == 'n'))
+			{
+				bool bNormal = It[1] == 'n';
+				It += bNormal ? 2 : 1;
+				
+				Vec3 Value;
+				for (u32 Axis = 0; Axis < 3; Axis++)
+				{
+					char* ParseEnd = nullptr;
+					Value[Axis] = strtof(It, &ParseEnd);
+					if (ParseEnd == It)
+					{
+						OutError = "Malformed vertex on line " + std::to_string(LineNumber);
+						return false;
+					}
+					It = ParseEnd;
+				}
+				(bNormal ? Normals : Positions).push_back(Value);
+			}
+			else if (It[0] == 'f' && (It[1] == ' ' || It[1] == '\t'))
+			{
+				It++;
+				Polygon.clear();
+				while ((It = SkipSpaces(It, End)) < End && *It != '\r')
+				{
+					u32 Position = 0;
+					u32 Normal = INDEX_NONE;
+					u32 Unused = 0;
+					bool bValid = ParseObjIndex(It, End, static_cast<u32>(Positions.size()), Position);
+					if (bValid && It < End && *It == '/')
+					{
+						It++;
+						if (It < End && *It != '/')
+						{
+							bValid = ParseObjIndex(It, End, 0x7FFFFFFF, Unused); // Texture coordinates are not kept
+						}
+						if (bValid && It < End && *It == '/')
+						{
+							It++;
+							bValid = ParseObjIndex(It, End, static_cast<u32>(Normals.size()), Normal);
+						}
+					}
+					if (!bValid)
+					{
+						OutError = "Malformed face on line " + std::to_string(LineNumber);
+						return false;
+					}
+					
+					u64 Key = (static_cast<u64>(Position) << 32) | (Normal + 1u);
+					auto [Found, bInserted] = VertexLookup.emplace(Key, static_cast<u32>(OutMesh.Vertices.size()));
+					if (bInserted)
+					{
+						MeshSourceVertex Vertex = {};
+						memcpy(Vertex.Position, Positions[Position].data(), sizeof(Vertex.Position));
+						if (Normal != INDEX_NONE)
+						{
+							memcpy(Vertex.Normal, Normals[Normal].data(), sizeof(Vertex.Normal));
+							Normalize(Vertex.Normal);
+						}
+						OutMesh.Vertices.push_back(Vertex);
+						VertexPositions.push_back(Position);
+						bNeedsNormal.push_back(Normal == INDEX_NONE);
+					}
+					Polygon.push_back(Found->second);
+				}
+				
+				for (arch i = 2; i < Polygon.size(); i++)
+				{
+					OutMesh.Indices.insert(OutMesh.Indices.end(), { Polygon[0], Polygon[i - 1], Polygon[i] });
+				}
+			}
+		}
+		
+		if (OutMesh.Indices.empty())
+		{
+			OutError = "No faces found";
+			return false;
+		}
+		
+		if (std::find(bNeedsNormal.begin(), bNeedsNormal.end(), true) != bNeedsNormal.end())
+		{
+			GenerateNormals(OutMesh, 0, 0, VertexPositions, bNeedsNormal);
+		}
+		return true;
+	}
+	
+	// glTF
+	
+	static constexpr u32 GLB_MAGIC = 0x46546C67; // "glTF"
+	static constexpr u32 GLB_CHUNK_JSON = 0x4E4F534A;
+	static constexpr u32 GLB_CHUNK_BIN = 0x004E4942;
+	static constexpr u32 GLTF_FLOAT = 5126;
+	static constexpr u32 GLTF_UNSIGNED_BYTE = 5121;
+	static constexpr u32 GLTF_UNSIGNED_SHORT = 5123;
+	static constexpr u32 GLTF_UNSIGNED_INT = 5125;
+	static constexpr u32 GLTF_TRIANGLES = 4;
+	
+	using Mat4 = std::array<f32, 16>; // Column major, as glTF stores them
+	
+	static Mat4 Multiply(const Mat4& A, const Mat4& B)
+	{
+		Mat4 Result = {};
+		for (u32 Column = 0; Column < 4; Column++)
+		{
+			for (u32 Row = 0; Row < 4; Row++)
+			{
+				for (u32 k = 0; k < 4; k++)
+				{
+					Result[Column * 4 + Row] += A[k * 4 + Row] * B[Column * 4 + k];
+				}
+			}
+		}
+		return Result;
+	}
+	
+	static bool DecodeBase64(const std::string& Text, arch Start, std::vector<u8>& OutData)
+	{
+		u32 Accumulator = 0;
+		u32 Bits = 0;
+		for (arch i = Start; i < Text.size() && Text[i] != '='; i++)
+		{
+			char C = Text[i];
+			u32 Value;
+			if (C >= 'A' && C <= 'Z') Value = C - 'A';
+			else if (C >= 'a' && C <= 'z') Value = C - 'a' + 26;
+			else if (C >= '0' && C <= '9') Value = C - '0' + 52;
+			else if (C == '+') Value = 62;
+			else if (C == '/') Value = 63;
+			else return false;
+			
+			Accumulator = (Accumulator << 6) | Value;
+			Bits += 6;
+			if (Bits >= 8)
+			{
+				Bits -= 8;
+				OutData.push_back(static_cast<u8>(Accumulator >> Bits));
+			}
+		}
+		return true;
+	}
+	
+	static bool ReadWholeFile(const std::string& Path, std::vector<u8>& OutData)
+	{
+		arch Size;
+		if (!Platform::FileGetSize(Path.c_str(), Size))
+		{
+			return false;
+		}
+		OutData.resize(Size);
+		return Size == 0 || Platform::FileReadBytes(Path.c_str(), OutData.data(), Size);
+	}
+	
+	struct GltfContext
+	{
+		YAML::Node Document;
+		std::vector<std::vector<u8>> Buffers;
+	};
+	
+	// Elements of an accessor, each widened to Components floats or one u32.
+	static bool ReadAccessor(const GltfContext& Gltf, u32 AccessorIndex, u32 Components, std::vector<f32>* OutFloats, std::vector<u32>* OutIndices, std::string& OutError)
+	{
+		const YAML::Node Accessor = Gltf.Document["accessors"][AccessorIndex];
+		if (!Accessor.IsDefined() || !Accessor["bufferView"].IsDefined() || Accessor["sparse"].IsDefined())
+		{
+			OutError = "Accessor " + std::to_string(AccessorIndex) + " is missing, sparse or has no buffer view";
+			return false;
+		}
+		
+		const YAML::Node View = Gltf.Document["bufferViews"][Accessor["bufferView"].as<u32>()];
+		u32 Buffer = View["buffer"].as<u32>();
+		u32 ComponentType = Accessor["componentType"].as<u32>();
+		u32 Count = Accessor["count"].as<u32>();
+		u64 Offset = View["byteOffset"].as<u64>(0) + Accessor["byteOffset"].as<u64>(0);
+		
+		u32 ComponentSize = ComponentType == GLTF_FLOAT || ComponentType == GLTF_UNSIGNED_INT ? 4 : (ComponentType == GLTF_UNSIGNED_SHORT ? 2 : 1);
+		u32 ElementSize = ComponentSize * Components;
+		u32 Stride = View["byteStride"].as<u32>(ElementSize);
+		
+		bool bFloat = OutFloats != nullptr;
+		if ((bFloat && ComponentType != GLTF_FLOAT) || (!bFloat && ComponentType != GLTF_UNSIGNED_BYTE && ComponentType != GLTF_UNSIGNED_SHORT && ComponentType != GLTF_UNSIGNED_INT))
+		{
+			OutError = "Accessor " + std::to_string(AccessorIndex) + " has an unsupported component type, quantised glTF is not supported";
+			return false;
+		}
+		if (Buffer >= Gltf.Buffers.size() || (Count > 0 && Offset + static_cast<u64>(Stride) * (Count - 1) + ElementSize > Gltf.Buffers[Buffer].size()))
+		{
+			OutError = "Accessor " + std::to_string(AccessorIndex) + " reads past its buffer";
+			return false;
+		}
+		
+		const u8* Data = Gltf.Buffers[Buffer].data() + Offset;
+		for (u32 i = 0; i < Count; i++)
+		{
+			const u8* Element = Data + static_cast<arch>(Stride) * i;
+			if (bFloat)
+			{
+				f32 Values[4];
+				memcpy(Values, Element, ElementSize);
+				OutFloats->insert(OutFloats->end(), Values, Values + Components);
+			}
+			else if (ComponentType == GLTF_UNSIGNED_INT)
+			{
+				u32 Value;
+				memcpy(&Value, Element, sizeof(Value));
+				OutIndices->push_back(Value);
+			}
+			else if (ComponentType == GLTF_UNSIGNED_SHORT)
+			{
+				u16 Value;
+				memcpy(&Value, Element, sizeof(Value));
+				OutIndices->push_back(Value);
+			}
+			else
+			{
+				OutIndices->push_back(*Element);
+			}
+		}
+		return true;
+	}
+	
+	static Mat4 GetNodeTransform(const YAML::Node& Node)
+	{
+		Mat4 Result = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		if (Node["matrix"].IsDefined())
+		{
+			for (u32 i = 0; i < 16; i++)
+			{
+				Result[i] = Node["matrix"][i].as<f32>();
+			}
+			return Result;
+		}
+		
+		// T * R * S
+		f32 T[3] = { 0.0f, 0.0f, 0.0f };
+		f32 R[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		f32 S[3] = { 1.0f, 1.0f, 1.0f };
+		for (u32 i = 0; i < 3 && Node["translation"].IsDefined(); i++) T[i] = Node["translation"][i].as<f32>();
+		for (u32 i = 0; i < 4 && Node["rotation"].IsDefined(); i++) R[i] = Node["rotation"][i].as<f32>();
+		for (u32 i = 0; i < 3 && Node["scale"].IsDefined(); i++) S[i] = Node["scale"][i].as<f32>();
+		
+		f32 X = R[0], Y = R[1], Z = R[2], W = R[3];
+		f32 Rotation[9] = {
+			1 - 2 * (Y * Y + Z * Z), 2 * (X * Y + Z * W), 2 * (X * Z - Y * W),
+			2 * (X * Y - Z * W), 1 - 2 * (X * X + Z * Z), 2 * (Y * Z + X * W),
+			2 * (X * Z + Y * W), 2 * (Y * Z - X * W), 1 - 2 * (X * X + Y * Y),
+		};
+		for (u32 Column = 0; Column < 3; Column++)
+		{
+			for (u32 Row = 0; Row < 3; Row++)
+			{
+				Result[Column * 4 + Row] = Rotation[Column * 3 + Row] * S[Column];
+			}
+			Result[12 + Column] = T[Column];
+		}
+		return Result;
+	}
+	
+	static bool ImportGltfMesh(const GltfContext& Gltf, u32 MeshIndex, const Mat4& Transform, MeshSource& OutMesh, std::string& OutError)
+	{
+		// Normals take the inverse transpose, the cofactor matrix is that up to a scale renormalising removes.
+		const f32* M = Transform.data();
+		f32 NormalMatrix[9] = {
+			M[5] * M[10] - M[6] * M[9], M[6] * M[8] - M[4] * M[10], M[4] * M[9] - M[5] * M[8],
+			M[9] * M[2] - M[10] * M[1], M[10] * M[0] - M[8] * M[2], M[8] * M[1] - M[9] * M[0],
+			M[1] * M[6] - M[2] * M[5], M[2] * M[4] - M[0] * M[6], M[0] * M[5] - M[1] * M[4],
+		};
+		
+		const YAML::Node Primitives = Gltf.Document["meshes"][MeshIndex]["primitives"];
+		for (u32 p = 0; Primitives.IsDefined() && p < Primitives.size(); p++)
+		{
+			const YAML::Node Primitive = Primitives[p];
+			if (Primitive["mode"].as<u32>(GLTF_TRIANGLES) != GLTF_TRIANGLES)
+			{
+				LLOG(LocusMeshCook, Warning, "Skipping primitive %u of mesh %u, only triangle lists are imported", p, MeshIndex);
+				continue;
+			}
+			
+			const YAML::Node Attributes = Primitive["attributes"];
+			if (!Attributes["POSITION"].IsDefined())
+			{
+				continue;
+			}
+			
+			std::vector<f32> Positions;
+			std::vector<f32> Normals;
+			std::vector<u32> Indices;
+			if (!ReadAccessor(Gltf, Attributes["POSITION"].as<u32>(), 3, &Positions, nullptr, OutError)
+				|| (Attributes["NORMAL"].IsDefined() && !ReadAccessor(Gltf, Attributes["NORMAL"].as<u32>(), 3, &Normals, nullptr, OutError))
+				|| (Primitive["indices"].IsDefined() && !ReadAccessor(Gltf, Primitive["indices"].as<u32>(), 1, nullptr, &Indices, OutError)))
+			{
+				return false;
+			}
+			
+			u32 VertexCount = static_cast<u32>(Positions.size() / 3);
+			if (Indices.empty())
+			{
+				for (u32 i = 0; i < VertexCount; i++)
+				{
+					Indices.push_back(i);
+				}
+			}
+			
+			u32 FirstVertex = static_cast<u32>(OutMesh.Vertices.size());
+			u32 FirstIndex = static_cast<u32>(OutMesh.Indices.size());
+			bool bHasNormals = Normals.size() == Positions.size();
+			for (u32 i = 0; i < VertexCount; i++)
+			{
+				const f32* P = &Positions[i * 3];
+				MeshSourceVertex Vertex = {};
+				for (u32 Row = 0; Row < 3; Row++)
+				{
+					Vertex.Position[Row] = M[Row] * P[0] + M[4 + Row] * P[1] + M[8 + Row] * P[2] + M[12 + Row];
+					if (bHasNormals)
+					{
+						const f32* N = &Normals[i * 3];
+						Vertex.Normal[Row] = NormalMatrix[Row * 3 + 0] * N[0] + NormalMatrix[Row * 3 + 1] * N[1] + NormalMatrix[Row * 3 + 2] * N[2];
+					}
+				}
+				Normalize(Vertex.Normal);
+				OutMesh.Vertices.push_back(Vertex);
+			}
+			
+			for (arch i = 0; i + 2 < Indices.size(); i += 3)
+			{
+				if (Indices[i] >= VertexCount || Indices[i + 1] >= VertexCount || Indices[i + 2] >= VertexCount)
+				{
+					OutError = "Mesh " + std::to_string(MeshIndex) + " indexes past its vertices";
+					return false;
+				}
+				
+				// A mirroring transform flips the winding.
+				bool bMirrored = (M[0] * NormalMatrix[0] + M[1] * NormalMatrix[3] + M[2] * NormalMatrix[6]) < 0.0f;
+				OutMesh.Indices.push_back(FirstVertex + Indices[i]);
+				OutMesh.Indices.push_back(FirstVertex + Indices[bMirrored ? i + 2 : i + 1]);
+				OutMesh.Indices.push_back(FirstVertex + Indices[bMirrored ? i + 1 : i + 2]);
+			}
+			
+			if (!bHasNormals)
+			{
+				std::vector<u32> SharedIds(VertexCount);
+				for (u32 i = 0; i < VertexCount; i++)
+				{
+					SharedIds[i] = i;
+				}
+				GenerateNormals(OutMesh, FirstVertex, FirstIndex, SharedIds, std::vector<bool>(VertexCount, true));
+			}
+		}
+		return true;
+	}
+	
+	static bool ImportGltfNode(const GltfContext& Gltf, u32 NodeIndex, const Mat4& ParentTransform, u32 Depth, MeshSource& OutMesh, std::string& OutError)
+	{
+		const YAML::Node Node = Gltf.Document["nodes"][NodeIndex];
+		if (!Node.IsDefined() || Depth > 64)
+		{
+			OutError = "Node " + std::to_string(NodeIndex) + " is missing or the hierarchy has a cycle";
+			return false;
+		}
+		
+		Mat4 Transform = Multiply(ParentTransform, GetNodeTransform(Node));
+		if (Node["mesh"].IsDefined() && !ImportGltfMesh(Gltf, Node["mesh"].as<u32>(), Transform, OutMesh, OutError))
+		{
+			return false;
+		}
+		
+		const YAML::Node Children = Node["children"];
+		for (u32 i = 0; Children.IsDefined() && i < Children.size(); i++)
+		{
+			if (!ImportGltfNode(Gltf, Children[i].as<u32>(), Transform, Depth + 1, OutMesh, OutError))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	bool ImportGltf(const char* Path, MeshSource& OutMesh, std::string& OutError)
+	{
+		OutMesh = {};
+		
+		std::vector<u8> File;
+		if (!ReadWholeFile(Path, File))
+		{
+			OutError = "Could not read the file";
+			return false;
+		}
+		
+		std::string Json;
+		std::vector<u8> BinaryChunk;
+		u32 Magic = 0;
+		if (File.size() >= 12)
+		{
+			memcpy(&Magic, File.data(), sizeof(Magic));
+		}
+		
+		if (Magic == GLB_MAGIC)
+		{
+			// Header, then chunks of length, type and 4-byte aligned data.
+			for (arch Offset = 12; Offset + 8 <= File.size();)
+			{
+				u32 ChunkLength, ChunkType;
+				memcpy(&ChunkLength, File.data() + Offset, sizeof(u32));
+				memcpy(&ChunkType, File.data() + Offset + 4, sizeof(u32));
+				const u8* Chunk = File.data() + Offset + 8;
+				if (Offset + 8 + ChunkLength > File.size())
+				{
+					OutError = "GLB chunk runs past the end of the file";
+					return false;
+				}
+				
+				if (ChunkType == GLB_CHUNK_JSON)
+				{
+					Json.assign(reinterpret_cast<const char*>(Chunk), ChunkLength);
+				}
+				else if (ChunkType == GLB_CHUNK_BIN && BinaryChunk.empty())
+				{
+					BinaryChunk.assign(Chunk, Chunk + ChunkLength);
+				}
+				Offset += 8 + ((ChunkLength + 3) & ~3u);
+			}
+		}
+		else
+		{
+			Json.assign(File.begin(), File.end());
+		}
+		
+		// JSON is read as YAML, which rejects tabs in places JSON allows them. Tabs inside JSON strings
+		// must be escaped, so any literal one is whitespace.
+		std::replace(Json.begin(), Json.end(), '\t', ' ');
+		
+		GltfContext Gltf;
+		try
+		{
+			Gltf.Document = YAML::Load(Json);
+		}
+		catch (const YAML::Exception& Exception)
+		{
+			OutError = std::string("Malformed glTF JSON: ") + Exception.what();
+			return false;
+		}
+		
+		std::filesystem::path Directory = std::filesystem::path(Path).parent_path();
+		const YAML::Node Buffers = Gltf.Document["buffers"];
+		for (u32 i = 0; Buffers.IsDefined() && i < Buffers.size(); i++)
+		{
+			std::vector<u8>& Buffer = Gltf.Buffers.emplace_back();
+			if (!Buffers[i]["uri"].IsDefined())
+			{
+				Buffer = BinaryChunk; // Only the first buffer of a GLB may omit its URI
+				continue;
+			}
+			
+			std::string Uri = Buffers[i]["uri"].as<std::string>();
+			if (Uri.compare(0, 5, "data:") == 0)
+			{
+				arch Comma = Uri.find(',');
+				if (Comma == std::string::npos || Uri.find(";base64") > Comma || !DecodeBase64(Uri, Comma + 1, Buffer))
+				{
+					OutError = "Buffer " + std::to_string(i) + " has a data URI that is not base64";
+					return false;
+				}
+			}
+			else if (!ReadWholeFile((Directory / Uri).string(), Buffer))
+			{
+				OutError = "Could not read buffer " + Uri;
+				return false;
+			}
+		}
+		
+		try
+		{
+			Mat4 Identity = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			const YAML::Node Scenes = Gltf.Document["scenes"];
+			if (Scenes.IsDefined() && Scenes.size() > 0)
+			{
+				const YAML::Node Roots = Scenes[Gltf.Document["scene"].as<u32>(0)]["nodes"];
+				for (u32 i = 0; Roots.IsDefined() && i < Roots.size(); i++)
+				{
+					if (!ImportGltfNode(Gltf, Roots[i].as<u32>(), Identity, 0, OutMesh, OutError))
+					{
+						return false;
+					}
+				}
+			}
+			else
+			{
+				// No scene to say how meshes are placed, take them as they are.
+				const YAML::Node Meshes = Gltf.Document["meshes"];
+				for (u32 i = 0; Meshes.IsDefined() && i < Meshes.size(); i++)
+				{
+					if (!ImportGltfMesh(Gltf, i, Identity, OutMesh, OutError))
+					{
+						return false;
+					}
+				}
+			}
+		}
+		catch (const YAML::Exception& Exception)
+		{
+			OutError = std::string("Unexpected glTF structure: ") + Exception.what();
+			return false;
+		}
+		
+		if (OutMesh.Indices.empty())
+		{
+			OutError = "No triangles found";
+			return false;
+		}
+		return true;
+	}
+	
+	// Optimisation
+	
+	static constexpr u32 VERTEX_CACHE_SIZE = 32;
+	static constexpr f32 CACHE_DECAY_POWER = 1.5f;
+	static constexpr f32 LAST_TRIANGLE_SCORE = 0.75f;
+	static constexpr f32 VALENCE_BOOST_SCALE = 2.0f;
+	static constexpr f32 VALENCE_BOOST_POWER = 0.5f;
+	
+	static f32 VertexScore(i32 CachePosition, u32 ActiveTriangles)
+	{
+		if (ActiveTriangles == 0)
+		{
+			return -1.0f;
+		}
+		
+		f32 Score = 0.0f;
+		if (CachePosition >= 0)
+		{
+			// The last triangle's vertices score a fixed amount so it isn't simply repeated.
+			if (CachePosition < 3)
+			{
+				Score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				f32 Scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+				Score = std::pow(1.0f - (CachePosition - 3) * Scaler, CACHE_DECAY_POWER);
+			}
+		}
+		
+		// Vertices with few triangles left get priority, so they don't end up stranded.
+		return Score + VALENCE_BOOST_SCALE * std::pow(static_cast<f32>(ActiveTriangles), -VALENCE_BOOST_POWER);
+	}
+	
+	void OptimizeVertexCache(std::vector<u32>& Indices, u32 VertexCount)
+	{
+		u32 TriangleCount = static_cast<u32>(Indices.size() / 3);
+		if (TriangleCount == 0)
+		{
+			return;
+		}
+		
+		// Triangles of every vertex, the first ActiveTriangles of each list are still to be emitted.
+		std::vector<u32> ActiveTriangles(VertexCount, 0);
+		for (u32 Index : Indices)
+		{
+			ActiveTriangles[Index]++;
+		}
+		std::vector<u32> FirstTriangle(VertexCount + 1, 0);
+		for (u32 v = 0; v < VertexCount; v++)
+		{
+			FirstTriangle[v + 1] = FirstTriangle[v] + ActiveTriangles[v];
+		}
+		std::vector<u32> VertexTriangles(Indices.size());
+		std::vector<u32> Filled(VertexCount, 0);
+		for (u32 t = 0; t < TriangleCount; t++)
+		{
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				u32 v = Indices[t * 3 + Corner];
+				VertexTriangles[FirstTriangle[v] + Filled[v]++] = t;
+			}
+		}
+		
+		std::vector<i32> CachePosition(VertexCount, -1);
+		std::vector<f32> VertexScores(VertexCount);
+		for (u32 v = 0; v < VertexCount; v++)
+		{
+			VertexScores[v] = VertexScore(-1, ActiveTriangles[v]);
+		}
+		
+		std::vector<f32> TriangleScores(TriangleCount);
+		std::vector<bool> bEmitted(TriangleCount, false);
+		u32 BestTriangle = INDEX_NONE;
+		f32 BestScore = -1.0f;
+		for (u32 t = 0; t < TriangleCount; t++)
+		{
+			TriangleScores[t] = VertexScores[Indices[t * 3]] + VertexScores[Indices[t * 3 + 1]] + VertexScores[Indices[t * 3 + 2]];
+			if (TriangleScores[t] > BestScore)
+			{
+				BestScore = TriangleScores[t];
+				BestTriangle = t;
+			}
+		}
+		
+		std::vector<u32> Output;
+		Output.reserve(Indices.size());
+		std::vector<u32> Cache;
+		std::vector<u32> NewCache;
+		Cache.reserve(VERTEX_CACHE_SIZE + 3);
+		NewCache.reserve(VERTEX_CACHE_SIZE + 3);
+		u32 ScanCursor = 0;
+		
+		for (u32 Emitted = 0; Emitted < TriangleCount; Emitted++)
+		{
+			if (BestTriangle == INDEX_NONE)
+			{
+				// Nothing in the cache has triangles left, carry on from the next unemitted one.
+				while (bEmitted[ScanCursor])
+				{
+					ScanCursor++;
+				}
+				BestTriangle = ScanCursor;
+			}
+			
+			u32 Triangle = BestTriangle;
+			bEmitted[Triangle] = true;
+			
+			// Emit it and drop it from its vertices' active lists.
+			NewCache.clear();
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				u32 v = Indices[Triangle * 3 + Corner];
+				Output.push_back(v);
+				NewCache.push_back(v);
+				
+				u32* List = &VertexTriangles[FirstTriangle[v]];
+				u32 Active = ActiveTriangles[v];
+				for (u32 i = 0; i < Active; i++)
+				{
+					if (List[i] == Triangle)
+					{
+						std::swap(List[i], List[Active - 1]);
+						break;
+					}
+				}
+				ActiveTriangles[v]--;
+			}
+			
+			for (u32 v : Cache)
+			{
+				if (v != NewCache[0] && v != NewCache[1] && v != NewCache[2])
+				{
+					NewCache.push_back(v);
+				}
+			}
+			
+			// Rescore everything that moved in or out of the cache, then the triangles they touch.
+			for (u32 i = 0; i < NewCache.size(); i++)
+			{
+				u32 v = NewCache[i];
+				CachePosition[v] = i < VERTEX_CACHE_SIZE ? static_cast<i32>(i) : -1;
+				VertexScores[v] = VertexScore(CachePosition[v], ActiveTriangles[v]);
+			}
+			
+			BestTriangle = INDEX_NONE;
+			BestScore = -1.0f;
+			for (u32 v : NewCache)
+			{
+				for (u32 i = 0; i < ActiveTriangles[v]; i++)
+				{
+					u32 t = VertexTriangles[FirstTriangle[v] + i];
+					TriangleScores[t] = VertexScores[Indices[t * 3]] + VertexScores[Indices[t * 3 + 1]] + VertexScores[Indices[t * 3 + 2]];
+					if (TriangleScores[t] > BestScore)
+					{
+						BestScore = TriangleScores[t];
+						BestTriangle = t;
+					}
+				}
+			}
+			
+			NewCache.resize(std::min<arch>(NewCache.size(), VERTEX_CACHE_SIZE));
+			std::swap(Cache, NewCache);
+		}
+		
+		Indices = std::move(Output);
+	}
+	
+	void OptimizeVertexFetch(MeshSource& Mesh)
+	{
+		std::vector<u32> Remap(Mesh.Vertices.size(), INDEX_NONE);
+		std::vector<MeshSourceVertex> Reordered;
+		Reordered.reserve(Mesh.Vertices.size());
+		
+		for (u32& Index : Mesh.Indices)
+		{
+			if (Remap[Index] == INDEX_NONE)
+			{
+				Remap[Index] = static_cast<u32>(Reordered.size());
+				Reordered.push_back(Mesh.Vertices[Index]);
+			}
+			Index = Remap[Index];
+		}
+		
+		// Vertices no triangle uses are dropped.
+		Mesh.Vertices = std::move(Reordered);
+	}
+	
+	f32 ComputeAcmr(const std::vector<u32>& Indices, u32 VertexCount, u32 CacheSize)
+	{
+		if (Indices.size() < 3)
+		{
+			return 0.0f;
+		}
+		
+		// FIFO, an entry's age is how many misses happened since it was loaded.
+		std::vector<u64> LoadedAt(VertexCount, 0);
+		u64 Misses = 0;
+		for (u32 Index : Indices)
+		{
+			if (LoadedAt[Index] == 0 || Misses + 1 - LoadedAt[Index] > CacheSize)
+			{
+				Misses++;
+				LoadedAt[Index] = Misses;
+			}
+		}
+		return static_cast<f32>(Misses) / static_cast<f32>(Indices.size() / 3);
+	}
+	
+	// Simplification
+	
+	static constexpr f32 LOD_REDUCTION_MIN = 0.85f; // A LOD keeping more than this of the last one is not worth storing
+	static constexpr f32 LOD_ERROR_LIMIT = 0.25f; // Of the bounding radius, selection keeps coarse LODs for when they are tiny on screen
+	static constexpr f32 CONE_MINIMUM_DOT = 0.1f; // Flatter than this and the cone would cull almost nothing
+	static constexpr f32 CONE_MARGIN = 0.01f; // Quantised positions tilt small triangles slightly
+	
+	// Sum of squared distances to a set of planes, the symmetric 4x4 matrix's upper triangle row by row.
+	struct Quadric
+	{
+		f64 A[10] = {};
+		f64 Weight = 0.0;
+	};
+	
+	static void AddPlane(Quadric& Q, const Vec3& Normal, f64 Distance, f64 Weight)
+	{
+		f64 Plane[4] = { Normal[0], Normal[1], Normal[2], Distance };
+		u32 k = 0;
+		for (u32 Row = 0; Row < 4; Row++)
+		{
+			for (u32 Column = Row; Column < 4; Column++)
+			{
+				Q.A[k++] += Weight * Plane[Row] * Plane[Column];
+			}
+		}
+		Q.Weight += Weight;
+	}
+	
+	static void AddQuadric(Quadric& Q, const Quadric& Other)
+	{
+		for (u32 k = 0; k < 10; k++)
+		{
+			Q.A[k] += Other.A[k];
+		}
+		Q.Weight += Other.Weight;
+	}
+	
+	// Mean squared distance from Position to the planes in A and B together.
+	static f64 CollapseCost(const Quadric& A, const Quadric& B, const f32 Position[3])
+	{
+		f64 Point[4] = { Position[0], Position[1], Position[2], 1.0 };
+		f64 Sum = 0.0;
+		u32 k = 0;
+		for (u32 Row = 0; Row < 4; Row++)
+		{
+			for (u32 Column = Row; Column < 4; Column++)
+			{
+				Sum += (Row == Column ? 1.0 : 2.0) * (A.A[k] + B.A[k]) * Point[Row] * Point[Column];
+				k++;
+			}
+		}
+		f64 Weight = A.Weight + B.Weight;
+		return Weight > 0.0 ? std::max(Sum, 0.0) / Weight : 0.0;
+	}
+	
+	static Vec3 TriangleNormal(const f32* P0, const f32* P1, const f32* P2)
+	{
+		return Cross({ P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] }, { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] });
+	}
+	
+	static f32 Dot(const Vec3& A, const Vec3& B)
+	{
+		return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+	}
+	
+	f32 SimplifyMesh(const MeshSource& Mesh, const std::vector<u32>& Indices, u32 TargetIndexCount, f32 ErrorLimit, std::vector<u32>& OutIndices)
+	{
+		u32 VertexCount = static_cast<u32>(Mesh.Vertices.size());
+		std::vector<bool> bLocked(VertexCount, false);
+		
+		// Vertices sharing a position sit on an attribute seam, moving one would tear the surface.
+		std::vector<u32> ByPosition(VertexCount);
+		for (u32 v = 0; v < VertexCount; v++)
+		{
+			ByPosition[v] = v;
+		}
+		auto PositionLess = [&Mesh](u32 A, u32 B)
+		{
+			return std::lexicographical_compare(Mesh.Vertices[A].Position, Mesh.Vertices[A].Position + 3, Mesh.Vertices[B].Position, Mesh.Vertices[B].Position + 3);
+		};
+		std::sort(ByPosition.begin(), ByPosition.end(), PositionLess);
+		for (u32 i = 1; i < VertexCount; i++)
+		{
+			if (!PositionLess(ByPosition[i - 1], ByPosition[i]))
+			{
+				bLocked[ByPosition[i - 1]] = true;
+				bLocked[ByPosition[i]] = true;
+			}
+		}
+		
+		// Edges without exactly two triangles are open borders or non-manifold.
+		std::vector<u64> Edges;
+		Edges.reserve(Indices.size());
+		for (arch i = 0; i < Indices.size(); i += 3)
+		{
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				u32 A = Indices[i + Corner];
+				u32 B = Indices[i + (Corner + 1) % 3];
+				Edges.push_back((static_cast<u64>(std::min(A, B)) << 32) | std::max(A, B));
+			}
+		}
+		std::sort(Edges.begin(), Edges.end());
+		for (arch i = 0; i < Edges.size();)
+		{
+			arch Run = 1;
+			while (i + Run < Edges.size() && Edges[i + Run] == Edges[i])
+			{
+				Run++;
+			}
+			if (Run != 2)
+			{
+				bLocked[Edges[i] >> 32] = true;
+				bLocked[Edges[i] & 0xFFFFFFFF] = true;
+			}
+			i += Run;
+		}
+		
+		// Area weighted, so the error is a mean distance that small slivers cannot dominate.
+		std::vector<Quadric> Quadrics(VertexCount);
+		for (arch i = 0; i < Indices.size(); i += 3)
+		{
+			const f32* P0 = Mesh.Vertices[Indices[i + 0]].Position;
+			Vec3 Normal = TriangleNormal(P0, Mesh.Vertices[Indices[i + 1]].Position, Mesh.Vertices[Indices[i + 2]].Position);
+			f32 Area = 0.5f * std::sqrt(Dot(Normal, Normal));
+			if (Area <= 0.0f)
+			{
+				continue;
+			}
+			Normalize(Normal.data());
+			f64 Distance = -(static_cast<f64>(Normal[0]) * P0[0] + static_cast<f64>(Normal[1]) * P0[1] + static_cast<f64>(Normal[2]) * P0[2]);
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				AddPlane(Quadrics[Indices[i + Corner]], Normal, Distance, Area);
+			}
+		}
+		
+		struct Collapse
+		{
+			u32 From;
+			u32 To;
+			f64 Cost;
+		};
+		
+		std::vector<u32> Result = Indices;
+		std::vector<u32> Remap(VertexCount);
+		std::vector<u32> FirstTriangle(VertexCount + 1);
+		std::vector<u32> VertexTriangles;
+		std::vector<Collapse> Collapses;
+		std::vector<bool> bTouched(VertexCount);
+		std::vector<u32> Stamps(VertexCount, 0);
+		u32 Stamp = 0;
+		f64 ErrorLimitSquared = static_cast<f64>(ErrorLimit) * ErrorLimit;
+		f64 MaxCost = 0.0;
+		
+		// Each pass collapses independent edges cheapest first, so no collapse sees a neighbourhood another one changed.
+		while (Result.size() > TargetIndexCount)
+		{
+			u32 TriangleCount = static_cast<u32>(Result.size() / 3);
+			
+			std::fill(FirstTriangle.begin(), FirstTriangle.end(), 0);
+			for (u32 Index : Result)
+			{
+				FirstTriangle[Index + 1]++;
+			}
+			for (u32 v = 0; v < VertexCount; v++)
+			{
+				FirstTriangle[v + 1] += FirstTriangle[v];
+			}
+			VertexTriangles.resize(Result.size());
+			std::vector<u32> Filled(FirstTriangle.begin(), FirstTriangle.end() - 1);
+			for (u32 t = 0; t < TriangleCount; t++)
+			{
+				for (u32 Corner = 0; Corner < 3; Corner++)
+				{
+					VertexTriangles[Filled[Result[t * 3 + Corner]]++] = t;
+				}
+			}
+			
+			// Interior edges appear once in each direction, take each from its smaller end and try both ways round.
+			Collapses.clear();
+			for (u32 t = 0; t < TriangleCount; t++)
+			{
+				for (u32 Corner = 0; Corner < 3; Corner++)
+				{
+					u32 A = Result[t * 3 + Corner];
+					u32 B = Result[t * 3 + (Corner + 1) % 3];
+					if (A > B)
+					{
+						continue;
+					}
+					if (!bLocked[A])
+					{
+						Collapses.push_back({ A, B, CollapseCost(Quadrics[A], Quadrics[B], Mesh.Vertices[B].Position) });
+					}
+					if (!bLocked[B])
+					{
+						Collapses.push_back({ B, A, CollapseCost(Quadrics[A], Quadrics[B], Mesh.Vertices[A].Position) });
+					}
+				}
+			}
+			std::sort(Collapses.begin(), Collapses.end(), [](const Collapse& A, const Collapse& B) { return A.Cost < B.Cost; });
+			
+			// Interior collapses remove two triangles each.
+			u32 Budget = static_cast<u32>((Result.size() - TargetIndexCount) / 6 + 1);
+			u32 Collapsed = 0;
+			std::fill(bTouched.begin(), bTouched.end(), false);
+			for (u32 v = 0; v < VertexCount; v++)
+			{
+				Remap[v] = v;
+			}
+			
+			for (const Collapse& Candidate : Collapses)
+			{
+				if (Candidate.Cost > ErrorLimitSquared || Collapsed >= Budget)
+				{
+					break;
+				}
+				if (bTouched[Candidate.From] || bTouched[Candidate.To])
+				{
+					continue;
+				}
+				
+				// Exactly two shared neighbours, otherwise the collapse pinches the surface into a non-manifold fin.
+				Stamp += 2;
+				for (u32 i = FirstTriangle[Candidate.From]; i < FirstTriangle[Candidate.From + 1]; i++)
+				{
+					for (u32 Corner = 0; Corner < 3; Corner++)
+					{
+						Stamps[Result[VertexTriangles[i] * 3 + Corner]] = Stamp;
+					}
+				}
+				u32 SharedNeighbours = 0;
+				for (u32 i = FirstTriangle[Candidate.To]; i < FirstTriangle[Candidate.To + 1]; i++)
+				{
+					for (u32 Corner = 0; Corner < 3; Corner++)
+					{
+						u32 v = Result[VertexTriangles[i] * 3 + Corner];
+						if (v != Candidate.From && v != Candidate.To && Stamps[v] == Stamp)
+						{
+							Stamps[v] = Stamp + 1;
+							SharedNeighbours++;
+						}
+					}
+				}
+				if (SharedNeighbours != 2)
+				{
+					continue;
+				}
+				
+				// Triangles that survive must not turn over.
+				bool bFlips = false;
+				for (u32 i = FirstTriangle[Candidate.From]; i < FirstTriangle[Candidate.From + 1] && !bFlips; i++)
+				{
+					const u32* Triangle = &Result[VertexTriangles[i] * 3];
+					if (Triangle[0] == Candidate.To || Triangle[1] == Candidate.To || Triangle[2] == Candidate.To)
+					{
+						continue;
+					}
+					const f32* Before[3];
+					const f32* After[3];
+					for (u32 Corner = 0; Corner < 3; Corner++)
+					{
+						Before[Corner] = Mesh.Vertices[Triangle[Corner]].Position;
+						After[Corner] = Triangle[Corner] == Candidate.From ? Mesh.Vertices[Candidate.To].Position : Before[Corner];
+					}
+					bFlips = Dot(TriangleNormal(Before[0], Before[1], Before[2]), TriangleNormal(After[0], After[1], After[2])) <= 0.0f;
+				}
+				if (bFlips)
+				{
+					continue;
+				}
+				
+				Remap[Candidate.From] = Candidate.To;
+				AddQuadric(Quadrics[Candidate.To], Quadrics[Candidate.From]);
+				MaxCost = std::max(MaxCost, Candidate.Cost);
+				for (u32 i = FirstTriangle[Candidate.From]; i < FirstTriangle[Candidate.From + 1]; i++)
+				{
+					for (u32 Corner = 0; Corner < 3; Corner++)
+					{
+						bTouched[Result[VertexTriangles[i] * 3 + Corner]] = true;
+					}
+				}
+				Collapsed++;
+			}
+			
+			if (Collapsed == 0)
+			{
+				break;
+			}
+			
+			arch Kept = 0;
+			for (arch i = 0; i < Result.size(); i += 3)
+			{
+				u32 A = Remap[Result[i + 0]];
+				u32 B = Remap[Result[i + 1]];
+				u32 C = Remap[Result[i + 2]];
+				if (A != B && B != C && C != A)
+				{
+					Result[Kept++] = A;
+					Result[Kept++] = B;
+					Result[Kept++] = C;
+				}
+			}
+			Result.resize(Kept);
+		}
+		
+		OutIndices = std::move(Result);
+		return static_cast<f32>(std::sqrt(MaxCost));
+	}
+	
+	void BuildLodChain(const MeshSource& Mesh, std::vector<MeshLod>& OutLods)
+	{
+		OutLods.clear();
+		OutLods.push_back({ Mesh.Indices, 0.0f });
+		
+		f32 Min[3];
+		f32 Max[3];
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Min[Axis] = Max[Axis] = Mesh.Vertices[0].Position[Axis];
+		}
+		for (const MeshSourceVertex& Vertex : Mesh.Vertices)
+		{
+			for (u32 Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(Min[Axis], Vertex.Position[Axis]);
+				Max[Axis] = std::max(Max[Axis], Vertex.Position[Axis]);
+			}
+		}
+		Vec3 Diagonal = { Max[0] - Min[0], Max[1] - Min[1], Max[2] - Min[2] };
+		f32 ErrorLimit = LOD_ERROR_LIMIT * 0.5f * std::sqrt(Dot(Diagonal, Diagonal));
+		
+		u32 VertexCount = static_cast<u32>(Mesh.Vertices.size());
+		while (OutLods.size() < MESH_ASSET_LODS_MAX && OutLods.back().Indices.size() / 3 > MESH_ASSET_MESHLET_TRIANGLES_MAX)
+		{
+			// Always from the full mesh, so each LOD's error is measured against the real surface.
+			u32 Target = static_cast<u32>(OutLods.back().Indices.size() / 6 * 3);
+			MeshLod Lod;
+			Lod.Error = SimplifyMesh(Mesh, Mesh.Indices, Target, ErrorLimit, Lod.Indices);
+			if (Lod.Indices.empty() || static_cast<f32>(Lod.Indices.size()) > LOD_REDUCTION_MIN * static_cast<f32>(OutLods.back().Indices.size()))
+			{
+				break;
+			}
+			
+			// Errors only ever grow down the chain, selection relies on it.
+			Lod.Error = std::max(Lod.Error, OutLods.back().Error);
+			OptimizeVertexCache(Lod.Indices, VertexCount);
+			OutLods.push_back(std::move(Lod));
+		}
+	}
+	
+	static MeshAssetMeshlet BuildMeshlet(const MeshSource& Mesh, const std::vector<u32>& Indices, u32 FirstTriangle, u32 EndTriangle)
+	{
+		MeshAssetMeshlet Meshlet = {};
+		Meshlet.FirstIndex = FirstTriangle * 3;
+		Meshlet.TriangleCount = EndTriangle - FirstTriangle;
+		
+		f32 Min[3];
+		f32 Max[3];
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Min[Axis] = Max[Axis] = Mesh.Vertices[Indices[FirstTriangle * 3]].Position[Axis];
+		}
+		for (u32 i = FirstTriangle * 3; i < EndTriangle * 3; i++)
+		{
+			for (u32 Axis = 0; Axis < 3; Axis++)
+			{
+				Min[Axis] = std::min(Min[Axis], Mesh.Vertices[Indices[i]].Position[Axis]);
+				Max[Axis] = std::max(Max[Axis], Mesh.Vertices[Indices[i]].Position[Axis]);
+			}
+		}
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Meshlet.Sphere[Axis] = 0.5f * (Min[Axis] + Max[Axis]);
+		}
+		f32 RadiusSquared = 0.0f;
+		for (u32 i = FirstTriangle * 3; i < EndTriangle * 3; i++)
+		{
+			const f32* Position = Mesh.Vertices[Indices[i]].Position;
+			Vec3 Offset = { Position[0] - Meshlet.Sphere[0], Position[1] - Meshlet.Sphere[1], Position[2] - Meshlet.Sphere[2] };
+			RadiusSquared = std::max(RadiusSquared, Dot(Offset, Offset));
+		}
+		Meshlet.Sphere[3] = std::sqrt(RadiusSquared);
+		
+		// Counter clockwise front faces, matching the pipeline.
+		std::vector<Vec3> Normals;
+		Vec3 Axis = { 0.0f, 0.0f, 0.0f };
+		for (u32 t = FirstTriangle; t < EndTriangle; t++)
+		{
+			Vec3 Normal = TriangleNormal(Mesh.Vertices[Indices[t * 3]].Position, Mesh.Vertices[Indices[t * 3 + 1]].Position, Mesh.Vertices[Indices[t * 3 + 2]].Position);
+			if (Dot(Normal, Normal) <= 0.0f)
+			{
+				continue;
+			}
+			Normalize(Normal.data());
+			Normals.push_back(Normal);
+			Axis[0] += Normal[0];
+			Axis[1] += Normal[1];
+			Axis[2] += Normal[2];
+		}
+		Normalize(Axis.data());
+		
+		f32 MinimumDot = Normals.empty() ? -1.0f : 1.0f;
+		for (const Vec3& Normal : Normals)
+		{
+			MinimumDot = std::min(MinimumDot, Dot(Normal, Axis));
+		}
+		
+		if (MinimumDot <= CONE_MINIMUM_DOT)
+		{
+			// A cutoff of one can never pass the test.
+			Meshlet.Cone[3] = 1.0f;
+		}
+		else
+		{
+			Meshlet.Cone[0] = Axis[0];
+			Meshlet.Cone[1] = Axis[1];
+			Meshlet.Cone[2] = Axis[2];
+			Meshlet.Cone[3] = std::min(1.0f, std::sqrt(1.0f - MinimumDot * MinimumDot) + CONE_MARGIN);
+		}
+		return Meshlet;
+	}
+	
+	void BuildMeshlets(const MeshSource& Mesh, const std::vector<u32>& Indices, u32 FirstIndex, std::vector<MeshAssetMeshlet>& OutMeshlets)
+	{
+		u32 TriangleCount = static_cast<u32>(Indices.size() / 3);
+		std::vector<u32> LastMeshlet(Mesh.Vertices.size(), INDEX_NONE);
+		u32 MeshletIndex = 0;
+		u32 MeshletVertices = 0;
+		u32 MeshletStart = 0;
+		
+		for (u32 t = 0; t < TriangleCount; t++)
+		{
+			u32 NewVertices = 0;
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				NewVertices += LastMeshlet[Indices[t * 3 + Corner]] != MeshletIndex ? 1 : 0;
+			}
+			
+			if (MeshletVertices + NewVertices > MESH_ASSET_MESHLET_VERTICES_MAX || t - MeshletStart == MESH_ASSET_MESHLET_TRIANGLES_MAX)
+			{
+				OutMeshlets.push_back(BuildMeshlet(Mesh, Indices, MeshletStart, t));
+				OutMeshlets.back().FirstIndex += FirstIndex;
+				MeshletIndex++;
+				MeshletVertices = 0;
+				MeshletStart = t;
+			}
+			
+			for (u32 Corner = 0; Corner < 3; Corner++)
+			{
+				u32 v = Indices[t * 3 + Corner];
+				if (LastMeshlet[v] != MeshletIndex)
+				{
+					LastMeshlet[v] = MeshletIndex;
+					MeshletVertices++;
+				}
+			}
+		}
+		
+		if (MeshletStart < TriangleCount)
+		{
+			OutMeshlets.push_back(BuildMeshlet(Mesh, Indices, MeshletStart, TriangleCount));
+			OutMeshlets.back().FirstIndex += FirstIndex;
+		}
+	}
+	
+	static u64 AlignUp(u64 Value, u64 Alignment)
+	{
+		return (Value + Alignment - 1) & ~(Alignment - 1);
+	}
+	
+	void CookMesh(const MeshSource& Mesh, const std::vector<MeshLod>& Lods, std::vector<u8>& OutAsset)
+	{
+		u32 VertexCount = static_cast<u32>(Mesh.Vertices.size());
+		bool bIndices16 = VertexCount <= 0x10000;
+		
+		std::vector<u32> AllIndices;
+		std::vector<MeshAssetLod> AssetLods;
+		std::vector<MeshAssetMeshlet> Meshlets;
+		for (const MeshLod& Lod : Lods)
+		{
+			MeshAssetLod& AssetLod = AssetLods.emplace_back();
+			AssetLod = {};
+			AssetLod.FirstIndex = static_cast<u32>(AllIndices.size());
+			AssetLod.IndexCount = static_cast<u32>(Lod.Indices.size());
+			AssetLod.FirstMeshlet = static_cast<u32>(Meshlets.size());
+			AssetLod.Error = Lod.Error;
+			BuildMeshlets(Mesh, Lod.Indices, AssetLod.FirstIndex, Meshlets);
+			AssetLod.MeshletCount = static_cast<u32>(Meshlets.size()) - AssetLod.FirstMeshlet;
+			AllIndices.insert(AllIndices.end(), Lod.Indices.begin(), Lod.Indices.end());
+		}
+		u32 IndexCount = static_cast<u32>(AllIndices.size());
+		
+		MeshAssetHeader Header = {};
+		Header.Magic = MESH_ASSET_MAGIC;
+		Header.Version = MESH_ASSET_VERSION;
+		Header.VertexCount = VertexCount;
+		Header.IndexCount = IndexCount;
+		Header.Flags = bIndices16 ? static_cast<u32>(MESH_ASSET_INDICES_16) : 0u;
+		Header.LodCount = static_cast<u32>(AssetLods.size());
+		Header.MeshletCount = static_cast<u32>(Meshlets.size());
+		
+		f32 Max[3];
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Header.BoundsMin[Axis] = Mesh.Vertices[0].Position[Axis];
+			Max[Axis] = Mesh.Vertices[0].Position[Axis];
+		}
+		for (const MeshSourceVertex& Vertex : Mesh.Vertices)
+		{
+			for (u32 Axis = 0; Axis < 3; Axis++)
+			{
+				Header.BoundsMin[Axis] = std::min(Header.BoundsMin[Axis], Vertex.Position[Axis]);
+				Max[Axis] = std::max(Max[Axis], Vertex.Position[Axis]);
+			}
+		}
+		
+		f32 RadiusSquared = 0.0f;
+		for (u32 Axis = 0; Axis < 3; Axis++)
+		{
+			Header.BoundsExtent[Axis] = Max[Axis] - Header.BoundsMin[Axis];
+			Header.Sphere[Axis] = Header.BoundsMin[Axis] + 0.5f * Header.BoundsExtent[Axis];
+		}
+		for (const MeshSourceVertex& Vertex : Mesh.Vertices)
+		{
+			f32 X = Vertex.Position[0] - Header.Sphere[0];
+			f32 Y = Vertex.Position[1] - Header.Sphere[1];
+			f32 Z = Vertex.Position[2] - Header.Sphere[2];
+			RadiusSquared = std::max(RadiusSquared, X * X + Y * Y + Z * Z);
+		}
+		Header.Sphere[3] = std::sqrt(RadiusSquared);
+		
+		u64 IndexSize = bIndices16 ? 2 : 4;
+		Header.VertexOffset = AlignUp(sizeof(MeshAssetHeader), MESH_ASSET_ALIGNMENT);
+		Header.IndexOffset = AlignUp(Header.VertexOffset + sizeof(MeshAssetVertex) * static_cast<u64>(VertexCount), MESH_ASSET_ALIGNMENT);
+		Header.LodOffset = AlignUp(Header.IndexOffset + IndexSize * IndexCount, MESH_ASSET_ALIGNMENT);
+		Header.MeshletOffset = AlignUp(Header.LodOffset + sizeof(MeshAssetLod) * AssetLods.size(), MESH_ASSET_ALIGNMENT);
+		OutAsset.assign(Header.MeshletOffset + sizeof(MeshAssetMeshlet) * Meshlets.size(), 0);
+		memcpy(OutAsset.data(), &Header, sizeof(Header));
+		
+		MeshAssetVertex* Vertices = reinterpret_cast<MeshAssetVertex*>(OutAsset.data() + Header.VertexOffset);
+		for (u32 i = 0; i < VertexCount; i++)
+		{
+			const MeshSourceVertex& Source = Mesh.Vertices[i];
+			for (u32 Axis = 0; Axis < 3; Axis++)
+			{
+				f32 Unorm = Header.BoundsExtent[Axis] > 0.0f ? (Source.Position[Axis] - Header.BoundsMin[Axis]) / Header.BoundsExtent[Axis] : 0.0f;
+				Vertices[i].Position[Axis] = static_cast<u16>(std::lround(std::clamp(Unorm, 0.0f, 1.0f) * 65535.0f));
+			}
+			EncodeOctahedralNormal(Source.Normal, Vertices[i].Normal);
+		}
+		
+		u8* Indices = OutAsset.data() + Header.IndexOffset;
+		for (u32 i = 0; i < IndexCount; i++)
+		{
+			if (bIndices16)
+			{
+				u16 Index = static_cast<u16>(AllIndices[i]);
+				memcpy(Indices + i * 2, &Index, sizeof(Index));
+			}
+			else
+			{
+				memcpy(Indices + i * 4, &AllIndices[i], sizeof(u32));
+			}
+		}
+		
+		memcpy(OutAsset.data() + Header.LodOffset, AssetLods.data(), sizeof(MeshAssetLod) * AssetLods.size());
+		memcpy(OutAsset.data() + Header.MeshletOffset, Meshlets.data(), sizeof(MeshAssetMeshlet) * Meshlets.size());
+	}
+}
\ No newline at end of file
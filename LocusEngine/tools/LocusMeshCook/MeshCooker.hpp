@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Base/Base.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+	Offline side of the mesh asset pipeline: importers, index and vertex reordering, and the
+	quantising writer for the .lmesh format described in Graphics/MeshAsset.hpp.
+	
+	Importers flatten everything they find into one triangle list with positions and normals.
+	Missing normals are generated smooth, area weighted across faces sharing a position.
+	
+	LODs come from quadric error edge collapses onto existing vertices, so every LOD indexes the
+	same vertex buffer. Vertices on open borders and attribute seams never move, which keeps
+	silhouettes and shading splits intact at the cost of simplifying heavily seamed meshes less.
+*/
+
+namespace Locus
+{
+	struct MeshSourceVertex
+	{
+		f32 Position[3];
+		f32 Normal[3];
+	};
+	
+	struct MeshSource
+	{
+		std::vector<MeshSourceVertex> Vertices;
+		std::vector<u32> Indices;
+	};
+	
+	struct MeshLod
+	{
+		std::vector<u32> Indices;
+		f32 Error; // Object space, see MeshAssetLod
+	};
+	
+	struct MeshAssetMeshlet;
+	
+	// Wavefront OBJ, polygons are fanned into triangles. Materials and texture coordinates are ignored.
+	bool ImportObj(const u8* Data, arch Size, MeshSource& OutMesh, std::string& OutError);
+	
+	// glTF 2.0, .gltf with external or base64 buffers, or .glb. Every triangle primitive of every mesh
+	// the default scene instantiates is baked with its node's world transform.
+	bool ImportGltf(const char* Path, MeshSource& OutMesh, std::string& OutError);
+	
+	// Tom Forsyth's linear-speed vertex cache optimisation, reorders triangles in place.
+	void OptimizeVertexCache(std::vector<u32>& Indices, u32 VertexCount);
+	
+	// Renumbers vertices in order of first use, so the vertex fetch walks memory forwards.
+	void OptimizeVertexFetch(MeshSource& Mesh);
+	
+	// Average vertex shader invocations per triangle through a FIFO cache of CacheSize entries.
+	f32 ComputeAcmr(const std::vector<u32>& Indices, u32 VertexCount, u32 CacheSize);
+	
+	// Collapses edges until at most TargetIndexCount indices remain or the next collapse would move the
+	// surface further than ErrorLimit. Returns how far the surface may have moved.
+	f32 SimplifyMesh(const MeshSource& Mesh, const std::vector<u32>& Indices, u32 TargetIndexCount, f32 ErrorLimit, std::vector<u32>& OutIndices);
+	
+	// The mesh's own indices first, then halving the triangle count each step until simplification stalls
+	// or MESH_ASSET_LODS_MAX is reached. Every LOD comes out optimised for the vertex cache.
+	void BuildLodChain(const MeshSource& Mesh, std::vector<MeshLod>& OutLods);
+	
+	// Greedy in index order, so each meshlet is a contiguous run of triangles starting FirstIndex into the asset's indices.
+	void BuildMeshlets(const MeshSource& Mesh, const std::vector<u32>& Indices, u32 FirstIndex, std::vector<MeshAssetMeshlet>& OutMeshlets);
+	
+	void CookMesh(const MeshSource& Mesh, const std::vector<MeshLod>& Lods, std::vector<u8>& OutAsset);
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "Base/Base.hpp"
+#include "MeshCooker.hpp"
+#include "Platform/Platform.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+	Usage: LocusMeshCook <Input.obj|Input.gltf|Input.glb> <Output.lmesh>
+	
+	Imports a triangle mesh, reorders it for the post-transform vertex cache and vertex fetch, then writes
+	it quantised in the runtime mesh format (Graphics/MeshAsset.hpp).
+*/
+
+using namespace Locus;
+
+static constexpr u32 ACMR_CACHE_SIZE = 32;
+
+i32 main(i32 argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		LLOG(LocusMeshCook, Error, "Usage: LocusMeshCook <Input.obj|Input.gltf|Input.glb> <Output.lmesh>");
+		return 1;
+	}
+	
+	const char* InputPath = argv[1];
+	const char* OutputPath = argv[2];
+	std::string Extension = std::filesystem::path(InputPath).extension().string();
+	
+	MeshSource Mesh;
+	std::string ImportError;
+	bool bImported = false;
+	if (Extension == ".obj")
+	{
+		arch Size;
+		std::vector<u8> Data;
+		if (Platform::FileGetSize(InputPath, Size))
+		{
+			Data.resize(Size);
+			bImported = Platform::FileReadBytes(InputPath, Data.data(), Size) && ImportObj(Data.data(), Size, Mesh, ImportError);
+		}
+		else
+		{
+			ImportError = "Could not read the file";
+		}
+	}
+	else if (Extension == ".gltf" || Extension == ".glb")
+	{
+		bImported = ImportGltf(InputPath, Mesh, ImportError);
+	}
+	else
+	{
+		ImportError = "Unsupported extension " + Extension;
+	}
+	
+	if (!bImported)
+	{
+		LLOG(LocusMeshCook, Error, "Could not import %s: %s", InputPath, ImportError.c_str());
+		return 1;
+	}
+	
+	u32 VertexCount = static_cast<u32>(Mesh.Vertices.size());
+	f32 AcmrBefore = ComputeAcmr(Mesh.Indices, VertexCount, ACMR_CACHE_SIZE);
+	OptimizeVertexCache(Mesh.Indices, VertexCount);
+	f32 AcmrAfter = ComputeAcmr(Mesh.Indices, VertexCount, ACMR_CACHE_SIZE);
+	OptimizeVertexFetch(Mesh);
+	
+	std::vector<u8> Asset;
+	std::vector<MeshLod> Lods;
+	BuildLodChain(Mesh, Lods);
+	CookMesh(Mesh, Lods, Asset);
+	if (!Platform::FileWriteBytesAtomic(OutputPath, Asset.data(), Asset.size()))
+	{
+		LLOG(LocusMeshCook, Error, "Could not write %s", OutputPath);
+		return 1;
+	}
+	
+	LLOG(LocusMeshCook, Info, "Cooked %s: %zu vertices, %zu triangles, ACMR %.3f -> %.3f, %zu bytes", InputPath, Mesh.Vertices.size(), Mesh.Indices.size() / 3, AcmrBefore, AcmrAfter, Asset.size());
+	for (arch i = 0; i < Lods.size(); i++)
+	{
+		LLOG(LocusMeshCook, Info, "  LOD %zu: %zu triangles, error %g", i, Lods[i].Indices.size() / 3, Lods[i].Error);
+	}
+	return 0;
+}
\ No newline at end of file
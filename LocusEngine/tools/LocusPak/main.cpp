@@ -0,0 +1,79 @@
+#include "Base/Base.hpp"
+#include "Platform/PackFile.hpp"
+#include "Platform/Platform.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+/*
+	Usage: LocusPak <ContentDirectory> <OutputPack> [--no-compress]
+	
+	Packs every file under ContentDirectory, using paths relative to it as logical paths.
+*/
+
+using namespace Locus;
+
+i32 main(i32 argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		LLOG(LocusPak, Error, "Usage: LocusPak <ContentDirectory> <OutputPack> [--no-compress]");
+		return 1;
+	}
+	
+	const char* ContentDirectory = argv[1];
+	const char* OutputPath = argv[2];
+	bool bCompress = !(argc > 3 && strcmp(argv[3], "--no-compress") == 0);
+	
+	std::filesystem::path Root(ContentDirectory);
+	if (!std::filesystem::is_directory(Root))
+	{
+		LLOG(LocusPak, Error, "%s is not a directory", ContentDirectory);
+		return 1;
+	}
+	
+	PackWriter Writer;
+	u64 TotalBytes = 0;
+	
+	for (const auto& Item : std::filesystem::recursive_directory_iterator(Root))
+	{
+		if (!Item.is_regular_file())
+		{
+			continue;
+		}
+		
+		std::string FilePath = Item.path().string();
+		std::string LogicalPath = std::filesystem::relative(Item.path(), Root).generic_string();
+		
+		arch Size;
+		if (!Platform::FileGetSize(FilePath.c_str(), Size))
+		{
+			LLOG(LocusPak, Error, "Could not open %s", FilePath.c_str());
+			return 1;
+		}
+		
+		std::vector<u8> Data(Size);
+		if (Size > 0 && !Platform::FileReadBytes(FilePath.c_str(), Data.data(), Size))
+		{
+			LLOG(LocusPak, Error, "Could not read %s", FilePath.c_str());
+			return 1;
+		}
+		
+		// Cooked meshes stay uncompressed so the runtime can map them and upload straight from the pack.
+		bool bStored = Item.path().extension() == ".lmesh";
+		Writer.AddFile(LogicalPath.c_str(), Data.data(), Size, bCompress && !bStored);
+		TotalBytes += Size;
+	}
+	
+	if (!Writer.Write(OutputPath))
+	{
+		LLOG(LocusPak, Error, "Could not write %s", OutputPath);
+		return 1;
+	}
+	
+	arch PackSize = 0;
+	Platform::FileGetSize(OutputPath, PackSize);
+	LLOG(LocusPak, Info, "Packed %zu files (%llu bytes) into %s (%zu bytes)", Writer.GetEntryCount(), (unsigned long long)TotalBytes, OutputPath, PackSize);
+	return 0;
+}
\ No newline at end of file